@@ -65,23 +65,38 @@ LOCAL_SRC_FILES := \
     ap_interface_impl.cpp \
     client_interface_binder.cpp \
     client_interface_impl.cpp \
+    latency_histogram.cpp \
+    link_stats_sampler.cpp \
     logging_utils.cpp \
     looper_backed_event_loop.cpp \
+    mlme_event_timeline.cpp \
+    scanning/channel_planner.cpp \
     scanning/channel_settings.cpp \
     scanning/hidden_network.cpp \
+    scanning/hidden_network_scheduler.cpp \
     scanning/offload_scan_callback_interface_impl.cpp \
     scanning/pno_network.cpp \
+    scanning/pno_network_ranker.cpp \
     scanning/pno_settings.cpp \
     scanning/scan_result.cpp \
+    scanning/scan_result_delta.cpp \
+    scanning/scan_result_delta_tracker.cpp \
+    scanning/scan_result_filter.cpp \
+    scanning/scan_result_projection.cpp \
+    scanning/scan_result_shared_memory.cpp \
+    scanning/scan_result_snapshot.cpp \
+    scanning/scan_plan_generator.cpp \
     scanning/offload/scan_stats.cpp \
     scanning/single_scan_settings.cpp \
     scanning/scan_utils.cpp \
     scanning/wifi_gbk2utf.cpp \
     scanning/scanner_impl.cpp \
+    scanning/offload/hidl_call_stats.cpp \
     scanning/offload/offload_scan_manager.cpp \
     scanning/offload/offload_callback.cpp \
     scanning/offload/offload_service_utils.cpp \
     scanning/offload/offload_scan_utils.cpp \
+    scanning/offload/subscription_delay_policy.cpp \
     server.cpp
 LOCAL_SHARED_LIBRARIES := \
     android.hardware.wifi.offload@1.0 \
@@ -134,13 +149,20 @@ LOCAL_SRC_FILES := \
     aidl/android/net/wifi/IInterfaceEventCallback.aidl \
     aidl/android/net/wifi/IPnoScanEvent.aidl \
     aidl/android/net/wifi/IScanEvent.aidl \
+    aidl/android/net/wifi/IScanRequestCallback.aidl \
+    aidl/android/net/wifi/IScanResultDeltaEvent.aidl \
     aidl/android/net/wifi/IWificond.aidl \
     aidl/android/net/wifi/IWifiScannerImpl.aidl \
+    mlme_event_stats.cpp \
     scanning/channel_settings.cpp \
     scanning/hidden_network.cpp \
+    scanning/offload/scan_stats.cpp \
     scanning/pno_network.cpp \
     scanning/pno_settings.cpp \
     scanning/scan_result.cpp \
+    scanning/scan_result_delta.cpp \
+    scanning/scan_result_filter.cpp \
+    scanning/scan_result_projection.cpp \
     scanning/single_scan_settings.cpp
 LOCAL_SHARED_LIBRARIES := \
     libbinder
@@ -192,9 +214,15 @@ LOCAL_CPPFLAGS := $(wificond_cpp_flags)
 LOCAL_C_INCLUDES := $(wificond_includes)
 LOCAL_SRC_FILES := \
     tests/ap_interface_impl_unittest.cpp \
+    tests/channel_planner_unittest.cpp \
     tests/client_interface_impl_unittest.cpp \
+    tests/hidden_network_scheduler_unittest.cpp \
+    tests/hidl_call_util_unittest.cpp \
+    tests/latency_histogram_unittest.cpp \
+    tests/link_stats_sampler_unittest.cpp \
     tests/looper_backed_event_loop_unittest.cpp \
     tests/main.cpp \
+    tests/mlme_event_timeline_unittest.cpp \
     tests/mock_client_interface_impl.cpp \
     tests/mock_netlink_manager.cpp \
     tests/mock_netlink_utils.cpp \
@@ -204,6 +232,9 @@ LOCAL_SRC_FILES := \
     tests/mock_offload_scan_callback_interface_impl.cpp \
     tests/mock_offload_scan_manager.cpp \
     tests/mock_offload_service_utils.cpp \
+    tests/mock_scan_event.cpp \
+    tests/mock_scan_result_delta_event.cpp \
+    tests/mock_scan_request_callback.cpp \
     tests/mock_scan_utils.cpp \
     tests/netlink_manager_unittest.cpp \
     tests/netlink_utils_unittest.cpp \
@@ -214,12 +245,18 @@ LOCAL_SRC_FILES := \
     tests/offload_scan_manager_test.cpp \
     tests/offload_scan_utils_test.cpp \
     tests/offload_test_utils.cpp \
+    tests/pno_network_ranker_unittest.cpp \
     tests/scanner_unittest.cpp \
+    tests/scan_plan_generator_unittest.cpp \
+    tests/scan_result_delta_tracker_unittest.cpp \
+    tests/scan_result_shared_memory_unittest.cpp \
+    tests/scan_result_snapshot_unittest.cpp \
     tests/scan_result_unittest.cpp \
     tests/scan_settings_unittest.cpp \
     tests/scan_stats_unittest.cpp \
     tests/scan_utils_unittest.cpp \
-    tests/server_unittest.cpp
+    tests/server_unittest.cpp \
+    tests/subscription_delay_policy_unittest.cpp
 LOCAL_STATIC_LIBRARIES := \
     libgmock \
     libgtest \
@@ -270,3 +307,48 @@ LOCAL_STATIC_LIBRARIES := \
     libwificond_ipc \
     libwificond_test_utils
 include $(BUILD_NATIVE_TEST)
+
+###
+### wificond benchmarks.
+###
+include $(CLEAR_VARS)
+LOCAL_MODULE := wificond_benchmark
+LOCAL_CPPFLAGS := $(wificond_cpp_flags)
+LOCAL_C_INCLUDES := $(wificond_includes)
+LOCAL_SRC_FILES := \
+    tests/benchmarks/offload_scan_utils_benchmark.cpp \
+    tests/benchmarks/roam_handling_benchmark.cpp \
+    tests/benchmarks/scan_result_transfer_benchmark.cpp
+LOCAL_STATIC_LIBRARIES := \
+    libwificond \
+    libwificond_nl
+LOCAL_SHARED_LIBRARIES := \
+    android.hardware.wifi.offload@1.0 \
+    libbase \
+    libbinder \
+    libcutils \
+    libhidlbase \
+    libhidltransport \
+    liblog \
+    libutils
+include $(BUILD_NATIVE_BENCHMARK)
+
+###
+### wificond channel planner simulator.
+###
+include $(CLEAR_VARS)
+LOCAL_MODULE := wificond_channel_planner_simulator
+LOCAL_MODULE_TAGS := tests
+LOCAL_CPPFLAGS := $(wificond_cpp_flags)
+LOCAL_C_INCLUDES := $(wificond_includes)
+LOCAL_SRC_FILES := \
+    tests/benchmarks/channel_planner_simulator.cpp
+LOCAL_STATIC_LIBRARIES := \
+    libwificond
+LOCAL_SHARED_LIBRARIES := \
+    libbase \
+    libbinder \
+    libcutils \
+    liblog \
+    libutils
+include $(BUILD_EXECUTABLE)
@@ -25,6 +25,7 @@
 using android::binder::Status;
 using android::net::wifi::IANQPDoneCallback;
 using android::net::wifi::IWifiScannerImpl;
+using com::android::server::wifi::wificond::MlmeEventStats;
 using std::vector;
 
 namespace android {
@@ -103,5 +104,13 @@ Status ClientInterfaceBinder::requestANQP(
   return Status::ok();
 }
 
+Status ClientInterfaceBinder::getMlmeEventStats(MlmeEventStats* out_stats) {
+  if (impl_ == nullptr) {
+    return Status::ok();
+  }
+  *out_stats = impl_->GetMlmeEventStats();
+  return Status::ok();
+}
+
 }  // namespace wificond
 }  // namespace android
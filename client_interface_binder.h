@@ -52,6 +52,9 @@ class ClientInterfaceBinder : public android::net::wifi::BnClientInterface {
       const ::std::vector<uint8_t>& bssid,
       const ::android::sp<::android::net::wifi::IANQPDoneCallback>& callback,
       bool* out_success) override;
+  ::android::binder::Status getMlmeEventStats(
+      ::com::android::server::wifi::wificond::MlmeEventStats* out_stats)
+      override;
 
  private:
   ClientInterfaceImpl* impl_;
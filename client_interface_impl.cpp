@@ -19,18 +19,24 @@
 #include <vector>
 
 #include <android-base/logging.h>
+#include <cutils/properties.h>
+#include <utils/Timers.h>
 #include <wifi_system/supplicant_manager.h>
 
 #include "wificond/client_interface_binder.h"
+#include "wificond/logging_utils.h"
 #include "wificond/net/mlme_event.h"
 #include "wificond/net/netlink_utils.h"
+#include "wificond/scanning/offload/offload_scan_manager.h"
 #include "wificond/scanning/offload/offload_service_utils.h"
 #include "wificond/scanning/scan_result.h"
 #include "wificond/scanning/scan_utils.h"
 #include "wificond/scanning/scanner_impl.h"
 
 using android::net::wifi::IClientInterface;
+using com::android::server::wifi::wificond::MlmeEventStats;
 using com::android::server::wifi::wificond::NativeScanResult;
+using com::android::server::wifi::wificond::NativeScanStats;
 using android::sp;
 using android::wifi_system::InterfaceTool;
 using android::wifi_system::SupplicantManager;
@@ -43,6 +49,22 @@ using std::vector;
 namespace android {
 namespace wificond {
 
+namespace {
+
+// Getters polled within this period read the same station info.
+constexpr int32_t kDefaultLinkStatsSamplingPeriodMs = 1000;
+
+int64_t GetBootTimeMs() {
+  return systemTime(SYSTEM_TIME_BOOTTIME) / 1000000;
+}
+
+int64_t GetLinkStatsSamplingPeriodMs() {
+  return property_get_int32("persist.wifi.link_stats.sampling_period_ms",
+                            kDefaultLinkStatsSamplingPeriodMs);
+}
+
+}  // namespace
+
 MlmeEventHandlerImpl::MlmeEventHandlerImpl(ClientInterfaceImpl* client_interface)
     : client_interface_(client_interface) {
 }
@@ -51,9 +73,12 @@ MlmeEventHandlerImpl::~MlmeEventHandlerImpl() {
 }
 
 void MlmeEventHandlerImpl::OnConnect(unique_ptr<MlmeConnectEvent> event) {
+  client_interface_->mlme_event_timeline_.Add(
+      {GetBootTimeMs(), MlmeEventType::kConnect, event->GetStatusCode(),
+       event->IsTimeout(), event->GetBSSID()});
   if (!event->IsTimeout() && event->GetStatusCode() == 0) {
     client_interface_->is_associated_ = true;
-    client_interface_->RefreshAssociateFreq();
+    client_interface_->RefreshAssociateFreq(event->GetFrequency());
     client_interface_->bssid_ = event->GetBSSID();
   } else {
     if (event->IsTimeout()) {
@@ -65,9 +90,12 @@ void MlmeEventHandlerImpl::OnConnect(unique_ptr<MlmeConnectEvent> event) {
 }
 
 void MlmeEventHandlerImpl::OnRoam(unique_ptr<MlmeRoamEvent> event) {
+  client_interface_->mlme_event_timeline_.Add(
+      {GetBootTimeMs(), MlmeEventType::kRoam, event->GetStatusCode(), false,
+       event->GetBSSID()});
   if (event->GetStatusCode() == 0) {
     client_interface_->is_associated_ = true;
-    client_interface_->RefreshAssociateFreq();
+    client_interface_->RefreshAssociateFreq(event->GetFrequency());
     client_interface_->bssid_ = event->GetBSSID();
   } else {
     client_interface_->is_associated_ = false;
@@ -76,9 +104,12 @@ void MlmeEventHandlerImpl::OnRoam(unique_ptr<MlmeRoamEvent> event) {
 }
 
 void MlmeEventHandlerImpl::OnAssociate(unique_ptr<MlmeAssociateEvent> event) {
+  client_interface_->mlme_event_timeline_.Add(
+      {GetBootTimeMs(), MlmeEventType::kAssociate, event->GetStatusCode(),
+       event->IsTimeout(), event->GetBSSID()});
   if (!event->IsTimeout() && event->GetStatusCode() == 0) {
     client_interface_->is_associated_ = true;
-    client_interface_->RefreshAssociateFreq();
+    client_interface_->RefreshAssociateFreq(event->GetFrequency());
     client_interface_->bssid_ = event->GetBSSID();
   } else {
     if (event->IsTimeout()) {
@@ -90,11 +121,17 @@ void MlmeEventHandlerImpl::OnAssociate(unique_ptr<MlmeAssociateEvent> event) {
 }
 
 void MlmeEventHandlerImpl::OnDisconnect(unique_ptr<MlmeDisconnectEvent> event) {
+  client_interface_->mlme_event_timeline_.Add(
+      {GetBootTimeMs(), MlmeEventType::kDisconnect, 0, false,
+       event->GetBSSID()});
   client_interface_->is_associated_ = false;
   client_interface_->bssid_.clear();
 }
 
 void MlmeEventHandlerImpl::OnDisassociate(unique_ptr<MlmeDisassociateEvent> event) {
+  client_interface_->mlme_event_timeline_.Add(
+      {GetBootTimeMs(), MlmeEventType::kDisassociate, 0, false,
+       event->GetBSSID()});
   client_interface_->is_associated_ = false;
   client_interface_->bssid_.clear();
 }
@@ -108,7 +145,8 @@ ClientInterfaceImpl::ClientInterfaceImpl(
     InterfaceTool* if_tool,
     SupplicantManager* supplicant_manager,
     NetlinkUtils* netlink_utils,
-    ScanUtils* scan_utils)
+    ScanUtils* scan_utils,
+    EventLoop* event_loop)
     : wiphy_index_(wiphy_index),
       interface_name_(interface_name),
       interface_index_(interface_index),
@@ -117,10 +155,13 @@ ClientInterfaceImpl::ClientInterfaceImpl(
       supplicant_manager_(supplicant_manager),
       netlink_utils_(netlink_utils),
       scan_utils_(scan_utils),
-      offload_service_utils_(new OffloadServiceUtils()),
+      offload_service_utils_(new OffloadServiceUtils(event_loop)),
       mlme_event_handler_(new MlmeEventHandlerImpl(this)),
       binder_(new ClientInterfaceBinder(this)),
-      is_associated_(false) {
+      is_associated_(false),
+      associate_freq_(0),
+      link_stats_sampler_(netlink_utils, interface_index,
+                          GetLinkStatsSamplingPeriodMs()) {
   netlink_utils_->SubscribeMlmeEvent(
       interface_index_,
       mlme_event_handler_.get());
@@ -139,7 +180,8 @@ ClientInterfaceImpl::ClientInterfaceImpl(
                              this,
                              netlink_utils_,
                              scan_utils_,
-                             offload_service_utils_);
+                             offload_service_utils_,
+                             event_loop);
 }
 
 ClientInterfaceImpl::~ClientInterfaceImpl() {
@@ -174,6 +216,148 @@ void ClientInterfaceImpl::Dump(std::stringstream* ss) const {
       << wiphy_features_.supports_random_mac_oneshot_scan << endl;
   *ss << "Device supports random MAC for scheduled scan: "
       << wiphy_features_.supports_random_mac_sched_scan << endl;
+  *ss << "Device supports flushing BSS cache on scan: "
+      << wiphy_features_.supports_scan_flush << endl;
+  ScanResultDumpStats dump_stats =
+      scan_utils_->GetScanResultDumpStats(interface_index_);
+  *ss << "Number of scan result dumps: " << dump_stats.num_dumps << endl;
+  *ss << "BSSs in last / largest scan result dump: "
+      << dump_stats.last_num_bss << " / " << dump_stats.max_num_bss << endl;
+  *ss << "Bytes in last / largest scan result dump: "
+      << dump_stats.last_num_bytes << " / " << dump_stats.max_num_bytes
+      << endl;
+  *ss << "Stale BSSs dropped from scan result dumps: "
+      << dump_stats.total_num_stale_bss << " of "
+      << dump_stats.total_num_bss << endl;
+  *ss << "BSSs kept without a boot time stamp (age unknown): "
+      << dump_stats.total_num_unknown_age_bss << endl;
+  *ss << "Hidden network coverage (requested / probed / deferred):" << endl;
+  for (const auto& it : scanner_->GetHiddenNetworkCoverageStats()) {
+    *ss << "  " << string(it.first.begin(), it.first.end()) << ": "
+        << it.second.num_requested << " / " << it.second.num_probed << " / "
+        << it.second.num_deferred << endl;
+  }
+  *ss << "Scan queueing by priority (started / expired / pre-empted, "
+      << "average / max queueing ms):" << endl;
+  for (const auto& it : scanner_->GetScanArbitrationStats()) {
+    const ScanArbitrationStats& stats = it.second;
+    *ss << "  " << it.first << ": " << stats.num_started << " / "
+        << stats.num_expired << " / " << stats.num_preempted << ", "
+        << (stats.num_started == 0
+                ? 0 : stats.total_queueing_ms / stats.num_started)
+        << " / " << stats.max_queueing_ms << endl;
+  }
+  const OffloadReconnectStats reconnect_stats =
+      scanner_->GetOffloadReconnectStats();
+  *ss << "Offload HAL deaths / reconnect attempts / reconnects / "
+      << "restore failures: " << reconnect_stats.num_service_deaths << " / "
+      << reconnect_stats.num_reconnect_attempts << " / "
+      << reconnect_stats.num_reconnects << " / "
+      << reconnect_stats.num_restore_failures << endl;
+  const PnoOffloadStats& pno_offload_stats = scanner_->GetPnoOffloadStats();
+  *ss << "Pno scans moved to netlink / back to Offload HAL: "
+      << pno_offload_stats.num_fallbacks << " / "
+      << pno_offload_stats.num_restores << endl;
+  *ss << "Pno scans split between Offload HAL and netlink: "
+      << pno_offload_stats.num_hybrid_starts << " (network found events merged: "
+      << pno_offload_stats.num_merged_matches << ")" << endl;
+  const PnoUpdateStats& pno_update_stats = scanner_->GetPnoUpdateStats();
+  *ss << "Pno scan updates / unchanged / scheduled scans kept: "
+      << pno_update_stats.num_updates << " / "
+      << pno_update_stats.num_unchanged_updates << " / "
+      << pno_update_stats.num_sched_scans_kept << endl;
+  *ss << "Pno scan rotations of left out networks: "
+      << pno_update_stats.num_rotations << endl;
+  const OffloadSubscriptionStats subscription_stats =
+      scanner_->GetOffloadSubscriptionStats();
+  *ss << "Offload HAL subscriptions / in place updates / result reports: "
+      << subscription_stats.num_subscriptions << " / "
+      << subscription_stats.num_in_place_updates << " / "
+      << subscription_stats.num_result_reports << ", current delay "
+      << subscription_stats.current_delay_ms << " ms, first report after "
+      << "average / max ms: "
+      << (subscription_stats.num_first_reports == 0
+              ? 0
+              : subscription_stats.total_first_report_latency_ms /
+                    subscription_stats.num_first_reports)
+      << " / " << subscription_stats.max_first_report_latency_ms << endl;
+  const HidlCallStats& hidl_call_stats = scanner_->GetOffloadHidlCallStats();
+  *ss << "Offload HAL calls (calls / transport failures / calls over "
+      << hidl_call_stats.GetDeadlineMs() << " ms, average / max us, "
+      << "latency):" << endl;
+  for (const auto& it : hidl_call_stats.GetMethodStats()) {
+    const HidlMethodStats& stats = it.second;
+    *ss << "  " << it.first << ": " << stats.latency.GetCount() << " / "
+        << stats.num_transport_failures << " / " << stats.num_slow_calls
+        << ", " << stats.latency.GetAverageUs() << " / "
+        << stats.latency.GetMaxUs() << ", " << stats.latency.ToString()
+        << endl;
+  }
+  vector<NativeScanStats> offload_scan_stats;
+  scanner_->getOffloadScanStatsHistory(&offload_scan_stats);
+  *ss << "Offload HAL scan stats (boot time s: scans per hour, channels per "
+      << "scan, duty cycle %, serviced %):" << endl;
+  for (const NativeScanStats& stats : offload_scan_stats) {
+    *ss << "  " << stats.time_stamp_ << ": " << stats.GetScansPerHour()
+        << ", " << stats.GetChannelsPerScan() << ", "
+        << stats.GetDutyCycle() * 100 << ", "
+        << stats.GetServicedRatio() * 100 << endl;
+  }
+  const MlmeEventStats mlme_event_stats = GetMlmeEventStats();
+  *ss << "Connect attempts / failures, roams, disconnects: "
+      << mlme_event_stats.num_connect_attempts_ << " / "
+      << mlme_event_stats.num_connect_failures_ << ", "
+      << mlme_event_stats.num_roams_ << ", "
+      << mlme_event_stats.num_disconnects_ << endl;
+  const OutageHistogram& reconnect_outage =
+      mlme_event_timeline_.GetReconnectOutage();
+  *ss << "Reconnect outage after loss or failure (count, average / max ms): "
+      << reconnect_outage.GetCount() << ", "
+      << reconnect_outage.GetAverageMs() << " / "
+      << reconnect_outage.GetMaxMs() << ", "
+      << reconnect_outage.ToString() << endl;
+  const OutageHistogram& roam_interruption =
+      mlme_event_timeline_.GetRoamInterruption();
+  *ss << "Roam interruption (count, average / max ms): "
+      << roam_interruption.GetCount() << ", "
+      << roam_interruption.GetAverageMs() << " / "
+      << roam_interruption.GetMaxMs() << ", "
+      << roam_interruption.ToString() << endl;
+  *ss << "MLME events (boot time ms: event, status, bssid):" << endl;
+  for (const MlmeEventRecord& event : mlme_event_timeline_.GetEvents()) {
+    *ss << "  " << event.time_ms << ": " << GetMlmeEventTypeName(event.type)
+        << ", ";
+    if (event.is_timeout) {
+      *ss << "timeout";
+    } else {
+      *ss << event.status_code;
+    }
+    *ss << ", " << LoggingUtils::GetMacString(event.bssid) << endl;
+  }
+  *ss << "Link stats requests / kernel queries: "
+      << link_stats_sampler_.GetNumRequests() << " / "
+      << link_stats_sampler_.GetNumKernelQueries() << " (sampling period "
+      << link_stats_sampler_.GetSamplingPeriodMs() << " ms)" << endl;
+  *ss << "Link stats samples (boot time ms: bssid, rssi / average dBm, "
+      << "tx / rx Mbps mcs nss MHz, tx packets / retries / failures, "
+      << "rx packets, tx / rx bytes, beacons lost):" << endl;
+  for (const LinkStatsSample& sample : link_stats_sampler_.GetSamples()) {
+    const StationInfo& info = sample.station_info;
+    *ss << "  " << sample.time_ms << ": "
+        << LoggingUtils::GetMacString(sample.bssid) << ", "
+        << static_cast<int>(info.current_rssi) << " / "
+        << static_cast<int>(info.signal_avg) << ", "
+        << info.tx_rate.bitrate / 10 << " " << info.tx_rate.mcs << " "
+        << static_cast<int>(info.tx_rate.nss) << " "
+        << info.tx_rate.width_mhz << " / "
+        << info.rx_rate.bitrate / 10 << " " << info.rx_rate.mcs << " "
+        << static_cast<int>(info.rx_rate.nss) << " "
+        << info.rx_rate.width_mhz << ", "
+        << info.station_tx_packets << " / " << info.tx_retries << " / "
+        << info.station_tx_failed << ", " << info.rx_packets << ", "
+        << info.tx_bytes << " / " << info.rx_bytes << ", "
+        << info.beacon_loss << endl;
+  }
   *ss << "------- Dump End -------" << endl;
 }
 
@@ -187,9 +371,8 @@ bool ClientInterfaceImpl::DisableSupplicant() {
 
 bool ClientInterfaceImpl::GetPacketCounters(vector<int32_t>* out_packet_counters) {
   StationInfo station_info;
-  if (!netlink_utils_->GetStationInfo(interface_index_,
-                                      bssid_,
-                                      &station_info)) {
+  if (!link_stats_sampler_.GetStationInfo(bssid_, GetBootTimeMs(),
+                                          &station_info)) {
     return false;
   }
   out_packet_counters->push_back(station_info.station_tx_packets);
@@ -205,9 +388,8 @@ bool ClientInterfaceImpl::SignalPoll(vector<int32_t>* out_signal_poll_results) {
   }
 
   StationInfo station_info;
-  if (!netlink_utils_->GetStationInfo(interface_index_,
-                                      bssid_,
-                                      &station_info)) {
+  if (!link_stats_sampler_.GetStationInfo(bssid_, GetBootTimeMs(),
+                                          &station_info)) {
     return false;
   }
   out_signal_poll_results->push_back(
@@ -233,9 +415,18 @@ bool ClientInterfaceImpl::requestANQP(
   return true;
 }
 
-bool ClientInterfaceImpl::RefreshAssociateFreq() {
-  // wpa_supplicant fetches associate frequency using the latest scan result.
-  // We should follow the same method here before we find a better solution.
+bool ClientInterfaceImpl::RefreshAssociateFreq(uint32_t event_frequency) {
+  if (event_frequency != 0) {
+    associate_freq_ = event_frequency;
+    return true;
+  }
+  if (netlink_utils_->GetInterfaceFrequency(interface_index_,
+                                            &associate_freq_)) {
+    return true;
+  }
+  // Some drivers don't report the channel of the interface. Fall back to
+  // the way wpa_supplicant finds it, which costs a full scan result dump.
+  LOG(WARNING) << "Looking up association frequency in scan results";
   std::vector<NativeScanResult> scan_results;
   if (!scan_utils_->GetScanResult(interface_index_, &scan_results)) {
     return false;
@@ -243,6 +434,7 @@ bool ClientInterfaceImpl::RefreshAssociateFreq() {
   for (auto& scan_result : scan_results) {
     if (scan_result.associated) {
       associate_freq_ = scan_result.frequency;
+      return true;
     }
   }
   return false;
@@ -252,5 +444,9 @@ bool ClientInterfaceImpl::IsAssociated() const {
   return is_associated_;
 }
 
+MlmeEventStats ClientInterfaceImpl::GetMlmeEventStats() const {
+  return mlme_event_timeline_.GetStats();
+}
+
 }  // namespace wificond
 }  // namespace android
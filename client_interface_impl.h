@@ -25,6 +25,9 @@
 #include <wifi_system/supplicant_manager.h>
 
 #include "android/net/wifi/IClientInterface.h"
+#include "wificond/link_stats_sampler.h"
+#include "wificond/mlme_event_stats.h"
+#include "wificond/mlme_event_timeline.h"
 #include "wificond/net/mlme_event_handler.h"
 #include "wificond/net/netlink_utils.h"
 #include "wificond/scanning/offload/offload_service_utils.h"
@@ -35,6 +38,7 @@ namespace wificond {
 
 class ClientInterfaceBinder;
 class ClientInterfaceImpl;
+class EventLoop;
 class ScanUtils;
 
 class MlmeEventHandlerImpl : public MlmeEventHandler {
@@ -67,7 +71,8 @@ class ClientInterfaceImpl {
       android::wifi_system::InterfaceTool* if_tool,
       android::wifi_system::SupplicantManager* supplicant_manager,
       NetlinkUtils* netlink_utils,
-      ScanUtils* scan_utils);
+      ScanUtils* scan_utils,
+      EventLoop* event_loop);
   virtual ~ClientInterfaceImpl();
 
   // Get a pointer to the binder representing this ClientInterfaceImpl.
@@ -84,10 +89,16 @@ class ClientInterfaceImpl {
       const ::std::vector<uint8_t>& bssid,
       const ::android::sp<::android::net::wifi::IANQPDoneCallback>& callback);
   virtual bool IsAssociated() const;
+  // Returns the connection statistics computed from the MLME events of this
+  // interface.
+  ::com::android::server::wifi::wificond::MlmeEventStats GetMlmeEventStats()
+      const;
   void Dump(std::stringstream* ss) const;
 
  private:
-  bool RefreshAssociateFreq();
+  // Updates |associate_freq_| after an association. |event_frequency| is
+  // the frequency carried by the MLME event, or 0 if it carried none.
+  bool RefreshAssociateFreq(uint32_t event_frequency);
 
   const uint32_t wiphy_index_;
   const std::string interface_name_;
@@ -106,6 +117,8 @@ class ClientInterfaceImpl {
   bool is_associated_;
   std::vector<uint8_t> bssid_;
   uint32_t associate_freq_;
+  MlmeEventTimeline mlme_event_timeline_;
+  LinkStatsSampler link_stats_sampler_;
 
   // Capability information for this wiphy/interface.
   BandInfo band_info_;
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/latency_histogram.h"
+
+#include <sstream>
+
+using std::string;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+constexpr int64_t kBucketUpperBoundsUs[LatencyHistogram::kNumBuckets - 1] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000,
+    500000, 1000000};
+
+constexpr const char* kBucketLabels[LatencyHistogram::kNumBuckets] = {
+    "<100us", "<250us", "<500us", "<1ms", "<2.5ms", "<5ms", "<10ms",
+    "<25ms", "<50ms", "<100ms", "<250ms", "<500ms", "<1s", ">=1s"};
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram()
+    : count_(0),
+      total_us_(0),
+      max_us_(0) {
+  bucket_counts_.fill(0);
+}
+
+void LatencyHistogram::Add(int64_t latency_us) {
+  size_t index = 0;
+  while (index < kNumBuckets - 1 &&
+         latency_us >= kBucketUpperBoundsUs[index]) {
+    index++;
+  }
+  bucket_counts_[index]++;
+  count_++;
+  total_us_ += latency_us;
+  if (latency_us > max_us_) {
+    max_us_ = latency_us;
+  }
+}
+
+int64_t LatencyHistogram::GetAverageUs() const {
+  if (count_ == 0) {
+    return 0;
+  }
+  return total_us_ / count_;
+}
+
+int64_t LatencyHistogram::GetBucketUpperBoundUs(size_t index) {
+  if (index >= kNumBuckets - 1) {
+    return -1;
+  }
+  return kBucketUpperBoundsUs[index];
+}
+
+string LatencyHistogram::ToString() const {
+  std::stringstream ss;
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    if (bucket_counts_[i] == 0) {
+      continue;
+    }
+    if (ss.tellp() > 0) {
+      ss << " ";
+    }
+    ss << kBucketLabels[i] << ":" << bucket_counts_[i];
+  }
+  return ss.str();
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_LATENCY_HISTOGRAM_H_
+#define WIFICOND_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <string>
+
+namespace android {
+namespace wificond {
+
+// Counts latencies in buckets growing in a 1-2.5-5 sequence, from 100 us to
+// 1 s. This keeps the distribution of a latency in constant memory.
+class LatencyHistogram {
+ public:
+  // Number of buckets. The last one counts every latency of 1 s or more.
+  static constexpr size_t kNumBuckets = 14;
+
+  LatencyHistogram();
+
+  void Add(int64_t latency_us);
+
+  uint32_t GetCount() const { return count_; }
+  int64_t GetMaxUs() const { return max_us_; }
+  // Returns 0 if no latency was added.
+  int64_t GetAverageUs() const;
+  const std::array<uint32_t, kNumBuckets>& GetBucketCounts() const {
+    return bucket_counts_;
+  }
+  // Returns the exclusive upper bound of bucket |index|, or -1 for the last
+  // bucket, which has none.
+  static int64_t GetBucketUpperBoundUs(size_t index);
+
+  // Returns the non-empty buckets, e.g. "<250us:3 <1ms:1 >=1s:1".
+  std::string ToString() const;
+
+ private:
+  std::array<uint32_t, kNumBuckets> bucket_counts_;
+  uint32_t count_;
+  int64_t total_us_;
+  int64_t max_us_;
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_LATENCY_HISTOGRAM_H_
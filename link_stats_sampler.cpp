@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/link_stats_sampler.h"
+
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+const size_t LinkStatsSampler::kMaxSamples = 16;
+
+LinkStatsSampler::LinkStatsSampler(NetlinkUtils* netlink_utils,
+                                   uint32_t interface_index,
+                                   int64_t sampling_period_ms)
+    : netlink_utils_(netlink_utils),
+      interface_index_(interface_index),
+      sampling_period_ms_(sampling_period_ms),
+      num_requests_(0),
+      num_kernel_queries_(0) {
+}
+
+bool LinkStatsSampler::GetStationInfo(const vector<uint8_t>& bssid,
+                                      int64_t now_ms,
+                                      StationInfo* out_station_info) {
+  num_requests_++;
+  if (samples_.empty() || samples_.back().bssid != bssid ||
+      now_ms - samples_.back().time_ms >= sampling_period_ms_ ||
+      now_ms < samples_.back().time_ms) {
+    if (!Sample(bssid, now_ms)) {
+      return false;
+    }
+  }
+  *out_station_info = samples_.back().station_info;
+  return true;
+}
+
+bool LinkStatsSampler::Sample(const vector<uint8_t>& bssid, int64_t now_ms) {
+  num_kernel_queries_++;
+  StationInfo station_info;
+  if (!netlink_utils_->GetStationInfo(interface_index_, bssid,
+                                      &station_info)) {
+    return false;
+  }
+  samples_.push_back({now_ms, bssid, station_info});
+  if (samples_.size() > kMaxSamples) {
+    samples_.pop_front();
+  }
+  return true;
+}
+
+}  // namespace wificond
+}  // namespace android
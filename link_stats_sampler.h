@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_LINK_STATS_SAMPLER_H_
+#define WIFICOND_LINK_STATS_SAMPLER_H_
+
+#include <deque>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "wificond/net/netlink_utils.h"
+
+namespace android {
+namespace wificond {
+
+// Station info of the AP an interface is associated with.
+struct LinkStatsSample {
+  // Boot time at which the sample was fetched.
+  int64_t time_ms;
+  std::vector<uint8_t> bssid;
+  StationInfo station_info;
+};
+
+// Fetches the station info of the associated AP for the getters of a client
+// interface, and keeps the latest samples.
+// A getter called within the sampling period of the latest sample reads it
+// instead of querying the kernel again. This collapses the queries of
+// getters polled back to back, e.g. the signal and the packet counters.
+class LinkStatsSampler {
+ public:
+  // Number of samples kept.
+  static const size_t kMaxSamples;
+
+  LinkStatsSampler(NetlinkUtils* netlink_utils,
+                   uint32_t interface_index,
+                   int64_t sampling_period_ms);
+  ~LinkStatsSampler() = default;
+
+  // Returns the station info of |bssid|, fetched at most one sampling period
+  // before |now_ms|. Fetches it from the kernel if there is no such sample.
+  // Returns false if it could not be fetched.
+  bool GetStationInfo(const std::vector<uint8_t>& bssid,
+                      int64_t now_ms,
+                      StationInfo* out_station_info);
+  // Fetches the station info of |bssid| from the kernel.
+  // Returns true on success.
+  bool Sample(const std::vector<uint8_t>& bssid, int64_t now_ms);
+
+  // Returns the latest samples, oldest first.
+  const std::deque<LinkStatsSample>& GetSamples() const { return samples_; }
+  int64_t GetSamplingPeriodMs() const { return sampling_period_ms_; }
+  // Calls to GetStationInfo().
+  uint32_t GetNumRequests() const { return num_requests_; }
+  // Queries sent to the kernel, whether they succeeded or not.
+  uint32_t GetNumKernelQueries() const { return num_kernel_queries_; }
+
+ private:
+  NetlinkUtils* const netlink_utils_;
+  const uint32_t interface_index_;
+  const int64_t sampling_period_ms_;
+  std::deque<LinkStatsSample> samples_;
+  uint32_t num_requests_;
+  uint32_t num_kernel_queries_;
+
+  DISALLOW_COPY_AND_ASSIGN(LinkStatsSampler);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_LINK_STATS_SAMPLER_H_
@@ -153,13 +153,19 @@ int main(int argc, char** argv) {
   }
   android::wificond::NetlinkUtils netlink_utils(&netlink_manager);
   android::wificond::ScanUtils scan_utils(&netlink_manager);
+  int32_t max_scan_result_age_ms =
+      property_get_int32("persist.wifi.scan_result.max_age_ms", 0);
+  if (max_scan_result_age_ms > 0) {
+    scan_utils.SetMaxScanResultAge(max_scan_result_age_ms);
+  }
 
   unique_ptr<android::wificond::Server> server(new android::wificond::Server(
       unique_ptr<InterfaceTool>(new InterfaceTool),
       unique_ptr<SupplicantManager>(new SupplicantManager()),
       unique_ptr<HostapdManager>(new HostapdManager()),
       &netlink_utils,
-      &scan_utils));
+      &scan_utils,
+      event_dispatcher.get()));
   server->CleanUpSystemState();
   RegisterServiceOrCrash(server.get());
 
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/mlme_event_stats.h"
+
+#include <android-base/logging.h>
+
+#include "wificond/parcelable_utils.h"
+
+using android::status_t;
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+MlmeEventStats::MlmeEventStats()
+    : num_connect_attempts_(0),
+      num_connect_failures_(0),
+      num_roams_(0),
+      num_disconnects_(0) {}
+
+bool MlmeEventStats::operator==(const MlmeEventStats& rhs) const {
+  return num_connect_attempts_ == rhs.num_connect_attempts_ &&
+         num_connect_failures_ == rhs.num_connect_failures_ &&
+         num_roams_ == rhs.num_roams_ &&
+         num_disconnects_ == rhs.num_disconnects_ &&
+         outage_bucket_upper_bounds_ms_ ==
+             rhs.outage_bucket_upper_bounds_ms_ &&
+         reconnect_outage_counts_ == rhs.reconnect_outage_counts_ &&
+         roam_interruption_counts_ == rhs.roam_interruption_counts_;
+}
+
+status_t MlmeEventStats::writeToParcel(::android::Parcel* parcel) const {
+  RETURN_IF_FAILED(parcel->writeUint32(num_connect_attempts_));
+  RETURN_IF_FAILED(parcel->writeUint32(num_connect_failures_));
+  RETURN_IF_FAILED(parcel->writeUint32(num_roams_));
+  RETURN_IF_FAILED(parcel->writeUint32(num_disconnects_));
+  RETURN_IF_FAILED(parcel->writeInt32Vector(outage_bucket_upper_bounds_ms_));
+  RETURN_IF_FAILED(parcel->writeInt32Vector(reconnect_outage_counts_));
+  RETURN_IF_FAILED(parcel->writeInt32Vector(roam_interruption_counts_));
+  return ::android::OK;
+}
+
+status_t MlmeEventStats::readFromParcel(const ::android::Parcel* parcel) {
+  RETURN_IF_FAILED(parcel->readUint32(&num_connect_attempts_));
+  RETURN_IF_FAILED(parcel->readUint32(&num_connect_failures_));
+  RETURN_IF_FAILED(parcel->readUint32(&num_roams_));
+  RETURN_IF_FAILED(parcel->readUint32(&num_disconnects_));
+  RETURN_IF_FAILED(parcel->readInt32Vector(&outage_bucket_upper_bounds_ms_));
+  RETURN_IF_FAILED(parcel->readInt32Vector(&reconnect_outage_counts_));
+  RETURN_IF_FAILED(parcel->readInt32Vector(&roam_interruption_counts_));
+  return ::android::OK;
+}
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_MLME_EVENT_STATS_H_
+#define WIFICOND_MLME_EVENT_STATS_H_
+
+#include <vector>
+
+#include <binder/Parcel.h>
+#include <binder/Parcelable.h>
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+// Connection statistics of a client interface, computed from its MLME
+// events. See MlmeEventTimeline.
+class MlmeEventStats : public ::android::Parcelable {
+ public:
+  MlmeEventStats();
+
+  bool operator==(const MlmeEventStats& rhs) const;
+  ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
+  ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
+
+  // Connect events, whether they succeeded or not. Each connection attempt
+  // ends with one, while associate events are only sent by some drivers.
+  uint32_t num_connect_attempts_;
+  uint32_t num_connect_failures_;
+  // Successful roam events.
+  uint32_t num_roams_;
+  // Losses of an association.
+  uint32_t num_disconnects_;
+  // Exclusive upper bound in milliseconds of each histogram bucket, or -1
+  // for the last bucket, which has none.
+  std::vector<int32_t> outage_bucket_upper_bounds_ms_;
+  // Counts of reconnect outages and roam interruptions in each bucket.
+  // Connections which succeed at the first attempt are not counted.
+  std::vector<int32_t> reconnect_outage_counts_;
+  std::vector<int32_t> roam_interruption_counts_;
+};
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
+
+#endif  // WIFICOND_MLME_EVENT_STATS_H_
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/mlme_event_timeline.h"
+
+#include <sstream>
+#include <utility>
+
+using com::android::server::wifi::wificond::MlmeEventStats;
+using std::string;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+constexpr int64_t kBucketUpperBoundsMs[OutageHistogram::kNumBuckets - 1] = {
+    50, 100, 250, 500, 1000, 2500, 5000, 10000, 20000};
+
+constexpr const char* kBucketLabels[OutageHistogram::kNumBuckets] = {
+    "<50ms", "<100ms", "<250ms", "<500ms", "<1s", "<2.5s", "<5s", "<10s",
+    "<20s", ">=20s"};
+
+}  // namespace
+
+OutageHistogram::OutageHistogram()
+    : count_(0),
+      total_ms_(0),
+      max_ms_(0) {
+  bucket_counts_.fill(0);
+}
+
+void OutageHistogram::Add(int64_t outage_ms) {
+  size_t index = 0;
+  while (index < kNumBuckets - 1 &&
+         outage_ms >= kBucketUpperBoundsMs[index]) {
+    index++;
+  }
+  bucket_counts_[index]++;
+  count_++;
+  total_ms_ += outage_ms;
+  if (outage_ms > max_ms_) {
+    max_ms_ = outage_ms;
+  }
+}
+
+int64_t OutageHistogram::GetAverageMs() const {
+  if (count_ == 0) {
+    return 0;
+  }
+  return total_ms_ / count_;
+}
+
+int64_t OutageHistogram::GetBucketUpperBoundMs(size_t index) {
+  if (index >= kNumBuckets - 1) {
+    return -1;
+  }
+  return kBucketUpperBoundsMs[index];
+}
+
+string OutageHistogram::ToString() const {
+  std::stringstream ss;
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    if (bucket_counts_[i] == 0) {
+      continue;
+    }
+    if (ss.tellp() > 0) {
+      ss << " ";
+    }
+    ss << kBucketLabels[i] << ":" << bucket_counts_[i];
+  }
+  return ss.str();
+}
+
+const size_t MlmeEventTimeline::kMaxEvents = 32;
+const int64_t MlmeEventTimeline::kMaxOutageMs = 30000;
+
+const char* GetMlmeEventTypeName(MlmeEventType type) {
+  switch (type) {
+    case MlmeEventType::kConnect:
+      return "connect";
+    case MlmeEventType::kAssociate:
+      return "associate";
+    case MlmeEventType::kRoam:
+      return "roam";
+    case MlmeEventType::kDisconnect:
+      return "disconnect";
+    case MlmeEventType::kDisassociate:
+      return "disassociate";
+  }
+  return "unknown";
+}
+
+MlmeEventTimeline::MlmeEventTimeline()
+    : num_connect_attempts_(0),
+      num_connect_failures_(0),
+      num_roams_(0),
+      num_disconnects_(0),
+      is_associated_(false),
+      outage_start_ms_(-1) {}
+
+void MlmeEventTimeline::Add(MlmeEventRecord event) {
+  bool is_loss = event.type == MlmeEventType::kDisconnect ||
+                 event.type == MlmeEventType::kDisassociate;
+  bool is_success = !is_loss && !event.is_timeout && event.status_code == 0;
+  // cfg80211 reports the result of every attempt in a connect event. On
+  // drivers with SME in the host, an associate event precedes it, which
+  // must not count as another attempt.
+  if (event.type == MlmeEventType::kConnect) {
+    num_connect_attempts_++;
+    if (!is_success) {
+      num_connect_failures_++;
+    }
+  }
+
+  if (is_success) {
+    if (event.type == MlmeEventType::kRoam) {
+      num_roams_++;
+    }
+    if (outage_start_ms_ >= 0) {
+      int64_t outage_ms = event.time_ms - outage_start_ms_;
+      bool roamed = event.type == MlmeEventType::kRoam ||
+                    (!last_bssid_.empty() && event.bssid != last_bssid_);
+      if (outage_ms <= kMaxOutageMs) {
+        OutageHistogram* histogram =
+            roamed ? &roam_interruption_ : &reconnect_outage_;
+        histogram->Add(outage_ms);
+      }
+      outage_start_ms_ = -1;
+    }
+    is_associated_ = true;
+    last_bssid_ = event.bssid;
+  } else {
+    // A disconnect event may follow a disassociate event for the same loss.
+    if (is_loss && is_associated_) {
+      num_disconnects_++;
+    }
+    if (outage_start_ms_ < 0) {
+      outage_start_ms_ = event.time_ms;
+    }
+    is_associated_ = false;
+  }
+
+  events_.push_back(std::move(event));
+  if (events_.size() > kMaxEvents) {
+    events_.pop_front();
+  }
+}
+
+MlmeEventStats MlmeEventTimeline::GetStats() const {
+  MlmeEventStats stats;
+  stats.num_connect_attempts_ = num_connect_attempts_;
+  stats.num_connect_failures_ = num_connect_failures_;
+  stats.num_roams_ = num_roams_;
+  stats.num_disconnects_ = num_disconnects_;
+  for (size_t i = 0; i < OutageHistogram::kNumBuckets; i++) {
+    stats.outage_bucket_upper_bounds_ms_.push_back(
+        static_cast<int32_t>(OutageHistogram::GetBucketUpperBoundMs(i)));
+    stats.reconnect_outage_counts_.push_back(
+        static_cast<int32_t>(reconnect_outage_.GetBucketCounts()[i]));
+    stats.roam_interruption_counts_.push_back(
+        static_cast<int32_t>(roam_interruption_.GetBucketCounts()[i]));
+  }
+  return stats;
+}
+
+}  // namespace wificond
+}  // namespace android
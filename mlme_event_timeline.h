@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_MLME_EVENT_TIMELINE_H_
+#define WIFICOND_MLME_EVENT_TIMELINE_H_
+
+#include <array>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "wificond/mlme_event_stats.h"
+
+namespace android {
+namespace wificond {
+
+enum class MlmeEventType {
+  kConnect,
+  kAssociate,
+  kRoam,
+  kDisconnect,
+  kDisassociate,
+};
+
+// Returns the name of |type|, e.g. "connect".
+const char* GetMlmeEventTypeName(MlmeEventType type);
+
+// An MLME event kept by MlmeEventTimeline.
+struct MlmeEventRecord {
+  // Boot time of the event.
+  int64_t time_ms;
+  MlmeEventType type;
+  // Status code of connect, associate and roam events. 0 = success.
+  uint16_t status_code;
+  bool is_timeout;
+  std::vector<uint8_t> bssid;
+};
+
+// Counts outages without an association in buckets from 50 ms to 20 s.
+// This keeps their distribution in constant memory.
+class OutageHistogram {
+ public:
+  // Number of buckets. The last one counts every outage of 20 s or more.
+  static constexpr size_t kNumBuckets = 10;
+
+  OutageHistogram();
+
+  void Add(int64_t outage_ms);
+
+  uint32_t GetCount() const { return count_; }
+  int64_t GetMaxMs() const { return max_ms_; }
+  // Returns 0 if no outage was added.
+  int64_t GetAverageMs() const;
+  const std::array<uint32_t, kNumBuckets>& GetBucketCounts() const {
+    return bucket_counts_;
+  }
+  // Returns the exclusive upper bound of bucket |index|, or -1 for the last
+  // bucket, which has none.
+  static int64_t GetBucketUpperBoundMs(size_t index);
+
+  // Returns the non-empty buckets, e.g. "<250ms:3 <1s:1 >=20s:1".
+  std::string ToString() const;
+
+ private:
+  std::array<uint32_t, kNumBuckets> bucket_counts_;
+  uint32_t count_;
+  int64_t total_ms_;
+  int64_t max_ms_;
+};
+
+// Keeps the latest MLME events of an interface, and measures from them how
+// long the interface goes without an association.
+// Such an outage starts when the association is lost, or when an attempt to
+// associate fails. It ends with the next successful connect, associate or
+// roam event. Outages which end on another AP are roam interruptions. The
+// other ones are reconnect outages.
+// The kernel does not report when an attempt starts, so these measure how
+// long recovering from a loss or a failure takes, not how long a connection
+// attempt takes. An attempt which succeeds right away is not measured.
+class MlmeEventTimeline {
+ public:
+  // Number of events kept.
+  static const size_t kMaxEvents;
+  // Longer outages are not measured: the interface was most likely left
+  // disconnected on purpose.
+  static const int64_t kMaxOutageMs;
+
+  MlmeEventTimeline();
+  ~MlmeEventTimeline() = default;
+
+  void Add(MlmeEventRecord event);
+
+  // Returns the latest events, oldest first.
+  const std::deque<MlmeEventRecord>& GetEvents() const { return events_; }
+  const OutageHistogram& GetReconnectOutage() const {
+    return reconnect_outage_;
+  }
+  const OutageHistogram& GetRoamInterruption() const {
+    return roam_interruption_;
+  }
+  ::com::android::server::wifi::wificond::MlmeEventStats GetStats() const;
+
+ private:
+  std::deque<MlmeEventRecord> events_;
+  OutageHistogram reconnect_outage_;
+  OutageHistogram roam_interruption_;
+  uint32_t num_connect_attempts_;
+  uint32_t num_connect_failures_;
+  uint32_t num_roams_;
+  uint32_t num_disconnects_;
+  bool is_associated_;
+  // Boot time at which the current outage started, or -1 if there is none.
+  int64_t outage_start_ms_;
+  // AP of the last association.
+  std::vector<uint8_t> last_bssid_;
+
+  DISALLOW_COPY_AND_ASSIGN(MlmeEventTimeline);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_MLME_EVENT_TIMELINE_H_
@@ -46,6 +46,15 @@ bool GetCommonFields(const NL80211Packet* packet,
   return true;
 }
 
+uint32_t GetWiphyFrequency(const NL80211Packet* packet) {
+  uint32_t frequency;
+  // Not every driver reports the channel of the new association.
+  if (!packet->GetAttributeValue(NL80211_ATTR_WIPHY_FREQ, &frequency)) {
+    return 0;
+  }
+  return frequency;
+}
+
 }  // namespace
 
 unique_ptr<MlmeAssociateEvent> MlmeAssociateEvent::InitFromPacket(
@@ -65,6 +74,7 @@ unique_ptr<MlmeAssociateEvent> MlmeAssociateEvent::InitFromPacket(
   // TODO(nywang): Parse NL80211_ATTR_FRAME 80211 management frame and get
   // status code.
   associate_event->status_code_ = 0;
+  associate_event->frequency_ = GetWiphyFrequency(packet);
   associate_event->is_timeout_ = packet->HasAttribute(NL80211_ATTR_TIMED_OUT);
 
   return associate_event;
@@ -87,6 +97,7 @@ unique_ptr<MlmeConnectEvent> MlmeConnectEvent::InitFromPacket(
     LOG(WARNING) << "Failed to get NL80211_ATTR_STATUS_CODE";
     connect_event->status_code_ = 0;
   }
+  connect_event->frequency_ = GetWiphyFrequency(packet);
   connect_event->is_timeout_ = packet->HasAttribute(NL80211_ATTR_TIMED_OUT);
 
   return connect_event;
@@ -109,6 +120,7 @@ unique_ptr<MlmeRoamEvent> MlmeRoamEvent::InitFromPacket(
     LOG(WARNING) << "Failed to get NL80211_ATTR_STATUS_CODE";
     roam_event->status_code_ = 0;
   }
+  roam_event->frequency_ = GetWiphyFrequency(packet);
 
   return roam_event;
 }
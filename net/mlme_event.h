@@ -38,6 +38,9 @@ class MlmeConnectEvent {
   // Status codes definition: IEEE 802.11-2012, 8.4.1.9, Table 8-37
   uint16_t GetStatusCode() const { return status_code_; }
   uint32_t GetInterfaceIndex() const { return interface_index_; }
+  // Returns the frequency of the associated AP in MHz, or 0 if the event
+  // doesn't carry NL80211_ATTR_WIPHY_FREQ.
+  uint32_t GetFrequency() const { return frequency_; }
   bool IsTimeout() const { return is_timeout_; }
 
  private:
@@ -46,6 +49,7 @@ class MlmeConnectEvent {
   uint32_t interface_index_;
   std::vector<uint8_t> bssid_;
   uint16_t status_code_;
+  uint32_t frequency_;
   bool is_timeout_;
 
   DISALLOW_COPY_AND_ASSIGN(MlmeConnectEvent);
@@ -62,6 +66,9 @@ class MlmeAssociateEvent {
   // Status codes definition: IEEE 802.11-2012, 8.4.1.9, Table 8-37
   uint16_t GetStatusCode() const { return status_code_; }
   uint32_t GetInterfaceIndex() const { return interface_index_; }
+  // Returns the frequency of the associated AP in MHz, or 0 if the event
+  // doesn't carry NL80211_ATTR_WIPHY_FREQ.
+  uint32_t GetFrequency() const { return frequency_; }
   bool IsTimeout() const { return is_timeout_; }
 
  private:
@@ -70,6 +77,7 @@ class MlmeAssociateEvent {
   uint32_t interface_index_;
   std::vector<uint8_t> bssid_;
   uint16_t status_code_;
+  uint32_t frequency_;
   bool is_timeout_;
 
   DISALLOW_COPY_AND_ASSIGN(MlmeAssociateEvent);
@@ -86,6 +94,9 @@ class MlmeRoamEvent {
   // Status codes definition: IEEE 802.11-2012, 8.4.1.9, Table 8-37
   uint16_t GetStatusCode() const { return status_code_; }
   uint32_t GetInterfaceIndex() const { return interface_index_; }
+  // Returns the frequency of the associated AP in MHz, or 0 if the event
+  // doesn't carry NL80211_ATTR_WIPHY_FREQ.
+  uint32_t GetFrequency() const { return frequency_; }
 
  private:
   MlmeRoamEvent() = default;
@@ -93,6 +104,7 @@ class MlmeRoamEvent {
   uint32_t interface_index_;
   std::vector<uint8_t> bssid_;
   uint16_t status_code_;
+  uint32_t frequency_;
 
   DISALLOW_COPY_AND_ASSIGN(MlmeRoamEvent);
 };
@@ -102,6 +114,9 @@ class MlmeDisconnectEvent {
  public:
   static std::unique_ptr<MlmeDisconnectEvent> InitFromPacket(
       const NL80211Packet* packet);
+  // Returns the BSSID of the AP the interface was associated with, or an
+  // empty vector if the event does not carry it.
+  const std::vector<uint8_t>& GetBSSID() const { return bssid_; }
   uint32_t GetInterfaceIndex() const { return interface_index_; }
  private:
   MlmeDisconnectEvent() = default;
@@ -116,6 +131,9 @@ class MlmeDisassociateEvent {
  public:
   static std::unique_ptr<MlmeDisassociateEvent> InitFromPacket(
       const NL80211Packet* packet);
+  // Returns the BSSID of the AP the interface was associated with, or an
+  // empty vector if the event does not carry it.
+  const std::vector<uint8_t>& GetBSSID() const { return bssid_; }
   uint32_t GetInterfaceIndex() const { return interface_index_; }
  private:
   MlmeDisassociateEvent() = default;
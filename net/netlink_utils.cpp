@@ -39,7 +39,78 @@ namespace {
 uint32_t k2GHzFrequencyLowerBound = 2400;
 uint32_t k2GHzFrequencyUpperBound = 2500;
 
+bool IsExtFeatureFlagSet(
+    const std::vector<uint8_t>& ext_feature_flags_bytes,
+    enum nl80211_ext_feature_index ext_feature_flag) {
+  // NL80211_ATTR_EXT_FEATURES is a bitmap with bit N of byte N / 8 set if
+  // extended feature N is supported. Drivers built against an older nl80211
+  // send a shorter bitmap, in which case the missing flags are unset.
+  size_t ext_feature_flag_idx = static_cast<size_t>(ext_feature_flag);
+  size_t ext_feature_flag_byte_pos = ext_feature_flag_idx / 8;
+  size_t ext_feature_flag_bit_pos = ext_feature_flag_idx % 8;
+  if (ext_feature_flag_byte_pos >= ext_feature_flags_bytes.size()) {
+    return false;
+  }
+  uint8_t ext_feature_flag_byte =
+      ext_feature_flags_bytes[ext_feature_flag_byte_pos];
+  return (ext_feature_flag_byte & (1U << ext_feature_flag_bit_pos));
+}
+
+void ParseRateInfo(const NL80211NestedAttr& rate_attr,
+                   StationRateInfo* out_rate_info) {
+  uint32_t bitrate32;
+  uint16_t bitrate16;
+  if (rate_attr.GetAttributeValue(NL80211_RATE_INFO_BITRATE32, &bitrate32)) {
+    out_rate_info->bitrate = bitrate32;
+  } else if (rate_attr.GetAttributeValue(NL80211_RATE_INFO_BITRATE,
+                                         &bitrate16)) {
+    out_rate_info->bitrate = bitrate16;
+  }
+  uint8_t mcs;
+  if (rate_attr.GetAttributeValue(NL80211_RATE_INFO_VHT_MCS, &mcs) ||
+      rate_attr.GetAttributeValue(NL80211_RATE_INFO_MCS, &mcs)) {
+    out_rate_info->mcs = mcs;
+  }
+  rate_attr.GetAttributeValue(NL80211_RATE_INFO_VHT_NSS, &out_rate_info->nss);
+  if (rate_attr.HasAttribute(NL80211_RATE_INFO_160_MHZ_WIDTH) ||
+      rate_attr.HasAttribute(NL80211_RATE_INFO_80P80_MHZ_WIDTH)) {
+    out_rate_info->width_mhz = 160;
+  } else if (rate_attr.HasAttribute(NL80211_RATE_INFO_80_MHZ_WIDTH)) {
+    out_rate_info->width_mhz = 80;
+  } else if (rate_attr.HasAttribute(NL80211_RATE_INFO_40_MHZ_WIDTH)) {
+    out_rate_info->width_mhz = 40;
+  }
+}
+
 }  // namespace
+
+WiphyFeatures::WiphyFeatures(uint32_t feature_flags,
+                             const std::vector<uint8_t>& ext_feature_flags_bytes)
+    : supports_random_mac_oneshot_scan(
+          feature_flags & NL80211_FEATURE_SCAN_RANDOM_MAC_ADDR),
+      supports_random_mac_sched_scan(
+          feature_flags & NL80211_FEATURE_SCHED_SCAN_RANDOM_MAC_ADDR),
+      supports_scan_flush(feature_flags & NL80211_FEATURE_SCAN_FLUSH) {
+  supports_low_span_oneshot_scan =
+      IsExtFeatureFlagSet(ext_feature_flags_bytes,
+                          NL80211_EXT_FEATURE_LOW_SPAN_SCAN);
+  supports_low_power_oneshot_scan =
+      IsExtFeatureFlagSet(ext_feature_flags_bytes,
+                          NL80211_EXT_FEATURE_LOW_POWER_SCAN);
+  supports_high_accuracy_oneshot_scan =
+      IsExtFeatureFlagSet(ext_feature_flags_bytes,
+                          NL80211_EXT_FEATURE_HIGH_ACCURACY_SCAN);
+  supports_scan_dwell =
+      IsExtFeatureFlagSet(ext_feature_flags_bytes,
+                          NL80211_EXT_FEATURE_SET_SCAN_DWELL);
+  supports_sched_scan_band_specific_rssi = IsExtFeatureFlagSet(
+      ext_feature_flags_bytes,
+      NL80211_EXT_FEATURE_SCHED_SCAN_BAND_SPECIFIC_RSSI_THOLD);
+  supports_sched_scan_relative_rssi =
+      IsExtFeatureFlagSet(ext_feature_flags_bytes,
+                          NL80211_EXT_FEATURE_SCHED_SCAN_RELATIVE_RSSI);
+}
+
 NetlinkUtils::NetlinkUtils(NetlinkManager* netlink_manager)
     : netlink_manager_(netlink_manager) {
   if (!netlink_manager_->IsStarted()) {
@@ -205,6 +276,35 @@ bool NetlinkUtils::GetInterfaces(uint32_t wiphy_index,
   return true;
 }
 
+bool NetlinkUtils::GetInterfaceFrequency(uint32_t interface_index,
+                                         uint32_t* out_frequency) {
+  NL80211Packet get_interface(
+      netlink_manager_->GetFamilyId(),
+      NL80211_CMD_GET_INTERFACE,
+      netlink_manager_->GetSequenceNumber(),
+      getpid());
+  get_interface.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_ATTR_IFINDEX, interface_index));
+
+  unique_ptr<const NL80211Packet> response;
+  if (!netlink_manager_->SendMessageAndGetSingleResponse(get_interface,
+                                                         &response)) {
+    LOG(ERROR) << "NL80211_CMD_GET_INTERFACE failed";
+    return false;
+  }
+  if (response->GetCommand() != NL80211_CMD_NEW_INTERFACE) {
+    LOG(ERROR) << "Wrong command in response to a get interface request: "
+               << static_cast<int>(response->GetCommand());
+    return false;
+  }
+  if (!response->GetAttributeValue(NL80211_ATTR_WIPHY_FREQ, out_frequency)) {
+    LOG(DEBUG) << "Interface with index " << interface_index
+               << " has no channel";
+    return false;
+  }
+  return true;
+}
+
 bool NetlinkUtils::SetInterfaceMode(uint32_t interface_index,
                                     InterfaceMode mode) {
   uint32_t set_to_mode = NL80211_IFTYPE_UNSPECIFIED;
@@ -268,7 +368,12 @@ bool NetlinkUtils::GetWiphyInfo(
     LOG(ERROR) << "Failed to get NL80211_ATTR_FEATURE_FLAGS";
     return false;
   }
-  *out_wiphy_features = WiphyFeatures(feature_flags);
+  vector<uint8_t> ext_feature_flags_bytes;
+  if (!response->GetAttributeValue(NL80211_ATTR_EXT_FEATURES,
+                                   &ext_feature_flags_bytes)) {
+    LOG(WARNING) << "Failed to get NL80211_ATTR_EXT_FEATURES";
+  }
+  *out_wiphy_features = WiphyFeatures(feature_flags, ext_feature_flags_bytes);
   return true;
 }
 
@@ -436,6 +541,35 @@ bool NetlinkUtils::GetStationInfo(uint32_t interface_index,
   }
 
   *out_station_info = StationInfo(tx_good, tx_bad, tx_bitrate, current_rssi);
+  ParseRateInfo(tx_bitrate_attr, &out_station_info->tx_rate);
+
+  // Optional fields.
+  uint64_t bytes64;
+  uint32_t bytes32;
+  if (sta_info.GetAttributeValue(NL80211_STA_INFO_RX_BYTES64, &bytes64)) {
+    out_station_info->rx_bytes = bytes64;
+  } else if (sta_info.GetAttributeValue(NL80211_STA_INFO_RX_BYTES, &bytes32)) {
+    out_station_info->rx_bytes = bytes32;
+  }
+  if (sta_info.GetAttributeValue(NL80211_STA_INFO_TX_BYTES64, &bytes64)) {
+    out_station_info->tx_bytes = bytes64;
+  } else if (sta_info.GetAttributeValue(NL80211_STA_INFO_TX_BYTES, &bytes32)) {
+    out_station_info->tx_bytes = bytes32;
+  }
+  sta_info.GetAttributeValue(NL80211_STA_INFO_RX_PACKETS,
+                             &out_station_info->rx_packets);
+  sta_info.GetAttributeValue(NL80211_STA_INFO_TX_RETRIES,
+                             &out_station_info->tx_retries);
+  sta_info.GetAttributeValue(NL80211_STA_INFO_BEACON_LOSS,
+                             &out_station_info->beacon_loss);
+  uint8_t signal_avg;
+  if (sta_info.GetAttributeValue(NL80211_STA_INFO_SIGNAL_AVG, &signal_avg)) {
+    out_station_info->signal_avg = static_cast<int8_t>(signal_avg);
+  }
+  NL80211NestedAttr rx_bitrate_attr(0);
+  if (sta_info.GetAttribute(NL80211_STA_INFO_RX_BITRATE, &rx_bitrate_attr)) {
+    ParseRateInfo(rx_bitrate_attr, &out_station_info->rx_rate);
+  }
   return true;
 }
 
@@ -94,22 +94,71 @@ struct ScanCapabilities {
 struct WiphyFeatures {
   WiphyFeatures()
       : supports_random_mac_oneshot_scan(false),
-        supports_random_mac_sched_scan(false) {}
+        supports_random_mac_sched_scan(false),
+        supports_scan_flush(false),
+        supports_low_span_oneshot_scan(false),
+        supports_low_power_oneshot_scan(false),
+        supports_high_accuracy_oneshot_scan(false),
+        supports_scan_dwell(false),
+        supports_sched_scan_band_specific_rssi(false),
+        supports_sched_scan_relative_rssi(false) {}
   WiphyFeatures(uint32_t feature_flags)
       : supports_random_mac_oneshot_scan(
             feature_flags & NL80211_FEATURE_SCAN_RANDOM_MAC_ADDR),
         supports_random_mac_sched_scan(
-            feature_flags & NL80211_FEATURE_SCHED_SCAN_RANDOM_MAC_ADDR) {}
+            feature_flags & NL80211_FEATURE_SCHED_SCAN_RANDOM_MAC_ADDR),
+        supports_scan_flush(feature_flags & NL80211_FEATURE_SCAN_FLUSH),
+        supports_low_span_oneshot_scan(false),
+        supports_low_power_oneshot_scan(false),
+        supports_high_accuracy_oneshot_scan(false),
+        supports_scan_dwell(false),
+        supports_sched_scan_band_specific_rssi(false),
+        supports_sched_scan_relative_rssi(false) {}
+  // |ext_feature_flags_bytes| is the bitmap carried by
+  // NL80211_ATTR_EXT_FEATURES.
+  WiphyFeatures(uint32_t feature_flags,
+                const std::vector<uint8_t>& ext_feature_flags_bytes);
   // This device/driver supports using a random MAC address during scan
   // (while not associated).
   bool supports_random_mac_oneshot_scan;
   // This device/driver supports using a random MAC address for every
   // scan iteration during scheduled scan (while not associated).
   bool supports_random_mac_sched_scan;
+  // This device/driver supports flushing its BSS cache on a successful
+  // scan.
+  bool supports_scan_flush;
+  // This device/driver supports performing low-span/low-latency one-shot
+  // scans.
+  bool supports_low_span_oneshot_scan;
+  // This device/driver supports performing low-power one-shot scans.
+  bool supports_low_power_oneshot_scan;
+  // This device/driver supports performing high-accuracy one-shot scans.
+  bool supports_high_accuracy_oneshot_scan;
+  // This device/driver supports setting the dwell time of a scan with
+  // NL80211_ATTR_MEASUREMENT_DURATION.
+  bool supports_scan_dwell;
+  // This device/driver supports 2.4GHz and 5GHz specific RSSI thresholds
+  // in scheduled scan match sets.
+  bool supports_sched_scan_band_specific_rssi;
+  // This device/driver supports reporting only BSSs better than the
+  // connected one in scheduled scans.
+  bool supports_sched_scan_relative_rssi;
   // There are other flags included in NL80211_ATTR_FEATURE_FLAGS.
   // We will add them once we find them useful.
 };
 
+// Rate of the frames sent to or received from a station.
+struct StationRateInfo {
+  // Bit rate in 100kbit/s.
+  uint32_t bitrate{0};
+  // MCS index of HT or VHT rates, or -1 for legacy rates.
+  int32_t mcs{-1};
+  // Number of spatial streams of VHT rates, or 0 if not reported.
+  uint8_t nss{0};
+  // Channel width in MHz.
+  uint32_t width_mhz{20};
+};
+
 struct StationInfo {
   StationInfo() = default;
   StationInfo(uint32_t station_tx_packets_,
@@ -128,8 +177,18 @@ struct StationInfo {
   uint32_t station_tx_bitrate;
   // Current signal strength.
   int8_t current_rssi;
-  // There are many other counters/parameters included in station info.
-  // We will add them once we find them useful.
+  // The fields below are left as is when the driver does not report them.
+  uint64_t rx_bytes{0};
+  uint64_t tx_bytes{0};
+  uint32_t rx_packets{0};
+  // Number of retransmitted packets.
+  uint32_t tx_retries{0};
+  // Number of beacons missed since the association.
+  uint32_t beacon_loss{0};
+  // Average signal strength.
+  int8_t signal_avg{0};
+  StationRateInfo tx_rate;
+  StationRateInfo rx_rate;
 };
 
 class MlmeEventHandler;
@@ -171,6 +230,14 @@ class NetlinkUtils {
   virtual bool GetInterfaces(uint32_t wiphy_index,
                              std::vector<InterfaceInfo>* interface_info);
 
+  // Get the frequency of the channel interface |interface_index| operates
+  // on, using a single NL80211_CMD_GET_INTERFACE request.
+  // |*out_frequency| returns the frequency in MHz.
+  // Returns false on failure or if the interface has no channel, e.g. because
+  // it isn't associated.
+  virtual bool GetInterfaceFrequency(uint32_t interface_index,
+                                     uint32_t* out_frequency);
+
   // Set the mode of interface.
   // |interface_index| is the interface index.
   // |mode| is one of the values in |enum InterfaceMode|.
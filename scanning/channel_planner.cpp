@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "wificond/scanning/channel_planner.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
+#include <android-base/logging.h>
+
+#include "wificond/scanning/scan_result.h"
+
+using com::android::server::wifi::wificond::NativeScanResult;
+using std::map;
+using std::pair;
+using std::set;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+// Returns the center frequency of 20 MHz channel |channel|, or 0 if it is
+// not a 2.4 GHz or 5 GHz channel.
+uint32_t ChannelToFrequency(size_t channel) {
+  if (channel >= 1 && channel <= 13) {
+    return 2407 + 5 * channel;
+  }
+  if (channel == 14) {
+    return 2484;
+  }
+  if (channel >= 32 && channel <= 177) {
+    return 5000 + 5 * channel;
+  }
+  return 0;
+}
+
+}  // namespace
+
+const double ChannelPlanner::kLearningRate = 0.3;
+const double ChannelPlanner::kSavedNetworkWeight = 10.0;
+const double ChannelPlanner::kCoverageRatio = 0.8;
+const double ChannelPlanner::kPnoCoverageRatio = 0.95;
+const uint32_t ChannelPlanner::kMinPartialScanChannels = 3;
+const uint32_t ChannelPlanner::kPartialScansPerFullSweep = 3;
+
+void ChannelPlanner::SetSavedSsids(const vector<vector<uint8_t>>& ssids) {
+  saved_ssids_ = ssids;
+}
+
+vector<uint32_t> ChannelPlanner::PlanScan() const {
+  if (last_partial_scan_missed_ ||
+      partial_scans_since_full_sweep_ >= kPartialScansPerFullSweep) {
+    return {};
+  }
+  return PlanChannels(kCoverageRatio);
+}
+
+vector<uint32_t> ChannelPlanner::PlanPnoScan() {
+  if (last_partial_scan_missed_ ||
+      partial_pno_scans_since_full_sweep_ >= kPartialScansPerFullSweep) {
+    partial_pno_scans_since_full_sweep_ = 0;
+    return {};
+  }
+  vector<uint32_t> freqs = PlanChannels(kPnoCoverageRatio);
+  if (!freqs.empty()) {
+    partial_pno_scans_since_full_sweep_++;
+  }
+  return freqs;
+}
+
+vector<uint32_t> ChannelPlanner::PlanChannels(double coverage_ratio) const {
+  vector<pair<double, uint32_t>> ranked_channels;
+  double total_yield = 0;
+  for (const auto& channel : channel_yield_) {
+    if (channel.second > 0) {
+      ranked_channels.emplace_back(channel.second, channel.first);
+      total_yield += channel.second;
+    }
+  }
+  // Without any history there is nothing to plan with.
+  if (ranked_channels.empty()) {
+    return {};
+  }
+  std::sort(ranked_channels.begin(), ranked_channels.end(),
+            [](const pair<double, uint32_t>& lhs,
+               const pair<double, uint32_t>& rhs) {
+              if (lhs.first != rhs.first) {
+                return lhs.first > rhs.first;
+              }
+              return lhs.second < rhs.second;
+            });
+
+  vector<uint32_t> freqs;
+  double covered_yield = 0;
+  for (const auto& channel : ranked_channels) {
+    if (freqs.size() >= kMinPartialScanChannels &&
+        covered_yield >= coverage_ratio * total_yield) {
+      break;
+    }
+    freqs.push_back(channel.second);
+    covered_yield += channel.first;
+  }
+  return freqs;
+}
+
+void ChannelPlanner::OnScanResults(const vector<uint32_t>& scanned_freqs,
+                                   const vector<NativeScanResult>& scan_results) {
+  bool found_network_of_interest = UpdateYield(scanned_freqs, scan_results);
+  if (scanned_freqs.empty()) {
+    partial_scans_since_full_sweep_ = 0;
+    last_partial_scan_missed_ = false;
+    return;
+  }
+  partial_scans_since_full_sweep_++;
+  last_partial_scan_missed_ = !found_network_of_interest;
+  if (last_partial_scan_missed_) {
+    LOG(DEBUG) << "Partial scan found no network of interest";
+  }
+}
+
+void ChannelPlanner::OnPnoScanResults(
+    const vector<uint32_t>& scanned_freqs,
+    const vector<NativeScanResult>& scan_results) {
+  UpdateYield(scanned_freqs, scan_results);
+}
+
+void ChannelPlanner::OnOffloadScanResults(
+    const vector<uint8_t>& histogram_channels,
+    const vector<NativeScanResult>& scan_results) {
+  set<uint32_t> scanned_freqs;
+  for (size_t channel = 0; channel < histogram_channels.size(); channel++) {
+    uint32_t freq = ChannelToFrequency(channel);
+    uint8_t previous_count = channel < offload_histogram_channels_.size()
+                                 ? offload_histogram_channels_[channel]
+                                 : 0;
+    // A count below the previous one means the Offload HAL restarted its
+    // counters.
+    bool scanned = histogram_channels[channel] > previous_count ||
+                   (histogram_channels[channel] < previous_count &&
+                    histogram_channels[channel] > 0);
+    if (scanned && freq != 0) {
+      scanned_freqs.insert(freq);
+    }
+  }
+  if (!histogram_channels.empty()) {
+    offload_histogram_channels_ = histogram_channels;
+  }
+  for (const auto& result : scan_results) {
+    scanned_freqs.insert(result.frequency);
+  }
+  // An empty list would stand for a full sweep.
+  if (scanned_freqs.empty()) {
+    return;
+  }
+  UpdateYield(vector<uint32_t>(scanned_freqs.begin(), scanned_freqs.end()),
+              scan_results);
+}
+
+bool ChannelPlanner::UpdateYield(const vector<uint32_t>& scanned_freqs,
+                                 const vector<NativeScanResult>& scan_results) {
+  bool full_sweep = scanned_freqs.empty();
+  map<uint32_t, double> observed_yield;
+  for (uint32_t freq : scanned_freqs) {
+    observed_yield[freq] = 0;
+  }
+  if (full_sweep) {
+    for (const auto& channel : channel_yield_) {
+      observed_yield[channel.first] = 0;
+    }
+  }
+
+  bool found_network_of_interest = false;
+  for (const auto& result : scan_results) {
+    auto observed = observed_yield.find(result.frequency);
+    if (observed == observed_yield.end()) {
+      if (!full_sweep) {
+        // Stale cache entry from a channel this scan did not cover.
+        continue;
+      }
+      observed = observed_yield.emplace(result.frequency, 0).first;
+    }
+    if (IsSavedSsid(result.ssid)) {
+      found_network_of_interest = true;
+      observed->second += kSavedNetworkWeight;
+    } else {
+      found_network_of_interest |= saved_ssids_.empty();
+      observed->second += 1;
+    }
+  }
+
+  for (const auto& observed : observed_yield) {
+    auto channel = channel_yield_.find(observed.first);
+    if (channel == channel_yield_.end()) {
+      channel_yield_[observed.first] = observed.second;
+      continue;
+    }
+    channel->second = (1 - kLearningRate) * channel->second +
+                      kLearningRate * observed.second;
+  }
+  return found_network_of_interest;
+}
+
+double ChannelPlanner::GetChannelYield(uint32_t freq) const {
+  auto channel = channel_yield_.find(freq);
+  if (channel == channel_yield_.end()) {
+    return 0;
+  }
+  return channel->second;
+}
+
+bool ChannelPlanner::IsSavedSsid(const vector<uint8_t>& ssid) const {
+  return std::find(saved_ssids_.begin(), saved_ssids_.end(), ssid) !=
+         saved_ssids_.end();
+}
+
+}  // namespace wificond
+}  // namespace android
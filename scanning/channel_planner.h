@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WIFICOND_SCANNING_CHANNEL_PLANNER_H_
+#define WIFICOND_SCANNING_CHANNEL_PLANNER_H_
+
+#include <map>
+#include <vector>
+
+#include <android-base/macros.h>
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+class NativeScanResult;
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
+
+namespace android {
+namespace wificond {
+
+// Learns from past scan results which channels tend to carry networks of
+// interest, and plans wild card single scans and PNO scans over netlink over
+// the most productive channels only. Full sweeps are still issued
+// periodically, and whenever a partial scan missed, so that new channels keep
+// being discovered.
+// Results of single scans, of PNO scans over netlink and of the Offload HAL
+// all feed the same per channel yield.
+class ChannelPlanner {
+ public:
+  // Weight of the newest observation in the per channel moving average.
+  static const double kLearningRate;
+  // A BSS of a saved network counts this many times more than any other BSS.
+  static const double kSavedNetworkWeight;
+  // A partial scan covers the best channels that together account for this
+  // fraction of the total yield.
+  static const double kCoverageRatio;
+  // Same as |kCoverageRatio| for PNO scans, which run for long between plans.
+  static const double kPnoCoverageRatio;
+  static const uint32_t kMinPartialScanChannels;
+  static const uint32_t kPartialScansPerFullSweep;
+
+  ChannelPlanner() = default;
+  virtual ~ChannelPlanner() = default;
+
+  // Sets the ssids of the networks we want to find, typically the saved
+  // networks from the PNO settings.
+  // If no ssid is set, every BSS is considered interesting.
+  void SetSavedSsids(const std::vector<std::vector<uint8_t>>& ssids);
+
+  // Returns the frequencies the next wild card scan should cover.
+  // An empty vector means a full sweep over all supported frequencies.
+  std::vector<uint32_t> PlanScan() const;
+
+  // Returns the frequencies the next PNO scan over netlink should cover.
+  // An empty vector means all supported frequencies.
+  std::vector<uint32_t> PlanPnoScan();
+
+  // Learns from |scan_results| returned by a scan over |scanned_freqs|.
+  // An empty |scanned_freqs| stands for a full sweep.
+  void OnScanResults(
+      const std::vector<uint32_t>& scanned_freqs,
+      const std::vector<::com::android::server::wifi::wificond::NativeScanResult>& scan_results);
+
+  // Learns from |scan_results| returned by a PNO scan over |scanned_freqs|.
+  // Unlike OnScanResults(), this does not change when single scans sweep all
+  // channels.
+  void OnPnoScanResults(
+      const std::vector<uint32_t>& scanned_freqs,
+      const std::vector<::com::android::server::wifi::wificond::NativeScanResult>& scan_results);
+
+  // Learns from |scan_results| found by the Offload HAL.
+  // |histogram_channels| counts how many times the Offload HAL scanned each
+  // channel so far, indexed by channel number. The channels whose count grew
+  // since the previous call were scanned for these results, and lose yield
+  // when they have no result. If it is empty, only the channels with a
+  // result are learned from.
+  void OnOffloadScanResults(
+      const std::vector<uint8_t>& histogram_channels,
+      const std::vector<::com::android::server::wifi::wificond::NativeScanResult>& scan_results);
+
+  // Returns the learned yield of the channel with frequency |freq|.
+  double GetChannelYield(uint32_t freq) const;
+
+ private:
+  bool IsSavedSsid(const std::vector<uint8_t>& ssid) const;
+  // Returns the best channels accounting for |coverage_ratio| of the yield,
+  // or an empty vector without history.
+  std::vector<uint32_t> PlanChannels(double coverage_ratio) const;
+  // Updates |channel_yield_| and returns true if a network of interest was
+  // found on a scanned channel.
+  bool UpdateYield(
+      const std::vector<uint32_t>& scanned_freqs,
+      const std::vector<::com::android::server::wifi::wificond::NativeScanResult>& scan_results);
+
+  // Moving average of weighted BSSs found per scan, keyed by frequency.
+  std::map<uint32_t, double> channel_yield_;
+  std::vector<std::vector<uint8_t>> saved_ssids_;
+  uint32_t partial_scans_since_full_sweep_{0};
+  bool last_partial_scan_missed_{false};
+  uint32_t partial_pno_scans_since_full_sweep_{0};
+  // Histogram passed to the previous OnOffloadScanResults() call.
+  std::vector<uint8_t> offload_histogram_channels_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChannelPlanner);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_CHANNEL_PLANNER_H_
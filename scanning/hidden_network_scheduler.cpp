@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/hidden_network_scheduler.h"
+
+#include <algorithm>
+
+using std::map;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+const uint32_t HiddenNetworkScheduler::kMaxTrackedSsids = 64;
+
+vector<vector<vector<uint8_t>>> HiddenNetworkScheduler::Schedule(
+    const vector<vector<uint8_t>>& ssids,
+    uint32_t max_ssids_per_scan,
+    bool full_coverage) {
+  num_schedules_++;
+  vector<vector<uint8_t>> pending;
+  for (const auto& ssid : ssids) {
+    SsidState& state = ssid_states_[ssid];
+    // Ignore duplicates within the same request.
+    if (state.last_requested == num_schedules_) {
+      continue;
+    }
+    state.last_requested = num_schedules_;
+    state.coverage.num_requested++;
+    pending.push_back(ssid);
+  }
+  // Least recently probed first. Ties keep the caller's order.
+  std::stable_sort(pending.begin(), pending.end(),
+                   [this](const vector<uint8_t>& lhs,
+                          const vector<uint8_t>& rhs) {
+                     return ssid_states_[lhs].last_probed <
+                            ssid_states_[rhs].last_probed;
+                   });
+
+  vector<vector<vector<uint8_t>>> batches(1);
+  for (const auto& ssid : pending) {
+    SsidState& state = ssid_states_[ssid];
+    if (batches.back().size() >= max_ssids_per_scan) {
+      if (!full_coverage || max_ssids_per_scan == 0) {
+        state.coverage.num_deferred++;
+        continue;
+      }
+      batches.emplace_back();
+    }
+    batches.back().push_back(ssid);
+    state.previous_probed = state.last_probed;
+    state.last_probed = num_schedules_;
+    state.coverage.num_probed++;
+  }
+  EvictLeastRecentlyRequested();
+  return batches;
+}
+
+void HiddenNetworkScheduler::Defer(const vector<vector<uint8_t>>& ssids) {
+  for (const auto& ssid : ssids) {
+    auto it = ssid_states_.find(ssid);
+    // Only undo a probe that the latest schedule counted.
+    if (it == ssid_states_.end() ||
+        it->second.last_probed != num_schedules_) {
+      continue;
+    }
+    SsidState& state = it->second;
+    state.last_probed = state.previous_probed;
+    state.coverage.num_probed--;
+    state.coverage.num_deferred++;
+  }
+}
+
+map<vector<uint8_t>, HiddenNetworkCoverage>
+HiddenNetworkScheduler::GetCoverageStats() const {
+  map<vector<uint8_t>, HiddenNetworkCoverage> stats;
+  for (const auto& it : ssid_states_) {
+    stats[it.first] = it.second.coverage;
+  }
+  return stats;
+}
+
+void HiddenNetworkScheduler::EvictLeastRecentlyRequested() {
+  while (ssid_states_.size() > kMaxTrackedSsids) {
+    auto oldest = ssid_states_.begin();
+    for (auto it = ssid_states_.begin(); it != ssid_states_.end(); ++it) {
+      if (it->second.last_requested < oldest->second.last_requested) {
+        oldest = it;
+      }
+    }
+    ssid_states_.erase(oldest);
+  }
+}
+
+}  // namespace wificond
+}  // namespace android
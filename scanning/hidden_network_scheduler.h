@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_HIDDEN_NETWORK_SCHEDULER_H_
+#define WIFICOND_SCANNING_HIDDEN_NETWORK_SCHEDULER_H_
+
+#include <map>
+#include <vector>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace wificond {
+
+// How often single scans probed a hidden network they were asked for.
+struct HiddenNetworkCoverage {
+  // Number of scan requests that asked for this network.
+  uint32_t num_requested{0};
+  // Number of scans that actually probed for it.
+  uint32_t num_probed{0};
+  // Number of scan requests that left it out for lack of ssid slots.
+  uint32_t num_deferred{0};
+};
+
+// Decides which hidden networks single scans probe for when a request asks
+// for more of them than the driver can take in one scan.
+// Networks that went longest without a probe go first, so consecutive
+// requests rotate through the whole set instead of always dropping the
+// same networks.
+class HiddenNetworkScheduler {
+ public:
+  static const uint32_t kMaxTrackedSsids;
+
+  HiddenNetworkScheduler() = default;
+  virtual ~HiddenNetworkScheduler() = default;
+
+  // Returns the batches of |ssids| to probe for, one batch per scan, each
+  // of them holding at most |max_ssids_per_scan| ssids.
+  // Without |full_coverage|, there is exactly one batch and the networks
+  // that don't fit in it are deferred to later requests. With
+  // |full_coverage|, the batches cover every ssid of |ssids|.
+  std::vector<std::vector<std::vector<uint8_t>>> Schedule(
+      const std::vector<std::vector<uint8_t>>& ssids,
+      uint32_t max_ssids_per_scan,
+      bool full_coverage);
+
+  // Reports that |ssids| were dropped from the scan that the latest call to
+  // Schedule() put them in. They count as deferred instead of probed, and
+  // keep their place in the rotation.
+  void Defer(const std::vector<std::vector<uint8_t>>& ssids);
+
+  // Returns the coverage of the most recently requested hidden networks,
+  // keyed by ssid.
+  std::map<std::vector<uint8_t>, HiddenNetworkCoverage> GetCoverageStats()
+      const;
+
+ private:
+  struct SsidState {
+    HiddenNetworkCoverage coverage;
+    // Values of |num_schedules_| when this ssid was last probed for and
+    // last requested. 0 means never.
+    uint64_t last_probed{0};
+    uint64_t last_requested{0};
+    // Value of |last_probed| before the latest probe, restored by Defer().
+    uint64_t previous_probed{0};
+  };
+
+  void EvictLeastRecentlyRequested();
+
+  std::map<std::vector<uint8_t>, SsidState> ssid_states_;
+  uint64_t num_schedules_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(HiddenNetworkScheduler);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_HIDDEN_NETWORK_SCHEDULER_H_
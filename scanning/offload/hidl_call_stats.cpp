@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/offload/hidl_call_stats.h"
+
+#include <android-base/logging.h>
+
+namespace android {
+namespace wificond {
+
+HidlCallStats::HidlCallStats(int64_t deadline_ms)
+    : deadline_ms_(deadline_ms) {}
+
+void HidlCallStats::RecordCall(const char* method_name, int64_t latency_us,
+                               bool transport_ok) {
+  HidlMethodStats& stats = method_stats_[method_name];
+  stats.latency.Add(latency_us);
+  if (!transport_ok) {
+    stats.num_transport_failures++;
+  }
+  if (deadline_ms_ > 0 && latency_us >= deadline_ms_ * 1000) {
+    stats.num_slow_calls++;
+    LOG(WARNING) << "HIDL call " << method_name << " took "
+                 << latency_us / 1000 << " ms, deadline is " << deadline_ms_
+                 << " ms";
+  }
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_OFFLOAD_HIDL_CALL_STATS_H_
+#define WIFICOND_SCANNING_OFFLOAD_HIDL_CALL_STATS_H_
+
+#include <map>
+#include <string>
+
+#include <android-base/macros.h>
+
+#include "wificond/latency_histogram.h"
+
+namespace android {
+namespace wificond {
+
+// Statistics of the calls to one HIDL method.
+struct HidlMethodStats {
+  LatencyHistogram latency;
+  // Calls whose transport failed, e.g. because the service died.
+  uint32_t num_transport_failures{0};
+  // Calls which returned after the deadline of HidlCallStats.
+  uint32_t num_slow_calls{0};
+};
+
+// Collects the statistics of HIDL calls made with HIDL_INVOKE_WITH_STATS(),
+// keyed by method name.
+class HidlCallStats {
+ public:
+  // Calls taking |deadline_ms| or longer are logged and counted as slow.
+  // 0 means no deadline.
+  explicit HidlCallStats(int64_t deadline_ms);
+  ~HidlCallStats() = default;
+
+  void RecordCall(const char* method_name, int64_t latency_us,
+                  bool transport_ok);
+
+  const std::map<std::string, HidlMethodStats>& GetMethodStats() const {
+    return method_stats_;
+  }
+  int64_t GetDeadlineMs() const { return deadline_ms_; }
+
+ private:
+  const int64_t deadline_ms_;
+  std::map<std::string, HidlMethodStats> method_stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(HidlCallStats);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_OFFLOAD_HIDL_CALL_STATS_H_
@@ -20,11 +20,14 @@
 #pragma once
 
 #include <android-base/logging.h>
+#include <utils/Timers.h>
 #include <functional>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 
+#include "wificond/scanning/offload/hidl_call_stats.h"
+
 namespace {
 namespace detail {
 template <typename>
@@ -84,18 +87,27 @@ struct functionArgSaver<std::function<void(ArgT...)>> final {
 // Invokes |method| on |object|, providing |method| a CallbackT as the
 // final argument. Returns a copy of the parameters that |method| provided
 // to CallbackT. (The parameters are returned by value.)
+// If |stats| is not null, the latency and the transport status of the call
+// are recorded in it under |method_name|.
 template <typename CallbackT, typename MethodT, typename ObjectT,
           typename... ArgT>
 std::pair<typename functionArgSaver<CallbackT>::StorageT, bool> invokeMethod(
+    android::wificond::HidlCallStats* stats, const char* method_name,
     MethodT method, ObjectT object, ArgT&&... methodArg) {
   functionArgSaver<CallbackT> result_buffer;
+  nsecs_t start_time = systemTime(SYSTEM_TIME_MONOTONIC);
   const auto& res = ((*object).*method)(std::forward<ArgT>(methodArg)...,
                                         result_buffer.saveArgs);
   bool transportStatus = true;
   if (!res.isOk()) {
-    LOG(ERROR) << " Transport failed " << res.description();
+    LOG(ERROR) << method_name << " Transport failed " << res.description();
     transportStatus = false;
   }
+  if (stats != nullptr) {
+    stats->RecordCall(
+        method_name, ns2us(systemTime(SYSTEM_TIME_MONOTONIC) - start_time),
+        transportStatus);
+  }
   return std::make_pair(result_buffer.saved_values, transportStatus);
 }
 }  // namespace detail
@@ -124,5 +136,19 @@ std::pair<typename functionArgSaver<CallbackT>::StorageT, bool> invokeMethod(
 #define HIDL_INVOKE(strong_pointer, method, ...)                            \
   (detail::invokeMethod<                                                    \
       std::remove_reference<decltype(*strong_pointer)>::type::method##_cb>( \
+      nullptr, #method,                                                     \
+      &std::remove_reference<decltype(*strong_pointer)>::type::method,      \
+      strong_pointer, ##__VA_ARGS__))
+
+// Same as HIDL_INVOKE(), and also records the latency and the transport
+// status of the call in |stats|, a HidlCallStats*.
+//
+// Example usage:
+//   HidlCallStats stats(100 /* deadline_ms */);
+//   auto result = HIDL_INVOKE_WITH_STATS(&stats, strong_pointer, method);
+#define HIDL_INVOKE_WITH_STATS(stats, strong_pointer, method, ...)          \
+  (detail::invokeMethod<                                                    \
+      std::remove_reference<decltype(*strong_pointer)>::type::method##_cb>( \
+      stats, #method,                                                       \
       &std::remove_reference<decltype(*strong_pointer)>::type::method,      \
       strong_pointer, ##__VA_ARGS__))
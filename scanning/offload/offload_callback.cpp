@@ -39,7 +39,7 @@ OffloadCallback::OffloadCallback(OffloadCallbackHandlers* handlers)
 Return<void> OffloadCallback::onScanResult(
     const hidl_vec<ScanResult>& scan_result) {
   if (handlers_ != nullptr) {
-    handlers_->OnScanResultHandler(std::vector<ScanResult>(scan_result));
+    handlers_->OnScanResultHandler(scan_result);
   } else {
     LOG(WARNING) << "No handler available for Offload scan results";
   }
@@ -26,9 +26,11 @@ class OffloadCallbackHandlers {
  public:
   virtual ~OffloadCallbackHandlers() {}
 
+  // |scanResult| is the batch as received from the Offload HAL. It is only
+  // valid during the call.
   virtual void OnScanResultHandler(
-      const std::vector<::android::hardware::wifi::offload::V1_0::ScanResult>&
-          scanResult) = 0;
+      const ::android::hardware::hidl_vec<
+          ::android::hardware::wifi::offload::V1_0::ScanResult>& scanResult) = 0;
   virtual void OnErrorHandler(
       const ::android::hardware::wifi::offload::V1_0::OffloadStatus&
           status) = 0;
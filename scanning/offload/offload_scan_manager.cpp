@@ -15,9 +15,11 @@
  */
 #include "wificond/scanning/offload/offload_scan_manager.h"
 
+#include <algorithm>
 #include <vector>
 
 #include <android-base/logging.h>
+#include <utils/Timers.h>
 
 #include "wificond/scanning/offload/hidl_call_util.h"
 #include "wificond/scanning/offload/offload_scan_utils.h"
@@ -44,7 +46,17 @@ using std::shared_ptr;
 using namespace std::placeholders;
 
 namespace {
-const uint32_t kSubscriptionDelayMs = 5000;
+const uint32_t kReconnectInitialDelayMs = 1000;
+const uint32_t kReconnectMaxDelayMs = 64000;
+const uint32_t kReconnectBackoffFactor = 2;
+// Offload HAL calls block the event loop, so they are expected to be quick.
+const int64_t kHidlCallDeadlineMs = 100;
+// With the default sampling period, this covers the last 12 hours.
+const size_t kScanStatsHistorySize = 48;
+
+int64_t GetBootTimeMs() {
+  return systemTime(SYSTEM_TIME_BOOTTIME) / 1000000;
+}
 }
 
 namespace android {
@@ -57,7 +69,7 @@ OffloadCallbackHandlersImpl::OffloadCallbackHandlersImpl(
 OffloadCallbackHandlersImpl::~OffloadCallbackHandlersImpl() {}
 
 void OffloadCallbackHandlersImpl::OnScanResultHandler(
-    const vector<ScanResult>& scanResult) {
+    const hidl_vec<ScanResult>& scanResult) {
   if (offload_scan_manager_ != nullptr) {
     offload_scan_manager_->ReportScanResults(scanResult);
   }
@@ -77,6 +89,15 @@ OffloadScanManager::OffloadScanManager(
       death_recipient_(nullptr),
       offload_status_(OffloadScanManager::kError),
       service_available_(false),
+      scan_requested_(false),
+      reconnecting_(false),
+      reconnect_pending_(false),
+      reconnect_delay_ms_(kReconnectInitialDelayMs),
+      scan_stats_sample_pending_(false),
+      hidl_call_stats_(kHidlCallDeadlineMs),
+      scan_start_time_ms_(-1),
+      requested_subscription_delay_ms_(0),
+      lifetime_token_(std::make_shared<bool>(true)),
       offload_service_utils_(utils),
       offload_callback_handlers_(new OffloadCallbackHandlersImpl(this)),
       event_callback_(callback) {
@@ -123,13 +144,122 @@ bool OffloadScanManager::InitService() {
 }
 
 bool OffloadScanManager::InitServiceIfNeeded() {
-  if (!service_available_) {
-    return InitService();
+  if (service_available_) {
+    return true;
+  }
+  if (!InitService()) {
+    return false;
+  }
+  if (reconnecting_) {
+    OnServiceReconnected();
   }
   return true;
 }
 
+void OffloadScanManager::ScheduleReconnect() {
+  if (reconnect_pending_) {
+    return;
+  }
+  std::weak_ptr<bool> lifetime_token = lifetime_token_;
+  auto task = [this, lifetime_token]() {
+    if (!lifetime_token.expired()) {
+      Reconnect();
+    }
+  };
+  if (!offload_service_utils_.lock()->PostDelayedTask(task,
+                                                      reconnect_delay_ms_)) {
+    LOG(ERROR) << "Unable to schedule reconnection to Offload HAL";
+    return;
+  }
+  reconnect_pending_ = true;
+}
+
+void OffloadScanManager::Reconnect() {
+  reconnect_pending_ = false;
+  if (!reconnecting_) {
+    // Reconnected by an API call in the meantime.
+    return;
+  }
+  reconnect_stats_.num_reconnect_attempts++;
+  if (!InitService()) {
+    reconnect_delay_ms_ = std::min(reconnect_delay_ms_ * kReconnectBackoffFactor,
+                                   kReconnectMaxDelayMs);
+    LOG(WARNING) << "Offload HAL still unavailable, retrying in "
+                 << reconnect_delay_ms_ << " ms";
+    ScheduleReconnect();
+    return;
+  }
+  OnServiceReconnected();
+}
+
+void OffloadScanManager::OnServiceReconnected() {
+  reconnecting_ = false;
+  reconnect_delay_ms_ = kReconnectInitialDelayMs;
+  // This is a new instance of the service, without errors from the old one.
+  offload_status_ = OffloadScanManager::kNoError;
+  reconnect_stats_.num_reconnects++;
+  LOG(INFO) << "Reconnected to Offload HAL";
+  if (!scan_requested_) {
+    return;
+  }
+  OffloadScanManager::ReasonCode reason_code;
+  if (!ConfigureScans(scan_param_, scan_filter_, &reason_code) ||
+      !SubscribeScanResults(&reason_code)) {
+    LOG(ERROR) << "Unable to restore Offload HAL scans, reason: "
+               << reason_code;
+    reconnect_stats_.num_restore_failures++;
+    scan_requested_ = false;
+    return;
+  }
+  ScheduleScanStatsSample();
+  if (event_callback_ != nullptr) {
+    event_callback_->OnOffloadScanRestored();
+  } else {
+    LOG(WARNING) << "No callback to report restored Offload HAL scans";
+  }
+}
+
+void OffloadScanManager::ScheduleScanStatsSample() {
+  if (scan_stats_sample_pending_) {
+    return;
+  }
+  uint32_t period_ms =
+      offload_service_utils_.lock()->GetScanStatsSamplingPeriodMs();
+  if (period_ms == 0) {
+    return;
+  }
+  std::weak_ptr<bool> lifetime_token = lifetime_token_;
+  auto task = [this, lifetime_token]() {
+    if (!lifetime_token.expired()) {
+      SampleScanStats();
+    }
+  };
+  if (!offload_service_utils_.lock()->PostDelayedTask(task, period_ms)) {
+    LOG(ERROR) << "Unable to schedule Offload HAL scan stats sampling";
+    return;
+  }
+  scan_stats_sample_pending_ = true;
+}
+
+void OffloadScanManager::SampleScanStats() {
+  scan_stats_sample_pending_ = false;
+  // Sampling stops along with the scans.
+  if (!scan_requested_) {
+    return;
+  }
+  NativeScanStats stats;
+  if (getOffloadStatus() == OffloadScanManager::kNoError &&
+      GetScanStats(&stats)) {
+    scan_stats_history_.push_back(stats);
+    if (scan_stats_history_.size() > kScanStatsHistorySize) {
+      scan_stats_history_.pop_front();
+    }
+  }
+  ScheduleScanStatsSample();
+}
+
 bool OffloadScanManager::stopScan(OffloadScanManager::ReasonCode* reason_code) {
+  scan_requested_ = false;
   if (!InitServiceIfNeeded() ||
       (getOffloadStatus() != OffloadScanManager::kNoError)) {
     *reason_code = OffloadScanManager::kNotAvailable;
@@ -146,7 +276,8 @@ bool OffloadScanManager::stopScan(OffloadScanManager::ReasonCode* reason_code) {
 }
 
 bool OffloadScanManager::GetScanStats(NativeScanStats* native_scan_stats) {
-  const auto& result = HIDL_INVOKE(wifi_offload_hal_, getScanStats);
+  const auto& result = HIDL_INVOKE_WITH_STATS(&hidl_call_stats_,
+                                             wifi_offload_hal_, getScanStats);
   const auto& offload_status_and_scan_stats = result.first;
   bool transport_status = result.second;
   if (!transport_status) {
@@ -159,6 +290,8 @@ bool OffloadScanManager::GetScanStats(NativeScanStats* native_scan_stats) {
     return false;
   }
   *native_scan_stats = OffloadScanUtils::convertToNativeScanStats(scan_stats);
+  native_scan_stats->time_stamp_ =
+      static_cast<uint32_t>(systemTime(SYSTEM_TIME_BOOTTIME) / 1000000000);
   return true;
 }
 
@@ -184,7 +317,18 @@ bool OffloadScanManager::startScan(
     const vector<vector<uint8_t>>& scan_ssids,
     const vector<vector<uint8_t>>& match_ssids,
     const vector<uint8_t>& match_security, const vector<uint32_t>& freqs,
+    uint32_t subscription_delay_ms,
     OffloadScanManager::ReasonCode* reason_code) {
+  // Scans updated at the same interval keep the current subscription, and
+  // with it the delay it backed off to.
+  bool keep_subscription =
+      scan_requested_ &&
+      scan_param_.disconnectedModeScanIntervalMs == interval_ms &&
+      requested_subscription_delay_ms_ == subscription_delay_ms;
+  int64_t scan_start_time_ms = scan_start_time_ms_;
+  // The new scans replace the previous ones, whether they start or not.
+  scan_requested_ = false;
+  scan_start_time_ms_ = -1;
   if (!InitServiceIfNeeded() ||
       getOffloadStatus() != OffloadScanManager::kNoError) {
     *reason_code = OffloadScanManager::kNotAvailable;
@@ -200,10 +344,24 @@ bool OffloadScanManager::startScan(
     return false;
   }
 
-  if (!SubscribeScanResults(reason_code)) {
-    return false;
+  if (keep_subscription) {
+    // configureScans() replaced the scan parameters and filter of the running
+    // scans in place.
+    subscription_stats_.num_in_place_updates++;
+    scan_start_time_ms_ = scan_start_time_ms;
+  } else {
+    subscription_delay_policy_.Reset(interval_ms, subscription_delay_ms);
+    if (!SubscribeScanResults(reason_code)) {
+      return false;
+    }
+    scan_start_time_ms_ = GetBootTimeMs();
   }
 
+  scan_requested_ = true;
+  requested_subscription_delay_ms_ = subscription_delay_ms;
+  scan_param_ = param;
+  scan_filter_ = filter;
+  ScheduleScanStatsSample();
   *reason_code = OffloadScanManager::kNone;
   return true;
 }
@@ -211,8 +369,8 @@ bool OffloadScanManager::startScan(
 bool OffloadScanManager::ConfigureScans(
     ScanParam param, ScanFilter filter,
     OffloadScanManager::ReasonCode* reason_code) {
-  const auto& result =
-      HIDL_INVOKE(wifi_offload_hal_, configureScans, param, filter);
+  const auto& result = HIDL_INVOKE_WITH_STATS(
+      &hidl_call_stats_, wifi_offload_hal_, configureScans, param, filter);
   if (!VerifyAndConvertHIDLStatus(result, reason_code)) {
     return false;
   }
@@ -221,11 +379,14 @@ bool OffloadScanManager::ConfigureScans(
 
 bool OffloadScanManager::SubscribeScanResults(
     OffloadScanManager::ReasonCode* reason_code) {
-  const auto& result = HIDL_INVOKE(wifi_offload_hal_, subscribeScanResults,
-                                   kSubscriptionDelayMs);
+  uint32_t delay_ms = subscription_delay_policy_.GetDelayMs();
+  const auto& result = HIDL_INVOKE_WITH_STATS(
+      &hidl_call_stats_, wifi_offload_hal_, subscribeScanResults, delay_ms);
   if (!VerifyAndConvertHIDLStatus(result, reason_code)) {
     return false;
   }
+  subscription_stats_.num_subscriptions++;
+  subscription_stats_.current_delay_ms = delay_ms;
   return true;
 }
 
@@ -238,12 +399,33 @@ OffloadScanManager::StatusCode OffloadScanManager::getOffloadStatus() const {
 
 bool OffloadScanManager::getScanResults(
     std::vector<NativeScanResult>* out_scan_results) {
-  for (const auto& scan_result : cached_scan_results_) {
-    out_scan_results->push_back(scan_result);
-  }
+  ScanResultSnapshot snapshot = cached_scan_results_.Get();
+  out_scan_results->insert(out_scan_results->end(), snapshot->begin(),
+                           snapshot->end());
   return true;
 }
 
+ScanResultSnapshot OffloadScanManager::getScanResultSnapshot() const {
+  return cached_scan_results_.Get();
+}
+
+OffloadReconnectStats OffloadScanManager::getReconnectStats() const {
+  return reconnect_stats_;
+}
+
+const HidlCallStats& OffloadScanManager::getHidlCallStats() const {
+  return hidl_call_stats_;
+}
+
+OffloadSubscriptionStats OffloadScanManager::getSubscriptionStats() const {
+  return subscription_stats_;
+}
+
+vector<NativeScanStats> OffloadScanManager::getScanStatsHistory() const {
+  return vector<NativeScanStats>(scan_stats_history_.begin(),
+                                 scan_stats_history_.end());
+}
+
 bool OffloadScanManager::getScanStats(NativeScanStats* native_scan_stats) {
   if (!InitServiceIfNeeded()) {
     LOG(ERROR) << "Offload HAL service unavailable";
@@ -263,13 +445,17 @@ OffloadScanManager::~OffloadScanManager() {
 }
 
 void OffloadScanManager::ReportScanResults(
-    const vector<ScanResult>& scanResult) {
-  cached_scan_results_.clear();
+    const hidl_vec<ScanResult>& scanResult) {
+  // Readers keep the previous snapshot until the new one is complete.
+  vector<NativeScanResult> scan_results;
   if (!OffloadScanUtils::convertToNativeScanResults(scanResult,
-                                                    &cached_scan_results_)) {
+                                                    &scan_results)) {
     LOG(WARNING) << "Unable to convert scan results to native format";
+    cached_scan_results_.Clear();
     return;
   }
+  cached_scan_results_.Publish(std::move(scan_results));
+  OnScanResultsReported();
   if (event_callback_ != nullptr) {
     event_callback_->OnOffloadScanResult();
   } else {
@@ -278,6 +464,29 @@ void OffloadScanManager::ReportScanResults(
   }
 }
 
+void OffloadScanManager::OnScanResultsReported() {
+  subscription_stats_.num_result_reports++;
+  if (!scan_requested_) {
+    return;
+  }
+  if (scan_start_time_ms_ >= 0) {
+    int64_t latency_ms = GetBootTimeMs() - scan_start_time_ms_;
+    scan_start_time_ms_ = -1;
+    subscription_stats_.num_first_reports++;
+    subscription_stats_.total_first_report_latency_ms += latency_ms;
+    subscription_stats_.max_first_report_latency_ms =
+        std::max(subscription_stats_.max_first_report_latency_ms, latency_ms);
+  }
+  if (!subscription_delay_policy_.OnScanResultsReported()) {
+    return;
+  }
+  OffloadScanManager::ReasonCode reason_code;
+  if (!SubscribeScanResults(&reason_code)) {
+    LOG(WARNING) << "Unable to update the Offload HAL subscription delay, "
+                    "reason: " << reason_code;
+  }
+}
+
 void OffloadScanManager::ReportError(const OffloadStatus& status) {
   OffloadStatusCode status_code = status.code;
   OffloadScanManager::StatusCode status_result = OffloadScanManager::kNoError;
@@ -323,6 +532,10 @@ void OffloadScanManager::OnObjectDeath(uint64_t cookie) {
     }
     service_available_ = false;
     death_recipient_.clear();
+    reconnect_stats_.num_service_deaths++;
+    reconnecting_ = true;
+    reconnect_delay_ms_ = kReconnectInitialDelayMs;
+    ScheduleReconnect();
   }
 }
 
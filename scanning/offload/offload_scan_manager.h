@@ -19,8 +19,14 @@
 #include <android/hardware/wifi/offload/1.0/IOffload.h>
 #include "wificond/scanning/offload/offload_callback.h"
 #include "wificond/scanning/offload/offload_callback_handlers.h"
+#include "wificond/scanning/offload/hidl_call_stats.h"
+#include "wificond/scanning/offload/scan_stats.h"
+#include "wificond/scanning/offload/subscription_delay_policy.h"
 #include "wificond/scanning/offload_scan_callback_interface_impl.h"
+#include "wificond/scanning/scan_result_snapshot.h"
 
+#include <deque>
+#include <memory>
 #include <vector>
 
 namespace com {
@@ -30,7 +36,6 @@ namespace wifi {
 namespace wificond {
 
 class NativeScanResult;
-class NativeScanStats;
 
 }  // namespace wificond
 }  // namespace wifi
@@ -45,6 +50,35 @@ class OffloadScanManager;
 class OffloadDeathRecipient;
 class OffloadServiceUtils;
 
+// Counters of the scan result subscriptions to the Offload HAL.
+struct OffloadSubscriptionStats {
+  // Calls to subscribeScanResults(), including delay updates.
+  uint32_t num_subscriptions{0};
+  // Scan result reports, each of which wakes wificond up.
+  uint32_t num_result_reports{0};
+  // startScan() calls which updated the running scans without subscribing
+  // again.
+  uint32_t num_in_place_updates{0};
+  // Delay of the latest subscription.
+  uint32_t current_delay_ms{0};
+  // Time from startScan() to the first report, over the scans which got one.
+  uint32_t num_first_reports{0};
+  int64_t total_first_report_latency_ms{0};
+  int64_t max_first_report_latency_ms{0};
+};
+
+// Counters of Offload HAL restarts.
+struct OffloadReconnectStats {
+  // Binder deaths of the Offload HAL service.
+  uint32_t num_service_deaths{0};
+  // Scheduled attempts to reconnect to the Offload HAL service.
+  uint32_t num_reconnect_attempts{0};
+  // Successful reconnections, whether scheduled or not.
+  uint32_t num_reconnects{0};
+  // Reconnections after which the previous scans could not be restored.
+  uint32_t num_restore_failures{0};
+};
+
 // Provides callback interface implementation from Offload HAL
 class OffloadCallbackHandlersImpl : public OffloadCallbackHandlers {
  public:
@@ -52,8 +86,9 @@ class OffloadCallbackHandlersImpl : public OffloadCallbackHandlers {
   ~OffloadCallbackHandlersImpl() override;
 
   void OnScanResultHandler(
-      const std::vector<android::hardware::wifi::offload::V1_0::ScanResult>&
-          scanResult) override;
+      const android::hardware::hidl_vec<
+          android::hardware::wifi::offload::V1_0::ScanResult>& scanResult)
+      override;
   void OnErrorHandler(
       const android::hardware::wifi::offload::V1_0::OffloadStatus& status)
       override;
@@ -96,6 +131,11 @@ class OffloadScanManager {
   /* Request start of offload scans with scan parameters and scan filter
    * settings. Internally calls Offload HAL service with configureScans()
    * and subscribeScanResults() APIs. Reason code indicates failure reason.
+   * Scan results are reported after |subscription_delay_ms|, or after a
+   * delay adapted to |interval_ms| if it is 0. See SubscriptionDelayPolicy.
+   * Running scans updated with the same |interval_ms| and
+   * |subscription_delay_ms| are only reconfigured, keeping the current
+   * subscription.
    */
   virtual bool startScan(
       uint32_t /* interval_ms */, int32_t /* rssi_threshold */,
@@ -103,6 +143,7 @@ class OffloadScanManager {
       const std::vector<std::vector<uint8_t>>& /* match_ssids */,
       const std::vector<uint8_t>& /* match_security */,
       const std::vector<uint32_t>& /* freqs */,
+      uint32_t /* subscription_delay_ms */,
       ReasonCode* /* failure reason */);
   /* Request stop of offload scans, returns true if the operation succeeds
    * Otherwise, returns false. Reason code is updated in case of failure.
@@ -117,11 +158,26 @@ class OffloadScanManager {
   virtual bool getScanResults(
       std::vector<::com::android::server::wifi::wificond::NativeScanResult>*
           out_scan_results);
+  /* Returns the most recent scan result available from Offload HAL without
+   * copying it. It is safe to call from any thread.
+   */
+  virtual ScanResultSnapshot getScanResultSnapshot() const;
+  /* Returns counters of Offload HAL restarts */
+  virtual OffloadReconnectStats getReconnectStats() const;
+  /* Returns the scan statistics sampled periodically while scans are
+   * requested, oldest first. See OffloadServiceUtils for the period.
+   */
+  virtual std::vector<::com::android::server::wifi::wificond::NativeScanStats>
+      getScanStatsHistory() const;
+  /* Returns the latency and failure statistics of the calls to Offload HAL */
+  virtual const HidlCallStats& getHidlCallStats() const;
+  /* Returns the counters of scan result subscriptions and reports */
+  virtual OffloadSubscriptionStats getSubscriptionStats() const;
 
  private:
   void ReportScanResults(
-      const std::vector<android::hardware::wifi::offload::V1_0::ScanResult>&
-          scanResult);
+      const android::hardware::hidl_vec<
+          android::hardware::wifi::offload::V1_0::ScanResult>& scanResult);
   void ReportError(
       const android::hardware::wifi::offload::V1_0::OffloadStatus& status);
   bool VerifyAndConvertHIDLStatus(
@@ -138,6 +194,16 @@ class OffloadScanManager {
       OffloadScanManager::ReasonCode* reason_code);
   bool InitServiceIfNeeded();
   bool InitService();
+  /* Reconnection to the Offload HAL service after its binder death, retried
+   * with exponential backoff.
+   */
+  void ScheduleReconnect();
+  void Reconnect();
+  void OnServiceReconnected();
+  void ScheduleScanStatsSample();
+  void SampleScanStats();
+  /* Accounts for a scan result report and backs the subscription delay off */
+  void OnScanResultsReported();
 
   /* Handle binder death */
   void OnObjectDeath(uint64_t /* cookie */);
@@ -147,10 +213,35 @@ class OffloadScanManager {
   android::sp<OffloadCallback> wifi_offload_callback_;
   android::sp<OffloadDeathRecipient> death_recipient_;
   StatusCode offload_status_;
-  std::vector<::com::android::server::wifi::wificond::NativeScanResult>
-      cached_scan_results_;
+  ScanResultSnapshotCache cached_scan_results_;
   bool service_available_;
 
+  // Scans requested by the last successful startScan(), until stopScan().
+  // They are restored when the Offload HAL service restarts.
+  bool scan_requested_;
+  android::hardware::wifi::offload::V1_0::ScanParam scan_param_;
+  android::hardware::wifi::offload::V1_0::ScanFilter scan_filter_;
+
+  // True from a binder death of the service until it is reconnected.
+  bool reconnecting_;
+  bool reconnect_pending_;
+  uint32_t reconnect_delay_ms_;
+  OffloadReconnectStats reconnect_stats_;
+  // Most recent samples of the scan statistics, oldest first.
+  std::deque<::com::android::server::wifi::wificond::NativeScanStats>
+      scan_stats_history_;
+  bool scan_stats_sample_pending_;
+  HidlCallStats hidl_call_stats_;
+  SubscriptionDelayPolicy subscription_delay_policy_;
+  OffloadSubscriptionStats subscription_stats_;
+  // Boot time of the last startScan(), or -1 once its first report arrived.
+  int64_t scan_start_time_ms_;
+  // |subscription_delay_ms| of the last successful startScan().
+  uint32_t requested_subscription_delay_ms_;
+  // Pending reconnect tasks only hold a weak reference to this, so that they
+  // do nothing once this object is destroyed.
+  const std::shared_ptr<bool> lifetime_token_;
+
   const std::weak_ptr<OffloadServiceUtils> offload_service_utils_;
   const std::shared_ptr<OffloadCallbackHandlersImpl> offload_callback_handlers_;
   std::shared_ptr<OffloadScanCallbackInterface> event_callback_;
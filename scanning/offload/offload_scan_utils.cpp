@@ -15,6 +15,9 @@
  */
 #include "wificond/scanning/offload/offload_scan_utils.h"
 
+#include <algorithm>
+#include <limits>
+
 #include <android-base/logging.h>
 #include <utils/Timers.h>
 
@@ -35,22 +38,24 @@ namespace android {
 namespace wificond {
 
 bool OffloadScanUtils::convertToNativeScanResults(
-    const vector<ScanResult>& scan_result,
+    const hidl_vec<ScanResult>& scan_result,
     vector<NativeScanResult>* native_scan_result) {
   if (native_scan_result == nullptr) return false;
+  const uint64_t tsf = systemTime(SYSTEM_TIME_MONOTONIC) / 1000;
+  native_scan_result->reserve(native_scan_result->size() + scan_result.size());
   for (size_t i = 0; i < scan_result.size(); i++) {
-    NativeScanResult single_scan_result;
-    single_scan_result.ssid.assign(scan_result[i].networkInfo.ssid.begin(),
-                                   scan_result[i].networkInfo.ssid.end());
-    for (size_t j = 0; j < scan_result[i].bssid.elementCount(); j++) {
-      single_scan_result.bssid.push_back(scan_result[i].bssid[j]);
-    }
-    single_scan_result.frequency = scan_result[i].frequency;
-    single_scan_result.signal_mbm = scan_result[i].rssi;
-    single_scan_result.tsf = systemTime(SYSTEM_TIME_MONOTONIC) / 1000;
-    single_scan_result.capability = scan_result[i].capability;
+    const ScanResult& result = scan_result[i];
+    native_scan_result->emplace_back();
+    NativeScanResult& single_scan_result = native_scan_result->back();
+    const hidl_vec<uint8_t>& ssid = result.networkInfo.ssid;
+    single_scan_result.ssid.assign(ssid.data(), ssid.data() + ssid.size());
+    single_scan_result.bssid.assign(
+        result.bssid.data(), result.bssid.data() + result.bssid.elementCount());
+    single_scan_result.frequency = result.frequency;
+    single_scan_result.signal_mbm = result.rssi;
+    single_scan_result.tsf = tsf;
+    single_scan_result.capability = result.capability;
     single_scan_result.associated = false;
-    native_scan_result->push_back(std::move(single_scan_result));
   }
   return true;
 }
@@ -61,11 +66,10 @@ ScanParam OffloadScanUtils::createScanParam(
   ScanParam scan_param;
   scan_param.disconnectedModeScanIntervalMs = scan_interval_ms;
   scan_param.frequencyList = frequency_list;
-  vector<hidl_vec<uint8_t>> ssid_list_tmp;
-  for (const auto& ssid : ssid_list) {
-    ssid_list_tmp.push_back(ssid);
+  scan_param.ssidList.resize(ssid_list.size());
+  for (size_t i = 0; i < ssid_list.size(); i++) {
+    scan_param.ssidList[i] = ssid_list[i];
   }
-  scan_param.ssidList = ssid_list_tmp;
   return scan_param;
 }
 
@@ -73,21 +77,16 @@ ScanFilter OffloadScanUtils::createScanFilter(
     const vector<vector<uint8_t>>& ssids, const vector<uint8_t>& flags,
     int8_t rssi_threshold) {
   ScanFilter scan_filter;
-  vector<NetworkInfo> nw_info_list;
-  size_t i = 0;
   scan_filter.rssiThreshold = rssi_threshold;
-  // Note that the number of ssids should match the number of security flags
-  for (const auto& ssid : ssids) {
-    NetworkInfo nw_info;
-    nw_info.ssid = ssid;
-    if (i < flags.size()) {
-      nw_info.flags = flags[i++];
-    } else {
-      continue;
-    }
-    nw_info_list.push_back(nw_info);
+  // Note that the number of ssids should match the number of security flags.
+  // Ssids without a flag are left out.
+  size_t num_networks = std::min(ssids.size(), flags.size());
+  scan_filter.preferredNetworkInfoList.resize(num_networks);
+  for (size_t i = 0; i < num_networks; i++) {
+    NetworkInfo& nw_info = scan_filter.preferredNetworkInfoList[i];
+    nw_info.ssid = ssids[i];
+    nw_info.flags = flags[i];
   }
-  scan_filter.preferredNetworkInfoList = nw_info_list;
   return scan_filter;
 }
 
@@ -95,21 +94,23 @@ NativeScanStats OffloadScanUtils::convertToNativeScanStats(
     const ScanStats& scanStats) {
   uint32_t num_channels_scanned = 0;
   uint32_t scan_duration_ms = 0;
-  vector<uint8_t> histogram_channels;
 
   for (size_t i = 0; i < scanStats.scanRecord.size(); i++) {
     scan_duration_ms += scanStats.scanRecord[i].durationMs;
     num_channels_scanned += scanStats.scanRecord[i].numChannelsScanned;
   }
-  for (size_t i = 0; i < scanStats.histogramChannelsScanned.size(); i++) {
-    histogram_channels.push_back(scanStats.histogramChannelsScanned[i]);
+  const auto& histogram = scanStats.histogramChannelsScanned;
+  vector<uint8_t> histogram_channels(histogram.size());
+  for (size_t i = 0; i < histogram.size(); i++) {
+    // Saturate rather than wrap, so that a busy channel never reads as idle.
+    histogram_channels[i] = static_cast<uint8_t>(
+        std::min<uint32_t>(histogram[i], std::numeric_limits<uint8_t>::max()));
   }
 
-  NativeScanStats native_scan_stats(
+  return NativeScanStats(
       scanStats.numScansRequestedByWifi, scanStats.numScansServicedByWifi,
       scanStats.subscriptionDurationMs, scan_duration_ms, num_channels_scanned,
-      histogram_channels);
-  return native_scan_stats;
+      std::move(histogram_channels));
 }
 
 }  // namespace wificond
@@ -40,11 +40,19 @@ namespace android {
 namespace wificond {
 
 // Provides utility methods for Offload Scan Manager
+// Conversions size their output once and copy each field in bulk, so their
+// cost grows linearly with the number of bytes converted.
 class OffloadScanUtils {
  public:
+  /* Appends the conversion of |scan_result| to |native_scan_result|.
+   * All results of a batch get the same timestamp, since the Offload HAL
+   * delivers them at once.
+   */
   static bool convertToNativeScanResults(
-      const std::vector<android::hardware::wifi::offload::V1_0::ScanResult>&,
-      std::vector<::com::android::server::wifi::wificond::NativeScanResult>*);
+      const android::hardware::hidl_vec<
+          android::hardware::wifi::offload::V1_0::ScanResult>& scan_result,
+      std::vector<::com::android::server::wifi::wificond::NativeScanResult>*
+          native_scan_result);
   static android::hardware::wifi::offload::V1_0::ScanParam createScanParam(
       const std::vector<std::vector<uint8_t>>& ssid_list,
       const std::vector<uint32_t>& frequency_list, uint32_t scan_interval_ms);
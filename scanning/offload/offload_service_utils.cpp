@@ -23,9 +23,18 @@
 
 using ::android::hardware::wifi::offload::V1_0::IOffload;
 
+namespace {
+
+const int32_t kDefaultScanStatsSamplingPeriodMs = 15 * 60 * 1000;
+
+}  // namespace
+
 namespace android {
 namespace wificond {
 
+OffloadServiceUtils::OffloadServiceUtils(EventLoop* event_loop)
+    : event_loop_(event_loop) {}
+
 android::sp<IOffload> OffloadServiceUtils::GetOffloadService() {
   return IOffload::tryGetService();
 }
@@ -49,6 +58,18 @@ bool OffloadServiceUtils::IsOffloadScanSupported() const {
   return false;
 }
 
+uint32_t OffloadServiceUtils::GetScanStatsSamplingPeriodMs() const {
+  int32_t period_ms = property_get_int32("persist.wifi.offload.stats_period_ms",
+                                         kDefaultScanStatsSamplingPeriodMs);
+  return period_ms > 0 ? static_cast<uint32_t>(period_ms) : 0;
+}
+
+uint32_t OffloadServiceUtils::GetMaxPnoNetworks() const {
+  int32_t max_networks =
+      property_get_int32("persist.wifi.offload.max_pno_networks", 0);
+  return max_networks > 0 ? static_cast<uint32_t>(max_networks) : 0;
+}
+
 std::shared_ptr<OffloadScanCallbackInterfaceImpl>
 OffloadServiceUtils::GetOffloadScanCallbackInterface(ScannerImpl* parent) {
   return std::make_shared<OffloadScanCallbackInterfaceImpl>(parent);
@@ -60,6 +81,16 @@ std::shared_ptr<OffloadScanManager> OffloadServiceUtils::GetOffloadScanManager(
   return std::make_shared<OffloadScanManager>(service_utils, callback_interface);
 }
 
+bool OffloadServiceUtils::PostDelayedTask(const std::function<void()>& task,
+                                          int64_t delay_ms) {
+  if (event_loop_ == nullptr) {
+    LOG(ERROR) << "No event loop to post Offload HAL task to";
+    return false;
+  }
+  event_loop_->PostDelayedTask(task, delay_ms);
+  return true;
+}
+
 OffloadDeathRecipient::OffloadDeathRecipient(
     OffloadDeathRecipientHandler handler)
     : handler_(handler) {}
@@ -17,6 +17,7 @@
 #define WIFICOND_OFFLOAD_SERVICE_UTILS_H_
 
 #include <android/hardware/wifi/offload/1.0/IOffload.h>
+#include "wificond/event_loop.h"
 #include "wificond/scanning/offload/offload_callback.h"
 #include "wificond/scanning/offload/offload_callback_handlers.h"
 #include "wificond/scanning/offload_scan_callback_interface_impl.h"
@@ -46,12 +47,20 @@ class OffloadDeathRecipient : public android::hardware::hidl_death_recipient {
 // Provides methods to get Offload HAL service and create callback
 class OffloadServiceUtils {
  public:
-  OffloadServiceUtils() = default;
+  // |event_loop| runs the delayed tasks of the Offload HAL clients. It is
+  // the event loop of the main thread, which also handles the Offload HAL
+  // callbacks.
+  explicit OffloadServiceUtils(EventLoop* event_loop);
   virtual ~OffloadServiceUtils() = default;
   virtual android::sp<android::hardware::wifi::offload::V1_0::IOffload>
       GetOffloadService();
   // Check if Offload scan is supported on this device.
   virtual bool IsOffloadScanSupported() const;
+  // Period of sampling the scan statistics of the Offload HAL, or 0 not to
+  // sample them.
+  virtual uint32_t GetScanStatsSamplingPeriodMs() const;
+  // Number of networks the Offload HAL can match against, or 0 if unknown.
+  virtual uint32_t GetMaxPnoNetworks() const;
   virtual android::sp<OffloadCallback> GetOffloadCallback(
       OffloadCallbackHandlers* handlers);
   virtual OffloadDeathRecipient* GetOffloadDeathRecipient(
@@ -61,6 +70,13 @@ class OffloadServiceUtils {
   virtual std::shared_ptr<OffloadScanManager> GetOffloadScanManager(
       std::weak_ptr<OffloadServiceUtils> service_utils,
       std::shared_ptr<OffloadScanCallbackInterfaceImpl> callback_interface);
+  // Runs |task| on the event loop of wificond after |delay_ms|.
+  // Returns false if there is no event loop.
+  virtual bool PostDelayedTask(const std::function<void()>& task,
+                               int64_t delay_ms);
+
+ private:
+  EventLoop* const event_loop_;
 };
 
 }  // namespace wificond
@@ -40,7 +40,7 @@ NativeScanStats::NativeScanStats(uint32_t num_scans_requested_by_wifi,
       scan_duration_ms_(scan_duration_ms),
       num_channels_scanned_(num_channels_scanned),
       time_stamp_(0),
-      histogram_channels_(histogram_channels) {}
+      histogram_channels_(std::move(histogram_channels)) {}
 
 NativeScanStats::NativeScanStats()
     : num_scans_requested_by_wifi_(0),
@@ -54,7 +54,8 @@ bool NativeScanStats::operator==(const NativeScanStats& rhs) const {
   if ((rhs.num_scans_requested_by_wifi_ != num_scans_requested_by_wifi_) ||
       (rhs.num_scans_serviced_by_wifi_ != num_scans_serviced_by_wifi_) ||
       (rhs.scan_duration_ms_ != scan_duration_ms_) ||
-      (rhs.num_channels_scanned_ != num_channels_scanned_)) {
+      (rhs.num_channels_scanned_ != num_channels_scanned_) ||
+      (rhs.time_stamp_ != time_stamp_)) {
     return false;
   }
   if (rhs.histogram_channels_.size() != histogram_channels_.size()) {
@@ -75,6 +76,7 @@ status_t NativeScanStats::writeToParcel(::android::Parcel* parcel) const {
   RETURN_IF_FAILED(parcel->writeUint32(scan_duration_ms_));
   RETURN_IF_FAILED(parcel->writeUint32(num_channels_scanned_));
   RETURN_IF_FAILED(parcel->writeByteVector(histogram_channels_));
+  RETURN_IF_FAILED(parcel->writeUint32(time_stamp_));
   return ::android::OK;
 }
 
@@ -85,9 +87,40 @@ status_t NativeScanStats::readFromParcel(const ::android::Parcel* parcel) {
   RETURN_IF_FAILED(parcel->readUint32(&scan_duration_ms_));
   RETURN_IF_FAILED(parcel->readUint32(&num_channels_scanned_));
   RETURN_IF_FAILED(parcel->readByteVector(&histogram_channels_));
+  RETURN_IF_FAILED(parcel->readUint32(&time_stamp_));
   return ::android::OK;
 }
 
+double NativeScanStats::GetScansPerHour() const {
+  if (subscription_duration_ms_ == 0) {
+    return 0;
+  }
+  return num_scans_serviced_by_wifi_ * 3600000.0 / subscription_duration_ms_;
+}
+
+double NativeScanStats::GetChannelsPerScan() const {
+  if (num_scans_serviced_by_wifi_ == 0) {
+    return 0;
+  }
+  return static_cast<double>(num_channels_scanned_) /
+         num_scans_serviced_by_wifi_;
+}
+
+double NativeScanStats::GetDutyCycle() const {
+  if (subscription_duration_ms_ == 0) {
+    return 0;
+  }
+  return static_cast<double>(scan_duration_ms_) / subscription_duration_ms_;
+}
+
+double NativeScanStats::GetServicedRatio() const {
+  if (num_scans_requested_by_wifi_ == 0) {
+    return 0;
+  }
+  return static_cast<double>(num_scans_serviced_by_wifi_) /
+         num_scans_requested_by_wifi_;
+}
+
 void NativeScanStats::DebugLog() {
   LOG(INFO) << "num_scans_requested_by_wifi=" << num_scans_requested_by_wifi_;
   LOG(INFO) << "num_scans_serviced_by_wifi=" << num_scans_serviced_by_wifi_;
@@ -42,11 +42,22 @@ class NativeScanStats : public ::android::Parcelable {
   ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
   void DebugLog();
 
+  // Rates derived from the counters above. They are 0 when undefined.
+  // Scans serviced per hour of subscription.
+  double GetScansPerHour() const;
+  // Average number of channels scanned per serviced scan.
+  double GetChannelsPerScan() const;
+  // Share of the subscription time spent scanning, between 0 and 1.
+  double GetDutyCycle() const;
+  // Share of the requested scans which were serviced, between 0 and 1.
+  double GetServicedRatio() const;
+
   uint32_t num_scans_requested_by_wifi_;
   uint32_t num_scans_serviced_by_wifi_;
   uint32_t subscription_duration_ms_;
   uint32_t scan_duration_ms_;
   uint32_t num_channels_scanned_;
+  // Boot time in seconds when the stats were read from the Offload HAL.
   uint32_t time_stamp_;
   std::vector<uint8_t> histogram_channels_;
 };
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/offload/subscription_delay_policy.h"
+
+#include <algorithm>
+
+namespace android {
+namespace wificond {
+
+const uint32_t SubscriptionDelayPolicy::kInitialDelayMs = 1000;
+const uint32_t SubscriptionDelayPolicy::kMaxDelayMs = 60000;
+const uint32_t SubscriptionDelayPolicy::kBackoffFactor = 2;
+const uint32_t SubscriptionDelayPolicy::kScanIntervalsPerDelay = 2;
+
+SubscriptionDelayPolicy::SubscriptionDelayPolicy()
+    : delay_ms_(kInitialDelayMs),
+      max_delay_ms_(kInitialDelayMs) {}
+
+void SubscriptionDelayPolicy::Reset(uint32_t scan_interval_ms,
+                                    uint32_t requested_delay_ms) {
+  if (requested_delay_ms != 0) {
+    delay_ms_ = requested_delay_ms;
+    max_delay_ms_ = requested_delay_ms;
+    return;
+  }
+  uint64_t max_delay_ms =
+      static_cast<uint64_t>(scan_interval_ms) * kScanIntervalsPerDelay;
+  max_delay_ms_ = static_cast<uint32_t>(std::max<uint64_t>(
+      kInitialDelayMs, std::min<uint64_t>(max_delay_ms, kMaxDelayMs)));
+  delay_ms_ = kInitialDelayMs;
+}
+
+bool SubscriptionDelayPolicy::OnScanResultsReported() {
+  if (delay_ms_ >= max_delay_ms_) {
+    return false;
+  }
+  delay_ms_ = std::min(delay_ms_ * kBackoffFactor, max_delay_ms_);
+  return true;
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_OFFLOAD_SUBSCRIPTION_DELAY_POLICY_H_
+#define WIFICOND_SCANNING_OFFLOAD_SUBSCRIPTION_DELAY_POLICY_H_
+
+#include <cstdint>
+
+namespace android {
+namespace wificond {
+
+// Chooses how long the Offload HAL may hold scan results before reporting
+// them to wificond.
+// The first results of a scan request come out after a short delay. The
+// delay then backs off towards a bound derived from the scan interval, so
+// that results of consecutive scans are batched into fewer wakeups. The
+// framework scans less often when the device is idle, which lengthens the
+// bound accordingly.
+class SubscriptionDelayPolicy {
+ public:
+  static const uint32_t kInitialDelayMs;
+  static const uint32_t kMaxDelayMs;
+  static const uint32_t kBackoffFactor;
+  // The delay backs off to at most this many scan intervals.
+  static const uint32_t kScanIntervalsPerDelay;
+
+  SubscriptionDelayPolicy();
+  ~SubscriptionDelayPolicy() = default;
+
+  // Starts over for scans every |scan_interval_ms|.
+  // A non-zero |requested_delay_ms| is used as is, without backing off.
+  void Reset(uint32_t scan_interval_ms, uint32_t requested_delay_ms);
+
+  // Returns the delay to subscribe to scan results with.
+  uint32_t GetDelayMs() const { return delay_ms_; }
+
+  // Backs off once scan results were reported.
+  // Returns true if the delay changed, and the subscription needs updating.
+  bool OnScanResultsReported();
+
+ private:
+  uint32_t delay_ms_;
+  uint32_t max_delay_ms_;
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_OFFLOAD_SUBSCRIPTION_DELAY_POLICY_H_
@@ -34,6 +34,9 @@ class OffloadScanCallbackInterface {
 
   virtual void OnOffloadScanResult() = 0;
   virtual void OnOffloadError(AsyncErrorReason) = 0;
+  // Called when the Offload HAL restarted after a BINDER_DEATH error and the
+  // scans requested before have been restored.
+  virtual void OnOffloadScanRestored() = 0;
 };
 
 }  // namespace wificond
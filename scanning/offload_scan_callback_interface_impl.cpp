@@ -38,5 +38,9 @@ void OffloadScanCallbackInterfaceImpl::OnOffloadError(
   scanner_impl_->OnOffloadError(error_code);
 }
 
+void OffloadScanCallbackInterfaceImpl::OnOffloadScanRestored() {
+  scanner_impl_->OnOffloadScanRestored();
+}
+
 }  // namespace wificond
 }  // namespace android
@@ -33,6 +33,7 @@ class OffloadScanCallbackInterfaceImpl
 
   void OnOffloadScanResult() override;
   void OnOffloadError(OffloadScanCallbackInterface::AsyncErrorReason) override;
+  void OnOffloadScanRestored() override;
 
  private:
   ScannerImpl* scanner_impl_;
@@ -31,6 +31,7 @@ namespace wificond {
 status_t PnoNetwork::writeToParcel(::android::Parcel* parcel) const {
   RETURN_IF_FAILED(parcel->writeInt32(is_hidden_ ? 1 : 0));
   RETURN_IF_FAILED(parcel->writeByteVector(ssid_));
+  RETURN_IF_FAILED(parcel->writeInt64(last_connected_age_ms_));
   return ::android::OK;
 }
 
@@ -39,6 +40,7 @@ status_t PnoNetwork::readFromParcel(const ::android::Parcel* parcel) {
   RETURN_IF_FAILED(parcel->readInt32(&is_hidden));
   is_hidden_ = (is_hidden != 0);
   RETURN_IF_FAILED(parcel->readByteVector(&ssid_));
+  RETURN_IF_FAILED(parcel->readInt64(&last_connected_age_ms_));
   return ::android::OK;
 }
 
@@ -33,13 +33,17 @@ class PnoNetwork : public ::android::Parcelable {
   PnoNetwork() = default;
   bool operator==(const PnoNetwork& rhs) const {
     return is_hidden_ == rhs.is_hidden_ &&
-           ssid_ == rhs.ssid_;
+           ssid_ == rhs.ssid_ &&
+           last_connected_age_ms_ == rhs.last_connected_age_ms_;
   }
   ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
   ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
 
   bool is_hidden_;
   std::vector<uint8_t> ssid_;
+  // Milliseconds since we were last connected to this network.
+  // -1 if we never were, or the framework does not know.
+  int64_t last_connected_age_ms_{-1};
 };
 
 }  // namespace wificond
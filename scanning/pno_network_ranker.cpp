@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/pno_network_ranker.h"
+
+#include <algorithm>
+
+#include "wificond/scanning/pno_network.h"
+#include "wificond/scanning/scan_result.h"
+
+using com::android::server::wifi::wificond::NativeScanResult;
+using com::android::server::wifi::wificond::PnoNetwork;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+constexpr double kMillisecondsPerHour = 60 * 60 * 1000;
+
+double GetRecency(int64_t age_ms) {
+  return 1.0 / (1.0 + std::max<int64_t>(age_ms, 0) / kMillisecondsPerHour);
+}
+
+}  // namespace
+
+const double PnoNetworkRanker::kLastConnectedWeight = 4.0;
+const double PnoNetworkRanker::kLastSeenWeight = 2.0;
+const double PnoNetworkRanker::kHiddenNetworkBonus = 0.5;
+const uint32_t PnoNetworkRanker::kSlotsPerRotatingSlot = 4;
+const uint32_t PnoNetworkRanker::kMaxTrackedSsids = 128;
+
+void PnoNetworkRanker::OnScanResults(
+    const vector<NativeScanResult>& scan_results,
+    int64_t now_ms) {
+  for (const auto& result : scan_results) {
+    if (!result.ssid.empty()) {
+      last_seen_ms_[result.ssid] = now_ms;
+    }
+  }
+  while (last_seen_ms_.size() > kMaxTrackedSsids) {
+    auto oldest = std::min_element(
+        last_seen_ms_.begin(), last_seen_ms_.end(),
+        [](const std::pair<const vector<uint8_t>, int64_t>& lhs,
+           const std::pair<const vector<uint8_t>, int64_t>& rhs) {
+          return lhs.second < rhs.second;
+        });
+    last_seen_ms_.erase(oldest);
+  }
+}
+
+double PnoNetworkRanker::GetScore(const PnoNetwork& network,
+                                  int64_t now_ms) const {
+  double score = 0;
+  if (network.last_connected_age_ms_ >= 0) {
+    score += kLastConnectedWeight * GetRecency(network.last_connected_age_ms_);
+  }
+  auto last_seen = last_seen_ms_.find(network.ssid_);
+  if (last_seen != last_seen_ms_.end()) {
+    score += kLastSeenWeight * GetRecency(now_ms - last_seen->second);
+  }
+  if (network.is_hidden_) {
+    score += kHiddenNetworkBonus;
+  }
+  return score;
+}
+
+vector<size_t> PnoNetworkRanker::SelectNetworks(
+    const vector<PnoNetwork>& networks,
+    uint32_t max_networks,
+    uint32_t max_hidden_networks,
+    int64_t now_ms,
+    bool advance_rotation) {
+  vector<double> scores;
+  vector<size_t> ranked;
+  uint32_t num_hidden = 0;
+  for (size_t i = 0; i < networks.size(); i++) {
+    scores.push_back(GetScore(networks[i], now_ms));
+    ranked.push_back(i);
+    if (networks[i].is_hidden_) {
+      num_hidden++;
+    }
+  }
+  // Ties keep the framework order.
+  std::stable_sort(ranked.begin(), ranked.end(),
+                   [&scores](size_t lhs, size_t rhs) {
+                     return scores[lhs] > scores[rhs];
+                   });
+  if (networks.size() <= max_networks && num_hidden <= max_hidden_networks) {
+    return ranked;
+  }
+
+  // Hold back a share of the slots for the overflow.
+  uint32_t rotating_slots = 0;
+  if (networks.size() > max_networks) {
+    rotating_slots = std::max(1u, max_networks / kSlotsPerRotatingSlot);
+  }
+  uint32_t rotating_hidden_slots = 0;
+  if (num_hidden > max_hidden_networks && max_hidden_networks > 0) {
+    rotating_hidden_slots =
+        std::max(1u, max_hidden_networks / kSlotsPerRotatingSlot);
+  }
+
+  vector<size_t> selected;
+  vector<size_t> overflow;
+  uint32_t num_selected_hidden = 0;
+  for (size_t index : ranked) {
+    bool is_hidden = networks[index].is_hidden_;
+    if (selected.size() + rotating_slots >= max_networks ||
+        (is_hidden && num_selected_hidden + rotating_hidden_slots >=
+                          max_hidden_networks)) {
+      overflow.push_back(index);
+      continue;
+    }
+    selected.push_back(index);
+    if (is_hidden) {
+      num_selected_hidden++;
+    }
+  }
+  if (overflow.empty()) {
+    return selected;
+  }
+
+  // Fill the held back slots with the next window of the overflow.
+  // A network skipped for lack of hidden slots starts the next window, so
+  // that it is not passed over.
+  size_t start = rotation_offset_ % overflow.size();
+  size_t next_start = start + overflow.size();
+  bool skipped = false;
+  for (size_t i = 0; i < overflow.size(); i++) {
+    if (selected.size() >= max_networks) {
+      if (!skipped) {
+        next_start = start + i;
+      }
+      break;
+    }
+    size_t index = overflow[(start + i) % overflow.size()];
+    if (networks[index].is_hidden_) {
+      if (num_selected_hidden >= max_hidden_networks) {
+        if (!skipped) {
+          next_start = start + i;
+          skipped = true;
+        }
+        continue;
+      }
+      num_selected_hidden++;
+    }
+    selected.push_back(index);
+  }
+  if (advance_rotation) {
+    rotation_offset_ = next_start % overflow.size();
+  }
+  return selected;
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_PNO_NETWORK_RANKER_H_
+#define WIFICOND_SCANNING_PNO_NETWORK_RANKER_H_
+
+#include <map>
+#include <vector>
+
+#include <android-base/macros.h>
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+class NativeScanResult;
+class PnoNetwork;
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
+
+namespace android {
+namespace wificond {
+
+// Picks which saved networks go into a scheduled scan when the firmware
+// cannot hold all of them.
+// Networks are ranked by how recently they were connected to, how recently
+// they were seen in scan results, and whether they are hidden. The best
+// networks always get a slot, while the remaining slots rotate through the
+// overflow, one window per scheduled scan start, so that every saved network
+// is periodically covered.
+class PnoNetworkRanker {
+ public:
+  // Weights of the score components. Recency components decay as
+  // 1 / (1 + age in hours).
+  static const double kLastConnectedWeight;
+  static const double kLastSeenWeight;
+  static const double kHiddenNetworkBonus;
+  // One out of this many slots is reserved for rotating the overflow in.
+  static const uint32_t kSlotsPerRotatingSlot;
+  static const uint32_t kMaxTrackedSsids;
+
+  PnoNetworkRanker() = default;
+  virtual ~PnoNetworkRanker() = default;
+
+  // Remembers when the ssids in |scan_results| were last seen.
+  void OnScanResults(
+      const std::vector<::com::android::server::wifi::wificond::NativeScanResult>& scan_results,
+      int64_t now_ms);
+
+  // Returns the score of |network| at |now_ms|. Higher is better.
+  double GetScore(
+      const ::com::android::server::wifi::wificond::PnoNetwork& network,
+      int64_t now_ms) const;
+
+  // Returns the indices into |networks| of the networks to put in the next
+  // scheduled scan, best first.
+  // At most |max_networks| networks are selected, and at most
+  // |max_hidden_networks| of them are hidden.
+  // If |advance_rotation| is true, a call with more networks than slots
+  // moves the next call to a new rotation window.
+  std::vector<size_t> SelectNetworks(
+      const std::vector<::com::android::server::wifi::wificond::PnoNetwork>& networks,
+      uint32_t max_networks,
+      uint32_t max_hidden_networks,
+      int64_t now_ms,
+      bool advance_rotation);
+
+ private:
+  // Boot time in milliseconds of the last sighting, keyed by ssid.
+  std::map<std::vector<uint8_t>, int64_t> last_seen_ms_;
+  // Position in the overflow where the next rotation window starts.
+  size_t rotation_offset_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(PnoNetworkRanker);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_PNO_NETWORK_RANKER_H_
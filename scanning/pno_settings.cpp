@@ -42,6 +42,7 @@ status_t PnoSettings::writeToParcel(::android::Parcel* parcel) const {
     RETURN_IF_FAILED(parcel->writeInt32(1));
     RETURN_IF_FAILED(network.writeToParcel(parcel));
   }
+  RETURN_IF_FAILED(parcel->writeInt32(offload_subscription_delay_ms_));
   return ::android::OK;
 }
 
@@ -66,6 +67,7 @@ status_t PnoSettings::readFromParcel(const ::android::Parcel* parcel) {
     RETURN_IF_FAILED(network.readFromParcel(parcel));
     pno_networks_.push_back(network);
   }
+  RETURN_IF_FAILED(parcel->readInt32(&offload_subscription_delay_ms_));
   return ::android::OK;
 }
 
@@ -38,11 +38,15 @@ class PnoSettings : public ::android::Parcelable {
   PnoSettings()
       : interval_ms_(0),
         min_2g_rssi_(0),
-        min_5g_rssi_(0) {}
+        min_5g_rssi_(0),
+        offload_subscription_delay_ms_(0) {}
   bool operator==(const PnoSettings& rhs) const {
-    return (pno_networks_ == rhs.pno_networks_ &&
+    return (interval_ms_ == rhs.interval_ms_ &&
+            pno_networks_ == rhs.pno_networks_ &&
             min_2g_rssi_ == rhs.min_2g_rssi_ &&
-            min_5g_rssi_ == rhs.min_5g_rssi_);
+            min_5g_rssi_ == rhs.min_5g_rssi_ &&
+            offload_subscription_delay_ms_ ==
+                rhs.offload_subscription_delay_ms_);
   }
   ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
   ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
@@ -51,6 +55,9 @@ class PnoSettings : public ::android::Parcelable {
   int32_t min_2g_rssi_;
   int32_t min_5g_rssi_;
   std::vector<PnoNetwork> pno_networks_;
+  // How long the Offload HAL may hold scan results before reporting them.
+  // 0 lets wificond adapt it to |interval_ms_|.
+  int32_t offload_subscription_delay_ms_;
 };
 
 }  // namespace wificond
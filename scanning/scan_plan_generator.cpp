@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/scan_plan_generator.h"
+
+#include <algorithm>
+
+#include <android-base/logging.h>
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+constexpr uint32_t kMsecPerSec = 1000;
+
+// NL80211_ATTR_SCHED_SCAN_PLANS carries intervals in seconds.
+uint32_t RoundDownToSeconds(uint32_t interval_ms) {
+  return std::max(interval_ms / kMsecPerSec, 1u) * kMsecPerSec;
+}
+
+}  // namespace
+
+ScanPlanGenerator::ScanPlanGenerator(const ScanCapabilities& scan_capabilities)
+    : scan_capabilities_(scan_capabilities) {}
+
+SchedScanIntervalSetting ScanPlanGenerator::Generate(
+    const Config& config) const {
+  if (!SupportsScanPlans()) {
+    return SchedScanIntervalSetting{{}, config.fast_interval_ms};
+  }
+  uint32_t max_interval_ms =
+      scan_capabilities_.max_scan_plan_interval * kMsecPerSec;
+  uint32_t slow_interval_ms = std::min(
+      RoundDownToSeconds(config.slow_interval_ms), max_interval_ms);
+  uint32_t interval_ms = std::min(
+      RoundDownToSeconds(config.fast_interval_ms), slow_interval_ms);
+  uint32_t n_iterations = std::min(
+      std::max(config.iterations_per_plan, 1u),
+      scan_capabilities_.max_scan_plan_iterations);
+
+  SchedScanIntervalSetting interval_setting;
+  // The last, infinite plan counts towards |max_num_scan_plans| too.
+  while (interval_ms < slow_interval_ms &&
+         interval_setting.plans.size() + 1 <
+             scan_capabilities_.max_num_scan_plans) {
+    interval_setting.plans.push_back({interval_ms, n_iterations});
+    if (config.backoff_factor < 2 ||
+        interval_ms > slow_interval_ms / config.backoff_factor) {
+      interval_ms = slow_interval_ms;
+    } else {
+      interval_ms = RoundDownToSeconds(interval_ms * config.backoff_factor);
+    }
+  }
+  interval_setting.final_interval_ms = slow_interval_ms;
+  return interval_setting;
+}
+
+bool ScanPlanGenerator::IsValid(
+    const SchedScanIntervalSetting& interval_setting) const {
+  if (interval_setting.plans.empty()) {
+    // Sent as a single NL80211_ATTR_SCHED_SCAN_INTERVAL in milliseconds.
+    return interval_setting.final_interval_ms > 0;
+  }
+  if (!SupportsScanPlans()) {
+    LOG(ERROR) << "Scan plans are not supported";
+    return false;
+  }
+  if (interval_setting.plans.size() + 1 >
+      scan_capabilities_.max_num_scan_plans) {
+    LOG(ERROR) << "Too many scan plans: " << interval_setting.plans.size() + 1;
+    return false;
+  }
+  uint32_t max_interval_ms =
+      scan_capabilities_.max_scan_plan_interval * kMsecPerSec;
+  for (const auto& plan : interval_setting.plans) {
+    if (plan.interval_ms < kMsecPerSec || plan.interval_ms > max_interval_ms) {
+      LOG(ERROR) << "Invalid scan plan interval: " << plan.interval_ms;
+      return false;
+    }
+    if (plan.n_iterations == 0 ||
+        plan.n_iterations > scan_capabilities_.max_scan_plan_iterations) {
+      LOG(ERROR) << "Invalid scan plan iterations: " << plan.n_iterations;
+      return false;
+    }
+  }
+  if (interval_setting.final_interval_ms < kMsecPerSec ||
+      interval_setting.final_interval_ms > max_interval_ms) {
+    LOG(ERROR) << "Invalid final scan plan interval: "
+               << interval_setting.final_interval_ms;
+    return false;
+  }
+  return true;
+}
+
+bool ScanPlanGenerator::SupportsScanPlans() const {
+  // At least one finite plan followed by the infinite one.
+  return scan_capabilities_.max_num_scan_plans >= 2 &&
+         scan_capabilities_.max_scan_plan_interval > 0 &&
+         scan_capabilities_.max_scan_plan_iterations > 0;
+}
+
+}  // namespace wificond
+}  // namespace android
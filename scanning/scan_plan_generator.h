@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_SCAN_PLAN_GENERATOR_H_
+#define WIFICOND_SCANNING_SCAN_PLAN_GENERATOR_H_
+
+#include <android-base/macros.h>
+
+#include "wificond/net/netlink_utils.h"
+#include "wificond/scanning/scan_utils.h"
+
+namespace android {
+namespace wificond {
+
+// Generates scheduled scan plans which back off exponentially from a fast
+// scan interval to a slow one, fitted to the scan plan limits of a wiphy.
+class ScanPlanGenerator {
+ public:
+  struct Config {
+    // Interval of the first plan.
+    uint32_t fast_interval_ms;
+    // Interval of the last, infinite plan.
+    uint32_t slow_interval_ms;
+    // Each plan scans |backoff_factor| times less often than the previous
+    // one, until |slow_interval_ms| is reached.
+    uint32_t backoff_factor;
+    // Number of scans of each finite plan.
+    uint32_t iterations_per_plan;
+  };
+
+  explicit ScanPlanGenerator(const ScanCapabilities& scan_capabilities);
+  ~ScanPlanGenerator() = default;
+
+  // Returns the scan plans for |config|.
+  // Intervals are rounded down to whole seconds and capped by
+  // |max_scan_plan_interval|, iterations are capped by
+  // |max_scan_plan_iterations|, and intermediate plans are dropped to stay
+  // within |max_num_scan_plans|.
+  // Returns a single |fast_interval_ms| interval if the wiphy doesn't
+  // support scan plans. The driver/firmware is then expected to implement
+  // its own back off logic.
+  SchedScanIntervalSetting Generate(const Config& config) const;
+
+  // Returns true if |interval_setting| can be sent to this wiphy as is.
+  bool IsValid(const SchedScanIntervalSetting& interval_setting) const;
+
+ private:
+  bool SupportsScanPlans() const;
+
+  const ScanCapabilities scan_capabilities_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanPlanGenerator);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_SCAN_PLAN_GENERATOR_H_
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/scan_result_delta.h"
+
+#include <android-base/logging.h>
+
+#include "wificond/parcelable_utils.h"
+
+using android::status_t;
+using std::vector;
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+namespace {
+
+status_t WriteScanResults(const vector<NativeScanResult>& scan_results,
+                          ::android::Parcel* parcel) {
+  RETURN_IF_FAILED(parcel->writeInt32(scan_results.size()));
+  for (const auto& scan_result : scan_results) {
+    // For Java readTypedList():
+    // A leading number 1 means this object is not null.
+    RETURN_IF_FAILED(parcel->writeInt32(1));
+    RETURN_IF_FAILED(scan_result.writeToParcel(parcel));
+  }
+  return ::android::OK;
+}
+
+status_t ReadScanResults(const ::android::Parcel* parcel,
+                         vector<NativeScanResult>* scan_results) {
+  int32_t num_scan_results = 0;
+  RETURN_IF_FAILED(parcel->readInt32(&num_scan_results));
+  for (int i = 0; i < num_scan_results; i++) {
+    NativeScanResult scan_result;
+    // From Java writeTypedList():
+    // A leading number 1 means this object is not null.
+    // We never expect a 0 or other values here.
+    int32_t leading_number = 0;
+    RETURN_IF_FAILED(parcel->readInt32(&leading_number));
+    if (leading_number != 1) {
+      LOG(ERROR) << "Unexpected leading number before an object: "
+                 << leading_number;
+      return ::android::BAD_VALUE;
+    }
+    RETURN_IF_FAILED(scan_result.readFromParcel(parcel));
+    scan_results->push_back(scan_result);
+  }
+  return ::android::OK;
+}
+
+}  // namespace
+
+status_t ScanResultDelta::writeToParcel(::android::Parcel* parcel) const {
+  RETURN_IF_FAILED(WriteScanResults(added_, parcel));
+  RETURN_IF_FAILED(WriteScanResults(updated_, parcel));
+  RETURN_IF_FAILED(parcel->writeInt32(lost_bssids_.size()));
+  for (const auto& bssid : lost_bssids_) {
+    RETURN_IF_FAILED(parcel->writeByteVector(bssid));
+  }
+  return ::android::OK;
+}
+
+status_t ScanResultDelta::readFromParcel(const ::android::Parcel* parcel) {
+  RETURN_IF_FAILED(ReadScanResults(parcel, &added_));
+  RETURN_IF_FAILED(ReadScanResults(parcel, &updated_));
+  int32_t num_lost_bssids = 0;
+  RETURN_IF_FAILED(parcel->readInt32(&num_lost_bssids));
+  for (int i = 0; i < num_lost_bssids; i++) {
+    vector<uint8_t> bssid;
+    RETURN_IF_FAILED(parcel->readByteVector(&bssid));
+    lost_bssids_.push_back(bssid);
+  }
+  return ::android::OK;
+}
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
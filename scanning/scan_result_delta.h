@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_SCAN_RESULT_DELTA_H_
+#define WIFICOND_SCANNING_SCAN_RESULT_DELTA_H_
+
+#include <vector>
+
+#include <binder/Parcel.h>
+#include <binder/Parcelable.h>
+
+#include "wificond/scanning/scan_result.h"
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+// Changes of the scan results between two consecutive scans.
+class ScanResultDelta : public ::android::Parcelable {
+ public:
+  ScanResultDelta() = default;
+  bool empty() const {
+    return added_.empty() && updated_.empty() && lost_bssids_.empty();
+  }
+  ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
+  ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
+
+  // BSSs that were not in the previous scan results.
+  std::vector<NativeScanResult> added_;
+  // BSSs whose signal, frequency, capabilities or information elements
+  // changed noticeably since they were last reported.
+  std::vector<NativeScanResult> updated_;
+  // BSSIDs of the BSSs that aged out of the scan results.
+  std::vector<std::vector<uint8_t>> lost_bssids_;
+};
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
+
+#endif  // WIFICOND_SCANNING_SCAN_RESULT_DELTA_H_
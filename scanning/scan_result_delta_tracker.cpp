@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/scan_result_delta_tracker.h"
+
+#include <cstdlib>
+
+using com::android::server::wifi::wificond::NativeScanResult;
+using com::android::server::wifi::wificond::ScanResultDelta;
+using std::map;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+// FNV-1a, a cheap first check before comparing information elements.
+uint32_t HashInfoElement(const vector<uint8_t>& info_element) {
+  uint32_t hash = 2166136261u;
+  for (uint8_t byte : info_element) {
+    hash = (hash ^ byte) * 16777619u;
+  }
+  return hash;
+}
+
+}  // namespace
+
+const int32_t ScanResultDeltaTracker::kSignalChangeThresholdMbm = 300;
+
+ScanResultDelta ScanResultDeltaTracker::Update(
+    const vector<NativeScanResult>& scan_results) {
+  ScanResultDelta delta;
+  map<vector<uint8_t>, ReportedBss> current_bss;
+  for (const auto& result : scan_results) {
+    ReportedBss bss = {result.frequency, result.signal_mbm, result.capability,
+                       result.associated, HashInfoElement(result.info_element),
+                       result.info_element};
+    auto reported = reported_bss_.find(result.bssid);
+    if (reported == reported_bss_.end()) {
+      delta.added_.push_back(result);
+    } else if (reported->second.frequency != bss.frequency ||
+               reported->second.capability != bss.capability ||
+               reported->second.associated != bss.associated ||
+               reported->second.info_element_hash != bss.info_element_hash ||
+               reported->second.info_element != bss.info_element ||
+               std::abs(reported->second.signal_mbm - bss.signal_mbm) >=
+                   kSignalChangeThresholdMbm) {
+      delta.updated_.push_back(result);
+    } else {
+      // Keep the reported signal as the reference so that slow drifts are
+      // reported once they add up.
+      bss = reported->second;
+    }
+    current_bss[result.bssid] = bss;
+  }
+  for (const auto& reported : reported_bss_) {
+    if (current_bss.find(reported.first) == current_bss.end()) {
+      delta.lost_bssids_.push_back(reported.first);
+    }
+  }
+  reported_bss_.swap(current_bss);
+  return delta;
+}
+
+void ScanResultDeltaTracker::Reset() {
+  reported_bss_.clear();
+}
+
+}  // namespace wificond
+}  // namespace android
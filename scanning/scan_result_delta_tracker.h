@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_SCAN_RESULT_DELTA_TRACKER_H_
+#define WIFICOND_SCANNING_SCAN_RESULT_DELTA_TRACKER_H_
+
+#include <map>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "wificond/scanning/scan_result_delta.h"
+
+namespace android {
+namespace wificond {
+
+// Remembers what was last reported about each BSS, and computes the
+// changes of the scan results against it.
+class ScanResultDeltaTracker {
+ public:
+  // Signal changes smaller than this, against the last reported signal, are
+  // not reported.
+  static const int32_t kSignalChangeThresholdMbm;
+
+  ScanResultDeltaTracker() = default;
+  virtual ~ScanResultDeltaTracker() = default;
+
+  // Returns the changes of |scan_results| against the previously reported
+  // scan results, and takes them as the new reference.
+  ::com::android::server::wifi::wificond::ScanResultDelta Update(
+      const std::vector<::com::android::server::wifi::wificond::NativeScanResult>& scan_results);
+
+  // Forgets every reported BSS. The next update reports all BSSs as added.
+  void Reset();
+
+  size_t GetNumTrackedBss() const { return reported_bss_.size(); }
+
+ private:
+  struct ReportedBss {
+    uint32_t frequency;
+    int32_t signal_mbm;
+    uint16_t capability;
+    bool associated;
+    // Tells most changes apart without comparing |info_element|, which
+    // settles hash collisions.
+    uint32_t info_element_hash;
+    std::vector<uint8_t> info_element;
+  };
+
+  // Keyed by BSSID.
+  std::map<std::vector<uint8_t>, ReportedBss> reported_bss_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanResultDeltaTracker);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_SCAN_RESULT_DELTA_TRACKER_H_
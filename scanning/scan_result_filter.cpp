@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "wificond/scanning/scan_result_filter.h"
+
+#include <android-base/logging.h>
+
+#include "wificond/parcelable_utils.h"
+
+using android::status_t;
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+status_t ScanResultFilter::writeToParcel(::android::Parcel* parcel) const {
+  RETURN_IF_FAILED(parcel->writeInt32(min_signal_mbm_));
+  RETURN_IF_FAILED(parcel->writeInt32Vector(frequencies_));
+  RETURN_IF_FAILED(parcel->writeInt64(max_age_ms_));
+  RETURN_IF_FAILED(parcel->writeInt64(min_timestamp_us_));
+  RETURN_IF_FAILED(parcel->writeInt32(ssids_.size()));
+  for (const auto& ssid : ssids_) {
+    RETURN_IF_FAILED(parcel->writeByteVector(ssid));
+  }
+  RETURN_IF_FAILED(parcel->writeInt32(max_results_));
+  return ::android::OK;
+}
+
+status_t ScanResultFilter::readFromParcel(const ::android::Parcel* parcel) {
+  RETURN_IF_FAILED(parcel->readInt32(&min_signal_mbm_));
+  RETURN_IF_FAILED(parcel->readInt32Vector(&frequencies_));
+  RETURN_IF_FAILED(parcel->readInt64(&max_age_ms_));
+  RETURN_IF_FAILED(parcel->readInt64(&min_timestamp_us_));
+  int32_t num_ssids = 0;
+  RETURN_IF_FAILED(parcel->readInt32(&num_ssids));
+  ssids_.clear();
+  for (int i = 0; i < num_ssids; i++) {
+    std::vector<uint8_t> ssid;
+    RETURN_IF_FAILED(parcel->readByteVector(&ssid));
+    ssids_.push_back(std::move(ssid));
+  }
+  RETURN_IF_FAILED(parcel->readInt32(&max_results_));
+  return ::android::OK;
+}
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
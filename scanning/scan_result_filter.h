@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WIFICOND_SCANNING_SCAN_RESULT_FILTER_H_
+#define WIFICOND_SCANNING_SCAN_RESULT_FILTER_H_
+
+#include <limits>
+#include <vector>
+
+#include <binder/Parcel.h>
+#include <binder/Parcelable.h>
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+// Criteria a scan result must meet to be returned by
+// IWifiScannerImpl::getFilteredScanResults().
+// A default constructed filter accepts every scan result.
+class ScanResultFilter : public ::android::Parcelable {
+ public:
+  ScanResultFilter()
+      : min_signal_mbm_(std::numeric_limits<int32_t>::min()),
+        max_age_ms_(0),
+        min_timestamp_us_(0),
+        max_results_(0) {}
+  bool operator==(const ScanResultFilter& rhs) const {
+    return min_signal_mbm_ == rhs.min_signal_mbm_ &&
+           frequencies_ == rhs.frequencies_ &&
+           max_age_ms_ == rhs.max_age_ms_ &&
+           min_timestamp_us_ == rhs.min_timestamp_us_ &&
+           ssids_ == rhs.ssids_ &&
+           max_results_ == rhs.max_results_;
+  }
+  ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
+  ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
+
+  // Results with a signal strength (100 * dBm) below this are dropped.
+  int32_t min_signal_mbm_;
+  // Frequencies in MHz to accept. Empty means any frequency.
+  std::vector<int32_t> frequencies_;
+  // Results last seen more than |max_age_ms_| milliseconds ago are dropped.
+  // 0 means no age limit.
+  int64_t max_age_ms_;
+  // Results last seen before this time (microseconds since boot) are
+  // dropped. 0 means no limit.
+  // Both age filters need the NL80211_BSS_LAST_SEEN_BOOTTIME stamp. Results
+  // from drivers which only report a TSF are not filtered by age.
+  int64_t min_timestamp_us_;
+  // SSIDs to accept. Empty means any SSID.
+  std::vector<std::vector<uint8_t>> ssids_;
+  // Only the |max_results_| strongest results are returned, strongest
+  // first. 0 means no limit.
+  int32_t max_results_;
+};
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
+
+#endif  // WIFICOND_SCANNING_SCAN_RESULT_FILTER_H_
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WIFICOND_SCANNING_SCAN_RESULT_PROJECTION_H_
+#define WIFICOND_SCANNING_SCAN_RESULT_PROJECTION_H_
+
+#include <vector>
+
+#include <binder/Parcel.h>
+#include <binder/Parcelable.h>
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+// Describes which parts of a scan result are returned by
+// IWifiScannerImpl::getFilteredScanResults().
+// A default constructed projection keeps every field.
+class ScanResultProjection : public ::android::Parcelable {
+ public:
+  ScanResultProjection() : omit_info_elements_(false) {}
+  bool operator==(const ScanResultProjection& rhs) const {
+    return omit_info_elements_ == rhs.omit_info_elements_ &&
+           info_element_ids_ == rhs.info_element_ids_;
+  }
+  ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
+  ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
+
+  // Drop the information elements blob entirely.
+  bool omit_info_elements_;
+  // Element IDs of the information elements to keep.
+  // Empty means keep all of them.
+  // Ignored if |omit_info_elements_| is true.
+  std::vector<int32_t> info_element_ids_;
+};
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
+
+#endif  // WIFICOND_SCANNING_SCAN_RESULT_PROJECTION_H_
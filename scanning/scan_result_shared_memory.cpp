@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "wificond/scanning/scan_result_shared_memory.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/memfd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <android-base/logging.h>
+#include <cutils/ashmem.h>
+
+#include "wificond/scanning/scan_result.h"
+
+using com::android::server::wifi::wificond::NativeScanResult;
+using std::vector;
+
+namespace android {
+namespace wificond {
+namespace {
+
+constexpr char kRegionName[] = "wificond_scan_results";
+constexpr size_t kBssidSize = 6;
+constexpr size_t kRecordAlignment = 8;
+
+struct FlatHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t num_results;
+  uint32_t total_size;
+};
+static_assert(sizeof(FlatHeader) == 16, "Unexpected FlatHeader size");
+
+struct FlatRecord {
+  uint32_t frequency;
+  int32_t signal_mbm;
+  uint64_t tsf;
+  uint16_t capability;
+  uint8_t associated;
+  uint8_t ssid_size;
+  uint8_t bssid[kBssidSize];
+  uint16_t reserved;
+  uint32_t info_element_size;
+};
+static_assert(sizeof(FlatRecord) == 32, "Unexpected FlatRecord size");
+
+size_t AlignRecordSize(size_t size) {
+  return (size + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+}  // namespace
+
+const uint32_t ScanResultSharedMemory::kMagic = 0x57534352;  // 'WSCR'
+const uint32_t ScanResultSharedMemory::kVersion = 1;
+
+bool ScanResultSharedMemory::Update(const vector<NativeScanResult>& scan_results,
+                                    int* out_fd) {
+  vector<uint8_t> data;
+  Serialize(scan_results, &data);
+  if (region_fd_.get() >= 0 && data == region_data_) {
+    reuse_count_++;
+    *out_fd = region_fd_.get();
+    return true;
+  }
+  if (!CreateRegion(data)) {
+    return false;
+  }
+  region_data_ = std::move(data);
+  *out_fd = region_fd_.get();
+  return true;
+}
+
+bool ScanResultSharedMemory::CreateRegion(const vector<uint8_t>& data) {
+  android::base::unique_fd fd(static_cast<int>(
+      syscall(__NR_memfd_create, kRegionName, MFD_CLOEXEC | MFD_ALLOW_SEALING)));
+  if (fd.get() < 0) {
+    if (errno == ENOSYS) {
+      return CreateAshmemRegion(data);
+    }
+    PLOG(ERROR) << "Failed to create memfd for scan results";
+    return false;
+  }
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t ret = TEMP_FAILURE_RETRY(
+        write(fd.get(), data.data() + written, data.size() - written));
+    if (ret <= 0) {
+      PLOG(ERROR) << "Failed to write scan results to memfd";
+      return false;
+    }
+    written += ret;
+  }
+  // Readers only get a read-only view of an immutable region.
+  if (fcntl(fd.get(), F_ADD_SEALS,
+            F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+    PLOG(ERROR) << "Failed to seal scan result memfd";
+    return false;
+  }
+  region_fd_ = std::move(fd);
+  return true;
+}
+
+bool ScanResultSharedMemory::CreateAshmemRegion(const vector<uint8_t>& data) {
+  android::base::unique_fd fd(ashmem_create_region(kRegionName, data.size()));
+  if (fd.get() < 0) {
+    PLOG(ERROR) << "Failed to create ashmem region for scan results";
+    return false;
+  }
+  // Ashmem regions can't be written to, only mapped.
+  void* addr = mmap(nullptr, data.size(), PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd.get(), 0);
+  if (addr == MAP_FAILED) {
+    PLOG(ERROR) << "Failed to map ashmem region for scan results";
+    return false;
+  }
+  memcpy(addr, data.data(), data.size());
+  munmap(addr, data.size());
+  // Same as sealing a memfd: readers can't map the region writable.
+  if (ashmem_set_prot_region(fd.get(), PROT_READ) != 0) {
+    PLOG(ERROR) << "Failed to make scan result ashmem region read-only";
+    return false;
+  }
+  region_fd_ = std::move(fd);
+  return true;
+}
+
+void ScanResultSharedMemory::Serialize(const vector<NativeScanResult>& scan_results,
+                                       vector<uint8_t>* out_data) {
+  size_t total_size = sizeof(FlatHeader);
+  for (const auto& result : scan_results) {
+    total_size += AlignRecordSize(sizeof(FlatRecord) + result.ssid.size() +
+                                  result.info_element.size());
+  }
+  // Zero fill so that padding bytes are deterministic.
+  out_data->assign(total_size, 0);
+
+  uint8_t* ptr = out_data->data();
+  FlatHeader header = {kMagic, kVersion,
+                       static_cast<uint32_t>(scan_results.size()),
+                       static_cast<uint32_t>(total_size)};
+  memcpy(ptr, &header, sizeof(header));
+  ptr += sizeof(header);
+
+  for (const auto& result : scan_results) {
+    FlatRecord record = {};
+    record.frequency = result.frequency;
+    record.signal_mbm = result.signal_mbm;
+    record.tsf = result.tsf;
+    record.capability = result.capability;
+    record.associated = result.associated ? 1 : 0;
+    record.ssid_size = static_cast<uint8_t>(result.ssid.size());
+    memcpy(record.bssid, result.bssid.data(),
+           std::min(result.bssid.size(), kBssidSize));
+    record.info_element_size = result.info_element.size();
+
+    uint8_t* record_start = ptr;
+    memcpy(ptr, &record, sizeof(record));
+    ptr += sizeof(record);
+    memcpy(ptr, result.ssid.data(), record.ssid_size);
+    ptr += record.ssid_size;
+    memcpy(ptr, result.info_element.data(), record.info_element_size);
+    ptr = record_start + AlignRecordSize(ptr - record_start);
+  }
+}
+
+bool ScanResultSharedMemory::Deserialize(const uint8_t* data,
+                                         size_t size,
+                                         vector<NativeScanResult>* out_scan_results) {
+  FlatHeader header;
+  if (size < sizeof(header)) {
+    LOG(ERROR) << "Scan result region is too small: " << size;
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != kMagic || header.version != kVersion ||
+      header.total_size > size) {
+    LOG(ERROR) << "Invalid scan result region header";
+    return false;
+  }
+
+  const uint8_t* end = data + header.total_size;
+  const uint8_t* ptr = data + sizeof(header);
+  out_scan_results->reserve(out_scan_results->size() + header.num_results);
+  for (uint32_t i = 0; i < header.num_results; i++) {
+    FlatRecord record;
+    if (end - ptr < static_cast<ptrdiff_t>(sizeof(record))) {
+      LOG(ERROR) << "Truncated scan result record";
+      return false;
+    }
+    memcpy(&record, ptr, sizeof(record));
+    size_t record_size = AlignRecordSize(
+        sizeof(record) + record.ssid_size + record.info_element_size);
+    if (static_cast<size_t>(end - ptr) < record_size) {
+      LOG(ERROR) << "Truncated scan result record payload";
+      return false;
+    }
+    const uint8_t* payload = ptr + sizeof(record);
+
+    NativeScanResult result;
+    result.ssid.assign(payload, payload + record.ssid_size);
+    result.bssid.assign(record.bssid, record.bssid + kBssidSize);
+    payload += record.ssid_size;
+    result.info_element.assign(payload, payload + record.info_element_size);
+    result.frequency = record.frequency;
+    result.signal_mbm = record.signal_mbm;
+    result.tsf = record.tsf;
+    result.capability = record.capability;
+    result.associated = (record.associated != 0);
+    out_scan_results->push_back(std::move(result));
+    ptr += record_size;
+  }
+  return true;
+}
+
+}  // namespace wificond
+}  // namespace android
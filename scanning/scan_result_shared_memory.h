@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WIFICOND_SCANNING_SCAN_RESULT_SHARED_MEMORY_H_
+#define WIFICOND_SCANNING_SCAN_RESULT_SHARED_MEMORY_H_
+
+#include <vector>
+
+#include <android-base/macros.h>
+#include <android-base/unique_fd.h>
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+class NativeScanResult;
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
+
+namespace android {
+namespace wificond {
+
+// Transfers scan results in bulk through a sealed, read-only memfd region
+// instead of marshalling every NativeScanResult through a Parcel.
+// Kernels without memfd_create() get a read-only ashmem region instead.
+//
+// The region holds a flat layout, all fields in host byte order:
+// Header: | magic u32 | version u32 | num_results u32 | total_size u32 |
+// Record: | frequency u32 | signal_mbm i32 | tsf u64 | capability u16 |
+//         | associated u8 | ssid_size u8 | bssid u8[6] | reserved u16 |
+//         | info_element_size u32 | ssid | info_element | padding |
+// Every record starts on an 8 byte boundary.
+class ScanResultSharedMemory {
+ public:
+  static const uint32_t kMagic;
+  static const uint32_t kVersion;
+
+  ScanResultSharedMemory() = default;
+  ~ScanResultSharedMemory() = default;
+
+  // Publishes |scan_results| in a sealed memory region.
+  // If |scan_results| are identical to the previously published ones the
+  // existing region is reused, otherwise a new region replaces it.
+  // The file descriptor of the region is returned by |*out_fd|. It remains
+  // owned by this object and stays valid until the next call to Update().
+  // Returns true on success.
+  bool Update(
+      const std::vector<::com::android::server::wifi::wificond::NativeScanResult>& scan_results,
+      int* out_fd);
+
+  // File descriptor of the current region, or -1 before the first
+  // successful Update(). It remains owned by this object.
+  int GetFd() const { return region_fd_.get(); }
+
+  // Number of Update() calls that reused the existing region.
+  uint32_t GetReuseCount() const { return reuse_count_; }
+
+  // Serializes |scan_results| into the flat layout described above.
+  static void Serialize(
+      const std::vector<::com::android::server::wifi::wificond::NativeScanResult>& scan_results,
+      std::vector<uint8_t>* out_data);
+
+  // Parses a buffer of |size| bytes in the flat layout described above.
+  // Returns false if the buffer is malformed.
+  static bool Deserialize(
+      const uint8_t* data,
+      size_t size,
+      std::vector<::com::android::server::wifi::wificond::NativeScanResult>* out_scan_results);
+
+ private:
+  bool CreateRegion(const std::vector<uint8_t>& data);
+  bool CreateAshmemRegion(const std::vector<uint8_t>& data);
+
+  android::base::unique_fd region_fd_;
+  // Copy of the bytes in the current region, used for change detection.
+  std::vector<uint8_t> region_data_;
+  uint32_t reuse_count_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(ScanResultSharedMemory);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_SCAN_RESULT_SHARED_MEMORY_H_
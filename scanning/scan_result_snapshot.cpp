@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/scan_result_snapshot.h"
+
+#include <utility>
+
+using com::android::server::wifi::wificond::NativeScanResult;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+ScanResultSnapshotCache::ScanResultSnapshotCache()
+    : snapshot_(std::make_shared<vector<NativeScanResult>>()) {}
+
+ScanResultSnapshot ScanResultSnapshotCache::Get() const {
+  return std::atomic_load(&snapshot_);
+}
+
+void ScanResultSnapshotCache::Publish(vector<NativeScanResult> scan_results) {
+  ScanResultSnapshot snapshot =
+      std::make_shared<vector<NativeScanResult>>(std::move(scan_results));
+  std::atomic_store(&snapshot_, snapshot);
+}
+
+void ScanResultSnapshotCache::Clear() {
+  Publish(vector<NativeScanResult>());
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_SCAN_RESULT_SNAPSHOT_H_
+#define WIFICOND_SCANNING_SCAN_RESULT_SNAPSHOT_H_
+
+#include <memory>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "wificond/scanning/scan_result.h"
+
+namespace android {
+namespace wificond {
+
+// An immutable set of scan results. Holding a snapshot keeps it alive and
+// unchanged, however many newer snapshots are published meanwhile.
+// Never nullptr when returned by ScanResultSnapshotCache.
+typedef std::shared_ptr<
+    const std::vector<::com::android::server::wifi::wificond::NativeScanResult>>
+    ScanResultSnapshot;
+
+// Holds the latest scan results of one source, e.g. the Offload HAL or the
+// kernel, as a ScanResultSnapshot.
+// New results are published by swapping in a complete snapshot, so readers
+// on other threads either get the previous snapshot or the new one, never a
+// partially written one.
+class ScanResultSnapshotCache {
+ public:
+  ScanResultSnapshotCache();
+  ~ScanResultSnapshotCache() = default;
+
+  // Returns the latest snapshot. This only takes a reference.
+  ScanResultSnapshot Get() const;
+
+  // Replaces the latest snapshot with |scan_results|.
+  void Publish(
+      std::vector<::com::android::server::wifi::wificond::NativeScanResult>
+          scan_results);
+
+  // Replaces the latest snapshot with an empty one.
+  void Clear();
+
+ private:
+  // Only accessed through std::atomic_load() and std::atomic_store().
+  ScanResultSnapshot snapshot_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanResultSnapshotCache);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_SCAN_RESULT_SNAPSHOT_H_
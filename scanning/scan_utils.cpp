@@ -16,21 +16,31 @@
 
 #include "wificond/scanning/scan_utils.h"
 
+#include <algorithm>
+#include <iterator>
 #include <vector>
 
 #include <linux/netlink.h>
 #include <linux/nl80211.h>
 
 #include <android-base/logging.h>
+#include <utils/Timers.h>
 
+#include "android/net/wifi/IWifiScannerImpl.h"
 #include "wificond/net/netlink_manager.h"
 #include "wificond/net/nl80211_packet.h"
 #include "wificond/scanning/scan_result.h"
+#include "wificond/scanning/scan_result_filter.h"
+#include "wificond/scanning/scan_result_projection.h"
 #ifdef CONFIG_WIFI_GBK
 #include "wificond/scanning/wifi_gbk2utf.h"
 #endif
 
+using android::net::wifi::IWifiScannerImpl;
 using com::android::server::wifi::wificond::NativeScanResult;
+using com::android::server::wifi::wificond::ScanResultFilter;
+using com::android::server::wifi::wificond::ScanResultProjection;
+using std::placeholders::_1;
 using std::unique_ptr;
 using std::vector;
 
@@ -40,11 +50,48 @@ namespace {
 
 constexpr uint8_t kElemIdSsid = 0;
 constexpr unsigned int kMsecPerSec = 1000;
+constexpr uint64_t kUsecPerMsec = 1000;
+// Margin in dB by which a BSS must beat the connected BSS to be reported by
+// a scheduled scan while associated.
+constexpr int8_t kSchedScanRelativeRssiDb = 5;
+
+// Keeps only the information elements whose element ID is in |element_ids|.
+vector<uint8_t> ProjectInfoElements(const vector<uint8_t>& ie,
+                                    const vector<int32_t>& element_ids) {
+  vector<uint8_t> projected_ie;
+  size_t pos = 0;
+  while (pos + 1 < ie.size()) {
+    uint8_t type = ie[pos];
+    size_t element_size = 2 + ie[pos + 1];
+    if (pos + element_size > ie.size()) {
+      break;
+    }
+    if (std::find(element_ids.begin(), element_ids.end(), type) !=
+        element_ids.end()) {
+      projected_ie.insert(projected_ie.end(),
+                          ie.begin() + pos,
+                          ie.begin() + pos + element_size);
+    }
+    pos += element_size;
+  }
+  return projected_ie;
+}
+
+void ApplyProjection(const ScanResultProjection& projection,
+                     NativeScanResult* scan_result) {
+  if (projection.omit_info_elements_) {
+    scan_result->info_element.clear();
+  } else if (!projection.info_element_ids_.empty()) {
+    scan_result->info_element = ProjectInfoElements(
+        scan_result->info_element, projection.info_element_ids_);
+  }
+}
 
 }  // namespace
 
 ScanUtils::ScanUtils(NetlinkManager* netlink_manager)
-    : netlink_manager_(netlink_manager) {
+    : netlink_manager_(netlink_manager),
+      max_scan_result_age_ms_(0) {
   if (!netlink_manager_->IsStarted()) {
     netlink_manager_->Start();
   }
@@ -84,8 +131,58 @@ void ScanUtils::UnsubscribeSchedScanResultNotification(
   netlink_manager_->UnsubscribeSchedScanResultNotification(interface_index);
 }
 
+void ScanUtils::SubscribeScanTriggerNotification(
+    uint32_t interface_index,
+    OnScanTriggeredHandler handler) {
+  on_scan_triggered_handler_[interface_index] = handler;
+}
+
+void ScanUtils::UnsubscribeScanTriggerNotification(uint32_t interface_index) {
+  on_scan_triggered_handler_.erase(interface_index);
+}
+
+void ScanUtils::SetMaxScanResultAge(uint32_t max_age_ms) {
+  max_scan_result_age_ms_ = max_age_ms;
+}
+
+ScanResultDumpStats ScanUtils::GetScanResultDumpStats(
+    uint32_t interface_index) const {
+  const auto it = scan_result_dump_stats_.find(interface_index);
+  if (it == scan_result_dump_stats_.end()) {
+    return ScanResultDumpStats();
+  }
+  return it->second;
+}
+
 bool ScanUtils::GetScanResult(uint32_t interface_index,
                               vector<NativeScanResult>* out_scan_results) {
+  return GetFilteredScanResult(interface_index,
+                               ScanResultFilter(),
+                               ScanResultProjection(),
+                               out_scan_results);
+}
+
+bool ScanUtils::GetFilteredScanResult(
+    uint32_t interface_index,
+    const ScanResultFilter& filter,
+    const ScanResultProjection& projection,
+    vector<NativeScanResult>* out_scan_results) {
+  uint64_t min_timestamp_us = std::max<int64_t>(filter.min_timestamp_us_, 0);
+  // The tighter of the filter's and the global cut-off applies.
+  uint64_t max_age_ms = max_scan_result_age_ms_;
+  if (filter.max_age_ms_ > 0 &&
+      (max_age_ms == 0 ||
+       static_cast<uint64_t>(filter.max_age_ms_) < max_age_ms)) {
+    max_age_ms = filter.max_age_ms_;
+  }
+  if (max_age_ms > 0) {
+    uint64_t now_us = systemTime(SYSTEM_TIME_BOOTTIME) / 1000;
+    uint64_t max_age_us = max_age_ms * kUsecPerMsec;
+    if (now_us > max_age_us) {
+      min_timestamp_us = std::max(min_timestamp_us, now_us - max_age_us);
+    }
+  }
+
   NL80211Packet get_scan(
       netlink_manager_->GetFamilyId(),
       NL80211_CMD_GET_SCAN,
@@ -100,12 +197,26 @@ bool ScanUtils::GetScanResult(uint32_t interface_index,
     LOG(ERROR) << "NL80211_CMD_GET_SCAN dump failed";
     return false;
   }
+  ScanResultDumpStats& stats = scan_result_dump_stats_[interface_index];
+  stats.num_dumps++;
+  stats.last_num_bss = 0;
+  stats.last_num_bytes = 0;
   if (response.empty()) {
     LOG(INFO) << "Unexpected empty scan result!";
     return true;
   }
 
+  // With a limit, the strongest results so far are kept in a min-heap, so
+  // that weaker BSSs are cut before their information elements are parsed.
+  size_t max_results =
+      filter.max_results_ > 0 ? static_cast<size_t>(filter.max_results_) : 0;
+  auto stronger = [](const NativeScanResult& lhs,
+                     const NativeScanResult& rhs) {
+    return lhs.signal_mbm > rhs.signal_mbm;
+  };
+  vector<NativeScanResult> top_results;
   for (auto& packet : response) {
+    stats.last_num_bytes += packet->GetConstData().size();
     if (packet->GetMessageType() == NLMSG_ERROR) {
       LOG(ERROR) << "Receive ERROR message: "
                  << strerror(packet->GetErrorCode());
@@ -126,18 +237,53 @@ bool ScanUtils::GetScanResult(uint32_t interface_index,
       continue;
     }
 
+    stats.last_num_bss++;
+    int32_t min_signal_mbm = filter.min_signal_mbm_;
+    if (max_results > 0 && top_results.size() == max_results) {
+      // Only a BSS stronger than the weakest one kept can make the cut.
+      min_signal_mbm =
+          std::max(min_signal_mbm, top_results.front().signal_mbm + 1);
+    }
     NativeScanResult scan_result;
-    if (!ParseScanResult(std::move(packet), &scan_result)) {
+    bool matched = true;
+    if (!ParseScanResult(std::move(packet), filter, min_timestamp_us,
+                         min_signal_mbm, &scan_result, &matched, &stats)) {
       LOG(DEBUG) << "Ignore invalid scan result";
       continue;
     }
-    out_scan_results->push_back(std::move(scan_result));
+    if (!matched) {
+      continue;
+    }
+    ApplyProjection(projection, &scan_result);
+    if (max_results == 0) {
+      out_scan_results->push_back(std::move(scan_result));
+      continue;
+    }
+    if (top_results.size() == max_results) {
+      std::pop_heap(top_results.begin(), top_results.end(), stronger);
+      top_results.pop_back();
+    }
+    top_results.push_back(std::move(scan_result));
+    std::push_heap(top_results.begin(), top_results.end(), stronger);
   }
+  stats.max_num_bss = std::max(stats.max_num_bss, stats.last_num_bss);
+  stats.max_num_bytes = std::max(stats.max_num_bytes, stats.last_num_bytes);
+  stats.total_num_bss += stats.last_num_bss;
+
+  // Strongest first.
+  std::sort_heap(top_results.begin(), top_results.end(), stronger);
+  std::move(top_results.begin(), top_results.end(),
+            std::back_inserter(*out_scan_results));
   return true;
 }
 
 bool ScanUtils::ParseScanResult(unique_ptr<const NL80211Packet> packet,
-                                NativeScanResult* scan_result) {
+                                const ScanResultFilter& filter,
+                                uint64_t min_timestamp_us,
+                                int32_t min_signal_mbm,
+                                NativeScanResult* scan_result,
+                                bool* matched,
+                                ScanResultDumpStats* stats) {
   if (packet->GetCommand() != NL80211_CMD_NEW_SCAN_RESULTS) {
     LOG(ERROR) << "Wrong command command for new scan result message";
     return false;
@@ -154,6 +300,38 @@ bool ScanUtils::ParseScanResult(unique_ptr<const NL80211Packet> packet,
       LOG(ERROR) << "Failed to get Frequency from scan result packet";
       return false;
     }
+    if (!filter.frequencies_.empty() &&
+        std::find(filter.frequencies_.begin(), filter.frequencies_.end(),
+                  static_cast<int32_t>(freq)) == filter.frequencies_.end()) {
+      *matched = false;
+      return true;
+    }
+    int32_t signal;
+    if (!bss.GetAttributeValue(NL80211_BSS_SIGNAL_MBM, &signal)) {
+      LOG(ERROR) << "Failed to get Signal Strength from scan result packet";
+      return false;
+    }
+    if (signal < min_signal_mbm) {
+      *matched = false;
+      return true;
+    }
+    uint64_t last_seen_since_boot_microseconds;
+    bool is_boottime;
+    if (!GetBssTimestamp(bss, &last_seen_since_boot_microseconds,
+                         &is_boottime)) {
+      // Logging is done inside |GetBssTimestamp|.
+      return false;
+    }
+    if (!is_boottime) {
+      // TSF is the timer of the AP, which cannot tell the age of the BSS.
+      if (min_timestamp_us > 0) {
+        stats->total_num_unknown_age_bss++;
+      }
+    } else if (last_seen_since_boot_microseconds < min_timestamp_us) {
+      stats->total_num_stale_bss++;
+      *matched = false;
+      return true;
+    }
     vector<uint8_t> ie;
     if (!bss.GetAttributeValue(NL80211_BSS_INFORMATION_ELEMENTS, &ie)) {
       LOG(ERROR) << "Failed to get Information Element from scan result packet";
@@ -187,15 +365,11 @@ bool ScanUtils::ParseScanResult(unique_ptr<const NL80211Packet> packet,
         }
     }
 #endif
-    uint64_t last_seen_since_boot_microseconds;
-    if (!GetBssTimestamp(bss, &last_seen_since_boot_microseconds)) {
-      // Logging is done inside |GetBssTimestamp|.
-      return false;
-    }
-    int32_t signal;
-    if (!bss.GetAttributeValue(NL80211_BSS_SIGNAL_MBM, &signal)) {
-      LOG(ERROR) << "Failed to get Signal Strength from scan result packet";
-      return false;
+    if (!filter.ssids_.empty() &&
+        std::find(filter.ssids_.begin(), filter.ssids_.end(), ssid) ==
+            filter.ssids_.end()) {
+      *matched = false;
+      return true;
     }
     uint16_t capability;
     if (!bss.GetAttributeValue(NL80211_BSS_CAPABILITY, &capability)) {
@@ -221,14 +395,18 @@ bool ScanUtils::ParseScanResult(unique_ptr<const NL80211Packet> packet,
 bool ScanUtils::GetBssTimestampForTesting(
     const NL80211NestedAttr& bss,
     uint64_t* last_seen_since_boot_microseconds){
-  return GetBssTimestamp(bss, last_seen_since_boot_microseconds);
+  bool is_boottime;
+  return GetBssTimestamp(bss, last_seen_since_boot_microseconds,
+                         &is_boottime);
 }
 
 bool ScanUtils::GetBssTimestamp(const NL80211NestedAttr& bss,
-                                uint64_t* last_seen_since_boot_microseconds){
+                                uint64_t* last_seen_since_boot_microseconds,
+                                bool* is_boottime){
   uint64_t last_seen_since_boot_nanoseconds;
-  if (bss.GetAttributeValue(NL80211_BSS_LAST_SEEN_BOOTTIME,
-                            &last_seen_since_boot_nanoseconds)) {
+  *is_boottime = bss.GetAttributeValue(NL80211_BSS_LAST_SEEN_BOOTTIME,
+                                       &last_seen_since_boot_nanoseconds);
+  if (*is_boottime) {
     *last_seen_since_boot_microseconds = last_seen_since_boot_nanoseconds / 1000;
   } else {
     // Fall back to use TSF if we can't find NL80211_BSS_LAST_SEEN_BOOTTIME
@@ -330,9 +508,80 @@ bool ScanUtils::GetSSIDFromInfoElement(const vector<uint8_t>& ie,
 
 bool ScanUtils::Scan(uint32_t interface_index,
                      bool request_random_mac,
+                     int scan_type,
+                     uint32_t dwell_time_ms,
+                     bool flush_cache,
                      const vector<vector<uint8_t>>& ssids,
                      const vector<uint32_t>& freqs,
                      int* error_code) {
+  NL80211Packet trigger_scan = CreateTriggerScanPacket(
+      interface_index, request_random_mac, scan_type, dwell_time_ms,
+      flush_cache, ssids, freqs);
+  // We are receiving an ERROR/ACK message instead of the actual
+  // scan results here, so it is OK to expect a timely response because
+  // kernel is supposed to send the ERROR/ACK back before the scan starts.
+  vector<unique_ptr<const NL80211Packet>> response;
+  if (!netlink_manager_->SendMessageAndGetAckOrError(trigger_scan,
+                                                     error_code)) {
+    // Logging is done inside |SendMessageAndGetAckOrError|.
+    return false;
+  }
+  if (*error_code != 0) {
+    LOG(ERROR) << "NL80211_CMD_TRIGGER_SCAN failed: " << strerror(*error_code);
+    return false;
+  }
+  return true;
+}
+
+bool ScanUtils::ScanAsync(uint32_t interface_index,
+                          bool request_random_mac,
+                          int scan_type,
+                          uint32_t dwell_time_ms,
+                          bool flush_cache,
+                          const vector<vector<uint8_t>>& ssids,
+                          const vector<uint32_t>& freqs) {
+  NL80211Packet trigger_scan = CreateTriggerScanPacket(
+      interface_index, request_random_mac, scan_type, dwell_time_ms,
+      flush_cache, ssids, freqs);
+  if (!netlink_manager_->RegisterHandlerAndSendMessage(
+          trigger_scan,
+          std::bind(&ScanUtils::OnScanTriggerResponse, this, interface_index,
+                    _1))) {
+    LOG(ERROR) << "Failed to send NL80211_CMD_TRIGGER_SCAN";
+    return false;
+  }
+  return true;
+}
+
+void ScanUtils::OnScanTriggerResponse(
+    uint32_t interface_index,
+    unique_ptr<const NL80211Packet> response) {
+  // With NLM_F_ACK the kernel answers with an NLMSG_ERROR message, whose
+  // error code is 0 for an ACK. It carries no NL80211_ATTR_COOKIE.
+  int error_code = 0;
+  if (response->GetMessageType() == NLMSG_ERROR) {
+    error_code = response->GetErrorCode();
+  }
+  if (error_code != 0) {
+    LOG(ERROR) << "NL80211_CMD_TRIGGER_SCAN failed: " << strerror(error_code);
+  }
+  const auto handler = on_scan_triggered_handler_.find(interface_index);
+  if (handler == on_scan_triggered_handler_.end()) {
+    LOG(WARNING) << "No handler for scan trigger answer from interface"
+                 << " with index: " << interface_index;
+    return;
+  }
+  handler->second(interface_index, error_code, 0);
+}
+
+NL80211Packet ScanUtils::CreateTriggerScanPacket(
+    uint32_t interface_index,
+    bool request_random_mac,
+    int scan_type,
+    uint32_t dwell_time_ms,
+    bool flush_cache,
+    const vector<vector<uint8_t>>& ssids,
+    const vector<uint32_t>& freqs) {
   NL80211Packet trigger_scan(
       netlink_manager_->GetFamilyId(),
       NL80211_CMD_TRIGGER_SCAN,
@@ -364,25 +613,42 @@ bool ScanUtils::Scan(uint32_t interface_index,
     trigger_scan.AddAttribute(freqs_attr);
   }
 
+  uint32_t scan_flags = 0;
   if (request_random_mac) {
+    scan_flags |= NL80211_SCAN_FLAG_RANDOM_ADDR;
+  }
+  if (flush_cache) {
+    scan_flags |= NL80211_SCAN_FLAG_FLUSH;
+  }
+  switch (scan_type) {
+    case IWifiScannerImpl::SCAN_TYPE_LOW_SPAN:
+      scan_flags |= NL80211_SCAN_FLAG_LOW_SPAN;
+      break;
+    case IWifiScannerImpl::SCAN_TYPE_LOW_POWER:
+      scan_flags |= NL80211_SCAN_FLAG_LOW_POWER;
+      break;
+    case IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY:
+      scan_flags |= NL80211_SCAN_FLAG_HIGH_ACCURACY;
+      break;
+    case IWifiScannerImpl::SCAN_TYPE_DEFAULT:
+      break;
+    default:
+      LOG(ERROR) << "Invalid scan type received: " << scan_type;
+  }
+  if (scan_flags) {
     trigger_scan.AddAttribute(
         NL80211Attr<uint32_t>(NL80211_ATTR_SCAN_FLAGS,
-                              NL80211_SCAN_FLAG_RANDOM_ADDR));
+                              scan_flags));
   }
-  // We are receiving an ERROR/ACK message instead of the actual
-  // scan results here, so it is OK to expect a timely response because
-  // kernel is supposed to send the ERROR/ACK back before the scan starts.
-  vector<unique_ptr<const NL80211Packet>> response;
-  if (!netlink_manager_->SendMessageAndGetAckOrError(trigger_scan,
-                                                     error_code)) {
-    // Logging is done inside |SendMessageAndGetAckOrError|.
-    return false;
-  }
-  if (*error_code != 0) {
-    LOG(ERROR) << "NL80211_CMD_TRIGGER_SCAN failed: " << strerror(*error_code);
-    return false;
+  if (dwell_time_ms > 0) {
+    // NL80211_ATTR_MEASUREMENT_DURATION is in TUs of 1024 microseconds.
+    uint32_t dwell_time_tu =
+        std::min<uint32_t>(dwell_time_ms * 1000 / 1024, UINT16_MAX);
+    trigger_scan.AddAttribute(
+        NL80211Attr<uint16_t>(NL80211_ATTR_MEASUREMENT_DURATION,
+                              std::max<uint32_t>(dwell_time_tu, 1)));
   }
-  return true;
+  return trigger_scan;
 }
 
 bool ScanUtils::StopScheduledScan(uint32_t interface_index) {
@@ -436,8 +702,9 @@ bool ScanUtils::AbortScan(uint32_t interface_index) {
 bool ScanUtils::StartScheduledScan(
     uint32_t interface_index,
     const SchedScanIntervalSetting& interval_setting,
-    int32_t rssi_threshold,
-    bool request_random_mac,
+    int32_t rssi_threshold_2g,
+    int32_t rssi_threshold_5g,
+    const SchedScanReqFlags& req_flags,
     const std::vector<std::vector<uint8_t>>& scan_ssids,
     const std::vector<std::vector<uint8_t>>& match_ssids,
     const std::vector<uint32_t>& freqs,
@@ -469,7 +736,16 @@ bool ScanUtils::StartScheduledScan(
     match_group.AddAttribute(
         NL80211Attr<vector<uint8_t>>(NL80211_SCHED_SCAN_MATCH_ATTR_SSID, match_ssids[i]));
     match_group.AddAttribute(
-        NL80211Attr<int32_t>(NL80211_SCHED_SCAN_MATCH_ATTR_RSSI, rssi_threshold));
+        NL80211Attr<int32_t>(NL80211_SCHED_SCAN_MATCH_ATTR_RSSI,
+                             std::min(rssi_threshold_2g, rssi_threshold_5g)));
+    if (req_flags.request_band_specific_rssi) {
+      NL80211NestedAttr per_band_rssi(NL80211_SCHED_SCAN_MATCH_PER_BAND_RSSI);
+      per_band_rssi.AddAttribute(
+          NL80211Attr<int32_t>(NL80211_BAND_2GHZ, rssi_threshold_2g));
+      per_band_rssi.AddAttribute(
+          NL80211Attr<int32_t>(NL80211_BAND_5GHZ, rssi_threshold_5g));
+      match_group.AddAttribute(per_band_rssi);
+    }
     scan_match_attr.AddAttribute(match_group);
   }
   start_sched_scan.AddAttribute(scan_match_attr);
@@ -508,12 +784,33 @@ bool ScanUtils::StartScheduledScan(
                               interval_setting.final_interval_ms));
   }
 
-  if (request_random_mac) {
+  if (req_flags.request_random_mac) {
     start_sched_scan.AddAttribute(
         NL80211Attr<uint32_t>(NL80211_ATTR_SCAN_FLAGS,
                               NL80211_SCAN_FLAG_RANDOM_ADDR));
   }
 
+  if (req_flags.request_relative_rssi) {
+    // Only wake up the host for BSSs which are better than the connected
+    // one. 5GHz BSSs get the same head start over 2.4GHz BSSs as the
+    // absolute thresholds give them.
+    start_sched_scan.AddAttribute(
+        NL80211Attr<int8_t>(NL80211_ATTR_SCHED_SCAN_RELATIVE_RSSI,
+                            kSchedScanRelativeRssiDb));
+    struct nl80211_bss_select_rssi_adjust rssi_adjust;
+    rssi_adjust.band = NL80211_BAND_5GHZ;
+    rssi_adjust.delta = static_cast<int8_t>(std::max<int32_t>(
+        std::min<int32_t>(rssi_threshold_2g - rssi_threshold_5g, INT8_MAX),
+        INT8_MIN));
+    const uint8_t* rssi_adjust_bytes =
+        reinterpret_cast<const uint8_t*>(&rssi_adjust);
+    start_sched_scan.AddAttribute(
+        NL80211Attr<vector<uint8_t>>(
+            NL80211_ATTR_SCHED_SCAN_RSSI_ADJUST,
+            vector<uint8_t>(rssi_adjust_bytes,
+                            rssi_adjust_bytes + sizeof(rssi_adjust))));
+  }
+
   vector<unique_ptr<const NL80211Packet>> response;
   if (!netlink_manager_->SendMessageAndGetAckOrError(start_sched_scan,
                                                      error_code)) {
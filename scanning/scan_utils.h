@@ -17,6 +17,7 @@
 #ifndef WIFICOND_SCANNING_SCAN_UTILS_H_
 #define WIFICOND_SCANNING_SCAN_UTILS_H_
 
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -31,6 +32,8 @@ namespace wifi {
 namespace wificond {
 
 class NativeScanResult;
+class ScanResultFilter;
+class ScanResultProjection;
 
 }  // namespace wificond
 }  // namespace wifi
@@ -55,6 +58,54 @@ struct SchedScanIntervalSetting {
   uint32_t final_interval_ms{0};
 };
 
+struct SchedScanReqFlags {
+  // Ask device/driver to use a random MAC address during scan.
+  // This should only be set if kernel supports this feature as
+  // |supports_random_mac_sched_scan| indicates.
+  bool request_random_mac{false};
+  // Apply the 2.4GHz and 5GHz RSSI thresholds to their own band.
+  // This should only be set if kernel supports this feature as
+  // |supports_sched_scan_band_specific_rssi| indicates.
+  bool request_band_specific_rssi{false};
+  // Only report BSSs which are better than the currently connected one.
+  // This should only be set while associated, and if kernel supports this
+  // feature as |supports_sched_scan_relative_rssi| indicates.
+  bool request_relative_rssi{false};
+};
+
+// This describes a type of function handling the kernel answer to a scan
+// triggered by ScanUtils::ScanAsync().
+// |interface_index| is the index of interface the scan was triggered on.
+// |error_code| is 0 if the kernel accepted the scan, or the errno it
+// rejected the scan with.
+// |cookie| is the NL80211_ATTR_COOKIE the kernel identified the scan with,
+// or 0 if the kernel supplied none. The ACK of NL80211_CMD_TRIGGER_SCAN
+// carries no cookie, so ScanUtils always passes 0.
+typedef std::function<void(
+    uint32_t interface_index,
+    int error_code,
+    uint64_t cookie)> OnScanTriggeredHandler;
+
+// Size statistics of the NL80211_CMD_GET_SCAN dumps of one interface.
+// The kernel BSS cache keeps growing while the device moves around, so
+// these show how much of a dump is actually useful.
+struct ScanResultDumpStats {
+  uint32_t num_dumps{0};
+  // Number of BSSs in the latest dump, and the largest seen so far.
+  uint32_t last_num_bss{0};
+  uint32_t max_num_bss{0};
+  // Size in bytes of the latest dump, and the largest seen so far.
+  uint64_t last_num_bytes{0};
+  uint64_t max_num_bytes{0};
+  // Total number of BSSs received, and how many of them were dropped
+  // because they were last seen too long ago.
+  uint64_t total_num_bss{0};
+  uint64_t total_num_stale_bss{0};
+  // BSSs kept under an age limit because the driver did not report when
+  // they were last seen in boot time.
+  uint64_t total_num_unknown_age_bss{0};
+};
+
 // Provides scanning helper functions.
 class ScanUtils {
  public:
@@ -70,6 +121,25 @@ class ScanUtils {
       uint32_t interface_index,
       std::vector<::com::android::server::wifi::wificond::NativeScanResult>* out_scan_results);
 
+  // Same as GetScanResult(), but only returns the scan results accepted by
+  // |filter|, with fields trimmed as described by |projection|.
+  // |filter| is evaluated while parsing the dump, so rejected results never
+  // have their information elements decoded.
+  // Returns true on success.
+  virtual bool GetFilteredScanResult(
+      uint32_t interface_index,
+      const ::com::android::server::wifi::wificond::ScanResultFilter& filter,
+      const ::com::android::server::wifi::wificond::ScanResultProjection& projection,
+      std::vector<::com::android::server::wifi::wificond::NativeScanResult>* out_scan_results);
+
+  // Drop scan results last seen more than |max_age_ms| milliseconds ago
+  // from every scan result dump, on top of any filter. 0 disables the
+  // cut-off, which is the default.
+  void SetMaxScanResultAge(uint32_t max_age_ms);
+
+  // Returns the dump size statistics of interface |interface_index|.
+  ScanResultDumpStats GetScanResultDumpStats(uint32_t interface_index) const;
+
 #ifdef CONFIG_WIFI_GBK
   // Get GBK ssid convert history
   // A SSID vector will be returned by |*out_ssid|.
@@ -85,6 +155,16 @@ class ScanUtils {
   // address during scan.
   // This flag should only be set if kernel supports this feature as
   // |supports_random_mac_oneshot_scan| indicates.
+  // |scan_type| is one of the IWifiScannerImpl::SCAN_TYPE_* constants. Types
+  // other than SCAN_TYPE_DEFAULT should only be requested if kernel supports
+  // them as |supports_low_span_oneshot_scan|,
+  // |supports_low_power_oneshot_scan| and
+  // |supports_high_accuracy_oneshot_scan| indicate.
+  // |dwell_time_ms| is the time to spend on each channel. 0 leaves it to the
+  // driver. This should only be set if |supports_scan_dwell| is true.
+  // |flush_cache| asks kernel to drop the BSSs it cached before this scan
+  // once the scan completes successfully. This should only be set if kernel
+  // supports this feature as |supports_scan_flush| indicates.
   // |ssids| is a vector of ssids we request to scan, which mostly is used
   // for hidden networks.
   // If |ssids| is an empty vector, it will do a passive scan.
@@ -95,33 +175,51 @@ class ScanUtils {
   // Returns true on success.
   virtual bool Scan(uint32_t interface_index,
                     bool request_random_mac,
+                    int scan_type,
+                    uint32_t dwell_time_ms,
+                    bool flush_cache,
                     const std::vector<std::vector<uint8_t>>& ssids,
                     const std::vector<uint32_t>& freqs,
                     int* error_code);
 
+  // Asynchronous version of |Scan|: sends the scan request without waiting
+  // for the kernel to answer it. The answer is passed to the handler
+  // subscribed with |SubscribeScanTriggerNotification| for
+  // |interface_index|.
+  // Returns true if the request was sent.
+  virtual bool ScanAsync(uint32_t interface_index,
+                         bool request_random_mac,
+                         int scan_type,
+                         uint32_t dwell_time_ms,
+                         bool flush_cache,
+                         const std::vector<std::vector<uint8_t>>& ssids,
+                         const std::vector<uint32_t>& freqs);
+
   // Send scan request to kernel for interface with index |interface_index|.
-  // |inteval_ms| is the expected scan interval in milliseconds.
-  // |rssi_threshold| is the minimum RSSI threshold value as a filter.
+  // |interval_setting| is the schedule of the scheduled scan.
+  // |rssi_threshold_2g| and |rssi_threshold_5g| are the minimum RSSI
+  // threshold values of 2.4GHz and 5GHz BSSs as filters.
+  // They are only applied per band if |req_flags| asks for band specific
+  // RSSI thresholds. Otherwise the lower of the two applies to all bands.
+  // |req_flags| selects optional scheduled scan features. See
+  // SchedScanReqFlags.
   // |scan_ssids| is a vector of ssids we request to scan, which is mostly
   // used for hidden networks.
-  // |request_random_mac| is used for asking device/driver to use a random MAC
-  // address during scan.
-  // This flag should only be set if kernel supports this feature as
-  // |supports_random_mac_sched_scan| indicates.
   // If |scan_ssids| is an empty vector, it will do a passive scan.
   // If |scan_ssids| contains an empty string, it will a scan for all ssids.
   // |freqs| is a vector of frequencies we request to scan.
   // |match_ssids| is the list of ssids that we want to add as filters.
   // If |freqs| is an empty vector, it will scan all supported frequencies.
-  // Only BSSs match the |match_ssids| and |rssi_threshold| will be returned as
+  // Only BSSs match the |match_ssids| and RSSI thresholds will be returned as
   // scan results.
   // |error_code| contains the errno kernel replied when this returns false.
   // Returns true on success.
   virtual bool StartScheduledScan(
       uint32_t interface_index,
       const SchedScanIntervalSetting& interval_setting,
-      int32_t rssi_threshold,
-      bool request_random_mac,
+      int32_t rssi_threshold_2g,
+      int32_t rssi_threshold_5g,
+      const SchedScanReqFlags& req_flags,
       const std::vector<std::vector<uint8_t>>& scan_ssids,
       const std::vector<std::vector<uint8_t>>& match_ssids,
       const std::vector<uint32_t>& freqs,
@@ -170,21 +268,60 @@ class ScanUtils {
   // interface with index |interface_index|.
   virtual void UnsubscribeSchedScanResultNotification(uint32_t interface_index);
 
+  // Sign up to be notified of the kernel answers to the scans triggered by
+  // |ScanAsync| on the given |interface_index|.
+  // See the declaration of OnScanTriggeredHandler for documentation on the
+  // semantics of this callback.
+  virtual void SubscribeScanTriggerNotification(
+      uint32_t interface_index,
+      OnScanTriggeredHandler handler);
+
+  // Cancel the sign-up of receiving scan trigger answers from interface with
+  // index |interface_index|.
+  virtual void UnsubscribeScanTriggerNotification(uint32_t interface_index);
+
  private:
+  // |*is_boottime| tells whether the timestamp comes from
+  // NL80211_BSS_LAST_SEEN_BOOTTIME. Otherwise it is a TSF of the AP, which
+  // is not comparable with the boot time.
   bool GetBssTimestamp(const NL80211NestedAttr& bss,
-                       uint64_t* last_seen_since_boot_microseconds);
+                       uint64_t* last_seen_since_boot_microseconds,
+                       bool* is_boottime);
 #ifdef CONFIG_WIFI_GBK
   bool ReplaceSSIDFromInfoElement(std::vector<uint8_t>& ie,
                               const std::vector<uint8_t>& ssid);
 #endif
   bool GetSSIDFromInfoElement(const std::vector<uint8_t>& ie,
                               std::vector<uint8_t>* ssid);
+  // Builds the NL80211_CMD_TRIGGER_SCAN request of |Scan| and |ScanAsync|.
+  NL80211Packet CreateTriggerScanPacket(
+      uint32_t interface_index,
+      bool request_random_mac,
+      int scan_type,
+      uint32_t dwell_time_ms,
+      bool flush_cache,
+      const std::vector<std::vector<uint8_t>>& ssids,
+      const std::vector<uint32_t>& freqs);
+  void OnScanTriggerResponse(uint32_t interface_index,
+                             std::unique_ptr<const NL80211Packet> response);
   // Converts a NL80211_CMD_NEW_SCAN_RESULTS packet to a ScanResult object.
+  // BSSs last seen before |min_timestamp_us|, weaker than |min_signal_mbm|
+  // or otherwise rejected by |filter| are skipped as early as possible, and
+  // |*matched| is set to false for them. BSSs skipped for their age are
+  // counted in |*stats|.
   bool ParseScanResult(
       std::unique_ptr<const NL80211Packet> packet,
-      ::com::android::server::wifi::wificond::NativeScanResult* scan_result);
+      const ::com::android::server::wifi::wificond::ScanResultFilter& filter,
+      uint64_t min_timestamp_us,
+      int32_t min_signal_mbm,
+      ::com::android::server::wifi::wificond::NativeScanResult* scan_result,
+      bool* matched,
+      ScanResultDumpStats* stats);
 
   NetlinkManager* netlink_manager_;
+  uint32_t max_scan_result_age_ms_;
+  std::map<uint32_t, ScanResultDumpStats> scan_result_dump_stats_;
+  std::map<uint32_t, OnScanTriggeredHandler> on_scan_triggered_handler_;
 
   DISALLOW_COPY_AND_ASSIGN(ScanUtils);
 };
@@ -16,25 +16,43 @@
 
 #include "wificond/scanning/scanner_impl.h"
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <limits>
+#include <set>
 #include <string>
 #include <vector>
 
 #include <android-base/logging.h>
+#include <cutils/properties.h>
+#include <utils/Timers.h>
 
 #include "wificond/client_interface_impl.h"
 #include "wificond/scanning/offload/offload_scan_manager.h"
 #include "wificond/scanning/offload/offload_service_utils.h"
+#include "wificond/scanning/scan_plan_generator.h"
 #include "wificond/scanning/scan_utils.h"
 
+using android::base::unique_fd;
 using android::binder::Status;
 using android::net::wifi::IPnoScanEvent;
 using android::net::wifi::IScanEvent;
+using android::net::wifi::IScanRequestCallback;
+using android::net::wifi::IScanResultDeltaEvent;
+using android::net::wifi::IWifiScannerImpl;
 using android::hardware::wifi::offload::V1_0::IOffload;
 using android::sp;
 using com::android::server::wifi::wificond::NativeScanResult;
+using com::android::server::wifi::wificond::NativeScanStats;
+using com::android::server::wifi::wificond::PnoNetwork;
 using com::android::server::wifi::wificond::PnoSettings;
+using com::android::server::wifi::wificond::ScanResultDelta;
+using com::android::server::wifi::wificond::ScanResultFilter;
+using com::android::server::wifi::wificond::ScanResultProjection;
 using com::android::server::wifi::wificond::SingleScanSettings;
 
+using std::map;
 using std::pair;
 using std::string;
 using std::vector;
@@ -46,18 +64,70 @@ using namespace std::placeholders;
 namespace android {
 namespace wificond {
 
+namespace {
+
+// Each scheduled scan plan scans half as often as the previous one.
+constexpr uint32_t kScanPlanBackoffFactor = 2;
+// The halves of a split PNO scan raise at most one network found event
+// within this window.
+constexpr int64_t kSplitPnoMatchWindowMs = 5000;
+// A scheduled scan which leaves out some networks is restarted with the next
+// ones after this many slow scan intervals.
+constexpr int64_t kPnoRotationWindowSlowScans = 4;
+// The kernel answers a scan trigger right away. An answer which takes longer
+// than this was lost, e.g. when the socket ran out of buffer space.
+constexpr int64_t kScanTriggerTimeoutMs = 3000;
+
+int64_t GetBootTimeMs() {
+  return systemTime(SYSTEM_TIME_BOOTTIME) / 1000000;
+}
+
+// Returns true if PNO scans with |lhs| and with |rhs| look for the same
+// networks in the same way. The ages of the networks are ignored: they only
+// rank the networks when some of them have to be left out.
+bool IsSamePnoScan(const PnoSettings& lhs, const PnoSettings& rhs) {
+  return lhs.interval_ms_ == rhs.interval_ms_ &&
+         lhs.min_2g_rssi_ == rhs.min_2g_rssi_ &&
+         lhs.min_5g_rssi_ == rhs.min_5g_rssi_ &&
+         lhs.offload_subscription_delay_ms_ ==
+             rhs.offload_subscription_delay_ms_ &&
+         std::equal(lhs.pno_networks_.begin(), lhs.pno_networks_.end(),
+                    rhs.pno_networks_.begin(), rhs.pno_networks_.end(),
+                    [](const PnoNetwork& lhs_network,
+                       const PnoNetwork& rhs_network) {
+                      return lhs_network.is_hidden_ ==
+                                 rhs_network.is_hidden_ &&
+                             lhs_network.ssid_ == rhs_network.ssid_;
+                    });
+}
+
+}  // namespace
+
 ScannerImpl::ScannerImpl(uint32_t wiphy_index, uint32_t interface_index,
                          const ScanCapabilities& scan_capabilities,
                          const WiphyFeatures& wiphy_features,
                          ClientInterfaceImpl* client_interface,
                          NetlinkUtils* netlink_utils, ScanUtils* scan_utils,
-                         weak_ptr<OffloadServiceUtils> offload_service_utils)
+                         weak_ptr<OffloadServiceUtils> offload_service_utils,
+                         EventLoop* event_loop)
     : valid_(true),
       scan_started_(false),
       pno_scan_started_(false),
       offload_scan_supported_(false),
       pno_scan_running_over_offload_(false),
       pno_scan_results_from_offload_(false),
+      pno_scan_awaiting_offload_(false),
+      pno_scan_split_(false),
+      pno_rotation_pending_(false),
+      pno_rotation_generation_(0),
+      last_pno_network_found_ms_(-1),
+      offload_max_pno_networks_(0),
+      scan_trigger_pending_(false),
+      scan_trigger_generation_(0),
+      scan_deadline_generation_(0),
+      preempting_scan_(false),
+      ongoing_scan_cookie_(0),
+      next_scan_request_id_(1),
       wiphy_index_(wiphy_index),
       interface_index_(interface_index),
       scan_capabilities_(scan_capabilities),
@@ -65,13 +135,22 @@ ScannerImpl::ScannerImpl(uint32_t wiphy_index, uint32_t interface_index,
       client_interface_(client_interface),
       netlink_utils_(netlink_utils),
       scan_utils_(scan_utils),
-      scan_event_handler_(nullptr) {
+      event_loop_(event_loop),
+      lifetime_token_(std::make_shared<bool>(true)),
+      scan_event_handler_(nullptr),
+      scan_result_region_outdated_(true),
+      planner_update_pending_(false),
+      pno_planner_update_pending_(false) {
   // Subscribe one-shot scan result notification from kernel.
   LOG(INFO) << "subscribe scan result for interface with index: "
             << (int)interface_index_;
   scan_utils_->SubscribeScanResultNotification(
       interface_index_,
       std::bind(&ScannerImpl::OnScanResultsReady, this, _1, _2, _3, _4));
+  // Subscribe answers to the scans triggered by scanAsync().
+  scan_utils_->SubscribeScanTriggerNotification(
+      interface_index_,
+      std::bind(&ScannerImpl::OnScanTriggered, this, _1, _2, _3));
   // Subscribe scheduled scan result notification from kernel.
   scan_utils_->SubscribeSchedScanResultNotification(
       interface_index_,
@@ -84,6 +163,16 @@ ScannerImpl::ScannerImpl(uint32_t wiphy_index, uint32_t interface_index,
   offload_scan_manager_ = offload_service_utils.lock()->GetOffloadScanManager(
       offload_service_utils, offload_scan_callback_interface);
   offload_scan_supported_ = offload_service_utils.lock()->IsOffloadScanSupported();
+  offload_max_pno_networks_ = offload_service_utils.lock()->GetMaxPnoNetworks();
+  if (offload_max_pno_networks_ == 0) {
+    // Without a known limit, assume the Offload HAL holds as many networks as
+    // the firmware does for scheduled scans.
+    offload_max_pno_networks_ = scan_capabilities_.max_match_sets;
+  }
+  if (property_get_bool("persist.wifi.adaptive_scan.enable", false)) {
+    LOG(INFO) << "Adaptive channel planning enabled";
+    channel_planner_.reset(new ChannelPlanner());
+  }
 }
 
 ScannerImpl::~ScannerImpl() {}
@@ -93,6 +182,7 @@ void ScannerImpl::Invalidate() {
             << (int)interface_index_;
   scan_utils_->UnsubscribeScanResultNotification(interface_index_);
   scan_utils_->UnsubscribeSchedScanResultNotification(interface_index_);
+  scan_utils_->UnsubscribeScanTriggerNotification(interface_index_);
 }
 
 bool ScannerImpl::CheckIsValid() {
@@ -163,7 +253,13 @@ Status ScannerImpl::getScanResults(vector<NativeScanResult>* out_scan_results) {
   }
   if (!scan_utils_->GetScanResult(interface_index_, out_scan_results)) {
     LOG(ERROR) << "Failed to get scan results via NL80211";
+    return Status::ok();
+  }
+  if (channel_planner_ != nullptr && planner_update_pending_) {
+    channel_planner_->OnScanResults(planner_scanned_freqs_, *out_scan_results);
+    planner_update_pending_ = false;
   }
+  pno_network_ranker_.OnScanResults(*out_scan_results, GetBootTimeMs());
   return Status::ok();
 }
 
@@ -172,17 +268,82 @@ Status ScannerImpl::getPnoScanResults(
   if (!CheckIsValid()) {
     return Status::ok();
   }
-  if (pno_scan_results_from_offload_) {
+  if (pno_scan_split_) {
+    if (!GetSplitPnoScanResults(out_scan_results)) {
+      return Status::ok();
+    }
+  } else if (pno_scan_results_from_offload_) {
     if (!offload_scan_manager_->getScanResults(out_scan_results)) {
       LOG(ERROR) << "Failed to get scan results via Offload HAL";
+      return Status::ok();
     }
   } else {
     if (!scan_utils_->GetScanResult(interface_index_, out_scan_results)) {
       LOG(ERROR) << "Failed to get scan results via NL80211";
+      return Status::ok();
+    }
+    if (channel_planner_ != nullptr && pno_planner_update_pending_) {
+      channel_planner_->OnPnoScanResults(pno_planner_scanned_freqs_,
+                                         *out_scan_results);
+      pno_planner_update_pending_ = false;
     }
   }
+  pno_network_ranker_.OnScanResults(*out_scan_results, GetBootTimeMs());
   return Status::ok();
 }
+
+Status ScannerImpl::getFilteredScanResults(
+    const ScanResultFilter& filter,
+    const ScanResultProjection& projection,
+    vector<NativeScanResult>* out_scan_results) {
+  if (!CheckIsValid()) {
+    return Status::ok();
+  }
+  if (!scan_utils_->GetFilteredScanResult(interface_index_, filter,
+                                          projection, out_scan_results)) {
+    LOG(ERROR) << "Failed to get filtered scan results via NL80211";
+  }
+  return Status::ok();
+}
+
+Status ScannerImpl::getScanResultsSharedMemory(unique_fd* out_fd) {
+  // Unlike the other getters, there is no empty result to fall back to: an
+  // invalid file descriptor cannot be written to the reply.
+  if (!CheckIsValid()) {
+    return Status::fromExceptionCode(Status::EX_ILLEGAL_STATE);
+  }
+  int region_fd = scan_result_shared_memory_.GetFd();
+  if (scan_result_region_outdated_ || region_fd < 0) {
+    vector<NativeScanResult> scan_results;
+    if (!scan_utils_->GetScanResult(interface_index_, &scan_results)) {
+      LOG(ERROR) << "Failed to get scan results via NL80211";
+      return Status::fromExceptionCode(Status::EX_ILLEGAL_STATE);
+    }
+    if (!scan_result_shared_memory_.Update(scan_results, &region_fd)) {
+      LOG(ERROR) << "Failed to publish scan results to shared memory";
+      return Status::fromExceptionCode(Status::EX_ILLEGAL_STATE);
+    }
+    scan_result_region_outdated_ = false;
+  }
+  // The region is owned by |scan_result_shared_memory_|. Hand out a
+  // duplicate so that the reply can close it once it has been sent.
+  out_fd->reset(dup(region_fd));
+  if (out_fd->get() < 0) {
+    PLOG(ERROR) << "Failed to duplicate scan result region fd";
+    return Status::fromExceptionCode(Status::EX_ILLEGAL_STATE);
+  }
+  return Status::ok();
+}
+
+Status ScannerImpl::getOffloadScanStatsHistory(
+    vector<NativeScanStats>* out_scan_stats) {
+  if (!CheckIsValid() || !offload_scan_supported_) {
+    return Status::ok();
+  }
+  *out_scan_stats = offload_scan_manager_->getScanStatsHistory();
+  return Status::ok();
+}
+
 Status ScannerImpl::getWifiGbkHistory(
     const vector<uint8_t>& ssid,
     std::unique_ptr<::std::vector<uint8_t>>* out_ssid) {
@@ -209,53 +370,517 @@ Status ScannerImpl::scan(const SingleScanSettings& scan_settings,
     return Status::ok();
   }
 
-  if (scan_started_) {
-    LOG(WARNING) << "Scan already started";
+  vector<ScanRequest> requests = CreateScanRequests(scan_settings);
+  *out_success = SubmitScanRequests(std::move(requests));
+  return Status::ok();
+}
+
+Status ScannerImpl::scanAsync(const SingleScanSettings& scan_settings,
+                              const sp<IScanRequestCallback>& callback,
+                              int32_t* out_request_id) {
+  *out_request_id = IWifiScannerImpl::SCAN_REQUEST_ID_INVALID;
+  if (!CheckIsValid()) {
+    return Status::ok();
+  }
+  if (callback == nullptr) {
+    LOG(ERROR) << "Asynchronous scan requested without a callback";
+    return Status::ok();
+  }
+
+  int32_t request_id = next_scan_request_id_;
+  next_scan_request_id_ = next_scan_request_id_ ==
+                                  std::numeric_limits<int32_t>::max()
+                              ? 1
+                              : next_scan_request_id_ + 1;
+  vector<ScanRequest> requests = CreateScanRequests(scan_settings);
+  for (auto& request : requests) {
+    request.async_trigger = true;
+  }
+  requests.back().callers.front().request_id = request_id;
+  requests.back().callers.front().callback = callback;
+  if (SubmitScanRequests(std::move(requests))) {
+    *out_request_id = request_id;
+  }
+  return Status::ok();
+}
+
+vector<ScannerImpl::ScanRequest> ScannerImpl::CreateScanRequests(
+    const SingleScanSettings& scan_settings) {
+  ScanRequest request;
+  request.priority = scan_settings.priority_;
+  request.scan_type = GetSupportedScanType(scan_settings.scan_type_);
+  if (scan_settings.dwell_time_ms_ > 0) {
+    if (wiphy_features_.supports_scan_dwell) {
+      request.dwell_time_ms = scan_settings.dwell_time_ms_;
+    } else {
+      LOG(WARNING) << "Scan dwell time is not supported, "
+                   << "using the driver default";
+    }
+  }
+  if (scan_settings.flush_cache_) {
+    if (wiphy_features_.supports_scan_flush) {
+      request.flush_cache = true;
+    } else {
+      LOG(WARNING) << "Flushing the BSS cache on scan is not supported";
+    }
+  }
+  vector<vector<uint8_t>> hidden_ssids;
+  for (auto& network : scan_settings.hidden_networks_) {
+    hidden_ssids.push_back(network.ssid_);
+  }
+  // One ssid slot is taken by the wild card ssid.
+  uint32_t max_hidden_ssids = 0;
+  if (scan_capabilities_.max_num_scan_ssids > request.ssids.size()) {
+    max_hidden_ssids =
+        scan_capabilities_.max_num_scan_ssids - request.ssids.size();
+  }
+  vector<vector<vector<uint8_t>>> hidden_ssid_batches =
+      hidden_network_scheduler_.Schedule(
+          hidden_ssids, max_hidden_ssids,
+          scan_settings.full_hidden_network_coverage_);
+  request.ssids.insert(request.ssids.end(), hidden_ssid_batches[0].begin(),
+                       hidden_ssid_batches[0].end());
+  if (hidden_ssid_batches.size() == 1 &&
+      hidden_ssid_batches[0].size() < hidden_ssids.size()) {
+    LOG(INFO) << "Deferring "
+              << hidden_ssids.size() - hidden_ssid_batches[0].size()
+              << " hidden network(s) to later scans";
+  }
+
+  for (auto& channel : scan_settings.channel_settings_) {
+    request.freqs.push_back(channel.frequency_);
   }
+  if (channel_planner_ != nullptr && request.freqs.empty()) {
+    request.freqs = channel_planner_->PlanScan();
+    if (!request.freqs.empty()) {
+      LOG(INFO) << "Planned partial scan over " << request.freqs.size()
+                << " channel(s)";
+    }
+  }
+
+  ScanCaller caller;
+  caller.priority = scan_settings.priority_;
+  caller.request_time_ms = GetBootTimeMs();
+  if (scan_settings.deadline_ms_ > 0) {
+    caller.deadline_ms = caller.request_time_ms + scan_settings.deadline_ms_;
+  }
+
+  if (hidden_ssid_batches.size() == 1) {
+    request.callers.push_back(caller);
+    return {request};
+  }
+  LOG(INFO) << "Splitting scan request into " << hidden_ssid_batches.size()
+            << " scans to probe all hidden networks";
+  // Only the last scan reports back to the caller. Flushing the BSS cache
+  // past the first scan would drop what the previous ones found.
+  vector<ScanRequest> split_scans;
+  for (const auto& batch : hidden_ssid_batches) {
+    ScanRequest split_scan = request;
+    split_scan.ssids = {{}};
+    split_scan.ssids.insert(split_scan.ssids.end(), batch.begin(),
+                            batch.end());
+    split_scan.flush_cache = split_scans.empty() && request.flush_cache;
+    split_scans.push_back(split_scan);
+  }
+  split_scans.back().callers.push_back(caller);
+  return split_scans;
+}
+
+bool ScannerImpl::SubmitScanRequests(vector<ScanRequest> requests) {
+  if (!scan_started_) {
+    int error_code = 0;
+    if (!StartScan(requests.front(), &error_code)) {
+      return false;
+    }
+    for (auto it = requests.begin() + 1; it != requests.end(); ++it) {
+      QueueScan(*it, false);
+    }
+    ArmScanDeadlineTimer();
+    return true;
+  }
+
+  // The kernel only runs one scan at a time. Instead of sending a request
+  // that would be rejected with EBUSY, either piggyback on the ongoing
+  // scan, pre-empt it, or queue the request for a later scan.
+  if (requests.size() == 1) {
+    ScanRequest& request = requests.front();
+    if (IsCoveredBy(request, ongoing_scan_)) {
+      LOG(INFO) << "Scan request is covered by the ongoing scan";
+      OnCallersStarted(&request);
+      AddCallers(request, &ongoing_scan_);
+      // Otherwise the callers are told together with the ones of the
+      // ongoing scan.
+      if (!scan_trigger_pending_) {
+        NotifyScanAcked(request, ongoing_scan_cookie_);
+      }
+      return true;
+    }
+    if (!CanPreemptOngoingScan(request)) {
+      LOG(INFO) << "Scan already started, coalescing into follow-up scan";
+      MergeInto(request, &follow_up_scan_);
+      ArmScanDeadlineTimer();
+      return true;
+    }
+  }
+  for (const auto& request : requests) {
+    QueueScan(request, false);
+  }
+  ArmScanDeadlineTimer();
+  if (CanPreemptOngoingScan(requests.front())) {
+    LOG(INFO) << "Pre-empting ongoing scan of priority "
+              << ongoing_scan_.priority << " for scan of priority "
+              << requests.front().priority;
+    if (scan_utils_->AbortScan(interface_index_)) {
+      preempting_scan_ = true;
+    } else {
+      LOG(WARNING) << "Failed to pre-empt ongoing scan";
+    }
+  }
+  return true;
+}
+
+bool ScannerImpl::CanPreemptOngoingScan(const ScanRequest& request) const {
+  // An unanswered trigger can't be aborted yet. The request still runs
+  // before the scans of lower priority.
+  return scan_started_ && !scan_trigger_pending_ && !preempting_scan_ &&
+         request.priority > ongoing_scan_.priority;
+}
+
+void ScannerImpl::QueueScan(const ScanRequest& request,
+                            bool ahead_of_equal_priority) {
+  auto it = std::find_if(
+      queued_scans_.begin(), queued_scans_.end(),
+      [&request, ahead_of_equal_priority](const ScanRequest& queued_scan) {
+        return ahead_of_equal_priority
+                   ? queued_scan.priority <= request.priority
+                   : queued_scan.priority < request.priority;
+      });
+  queued_scans_.insert(it, request);
+}
+
+bool ScannerImpl::DropExpiredCallers(ScanRequest* request) {
+  // The earlier scans of a split request have no callers of their own.
+  if (request->callers.empty()) {
+    return false;
+  }
+  int64_t now_ms = GetBootTimeMs();
+  ScanRequest expired_scan;
+  vector<ScanCaller> waiting_callers;
+  for (const auto& caller : request->callers) {
+    if (!caller.started && caller.deadline_ms != 0 &&
+        caller.deadline_ms < now_ms) {
+      expired_scan.callers.push_back(caller);
+      scan_arbitration_stats_[caller.priority].num_expired++;
+    } else {
+      waiting_callers.push_back(caller);
+    }
+  }
+  if (expired_scan.callers.empty()) {
+    return false;
+  }
+  LOG(WARNING) << expired_scan.callers.size()
+               << " scan request(s) missed their deadline";
+  NotifyScanFailed(expired_scan, ETIMEDOUT);
+  request->callers = waiting_callers;
+  return waiting_callers.empty();
+}
+
+void ScannerImpl::ArmScanDeadlineTimer() {
+  int64_t earliest_deadline_ms = 0;
+  auto find_earliest = [&earliest_deadline_ms](const ScanRequest& request) {
+    for (const auto& caller : request.callers) {
+      if (caller.started || caller.deadline_ms == 0) {
+        continue;
+      }
+      if (earliest_deadline_ms == 0 ||
+          caller.deadline_ms < earliest_deadline_ms) {
+        earliest_deadline_ms = caller.deadline_ms;
+      }
+    }
+  };
+  for (const auto& queued_scan : queued_scans_) {
+    find_earliest(queued_scan);
+  }
+  find_earliest(follow_up_scan_);
+  if (earliest_deadline_ms == 0) {
+    return;
+  }
+  uint32_t generation = ++scan_deadline_generation_;
+  std::weak_ptr<bool> lifetime_token = lifetime_token_;
+  auto task = [this, lifetime_token, generation]() {
+    if (!lifetime_token.expired() &&
+        generation == scan_deadline_generation_) {
+      OnScanDeadline();
+    }
+  };
+  // Deadlines are exclusive, see DropExpiredCallers().
+  int64_t delay_ms =
+      std::max<int64_t>(earliest_deadline_ms - GetBootTimeMs() + 1, 1);
+  event_loop_->PostDelayedTask(task, delay_ms);
+}
+
+void ScannerImpl::OnScanDeadline() {
+  for (auto it = queued_scans_.begin(); it != queued_scans_.end();) {
+    if (DropExpiredCallers(&*it)) {
+      it = queued_scans_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (DropExpiredCallers(&follow_up_scan_)) {
+    follow_up_scan_ = ScanRequest();
+  }
+  ArmScanDeadlineTimer();
+}
+
+void ScannerImpl::OnCallersStarted(ScanRequest* request) {
+  int64_t now_ms = GetBootTimeMs();
+  for (auto& caller : request->callers) {
+    if (caller.started) {
+      continue;
+    }
+    caller.started = true;
+    int64_t queueing_ms = now_ms - caller.request_time_ms;
+    ScanArbitrationStats& stats = scan_arbitration_stats_[caller.priority];
+    stats.num_started++;
+    stats.total_queueing_ms += queueing_ms;
+    stats.max_queueing_ms = std::max(stats.max_queueing_ms, queueing_ms);
+  }
+}
+
+bool ScannerImpl::StartScan(const ScanRequest& request, int* error_code) {
   // Only request MAC address randomization when station is not associated.
   bool request_random_mac = wiphy_features_.supports_random_mac_oneshot_scan &&
                             !client_interface_->IsAssociated();
 
-  // Initialize it with an empty ssid for a wild card scan.
-  vector<vector<uint8_t>> ssids = {{}};
+  *error_code = 0;
+  if (request.async_trigger) {
+    if (!scan_utils_->ScanAsync(interface_index_, request_random_mac,
+                                request.scan_type, request.dwell_time_ms,
+                                request.flush_cache, request.ssids,
+                                request.freqs)) {
+      return false;
+    }
+    scan_trigger_pending_ = true;
+    uint32_t generation = ++scan_trigger_generation_;
+    std::weak_ptr<bool> lifetime_token = lifetime_token_;
+    auto task = [this, lifetime_token, generation]() {
+      if (!lifetime_token.expired() &&
+          generation == scan_trigger_generation_) {
+        OnScanTriggerTimeout();
+      }
+    };
+    event_loop_->PostDelayedTask(task, kScanTriggerTimeoutMs);
+  } else {
+    if (!scan_utils_->Scan(interface_index_, request_random_mac,
+                           request.scan_type, request.dwell_time_ms,
+                           request.flush_cache, request.ssids, request.freqs,
+                           error_code)) {
+      CHECK(*error_code != ENODEV) << "Driver is in a bad state, restarting wificond";
+      return false;
+    }
+    scan_trigger_pending_ = false;
+  }
+  ongoing_scan_ = request;
+  ongoing_scan_cookie_ = 0;
+  scan_started_ = true;
+  OnCallersStarted(&ongoing_scan_);
+  return true;
+}
 
-  vector<vector<uint8_t>> skipped_scan_ssids;
-  for (auto& network : scan_settings.hidden_networks_) {
-    if (ssids.size() + 1 > scan_capabilities_.max_num_scan_ssids) {
-      skipped_scan_ssids.emplace_back(network.ssid_);
-      continue;
+int ScannerImpl::GetSupportedScanType(int scan_type) const {
+  bool supported;
+  switch (scan_type) {
+    case IWifiScannerImpl::SCAN_TYPE_LOW_SPAN:
+      supported = wiphy_features_.supports_low_span_oneshot_scan;
+      break;
+    case IWifiScannerImpl::SCAN_TYPE_LOW_POWER:
+      supported = wiphy_features_.supports_low_power_oneshot_scan;
+      break;
+    case IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY:
+      supported = wiphy_features_.supports_high_accuracy_oneshot_scan;
+      break;
+    default:
+      return IWifiScannerImpl::SCAN_TYPE_DEFAULT;
+  }
+  if (!supported) {
+    LOG(WARNING) << "Scan type " << scan_type
+                 << " is not supported, using the default scan type";
+    return IWifiScannerImpl::SCAN_TYPE_DEFAULT;
+  }
+  return scan_type;
+}
+
+bool ScannerImpl::IsCoveredBy(const ScanRequest& request,
+                              const ScanRequest& ongoing_scan) const {
+  // Low span and low power scans may skip channels or use short dwell
+  // times, so they can't stand in for a high accuracy scan.
+  if (request.scan_type == IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY &&
+      ongoing_scan.scan_type != IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY) {
+    return false;
+  }
+  if (request.dwell_time_ms > ongoing_scan.dwell_time_ms &&
+      ongoing_scan.dwell_time_ms != 0) {
+    return false;
+  }
+  if (request.flush_cache && !ongoing_scan.flush_cache) {
+    return false;
+  }
+  for (const auto& ssid : request.ssids) {
+    if (std::find(ongoing_scan.ssids.begin(), ongoing_scan.ssids.end(), ssid) ==
+        ongoing_scan.ssids.end()) {
+      return false;
+    }
+  }
+  // An empty frequency list covers all frequencies.
+  if (ongoing_scan.freqs.empty()) {
+    return true;
+  }
+  if (request.freqs.empty()) {
+    return false;
+  }
+  for (uint32_t freq : request.freqs) {
+    if (std::find(ongoing_scan.freqs.begin(), ongoing_scan.freqs.end(), freq) ==
+        ongoing_scan.freqs.end()) {
+      return false;
     }
-    ssids.push_back(network.ssid_);
   }
+  return true;
+}
 
-  LogSsidList(skipped_scan_ssids, "Skip scan ssid for single scan");
+void ScannerImpl::MergeInto(const ScanRequest& request,
+                            ScanRequest* follow_up_scan) {
+  if (follow_up_scan->callers.empty()) {
+    *follow_up_scan = request;
+    return;
+  }
+  AddCallers(request, follow_up_scan);
+  follow_up_scan->priority =
+      std::max(follow_up_scan->priority, request.priority);
+  follow_up_scan->async_trigger |= request.async_trigger;
 
-  vector<uint32_t> freqs;
-  for (auto& channel : scan_settings.channel_settings_) {
-    freqs.push_back(channel.frequency_);
+  // Callers asking for different scan types or dwell times share one scan.
+  // High accuracy wins, since it serves everyone; other mismatches fall back
+  // to the driver's regular trade-off.
+  if (follow_up_scan->scan_type != request.scan_type) {
+    if (follow_up_scan->scan_type !=
+            IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY &&
+        request.scan_type != IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY) {
+      follow_up_scan->scan_type = IWifiScannerImpl::SCAN_TYPE_DEFAULT;
+    } else {
+      follow_up_scan->scan_type = IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY;
+    }
+  }
+  if (follow_up_scan->dwell_time_ms != request.dwell_time_ms) {
+    follow_up_scan->dwell_time_ms = 0;
   }
+  follow_up_scan->flush_cache |= request.flush_cache;
 
-  int error_code = 0;
-  if (!scan_utils_->Scan(interface_index_, request_random_mac, ssids, freqs,
-                         &error_code)) {
-    CHECK(error_code != ENODEV) << "Driver is in a bad state, restarting wificond";
-    *out_success = false;
-    return Status::ok();
+  vector<vector<uint8_t>> skipped_scan_ssids;
+  for (const auto& ssid : request.ssids) {
+    if (std::find(follow_up_scan->ssids.begin(), follow_up_scan->ssids.end(),
+                  ssid) != follow_up_scan->ssids.end()) {
+      continue;
+    }
+    if (follow_up_scan->ssids.size() + 1 >
+        scan_capabilities_.max_num_scan_ssids) {
+      skipped_scan_ssids.push_back(ssid);
+      continue;
+    }
+    follow_up_scan->ssids.push_back(ssid);
+  }
+  LogSsidList(skipped_scan_ssids, "Skip scan ssid for follow-up scan");
+  // The request was scheduled right before it got merged. Its hidden
+  // networks that did not fit stay first in line for the next request.
+  hidden_network_scheduler_.Defer(skipped_scan_ssids);
+
+  // Scanning all frequencies absorbs any frequency list.
+  if (follow_up_scan->freqs.empty() || request.freqs.empty()) {
+    follow_up_scan->freqs.clear();
+    return;
+  }
+  for (uint32_t freq : request.freqs) {
+    if (std::find(follow_up_scan->freqs.begin(), follow_up_scan->freqs.end(),
+                  freq) == follow_up_scan->freqs.end()) {
+      follow_up_scan->freqs.push_back(freq);
+    }
   }
-  scan_started_ = true;
-  *out_success = true;
-  return Status::ok();
 }
 
 Status ScannerImpl::startPnoScan(const PnoSettings& pno_settings,
                                  bool* out_success) {
+  bool pno_scan_running = pno_scan_started_ || pno_scan_running_over_offload_;
+  if (pno_scan_running) {
+    pno_update_stats_.num_updates++;
+    // Restarting would reset the scan plans of the firmware for nothing.
+    // Networks left out are rotated in on a timer of their own.
+    if (IsSamePnoScan(pno_settings, pno_settings_)) {
+      LOG(VERBOSE) << "Pno settings unchanged, keep the running scans";
+      pno_update_stats_.num_unchanged_updates++;
+      pno_settings_ = pno_settings;
+      *out_success = true;
+      return Status::ok();
+    }
+  }
+  bool was_split = pno_scan_split_;
+  PnoSettings previous_netlink_settings = std::move(pno_netlink_settings_);
   pno_settings_ = pno_settings;
   pno_scan_results_from_offload_ = false;
+  pno_scan_awaiting_offload_ = false;
+  pno_scan_split_ = false;
+  pno_rotation_pending_ = true;
+  pno_netlink_settings_ = PnoSettings();
+  if (channel_planner_ != nullptr) {
+    vector<vector<uint8_t>> saved_ssids;
+    for (const auto& network : pno_settings.pno_networks_) {
+      saved_ssids.push_back(network.ssid_);
+    }
+    channel_planner_->SetSavedSsids(saved_ssids);
+  }
   LOG(VERBOSE) << "startPnoScan";
-  if (offload_scan_supported_ && StartPnoScanOffload(pno_settings)) {
+  PnoSettings offload_settings;
+  if (offload_scan_supported_) {
+    SplitPnoSettings(pno_settings, &offload_settings, &pno_netlink_settings_);
+  }
+  if (offload_scan_supported_ && StartPnoScanOffload(offload_settings)) {
     // scanning over offload succeeded
     *out_success = true;
+    if (was_split &&
+        !pno_netlink_settings_.pno_networks_.empty() &&
+        IsSamePnoScan(pno_netlink_settings_, previous_netlink_settings)) {
+      // Only the networks over the Offload HAL changed, which it updated in
+      // place. The scheduled scan goes on as it was.
+      pno_update_stats_.num_sched_scans_kept++;
+      pno_scan_split_ = true;
+    } else if (!pno_netlink_settings_.pno_networks_.empty()) {
+      if (pno_scan_started_) {
+        // The kernel cannot update the match sets of a running scheduled
+        // scan.
+        StopPnoScanDefault();
+      }
+      // Cover the networks the Offload HAL could not hold over netlink.
+      pno_scan_split_ = StartPnoScanDefault(pno_netlink_settings_);
+      if (pno_scan_split_) {
+        pno_offload_stats_.num_hybrid_starts++;
+        LOG(INFO) << "Pno scans split: "
+                  << offload_settings.pno_networks_.size()
+                  << " network(s) over Offload HAL, "
+                  << pno_netlink_settings_.pno_networks_.size()
+                  << " over netlink";
+      } else {
+        LOG(WARNING) << "Unable to scan over netlink for the networks the "
+                        "Offload HAL could not hold";
+      }
+    } else if (pno_scan_started_) {
+      // The Offload HAL holds all networks now, including those of a
+      // scheduled scan started while it was unavailable.
+      StopPnoScanDefault();
+    }
   } else {
+    if (pno_scan_started_) {
+      // The kernel rejects a second scheduled scan.
+      StopPnoScanDefault();
+    }
     *out_success = StartPnoScanDefault(pno_settings);
   }
   return Status::ok();
@@ -269,12 +894,16 @@ bool ScannerImpl::StartPnoScanOffload(const PnoSettings& pno_settings) {
   // Empty frequency list: scan all frequencies.
   vector<uint32_t> freqs;
 
-  ParsePnoSettings(pno_settings, &scan_ssids, &match_ssids, &freqs,
-                   &match_security);
+  ParsePnoSettings(pno_settings, offload_max_pno_networks_, &scan_ssids,
+                   &match_ssids, &freqs, &match_security);
   pno_scan_running_over_offload_ = offload_scan_manager_->startScan(
       pno_settings.interval_ms_,
-      // TODO: honor both rssi thresholds.
-      pno_settings.min_5g_rssi_, scan_ssids, match_ssids, match_security, freqs,
+      // The Offload HAL only takes one threshold for all bands. Use the lower
+      // one so that no candidate gets filtered out.
+      std::min(pno_settings.min_2g_rssi_, pno_settings.min_5g_rssi_),
+      scan_ssids, match_ssids, match_security, freqs,
+      static_cast<uint32_t>(
+          std::max(pno_settings.offload_subscription_delay_ms_, 0)),
       &reason_code);
   if (pno_scan_running_over_offload_) {
     LOG(VERBOSE) << "Pno scans requested over Offload HAL";
@@ -285,37 +914,72 @@ bool ScannerImpl::StartPnoScanOffload(const PnoSettings& pno_settings) {
   return pno_scan_running_over_offload_;
 }
 
+void ScannerImpl::SplitPnoSettings(const PnoSettings& pno_settings,
+                                   PnoSettings* offload_settings,
+                                   PnoSettings* netlink_settings) {
+  *offload_settings = pno_settings;
+  *netlink_settings = pno_settings;
+  offload_settings->pno_networks_.clear();
+  netlink_settings->pno_networks_.clear();
+  const vector<PnoNetwork>& networks = pno_settings.pno_networks_;
+  // Same limits as ParsePnoSettings() for the Offload HAL, so that it keeps
+  // every network selected here.
+  vector<size_t> selected = pno_network_ranker_.SelectNetworks(
+      networks, offload_max_pno_networks_,
+      scan_capabilities_.max_num_sched_scan_ssids, GetBootTimeMs(),
+      pno_rotation_pending_);
+  pno_rotation_pending_ = false;
+  vector<bool> is_selected(networks.size(), false);
+  for (size_t index : selected) {
+    is_selected[index] = true;
+    offload_settings->pno_networks_.push_back(networks[index]);
+  }
+  for (size_t i = 0; i < networks.size(); i++) {
+    if (!is_selected[i]) {
+      netlink_settings->pno_networks_.push_back(networks[i]);
+    }
+  }
+}
+
 void ScannerImpl::ParsePnoSettings(const PnoSettings& pno_settings,
+                                   uint32_t max_networks,
                                    vector<vector<uint8_t>>* scan_ssids,
                                    vector<vector<uint8_t>>* match_ssids,
                                    vector<uint32_t>* freqs,
                                    vector<uint8_t>* match_security) {
   // TODO provide actionable security match parameters
   const uint8_t kNetworkFlagsDefault = 0;
-  vector<vector<uint8_t>> skipped_scan_ssids;
-  vector<vector<uint8_t>> skipped_match_ssids;
-  for (auto& network : pno_settings.pno_networks_) {
+  const vector<PnoNetwork>& networks = pno_settings.pno_networks_;
+  // TODO remove pruning for Offload Scans
+  uint32_t max_hidden_networks = 0;
+  if (scan_capabilities_.max_num_sched_scan_ssids > scan_ssids->size()) {
+    max_hidden_networks =
+        scan_capabilities_.max_num_sched_scan_ssids - scan_ssids->size();
+  }
+  vector<size_t> selected = pno_network_ranker_.SelectNetworks(
+      networks, max_networks, max_hidden_networks, GetBootTimeMs(),
+      pno_rotation_pending_);
+  pno_rotation_pending_ = false;
+  vector<bool> is_selected(networks.size(), false);
+  for (size_t index : selected) {
+    is_selected[index] = true;
     // Add hidden network ssid.
-    if (network.is_hidden_) {
-      // TODO remove pruning for Offload Scans
-      if (scan_ssids->size() + 1 >
-          scan_capabilities_.max_num_sched_scan_ssids) {
-        skipped_scan_ssids.emplace_back(network.ssid_);
-        continue;
-      }
-      scan_ssids->push_back(network.ssid_);
+    if (networks[index].is_hidden_) {
+      scan_ssids->push_back(networks[index].ssid_);
     }
-
-    if (match_ssids->size() + 1 > scan_capabilities_.max_match_sets) {
-      skipped_match_ssids.emplace_back(network.ssid_);
-      continue;
-    }
-    match_ssids->push_back(network.ssid_);
+    match_ssids->push_back(networks[index].ssid_);
     match_security->push_back(kNetworkFlagsDefault);
   }
 
-  LogSsidList(skipped_scan_ssids, "Skip scan ssid for pno scan");
-  LogSsidList(skipped_match_ssids, "Skip match ssid for pno scan");
+  // Networks left out are rotated in by restarting the scheduled scan, see
+  // SchedulePnoRotation().
+  vector<vector<uint8_t>> skipped_ssids;
+  for (size_t i = 0; i < networks.size(); i++) {
+    if (!is_selected[i]) {
+      skipped_ssids.push_back(networks[i].ssid_);
+    }
+  }
+  LogSsidList(skipped_ssids, "Defer ssid to a later pno scan");
 }
 
 bool ScannerImpl::StartPnoScanDefault(const PnoSettings& pno_settings) {
@@ -332,17 +996,32 @@ bool ScannerImpl::StartPnoScanDefault(const PnoSettings& pno_settings) {
   // Empty frequency list: scan all frequencies.
   vector<uint32_t> freqs;
 
-  ParsePnoSettings(pno_settings, &scan_ssids, &match_ssids, &freqs, &unused);
+  ParsePnoSettings(pno_settings, scan_capabilities_.max_match_sets,
+                   &scan_ssids, &match_ssids, &freqs, &unused);
+  if (channel_planner_ != nullptr && freqs.empty()) {
+    freqs = channel_planner_->PlanPnoScan();
+    if (!freqs.empty()) {
+      LOG(INFO) << "Planned partial pno scan over " << freqs.size()
+                << " channel(s)";
+    }
+  }
+  bool associated = client_interface_->IsAssociated();
+  SchedScanReqFlags req_flags;
   // Only request MAC address randomization when station is not associated.
-  bool request_random_mac = wiphy_features_.supports_random_mac_sched_scan &&
-      !client_interface_->IsAssociated();
+  req_flags.request_random_mac =
+      wiphy_features_.supports_random_mac_sched_scan && !associated;
+  req_flags.request_band_specific_rssi =
+      wiphy_features_.supports_sched_scan_band_specific_rssi;
+  // Relative RSSI only makes sense against a connected BSS.
+  req_flags.request_relative_rssi =
+      wiphy_features_.supports_sched_scan_relative_rssi && associated;
 
   int error_code = 0;
   if (!scan_utils_->StartScheduledScan(interface_index_,
                                        GenerateIntervalSetting(pno_settings),
-                                       // TODO: honor both rssi thresholds.
+                                       pno_settings.min_2g_rssi_,
                                        pno_settings.min_5g_rssi_,
-                                       request_random_mac,
+                                       req_flags,
                                        scan_ssids,
                                        match_ssids,
                                        freqs,
@@ -353,13 +1032,68 @@ bool ScannerImpl::StartPnoScanDefault(const PnoSettings& pno_settings) {
   }
   LOG(INFO) << "Pno scan started";
   pno_scan_started_ = true;
+  pno_planner_scanned_freqs_ = freqs;
+  pno_planner_update_pending_ = false;
+  if (match_ssids.size() < pno_settings.pno_networks_.size()) {
+    SchedulePnoRotation(pno_settings.interval_ms_);
+  }
   return true;
 }
 
+void ScannerImpl::SchedulePnoRotation(int64_t interval_ms) {
+  uint32_t generation = ++pno_rotation_generation_;
+  std::weak_ptr<bool> lifetime_token = lifetime_token_;
+  auto task = [this, lifetime_token, generation]() {
+    if (!lifetime_token.expired() && generation == pno_rotation_generation_) {
+      RotatePnoNetworks();
+    }
+  };
+  event_loop_->PostDelayedTask(
+      task, interval_ms * PnoSettings::kSlowScanIntervalMultiplier *
+                kPnoRotationWindowSlowScans);
+}
+
+void ScannerImpl::RotatePnoNetworks() {
+  if (!pno_scan_started_) {
+    return;
+  }
+  // The kernel cannot update the match sets of a running scheduled scan.
+  // Restarting it also restarts its fast scans, hence the long window.
+  const PnoSettings settings =
+      pno_scan_split_ ? pno_netlink_settings_ : pno_settings_;
+  LOG(INFO) << "Restarting pno scan to rotate in the networks left out";
+  if (!StopPnoScanDefault()) {
+    LOG(ERROR) << "Unable to stop pno scan for rotation";
+    return;
+  }
+  pno_update_stats_.num_rotations++;
+  pno_rotation_pending_ = true;
+  if (StartPnoScanDefault(settings)) {
+    return;
+  }
+  LOG(ERROR) << "Unable to restart pno scan with the next networks";
+  if (pno_scan_split_) {
+    // The Offload HAL still covers its networks.
+    pno_scan_split_ = false;
+  } else if (pno_scan_event_handler_ != nullptr) {
+    pno_scan_event_handler_->OnPnoScanFailed();
+  }
+}
+
 Status ScannerImpl::stopPnoScan(bool* out_success) {
+  if (pno_scan_awaiting_offload_) {
+    // Keep the Offload HAL from restoring these scans when it restarts.
+    OffloadScanManager::ReasonCode reason_code;
+    offload_scan_manager_->stopScan(&reason_code);
+    pno_scan_awaiting_offload_ = false;
+  }
   if (offload_scan_supported_ && StopPnoScanOffload()) {
     // Pno scans over offload stopped successfully
     *out_success = true;
+    if (pno_scan_split_) {
+      StopPnoScanDefault();
+      pno_scan_split_ = false;
+    }
   } else {
     // Pno scans were not requested over offload
     *out_success = StopPnoScanDefault();
@@ -388,6 +1122,8 @@ bool ScannerImpl::StopPnoScanDefault() {
   if (!pno_scan_started_) {
     LOG(WARNING) << "No pno scan started";
   }
+  // Cancel the pending rotation.
+  pno_rotation_generation_++;
   if (!scan_utils_->StopScheduledScan(interface_index_)) {
     return false;
   }
@@ -405,6 +1141,13 @@ Status ScannerImpl::abortScan() {
     LOG(WARNING) << "Scan is not started. Ignore abort request";
     return Status::ok();
   }
+  // Abort also cancels the queued and coalesced follow-up scans. Their
+  // callers are failed together with the ones of the ongoing scan.
+  // A pending pre-emption turns into a plain abort.
+  preempting_scan_ = false;
+  ClearQueuedScans(&ongoing_scan_);
+  AddCallers(follow_up_scan_, &ongoing_scan_);
+  follow_up_scan_ = ScanRequest();
   if (!scan_utils_->AbortScan(interface_index_)) {
     LOG(WARNING) << "Abort scan failed";
   }
@@ -429,6 +1172,28 @@ Status ScannerImpl::unsubscribeScanEvents() {
   return Status::ok();
 }
 
+Status ScannerImpl::subscribeScanResultDeltas(
+    const sp<IScanResultDeltaEvent>& handler) {
+  if (!CheckIsValid()) {
+    return Status::ok();
+  }
+
+  if (scan_result_delta_handler_ != nullptr) {
+    LOG(ERROR) << "Found existing scan result delta subscriber."
+               << " This subscription request will unsubscribe it";
+  }
+  scan_result_delta_handler_ = handler;
+  // The new subscriber knows nothing yet.
+  scan_result_delta_tracker_.Reset();
+  return Status::ok();
+}
+
+Status ScannerImpl::unsubscribeScanResultDeltas() {
+  scan_result_delta_handler_ = nullptr;
+  scan_result_delta_tracker_.Reset();
+  return Status::ok();
+}
+
 Status ScannerImpl::subscribePnoScanEvents(const sp<IPnoScanEvent>& handler) {
   if (!CheckIsValid()) {
     return Status::ok();
@@ -451,25 +1216,191 @@ Status ScannerImpl::unsubscribePnoScanEvents() {
 void ScannerImpl::OnScanResultsReady(uint32_t interface_index, bool aborted,
                                      vector<vector<uint8_t>>& ssids,
                                      vector<uint32_t>& frequencies) {
-  if (!scan_started_) {
+  // Even an aborted or external scan may have updated the BSS table.
+  scan_result_region_outdated_ = true;
+  // The kernel answers a scan trigger before it reports on the scan, so a
+  // report arriving while the trigger is unanswered isn't about our scan.
+  if (!scan_started_ || scan_trigger_pending_) {
     LOG(INFO) << "Received external scan result notification from kernel.";
+    ScanRequest external_scan;
+    external_scan.callers.push_back(ScanCaller());
+    NotifyScanCallers(external_scan, aborted);
+    return;
+  }
+  ScanRequest finished_scan = ongoing_scan_;
+  if (!aborted) {
+    planner_scanned_freqs_ = ongoing_scan_.freqs;
+    planner_update_pending_ = true;
   }
+  ongoing_scan_ = ScanRequest();
   scan_started_ = false;
-  if (scan_event_handler_ != nullptr) {
+  bool preempted = preempting_scan_ && aborted;
+  preempting_scan_ = false;
+  if (preempted) {
+    LOG(INFO) << "Scan pre-empted, restarting it after the scans of higher "
+              << "priority";
+    scan_arbitration_stats_[finished_scan.priority].num_preempted++;
+    QueueScan(finished_scan, true);
+    StartNextScan();
+    return;
+  }
+  if (aborted) {
+    // The remaining scans of a split request can't complete it any more.
+    ClearQueuedScans(&finished_scan);
+  } else if (scan_result_delta_handler_ != nullptr) {
+    // Deliver the changes before the scan event, so that subscribers need
+    // not fetch the scan results.
+    NotifyScanResultDelta();
+  }
+  NotifyScanCallers(finished_scan, aborted);
+  StartNextScan();
+}
+
+void ScannerImpl::OnScanTriggerTimeout() {
+  if (!scan_started_ || !scan_trigger_pending_) {
+    return;
+  }
+  LOG(ERROR) << "No answer to scan trigger from kernel";
+  // In case the kernel did start the scan, so that the next one isn't
+  // rejected with EBUSY.
+  scan_utils_->AbortScan(interface_index_);
+  OnScanTriggered(interface_index_, ETIMEDOUT, 0);
+}
+
+void ScannerImpl::OnScanTriggered(uint32_t interface_index, int error_code,
+                                  uint64_t cookie) {
+  if (!scan_started_ || !scan_trigger_pending_) {
+    LOG(WARNING) << "Unexpected scan trigger answer from kernel";
+    return;
+  }
+  scan_trigger_pending_ = false;
+  if (error_code == 0) {
+    ongoing_scan_cookie_ = cookie;
+    NotifyScanAcked(ongoing_scan_, cookie);
+    return;
+  }
+  CHECK(error_code != ENODEV) << "Driver is in a bad state, restarting wificond";
+  ScanRequest failed_scan = ongoing_scan_;
+  ongoing_scan_ = ScanRequest();
+  scan_started_ = false;
+  // The remaining scans of a split request can't complete it any more.
+  ClearQueuedScans(&failed_scan);
+  NotifyScanFailed(failed_scan, error_code);
+  StartNextScan();
+}
+
+void ScannerImpl::StartNextScan() {
+  int error_code = 0;
+  while (!queued_scans_.empty() || !follow_up_scan_.callers.empty()) {
+    // The follow-up scan only overtakes the queued scans of lower priority.
+    bool from_queue =
+        !queued_scans_.empty() &&
+        (follow_up_scan_.callers.empty() ||
+         queued_scans_.front().priority >= follow_up_scan_.priority);
+    ScanRequest next_scan;
+    if (from_queue) {
+      next_scan = queued_scans_.front();
+      queued_scans_.pop_front();
+    } else {
+      next_scan = follow_up_scan_;
+      follow_up_scan_ = ScanRequest();
+      LOG(INFO) << "Starting follow-up scan for " << next_scan.callers.size()
+                << " coalesced scan request(s)";
+    }
+    if (DropExpiredCallers(&next_scan)) {
+      continue;
+    }
+    if (StartScan(next_scan, &error_code)) {
+      return;
+    }
+    if (from_queue) {
+      LOG(ERROR) << "Failed to start queued scan";
+      ClearQueuedScans(&next_scan);
+    } else {
+      LOG(ERROR) << "Failed to start follow-up scan";
+    }
+    NotifyScanFailed(next_scan, error_code);
+  }
+}
+
+void ScannerImpl::NotifyScanResultDelta() {
+  vector<NativeScanResult> scan_results;
+  if (!scan_utils_->GetScanResult(interface_index_, &scan_results)) {
+    LOG(ERROR) << "Failed to get scan results via NL80211";
+    return;
+  }
+  ScanResultDelta delta = scan_result_delta_tracker_.Update(scan_results);
+  if (delta.empty()) {
+    return;
+  }
+  LOG(DEBUG) << "Scan result delta: " << delta.added_.size() << " added, "
+             << delta.updated_.size() << " updated, "
+             << delta.lost_bssids_.size() << " lost";
+  scan_result_delta_handler_->OnScanResultDelta(delta);
+}
+
+void ScannerImpl::ClearQueuedScans(ScanRequest* callers) {
+  for (const auto& queued_scan : queued_scans_) {
+    AddCallers(queued_scan, callers);
+  }
+  queued_scans_.clear();
+}
+
+void ScannerImpl::AddCallers(const ScanRequest& from, ScanRequest* to) {
+  to->callers.insert(to->callers.end(), from.callers.begin(),
+                     from.callers.end());
+}
+
+void ScannerImpl::NotifyScanCallers(const ScanRequest& request,
+                                    bool aborted) {
+  if (aborted) {
+    LOG(WARNING) << "Scan aborted";
+  }
+  for (const auto& caller : request.callers) {
+    if (caller.callback != nullptr) {
+      caller.callback->OnScanRequestCompleted(caller.request_id, aborted);
+      continue;
+    }
+    if (scan_event_handler_ == nullptr) {
+      LOG(WARNING) << "No scan event handler found.";
+      continue;
+    }
     // TODO: Pass other parameters back once we find framework needs them.
     if (aborted) {
-      LOG(WARNING) << "Scan aborted";
       scan_event_handler_->OnScanFailed();
     } else {
       scan_event_handler_->OnScanResultReady();
     }
-  } else {
-    LOG(WARNING) << "No scan event handler found.";
+  }
+}
+
+void ScannerImpl::NotifyScanAcked(const ScanRequest& request,
+                                  uint64_t cookie) {
+  for (const auto& caller : request.callers) {
+    if (caller.callback != nullptr) {
+      caller.callback->OnScanRequestAcked(caller.request_id, cookie);
+    }
+  }
+}
+
+void ScannerImpl::NotifyScanFailed(const ScanRequest& request,
+                                   int error_code) {
+  for (const auto& caller : request.callers) {
+    if (caller.callback != nullptr) {
+      caller.callback->OnScanRequestFailed(caller.request_id, error_code);
+    } else if (scan_event_handler_ != nullptr) {
+      // scan() callers were told the scan started, so the failure reaches
+      // them as a scan event.
+      scan_event_handler_->OnScanFailed();
+    }
   }
 }
 
 void ScannerImpl::OnSchedScanResultsReady(uint32_t interface_index,
                                           bool scan_stopped) {
+  if (!scan_stopped) {
+    scan_result_region_outdated_ = true;
+  }
   if (pno_scan_event_handler_ != nullptr) {
     if (scan_stopped) {
       // If |pno_scan_started_| is false.
@@ -483,7 +1414,8 @@ void ScannerImpl::OnSchedScanResultsReady(uint32_t interface_index,
     } else {
       LOG(INFO) << "Pno scan result ready event";
       pno_scan_results_from_offload_ = false;
-      pno_scan_event_handler_->OnPnoNetworkFound();
+      pno_planner_update_pending_ = true;
+      NotifyPnoNetworkFound();
     }
   }
 }
@@ -491,29 +1423,26 @@ void ScannerImpl::OnSchedScanResultsReady(uint32_t interface_index,
 SchedScanIntervalSetting ScannerImpl::GenerateIntervalSetting(
     const ::com::android::server::wifi::wificond::PnoSettings&
         pno_settings) const {
-  bool support_num_scan_plans = scan_capabilities_.max_num_scan_plans >= 2;
-  bool support_scan_plan_interval =
-      scan_capabilities_.max_scan_plan_interval * 1000 >=
-          pno_settings.interval_ms_ * PnoSettings::kSlowScanIntervalMultiplier;
-  bool support_scan_plan_iterations =
-      scan_capabilities_.max_scan_plan_iterations >=
-                  PnoSettings::kFastScanIterations;
-
   uint32_t fast_scan_interval =
       static_cast<uint32_t>(pno_settings.interval_ms_);
-  if (support_num_scan_plans && support_scan_plan_interval &&
-      support_scan_plan_iterations) {
-    return SchedScanIntervalSetting{
-        {{fast_scan_interval, PnoSettings::kFastScanIterations}},
-        fast_scan_interval * PnoSettings::kSlowScanIntervalMultiplier};
-  } else {
-    // Device doesn't support the provided scan plans.
+  ScanPlanGenerator::Config config;
+  config.fast_interval_ms = fast_scan_interval;
+  config.slow_interval_ms =
+      fast_scan_interval * PnoSettings::kSlowScanIntervalMultiplier;
+  config.backoff_factor = kScanPlanBackoffFactor;
+  config.iterations_per_plan = PnoSettings::kFastScanIterations;
+
+  ScanPlanGenerator generator(scan_capabilities_);
+  SchedScanIntervalSetting interval_setting = generator.Generate(config);
+  if (!generator.IsValid(interval_setting)) {
     // Specify single interval instead.
     // In this case, the driver/firmware is expected to implement back off
     // logic internally using |pno_settings.interval_ms_| as "fast scan"
     // interval.
+    LOG(WARNING) << "Generated invalid scan plans, using a single interval";
     return SchedScanIntervalSetting{{}, fast_scan_interval};
   }
+  return interval_setting;
 }
 
 void ScannerImpl::OnOffloadScanResult() {
@@ -524,13 +1453,67 @@ void ScannerImpl::OnOffloadScanResult() {
   }
   LOG(INFO) << "Offload Scan results received";
   pno_scan_results_from_offload_ = true;
+  if (channel_planner_ != nullptr) {
+    // Fresh stats tell which channels the Offload HAL scanned for these
+    // results, so that the empty ones lose yield too. The periodic samples
+    // can be minutes old, or missing.
+    NativeScanStats scan_stats;
+    if (!offload_scan_manager_->getScanStats(&scan_stats)) {
+      LOG(WARNING) << "Failed to get scan stats via Offload HAL";
+    }
+    channel_planner_->OnOffloadScanResults(
+        scan_stats.histogram_channels_,
+        *offload_scan_manager_->getScanResultSnapshot());
+  }
   if (pno_scan_event_handler_ != nullptr) {
-    pno_scan_event_handler_->OnPnoNetworkFound();
+    NotifyPnoNetworkFound();
   } else {
     LOG(WARNING) << "No scan event handler Offload Scan result";
   }
 }
 
+void ScannerImpl::NotifyPnoNetworkFound() {
+  int64_t now_ms = GetBootTimeMs();
+  if (pno_scan_split_ && last_pno_network_found_ms_ >= 0 &&
+      now_ms - last_pno_network_found_ms_ < kSplitPnoMatchWindowMs) {
+    // The results of this half are merged into those already reported.
+    pno_offload_stats_.num_merged_matches++;
+    LOG(INFO) << "Pno network found event merged into the previous one";
+    return;
+  }
+  last_pno_network_found_ms_ = now_ms;
+  pno_scan_event_handler_->OnPnoNetworkFound();
+}
+
+bool ScannerImpl::GetSplitPnoScanResults(
+    vector<NativeScanResult>* out_scan_results) {
+  vector<NativeScanResult> offload_results;
+  if (!offload_scan_manager_->getScanResults(&offload_results)) {
+    LOG(WARNING) << "Failed to get scan results via Offload HAL";
+  }
+  if (!scan_utils_->GetScanResult(interface_index_, out_scan_results)) {
+    LOG(ERROR) << "Failed to get scan results via NL80211";
+    return false;
+  }
+  if (channel_planner_ != nullptr && pno_planner_update_pending_) {
+    channel_planner_->OnPnoScanResults(pno_planner_scanned_freqs_,
+                                       *out_scan_results);
+    pno_planner_update_pending_ = false;
+  }
+  // Kernel results carry all information elements, so they win over the
+  // Offload HAL results of the same BSS.
+  std::set<vector<uint8_t>> bssids;
+  for (const auto& result : *out_scan_results) {
+    bssids.insert(result.bssid);
+  }
+  for (auto& result : offload_results) {
+    if (bssids.insert(result.bssid).second) {
+      out_scan_results->push_back(std::move(result));
+    }
+  }
+  return true;
+}
+
 void ScannerImpl::OnOffloadError(
     OffloadScanCallbackInterface::AsyncErrorReason error_code) {
   if (!pno_scan_running_over_offload_) {
@@ -560,21 +1543,90 @@ void ScannerImpl::OnOffloadError(
       break;
   }
   bool success = false;
-  // Stop scans over Offload HAL and request them over netlink
-  stopPnoScan(&success);
-  if (success) {
-    LOG(INFO) << "Pno scans stopped";
+  if (error_code ==
+      OffloadScanCallbackInterface::AsyncErrorReason::BINDER_DEATH) {
+    // The scans died with the Offload HAL. OffloadScanManager restores them
+    // once the HAL restarts, see OnOffloadScanRestored().
+    pno_scan_running_over_offload_ = false;
+    pno_scan_awaiting_offload_ = true;
+  } else {
+    // Stop scans over Offload HAL and request them over netlink
+    stopPnoScan(&success);
+    if (success) {
+      LOG(INFO) << "Pno scans stopped";
+    }
   }
+  if (pno_scan_split_) {
+    // Netlink takes all networks over, not only those the Offload HAL could
+    // not hold.
+    StopPnoScanDefault();
+    pno_scan_split_ = false;
+  }
+  pno_offload_stats_.num_fallbacks++;
   // Restart PNO scans over netlink interface
   success = StartPnoScanDefault(pno_settings_);
   if (success) {
     LOG(INFO) << "Pno scans restarted";
   } else {
     LOG(ERROR) << "Unable to fall back to netlink pno scan";
+    if (pno_scan_awaiting_offload_) {
+      // PNO is reported as failed, so it must not come back by itself.
+      OffloadScanManager::ReasonCode reason_code;
+      offload_scan_manager_->stopScan(&reason_code);
+      pno_scan_awaiting_offload_ = false;
+    }
     pno_scan_event_handler_->OnPnoScanFailed();
   }
 }
 
+map<vector<uint8_t>, HiddenNetworkCoverage>
+ScannerImpl::GetHiddenNetworkCoverageStats() const {
+  return hidden_network_scheduler_.GetCoverageStats();
+}
+
+void ScannerImpl::OnOffloadScanRestored() {
+  if (!pno_scan_awaiting_offload_) {
+    LOG(WARNING) << "Offload HAL restored scans which are no longer requested";
+    return;
+  }
+  pno_scan_awaiting_offload_ = false;
+  StopPnoScanDefault();
+  pno_scan_running_over_offload_ = true;
+  if (!pno_netlink_settings_.pno_networks_.empty()) {
+    pno_scan_split_ = StartPnoScanDefault(pno_netlink_settings_);
+  }
+  pno_offload_stats_.num_restores++;
+  LOG(INFO) << "Pno scans moved back to Offload HAL";
+  if (pno_scan_event_handler_ != nullptr) {
+    pno_scan_event_handler_->OnPnoScanOverOffloadStarted();
+  }
+}
+
+const PnoOffloadStats& ScannerImpl::GetPnoOffloadStats() const {
+  return pno_offload_stats_;
+}
+
+const PnoUpdateStats& ScannerImpl::GetPnoUpdateStats() const {
+  return pno_update_stats_;
+}
+
+OffloadReconnectStats ScannerImpl::GetOffloadReconnectStats() const {
+  return offload_scan_manager_->getReconnectStats();
+}
+
+const HidlCallStats& ScannerImpl::GetOffloadHidlCallStats() const {
+  return offload_scan_manager_->getHidlCallStats();
+}
+
+OffloadSubscriptionStats ScannerImpl::GetOffloadSubscriptionStats() const {
+  return offload_scan_manager_->getSubscriptionStats();
+}
+
+const map<int, ScanArbitrationStats>& ScannerImpl::GetScanArbitrationStats()
+    const {
+  return scan_arbitration_stats_;
+}
+
 void ScannerImpl::LogSsidList(vector<vector<uint8_t>>& ssid_list,
                               string prefix) {
   if (ssid_list.empty()) {
@@ -17,14 +17,23 @@
 #ifndef WIFICOND_SCANNER_IMPL_H_
 #define WIFICOND_SCANNER_IMPL_H_
 
+#include <deque>
+#include <map>
+#include <memory>
 #include <vector>
 
 #include <android-base/macros.h>
 #include <binder/Status.h>
 
 #include "android/net/wifi/BnWifiScannerImpl.h"
+#include "wificond/event_loop.h"
 #include "wificond/net/netlink_utils.h"
+#include "wificond/scanning/channel_planner.h"
+#include "wificond/scanning/hidden_network_scheduler.h"
 #include "wificond/scanning/offload_scan_callback_interface.h"
+#include "wificond/scanning/pno_network_ranker.h"
+#include "wificond/scanning/scan_result_delta_tracker.h"
+#include "wificond/scanning/scan_result_shared_memory.h"
 #include "wificond/scanning/scan_utils.h"
 
 namespace android {
@@ -35,6 +44,50 @@ class OffloadServiceUtils;
 class ScanUtils;
 class OffloadScanCallbackInterfaceImpl;
 class OffloadScanManager;
+struct OffloadReconnectStats;
+struct OffloadSubscriptionStats;
+class HidlCallStats;
+
+// Queueing statistics of the single scan requests of one priority.
+struct ScanArbitrationStats {
+  // Requests whose scan started.
+  uint32_t num_started{0};
+  // Requests failed because their scan could not start before the deadline.
+  uint32_t num_expired{0};
+  // Scans pre-empted by a request of higher priority.
+  uint32_t num_preempted{0};
+  // Time from request to the start of its scan, summed over |num_started|.
+  int64_t total_queueing_ms{0};
+  int64_t max_queueing_ms{0};
+};
+
+// Moves of PNO scans between the Offload HAL and netlink.
+struct PnoOffloadStats {
+  // PNO scans moved to netlink because the Offload HAL failed.
+  uint32_t num_fallbacks{0};
+  // PNO scans moved back to the Offload HAL after it restarted.
+  uint32_t num_restores{0};
+  // PNO scans split between the Offload HAL and a scheduled scan because
+  // the Offload HAL could not hold all networks.
+  uint32_t num_hybrid_starts{0};
+  // Network found events not raised because the other half of a split PNO
+  // scan already raised one in the same match window.
+  uint32_t num_merged_matches{0};
+};
+
+// Updates of running PNO scans by startPnoScan().
+struct PnoUpdateStats {
+  // startPnoScan() calls while PNO scans were running.
+  uint32_t num_updates{0};
+  // Updates which kept the running scans, because the settings did not
+  // change.
+  uint32_t num_unchanged_updates{0};
+  // Updates of a split PNO scan which kept its scheduled scan, because only
+  // the networks over the Offload HAL changed.
+  uint32_t num_sched_scans_kept{0};
+  // Restarts of the scheduled scan to rotate in the networks left out of it.
+  uint32_t num_rotations{0};
+};
 
 class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
  public:
@@ -43,7 +96,8 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
               const WiphyFeatures& wiphy_features,
               ClientInterfaceImpl* client_interface,
               NetlinkUtils* netlink_utils, ScanUtils* scan_utils,
-              std::weak_ptr<OffloadServiceUtils> offload_service_utils);
+              std::weak_ptr<OffloadServiceUtils> offload_service_utils,
+              EventLoop* event_loop);
   ~ScannerImpl();
   // Returns a vector of available frequencies for 2.4GHz channels.
   ::android::binder::Status getAvailable2gChannels(
@@ -63,6 +117,23 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
   ::android::binder::Status getPnoScanResults(
       std::vector<com::android::server::wifi::wificond::NativeScanResult>*
           out_scan_results) override;
+  // Get the latest single scan results accepted by |filter|, trimmed
+  // according to |projection|.
+  ::android::binder::Status getFilteredScanResults(
+      const ::com::android::server::wifi::wificond::ScanResultFilter& filter,
+      const ::com::android::server::wifi::wificond::ScanResultProjection&
+          projection,
+      std::vector<com::android::server::wifi::wificond::NativeScanResult>*
+          out_scan_results) override;
+  // Get the latest single scan results as a sealed shared memory region.
+  // See ScanResultSharedMemory for the layout of the region.
+  // The kernel is only queried again once it reported new scan results.
+  ::android::binder::Status getScanResultsSharedMemory(
+      ::android::base::unique_fd* out_fd) override;
+  // Get the scan statistics sampled from the Offload HAL, oldest first.
+  ::android::binder::Status getOffloadScanStatsHistory(
+      std::vector<com::android::server::wifi::wificond::NativeScanStats>*
+          out_scan_stats) override;
   ::android::binder::Status getWifiGbkHistory(
       const std::vector<uint8_t>& ssid,
       std::unique_ptr<::std::vector<uint8_t>>* out_ssid) override;
@@ -70,6 +141,12 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
       const ::com::android::server::wifi::wificond::SingleScanSettings&
           scan_settings,
       bool* out_success) override;
+  ::android::binder::Status scanAsync(
+      const ::com::android::server::wifi::wificond::SingleScanSettings&
+          scan_settings,
+      const ::android::sp<::android::net::wifi::IScanRequestCallback>&
+          callback,
+      int32_t* out_request_id) override;
   ::android::binder::Status startPnoScan(
       const ::com::android::server::wifi::wificond::PnoSettings& pno_settings,
       bool* out_success) override;
@@ -79,6 +156,10 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
   ::android::binder::Status subscribeScanEvents(
       const ::android::sp<::android::net::wifi::IScanEvent>& handler) override;
   ::android::binder::Status unsubscribeScanEvents() override;
+  ::android::binder::Status subscribeScanResultDeltas(
+      const ::android::sp<::android::net::wifi::IScanResultDeltaEvent>& handler)
+      override;
+  ::android::binder::Status unsubscribeScanResultDeltas() override;
   ::android::binder::Status subscribePnoScanEvents(
       const ::android::sp<::android::net::wifi::IPnoScanEvent>& handler)
       override;
@@ -86,7 +167,20 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
   void OnOffloadScanResult();
   void OnOffloadError(
       OffloadScanCallbackInterface::AsyncErrorReason error_code);
+  void OnOffloadScanRestored();
   void Invalidate();
+  // Returns how often single scans probed the hidden networks they were
+  // asked for, keyed by ssid.
+  std::map<std::vector<uint8_t>, HiddenNetworkCoverage>
+      GetHiddenNetworkCoverageStats() const;
+  // Returns the queueing statistics of single scan requests, keyed by
+  // IWifiScannerImpl::SCAN_PRIORITY_* constant.
+  const std::map<int, ScanArbitrationStats>& GetScanArbitrationStats() const;
+  const PnoOffloadStats& GetPnoOffloadStats() const;
+  const PnoUpdateStats& GetPnoUpdateStats() const;
+  OffloadReconnectStats GetOffloadReconnectStats() const;
+  const HidlCallStats& GetOffloadHidlCallStats() const;
+  OffloadSubscriptionStats GetOffloadSubscriptionStats() const;
 
  private:
   bool CheckIsValid();
@@ -94,6 +188,11 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
                           std::vector<std::vector<uint8_t>>& ssids,
                           std::vector<uint32_t>& frequencies);
   void OnSchedScanResultsReady(uint32_t interface_index, bool scan_stopped);
+  // Fails the scan whose trigger the kernel did not answer in time, since
+  // the answer was most likely lost.
+  void OnScanTriggerTimeout();
+  void OnScanTriggered(uint32_t interface_index, int error_code,
+                       uint64_t cookie);
   void LogSsidList(std::vector<std::vector<uint8_t>>& ssid_list,
                    std::string prefix);
   bool StartPnoScanDefault(
@@ -101,15 +200,131 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
   bool StartPnoScanOffload(
       const ::com::android::server::wifi::wificond::PnoSettings& pno_settings);
   bool StopPnoScanDefault();
+  // Restarts the scheduled scan with the next networks left out of it, once
+  // it has run for a rotation window.
+  void SchedulePnoRotation(int64_t interval_ms);
+  void RotatePnoNetworks();
   bool StopPnoScanOffload();
+  // Splits the networks of |pno_settings| into the ones the Offload HAL can
+  // hold, best first, and the remaining ones.
+  void SplitPnoSettings(
+      const ::com::android::server::wifi::wificond::PnoSettings& pno_settings,
+      ::com::android::server::wifi::wificond::PnoSettings* offload_settings,
+      ::com::android::server::wifi::wificond::PnoSettings* netlink_settings);
+  // Fetches the results of both halves of a split PNO scan, without
+  // duplicate BSSs.
+  bool GetSplitPnoScanResults(
+      std::vector<::com::android::server::wifi::wificond::NativeScanResult>*
+          out_scan_results);
+  // Raises OnPnoNetworkFound() on |pno_scan_event_handler_|, at most once
+  // per match window while PNO scans are split.
+  void NotifyPnoNetworkFound();
   void ParsePnoSettings(
       const ::com::android::server::wifi::wificond::PnoSettings& pno_settings,
+      uint32_t max_networks,
       std::vector<std::vector<uint8_t>>* scan_ssids,
       std::vector<std::vector<uint8_t>>* match_ssids,
       std::vector<uint32_t>* freqs, std::vector<uint8_t>* match_security);
   SchedScanIntervalSetting GenerateIntervalSetting(
     const ::com::android::server::wifi::wificond::PnoSettings& pno_settings) const;
 
+  // A scan() or scanAsync() call waiting for its scan.
+  struct ScanCaller {
+    // Only set for scanAsync() calls. scan() calls are answered by exactly
+    // one scan event each once the scan finishes.
+    int32_t request_id{
+        ::android::net::wifi::IWifiScannerImpl::SCAN_REQUEST_ID_INVALID};
+    ::android::sp<::android::net::wifi::IScanRequestCallback> callback;
+    int priority{::android::net::wifi::IWifiScannerImpl::SCAN_PRIORITY_NORMAL};
+    // Boot time of the call.
+    int64_t request_time_ms{0};
+    // Boot time by which the scan must have started, or 0 for no deadline.
+    int64_t deadline_ms{0};
+    // True once the scan serving this call started.
+    bool started{false};
+  };
+
+  // A scan sent, or to be sent, to the kernel, together with the calls it
+  // serves.
+  struct ScanRequest {
+    // Always starts with an empty ssid for a wild card scan.
+    std::vector<std::vector<uint8_t>> ssids{{}};
+    // Empty means all supported frequencies.
+    std::vector<uint32_t> freqs;
+    // One of the IWifiScannerImpl::SCAN_TYPE_* constants, restricted to the
+    // types supported by this wiphy.
+    int scan_type{::android::net::wifi::IWifiScannerImpl::SCAN_TYPE_DEFAULT};
+    // 0 leaves the dwell time to the driver.
+    uint32_t dwell_time_ms{0};
+    // Drop the BSSs cached by the kernel once this scan succeeds.
+    bool flush_cache{false};
+    // Highest priority of the calls served, including the ones served by
+    // the later scans of a split request.
+    int priority{::android::net::wifi::IWifiScannerImpl::SCAN_PRIORITY_NORMAL};
+    std::vector<ScanCaller> callers;
+    // Send the scan without waiting for the kernel to accept it. The answer
+    // comes through OnScanTriggered().
+    bool async_trigger{false};
+  };
+
+  // Translates |scan_settings| to the scans serving them. There is more than
+  // one scan when the hidden networks don't fit in one. Only the last scan
+  // has a caller, initialized from |scan_settings|.
+  std::vector<ScanRequest> CreateScanRequests(
+      const ::com::android::server::wifi::wificond::SingleScanSettings&
+          scan_settings);
+  // Starts |requests| one after another, once the scans already running or
+  // queued with the same or higher priority are done. Returns false if the
+  // first one can't be started.
+  bool SubmitScanRequests(std::vector<ScanRequest> requests);
+  // Returns true if |request| should abort the ongoing scan to run first.
+  bool CanPreemptOngoingScan(const ScanRequest& request) const;
+  // Inserts |request| into |queued_scans_| behind the scans of higher
+  // priority, and ahead of or behind the ones of equal priority.
+  void QueueScan(const ScanRequest& request, bool ahead_of_equal_priority);
+  // Fails the callers of |request| whose scan did not start in time.
+  // Returns true if |request| isn't needed any more.
+  bool DropExpiredCallers(ScanRequest* request);
+  // Schedules OnScanDeadline() for the earliest deadline of the callers
+  // still waiting in |queued_scans_| or |follow_up_scan_|, if any.
+  void ArmScanDeadlineTimer();
+  // Fails the waiting callers whose deadline passed, without waiting for
+  // their scan to come up.
+  void OnScanDeadline();
+  // Records the queueing latency of the callers of |request|, which just
+  // got a running scan.
+  void OnCallersStarted(ScanRequest* request);
+  // Sends |request| to the kernel and makes it the ongoing scan.
+  // Returns true on success. Otherwise |*error_code| is the errno the kernel
+  // rejected the scan with, or 0.
+  bool StartScan(const ScanRequest& request, int* error_code);
+  // Starts the first of |queued_scans_| and |follow_up_scan_| that can be
+  // started, failing the callers of the others on the way.
+  void StartNextScan();
+  // Returns |scan_type| if this wiphy supports it, or SCAN_TYPE_DEFAULT
+  // otherwise.
+  int GetSupportedScanType(int scan_type) const;
+  // Returns true if every ssid and frequency of |request| is scanned by
+  // |ongoing_scan|, and |ongoing_scan| is at least as accurate as |request|
+  // asks for.
+  bool IsCoveredBy(const ScanRequest& request,
+                   const ScanRequest& ongoing_scan) const;
+  // Adds the ssids and frequencies of |request| to |follow_up_scan|.
+  void MergeInto(const ScanRequest& request, ScanRequest* follow_up_scan);
+  // Hands the callers of |from| over to |to|.
+  static void AddCallers(const ScanRequest& from, ScanRequest* to);
+  // Reports the outcome of a finished scan to each of its callers.
+  void NotifyScanCallers(const ScanRequest& request, bool aborted);
+  // Tells the scanAsync() callers of |request| that the kernel accepted it.
+  void NotifyScanAcked(const ScanRequest& request, uint64_t cookie);
+  // Tells the callers of |request| that it could not be started.
+  void NotifyScanFailed(const ScanRequest& request, int error_code);
+  // Sends the changes of the scan results to |scan_result_delta_handler_|.
+  void NotifyScanResultDelta();
+  // Drops |queued_scans_| and hands the callers they served over to
+  // |callers|.
+  void ClearQueuedScans(ScanRequest* callers);
+
   // Boolean variables describing current scanner status.
   bool valid_;
   bool scan_started_;
@@ -117,7 +332,50 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
   bool offload_scan_supported_;
   bool pno_scan_running_over_offload_;
   bool pno_scan_results_from_offload_;
+  // True while PNO scans run over netlink only because the Offload HAL died.
+  // They move back to the Offload HAL once it restores them.
+  bool pno_scan_awaiting_offload_;
+  // True while a scheduled scan covers the networks the Offload HAL could
+  // not hold, alongside PNO scans over the Offload HAL.
+  bool pno_scan_split_;
+  // True until the first network selection of a startPnoScan() call or of a
+  // rotation, which is the only one that advances the rotation of left out
+  // networks.
+  bool pno_rotation_pending_;
+  // Identifies the pending rotation of the scheduled scan. Bumped to cancel
+  // it.
+  uint32_t pno_rotation_generation_;
+  // Networks the Offload HAL could not hold. Empty if it holds them all.
+  ::com::android::server::wifi::wificond::PnoSettings pno_netlink_settings_;
+  // Boot time of the last OnPnoNetworkFound() raised, or -1 if none.
+  int64_t last_pno_network_found_ms_;
+  // Number of networks the Offload HAL can match against.
+  uint32_t offload_max_pno_networks_;
+  PnoOffloadStats pno_offload_stats_;
+  PnoUpdateStats pno_update_stats_;
   ::com::android::server::wifi::wificond::PnoSettings pno_settings_;
+  // Scan currently running in the kernel. Only valid if |scan_started_|.
+  ScanRequest ongoing_scan_;
+  // Requests received while |ongoing_scan_| runs, which it doesn't cover.
+  // They are coalesced into one scan issued once |ongoing_scan_| finishes.
+  ScanRequest follow_up_scan_;
+  // Remaining back-to-back scans of requests split for full hidden network
+  // coverage. They run before |follow_up_scan_|.
+  std::deque<ScanRequest> queued_scans_;
+  // True while the kernel has not answered the trigger of |ongoing_scan_|.
+  bool scan_trigger_pending_;
+  // Identifies the timeout of the pending trigger. Bumped for each trigger.
+  uint32_t scan_trigger_generation_;
+  // Identifies the latest deadline timer. Bumped each time one is armed.
+  uint32_t scan_deadline_generation_;
+  // True while |ongoing_scan_| is being aborted to make room for a scan of
+  // higher priority. It is restarted afterwards instead of failing.
+  bool preempting_scan_;
+  // NL80211_ATTR_COOKIE of |ongoing_scan_|, or 0 if the kernel gave none.
+  uint64_t ongoing_scan_cookie_;
+  // ID of the next scanAsync() call. Always positive.
+  int32_t next_scan_request_id_;
+  std::map<int, ScanArbitrationStats> scan_arbitration_stats_;
 
   const uint32_t wiphy_index_;
   const uint32_t interface_index_;
@@ -129,9 +387,34 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
   ClientInterfaceImpl* client_interface_;
   NetlinkUtils* const netlink_utils_;
   ScanUtils* const scan_utils_;
+  EventLoop* const event_loop_;
+  // Delayed tasks on |event_loop_| only run while this is alive.
+  const std::shared_ptr<bool> lifetime_token_;
   ::android::sp<::android::net::wifi::IPnoScanEvent> pno_scan_event_handler_;
   ::android::sp<::android::net::wifi::IScanEvent> scan_event_handler_;
+  ::android::sp<::android::net::wifi::IScanResultDeltaEvent>
+      scan_result_delta_handler_;
+  ScanResultDeltaTracker scan_result_delta_tracker_;
   std::shared_ptr<OffloadScanManager> offload_scan_manager_;
+  ScanResultSharedMemory scan_result_shared_memory_;
+  // True if the kernel reported new scan results since
+  // |scan_result_shared_memory_| was last updated.
+  bool scan_result_region_outdated_;
+  // Plans wild card scans and pno scans over netlink over the most productive
+  // channels, learning from the results of both and of the Offload HAL.
+  // nullptr unless adaptive channel planning is enabled.
+  std::unique_ptr<ChannelPlanner> channel_planner_;
+  // Frequencies of the last completed scan, which |channel_planner_| learns
+  // from the next time scan results are fetched.
+  std::vector<uint32_t> planner_scanned_freqs_;
+  bool planner_update_pending_;
+  // Same as above for the last pno scan over netlink.
+  std::vector<uint32_t> pno_planner_scanned_freqs_;
+  bool pno_planner_update_pending_;
+  // Decides which hidden networks each single scan probes for.
+  HiddenNetworkScheduler hidden_network_scheduler_;
+  // Decides which saved networks fit in the firmware PNO limits.
+  PnoNetworkRanker pno_network_ranker_;
 
   DISALLOW_COPY_AND_ASSIGN(ScannerImpl);
 };
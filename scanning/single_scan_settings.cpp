@@ -18,8 +18,10 @@
 
 #include <android-base/logging.h>
 
+#include "android/net/wifi/IWifiScannerImpl.h"
 #include "wificond/parcelable_utils.h"
 
+using android::net::wifi::IWifiScannerImpl;
 using android::status_t;
 
 namespace com {
@@ -28,7 +30,42 @@ namespace server {
 namespace wifi {
 namespace wificond {
 
+SingleScanSettings::SingleScanSettings()
+    : scan_type_(IWifiScannerImpl::SCAN_TYPE_DEFAULT),
+      dwell_time_ms_(0),
+      flush_cache_(false),
+      full_hidden_network_coverage_(false),
+      priority_(IWifiScannerImpl::SCAN_PRIORITY_NORMAL),
+      deadline_ms_(0) {}
+
+bool SingleScanSettings::isValidScanType(int32_t scan_type) {
+  return (scan_type == IWifiScannerImpl::SCAN_TYPE_LOW_SPAN ||
+          scan_type == IWifiScannerImpl::SCAN_TYPE_LOW_POWER ||
+          scan_type == IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY ||
+          scan_type == IWifiScannerImpl::SCAN_TYPE_DEFAULT);
+}
+
+bool SingleScanSettings::isValidPriority(int32_t priority) {
+  return (priority == IWifiScannerImpl::SCAN_PRIORITY_LOW ||
+          priority == IWifiScannerImpl::SCAN_PRIORITY_NORMAL ||
+          priority == IWifiScannerImpl::SCAN_PRIORITY_HIGH);
+}
+
 status_t SingleScanSettings::writeToParcel(::android::Parcel* parcel) const {
+  if (!isValidScanType(scan_type_)) {
+    LOG(ERROR) << "Unexpected scan type: " << scan_type_;
+    return ::android::BAD_VALUE;
+  }
+  if (!isValidPriority(priority_)) {
+    LOG(ERROR) << "Unexpected scan priority: " << priority_;
+    return ::android::BAD_VALUE;
+  }
+  RETURN_IF_FAILED(parcel->writeInt32(scan_type_));
+  RETURN_IF_FAILED(parcel->writeInt32(dwell_time_ms_));
+  RETURN_IF_FAILED(parcel->writeInt32(flush_cache_ ? 1 : 0));
+  RETURN_IF_FAILED(parcel->writeInt32(full_hidden_network_coverage_ ? 1 : 0));
+  RETURN_IF_FAILED(parcel->writeInt32(priority_));
+  RETURN_IF_FAILED(parcel->writeInt32(deadline_ms_));
   RETURN_IF_FAILED(parcel->writeInt32(channel_settings_.size()));
   for (const auto& channel : channel_settings_) {
     // For Java readTypedList():
@@ -47,6 +84,32 @@ status_t SingleScanSettings::writeToParcel(::android::Parcel* parcel) const {
 }
 
 status_t SingleScanSettings::readFromParcel(const ::android::Parcel* parcel) {
+  RETURN_IF_FAILED(parcel->readInt32(&scan_type_));
+  if (!isValidScanType(scan_type_)) {
+    LOG(ERROR) << "Unexpected scan type: " << scan_type_;
+    return ::android::BAD_VALUE;
+  }
+  RETURN_IF_FAILED(parcel->readInt32(&dwell_time_ms_));
+  if (dwell_time_ms_ < 0) {
+    LOG(ERROR) << "Unexpected dwell time: " << dwell_time_ms_;
+    return ::android::BAD_VALUE;
+  }
+  int32_t flush_cache = 0;
+  RETURN_IF_FAILED(parcel->readInt32(&flush_cache));
+  flush_cache_ = (flush_cache != 0);
+  int32_t full_hidden_network_coverage = 0;
+  RETURN_IF_FAILED(parcel->readInt32(&full_hidden_network_coverage));
+  full_hidden_network_coverage_ = (full_hidden_network_coverage != 0);
+  RETURN_IF_FAILED(parcel->readInt32(&priority_));
+  if (!isValidPriority(priority_)) {
+    LOG(ERROR) << "Unexpected scan priority: " << priority_;
+    return ::android::BAD_VALUE;
+  }
+  RETURN_IF_FAILED(parcel->readInt32(&deadline_ms_));
+  if (deadline_ms_ < 0) {
+    LOG(ERROR) << "Unexpected scan deadline: " << deadline_ms_;
+    return ::android::BAD_VALUE;
+  }
   int32_t num_channels = 0;
   RETURN_IF_FAILED(parcel->readInt32(&num_channels));
   // Convention used by Java side writeTypedList():
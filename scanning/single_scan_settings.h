@@ -33,14 +33,42 @@ namespace wificond {
 
 class SingleScanSettings : public ::android::Parcelable {
  public:
-  SingleScanSettings() = default;
+  SingleScanSettings();
   bool operator==(const SingleScanSettings& rhs) const {
-    return (channel_settings_ == rhs.channel_settings_ &&
+    return (scan_type_ == rhs.scan_type_ &&
+            dwell_time_ms_ == rhs.dwell_time_ms_ &&
+            flush_cache_ == rhs.flush_cache_ &&
+            full_hidden_network_coverage_ ==
+                rhs.full_hidden_network_coverage_ &&
+            priority_ == rhs.priority_ &&
+            deadline_ms_ == rhs.deadline_ms_ &&
+            channel_settings_ == rhs.channel_settings_ &&
             hidden_networks_ == rhs.hidden_networks_);
   }
   ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
   ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
+  static bool isValidScanType(int32_t scan_type);
+  static bool isValidPriority(int32_t priority);
 
+  // One of the IWifiScannerImpl::SCAN_TYPE_* constants.
+  int32_t scan_type_;
+  // Time to dwell on each channel, in milliseconds.
+  // 0 leaves the dwell time to the driver.
+  int32_t dwell_time_ms_;
+  // Drop BSSs cached by the kernel before this scan once it succeeds, so
+  // that the following scan results only contain BSSs found by this scan.
+  bool flush_cache_;
+  // Probe for every network of |hidden_networks_|, splitting the request into
+  // several back-to-back scans if the driver can't take them all at once.
+  // Otherwise the networks that don't fit are rotated in by later requests.
+  bool full_hidden_network_coverage_;
+  // One of the IWifiScannerImpl::SCAN_PRIORITY_* constants.
+  int32_t priority_;
+  // Longest time this request may wait for a scan to start, in milliseconds.
+  // The request fails with ETIMEDOUT as soon as it is exceeded, even while
+  // another scan is still running.
+  // 0 means no deadline.
+  int32_t deadline_ms_;
   std::vector<ChannelSettings> channel_settings_;
   std::vector<HiddenNetwork> hidden_networks_;
 };
@@ -64,13 +64,15 @@ Server::Server(unique_ptr<InterfaceTool> if_tool,
                unique_ptr<SupplicantManager> supplicant_manager,
                unique_ptr<HostapdManager> hostapd_manager,
                NetlinkUtils* netlink_utils,
-               ScanUtils* scan_utils)
+               ScanUtils* scan_utils,
+               EventLoop* event_loop)
     : base_ifname_(kBaseIfName),
       if_tool_(std::move(if_tool)),
       supplicant_manager_(std::move(supplicant_manager)),
       hostapd_manager_(std::move(hostapd_manager)),
       netlink_utils_(netlink_utils),
-      scan_utils_(scan_utils) {
+      scan_utils_(scan_utils),
+      event_loop_(event_loop) {
 }
 
 Status Server::RegisterCallback(const sp<IInterfaceEventCallback>& callback) {
@@ -134,7 +136,8 @@ Status Server::createClientInterface(sp<IClientInterface>* created_interface) {
       if_tool_.get(),
       supplicant_manager_.get(),
       netlink_utils_,
-      scan_utils_));
+      scan_utils_,
+      event_loop_));
   *created_interface = client_interface->GetBinder();
   client_interfaces_.push_back(std::move(client_interface));
   BroadcastClientInterfaceReady(client_interfaces_.back()->GetBinder());
@@ -35,6 +35,7 @@
 namespace android {
 namespace wificond {
 
+class EventLoop;
 class NL80211Packet;
 class NetlinkUtils;
 class ScanUtils;
@@ -47,7 +48,8 @@ class Server : public android::net::wifi::BnWificond {
          std::unique_ptr<wifi_system::SupplicantManager> supplicant_man,
          std::unique_ptr<wifi_system::HostapdManager> hostapd_man,
          NetlinkUtils* netlink_utils,
-         ScanUtils* scan_utils);
+         ScanUtils* scan_utils,
+         EventLoop* event_loop);
   ~Server() override = default;
 
   android::binder::Status RegisterCallback(
@@ -117,6 +119,7 @@ class Server : public android::net::wifi::BnWificond {
   const std::unique_ptr<wifi_system::HostapdManager> hostapd_manager_;
   NetlinkUtils* const netlink_utils_;
   ScanUtils* const scan_utils_;
+  EventLoop* const event_loop_;
 
   uint32_t wiphy_index_;
   std::vector<std::unique_ptr<ApInterfaceImpl>> ap_interfaces_;
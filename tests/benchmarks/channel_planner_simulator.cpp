@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Replays a recorded scan history against ChannelPlanner and compares the
+// time it takes to find a saved network with the time a full sweep takes.
+//
+// Usage: wificond_channel_planner_simulator <history file>
+//
+// The history file is a text file with one directive per line:
+//   saved <ssid>           Declares a saved network.
+//   scan                   Starts a new epoch of the recording.
+//   bss <frequency> <ssid> A BSS that was visible during the current epoch.
+// Lines starting with '#' are ignored.
+//
+// For every epoch, the planner keeps scanning the channels it plans until a
+// saved network is found or a full sweep has been done. Scan time is
+// estimated from per channel dwell times.
+
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "wificond/scanning/channel_planner.h"
+#include "wificond/scanning/scan_result.h"
+
+using ::com::android::server::wifi::wificond::NativeScanResult;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace android {
+namespace wificond {
+namespace {
+
+// Typical dwell time of an active scan on a non-DFS channel.
+constexpr uint32_t kActiveDwellMs = 40;
+// DFS channels are scanned passively and need to wait for a beacon.
+constexpr uint32_t kPassiveDwellMs = 110;
+
+struct Epoch {
+  vector<NativeScanResult> visible_bsss;
+};
+
+bool IsDfsFrequency(uint32_t freq) {
+  return (freq >= 5260 && freq <= 5320) || (freq >= 5500 && freq <= 5720);
+}
+
+uint32_t GetScanDurationMs(const set<uint32_t>& freqs) {
+  uint32_t duration_ms = 0;
+  for (uint32_t freq : freqs) {
+    duration_ms += IsDfsFrequency(freq) ? kPassiveDwellMs : kActiveDwellMs;
+  }
+  return duration_ms;
+}
+
+bool LoadHistory(const string& path,
+                 vector<vector<uint8_t>>* saved_ssids,
+                 vector<Epoch>* epochs,
+                 set<uint32_t>* all_freqs) {
+  std::ifstream input(path);
+  if (!input) {
+    std::cerr << "Failed to open " << path << std::endl;
+    return false;
+  }
+  string line;
+  while (std::getline(input, line)) {
+    std::istringstream tokens(line);
+    string directive;
+    if (!(tokens >> directive) || directive[0] == '#') {
+      continue;
+    }
+    if (directive == "saved") {
+      string ssid;
+      tokens >> ssid;
+      saved_ssids->emplace_back(ssid.begin(), ssid.end());
+    } else if (directive == "scan") {
+      epochs->emplace_back();
+    } else if (directive == "bss") {
+      uint32_t freq;
+      string ssid;
+      if (epochs->empty() || !(tokens >> freq >> ssid)) {
+        std::cerr << "Malformed line: " << line << std::endl;
+        return false;
+      }
+      NativeScanResult result;
+      result.frequency = freq;
+      result.ssid.assign(ssid.begin(), ssid.end());
+      epochs->back().visible_bsss.push_back(result);
+      all_freqs->insert(freq);
+    } else {
+      std::cerr << "Unknown directive: " << directive << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ContainsSavedNetwork(const vector<NativeScanResult>& results,
+                          const vector<vector<uint8_t>>& saved_ssids) {
+  for (const auto& result : results) {
+    for (const auto& ssid : saved_ssids) {
+      if (result.ssid == ssid) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+int Simulate(const string& path) {
+  vector<vector<uint8_t>> saved_ssids;
+  vector<Epoch> epochs;
+  set<uint32_t> all_freqs;
+  if (!LoadHistory(path, &saved_ssids, &epochs, &all_freqs)) {
+    return 1;
+  }
+  const uint32_t full_sweep_ms = GetScanDurationMs(all_freqs);
+
+  ChannelPlanner planner;
+  planner.SetSavedSsids(saved_ssids);
+  uint32_t epochs_with_saved_network = 0;
+  uint32_t planner_found = 0;
+  uint64_t planner_time_to_find_ms = 0;
+  uint64_t planner_total_scan_ms = 0;
+  uint32_t planner_scans = 0;
+  uint32_t planner_full_sweeps = 0;
+
+  for (const auto& epoch : epochs) {
+    bool reachable = ContainsSavedNetwork(epoch.visible_bsss, saved_ssids);
+    if (reachable) {
+      epochs_with_saved_network++;
+    }
+    uint32_t elapsed_ms = 0;
+    while (true) {
+      vector<uint32_t> planned_freqs = planner.PlanScan();
+      set<uint32_t> scanned_freqs(planned_freqs.begin(), planned_freqs.end());
+      if (planned_freqs.empty()) {
+        scanned_freqs = all_freqs;
+        planner_full_sweeps++;
+      }
+      vector<NativeScanResult> results;
+      for (const auto& bss : epoch.visible_bsss) {
+        if (scanned_freqs.count(bss.frequency)) {
+          results.push_back(bss);
+        }
+      }
+      elapsed_ms += GetScanDurationMs(scanned_freqs);
+      planner_scans++;
+      planner.OnScanResults(planned_freqs, results);
+      if (ContainsSavedNetwork(results, saved_ssids)) {
+        planner_found++;
+        planner_time_to_find_ms += elapsed_ms;
+        break;
+      }
+      if (planned_freqs.empty()) {
+        break;
+      }
+    }
+    planner_total_scan_ms += elapsed_ms;
+  }
+
+  std::cout << "Epochs: " << epochs.size()
+            << ", with a saved network in range: " << epochs_with_saved_network
+            << ", channels: " << all_freqs.size() << std::endl;
+  std::cout << "Full sweep: " << full_sweep_ms
+            << " ms per scan, time-to-find " << full_sweep_ms << " ms"
+            << std::endl;
+  std::cout << "Adaptive: " << planner_scans << " scans ("
+            << planner_full_sweeps << " full sweeps), found "
+            << planner_found << "/" << epochs_with_saved_network;
+  if (planner_found > 0) {
+    std::cout << ", mean time-to-find "
+              << planner_time_to_find_ms / planner_found << " ms";
+  }
+  if (!epochs.empty()) {
+    std::cout << ", mean scan time per epoch "
+              << planner_total_scan_ms / epochs.size() << " ms";
+  }
+  std::cout << std::endl;
+  return 0;
+}
+
+}  // namespace
+}  // namespace wificond
+}  // namespace android
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <history file>" << std::endl;
+    return 1;
+  }
+  return android::wificond::Simulate(argv[1]);
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Measures the conversions between the Offload HAL types and the wificond
+// types, for batches as large as the Offload HAL reports.
+
+#include <vector>
+
+#include <android/hardware/wifi/offload/1.0/IOffload.h>
+#include <benchmark/benchmark.h>
+
+#include "wificond/scanning/offload/offload_scan_utils.h"
+#include "wificond/scanning/scan_result.h"
+
+using ::com::android::server::wifi::wificond::NativeScanResult;
+using android::hardware::hidl_vec;
+using android::hardware::wifi::offload::V1_0::ScanFilter;
+using android::hardware::wifi::offload::V1_0::ScanResult;
+using std::vector;
+
+namespace android {
+namespace wificond {
+namespace {
+
+constexpr size_t kSsidSize = 12;
+
+hidl_vec<ScanResult> CreateOffloadScanResults(size_t num_results) {
+  vector<ScanResult> scan_results(num_results);
+  for (size_t i = 0; i < num_results; i++) {
+    ScanResult& result = scan_results[i];
+    result.tsf = 1000000 + i;
+    const uint8_t bssid[] = {0x02, 0x00, 0x00, 0x00,
+                             static_cast<uint8_t>(i >> 8),
+                             static_cast<uint8_t>(i)};
+    for (size_t j = 0; j < result.bssid.elementCount(); j++) {
+      result.bssid[j] = bssid[j];
+    }
+    result.capability = 0x0411;
+    result.rssi = -40 - static_cast<int8_t>(i % 50);
+    result.frequency = 2412 + (i % 13) * 5;
+    result.networkInfo.ssid =
+        vector<uint8_t>(kSsidSize, static_cast<uint8_t>('a' + i % 26));
+    result.networkInfo.flags = 0;
+  }
+  return hidl_vec<ScanResult>(std::move(scan_results));
+}
+
+void BM_ConvertToNativeScanResults(benchmark::State& state) {
+  const hidl_vec<ScanResult> scan_results =
+      CreateOffloadScanResults(state.range(0));
+  while (state.KeepRunning()) {
+    vector<NativeScanResult> native_scan_results;
+    OffloadScanUtils::convertToNativeScanResults(scan_results,
+                                                 &native_scan_results);
+    benchmark::DoNotOptimize(native_scan_results.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConvertToNativeScanResults)->Arg(50)->Arg(500);
+
+void BM_CreateScanFilter(benchmark::State& state) {
+  const vector<vector<uint8_t>> ssids(state.range(0),
+                                      vector<uint8_t>(kSsidSize, 'a'));
+  const vector<uint8_t> flags(state.range(0), 0);
+  while (state.KeepRunning()) {
+    ScanFilter scan_filter =
+        OffloadScanUtils::createScanFilter(ssids, flags, -80);
+    benchmark::DoNotOptimize(scan_filter.preferredNetworkInfoList.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CreateScanFilter)->Arg(50)->Arg(500);
+
+}  // namespace
+}  // namespace wificond
+}  // namespace android
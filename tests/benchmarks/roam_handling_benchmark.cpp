@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the cost of finding the association frequency when handling a
+// roam event: from the event itself, from a NL80211_CMD_GET_INTERFACE
+// request, or from a full NL80211_CMD_GET_SCAN dump as wpa_supplicant does.
+// The kernel is replaced by canned responses, so this only accounts for the
+// work done in wificond.
+
+#include <linux/nl80211.h>
+#include <unistd.h>
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "wificond/net/mlme_event.h"
+#include "wificond/net/netlink_manager.h"
+#include "wificond/net/netlink_utils.h"
+#include "wificond/net/nl80211_packet.h"
+#include "wificond/scanning/scan_result.h"
+#include "wificond/scanning/scan_utils.h"
+
+using ::com::android::server::wifi::wificond::NativeScanResult;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace wificond {
+namespace {
+
+constexpr uint16_t kFamilyId = 14;
+constexpr uint32_t kInterfaceIndex = 12;
+constexpr uint32_t kAssociatedFrequency = 5180;
+// Typical size of the information elements of a BSS in a GET_SCAN dump.
+constexpr size_t kInfoElementSize = 320;
+
+NL80211Packet CreateNewScanResultPacket(size_t index, bool associated) {
+  NL80211Packet packet(kFamilyId, NL80211_CMD_NEW_SCAN_RESULTS, 0, getpid());
+  packet.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_ATTR_IFINDEX, kInterfaceIndex));
+  vector<uint8_t> ie = {0, 8, 'n', 'e', 't', 'w', 'o', 'r', 'k',
+                        static_cast<uint8_t>('a' + index % 26)};
+  ie.resize(kInfoElementSize, static_cast<uint8_t>(index));
+  NL80211NestedAttr bss(NL80211_ATTR_BSS);
+  bss.AddAttribute(NL80211Attr<vector<uint8_t>>(
+      NL80211_BSS_BSSID,
+      {0x02, 0x00, 0x00, 0x00, static_cast<uint8_t>(index >> 8),
+       static_cast<uint8_t>(index)}));
+  bss.AddAttribute(NL80211Attr<uint32_t>(
+      NL80211_BSS_FREQUENCY,
+      associated ? kAssociatedFrequency : 2412 + (index % 13) * 5));
+  bss.AddAttribute(
+      NL80211Attr<vector<uint8_t>>(NL80211_BSS_INFORMATION_ELEMENTS, ie));
+  bss.AddAttribute(NL80211Attr<uint64_t>(NL80211_BSS_LAST_SEEN_BOOTTIME,
+                                         1000000000ull + index));
+  bss.AddAttribute(NL80211Attr<uint32_t>(NL80211_BSS_SIGNAL_MBM, -5000));
+  bss.AddAttribute(NL80211Attr<uint16_t>(NL80211_BSS_CAPABILITY, 0x0411));
+  if (associated) {
+    bss.AddAttribute(NL80211Attr<uint32_t>(NL80211_BSS_STATUS,
+                                           NL80211_BSS_STATUS_ASSOCIATED));
+  }
+  packet.AddAttribute(bss);
+  return packet;
+}
+
+NL80211Packet CreateRoamPacket(bool with_frequency) {
+  NL80211Packet packet(kFamilyId, NL80211_CMD_ROAM, 0, 0);
+  packet.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_ATTR_IFINDEX, kInterfaceIndex));
+  packet.AddAttribute(NL80211Attr<vector<uint8_t>>(
+      NL80211_ATTR_MAC, {0x02, 0x00, 0x00, 0x00, 0x00, 0x00}));
+  packet.AddAttribute(NL80211Attr<uint16_t>(NL80211_ATTR_STATUS_CODE, 0));
+  if (with_frequency) {
+    packet.AddAttribute(NL80211Attr<uint32_t>(NL80211_ATTR_WIPHY_FREQ,
+                                              kAssociatedFrequency));
+  }
+  return packet;
+}
+
+// Answers GET_SCAN with a dump of |num_bss| BSSs and GET_INTERFACE with the
+// channel of the association.
+class FakeNetlinkManager : public NetlinkManager {
+ public:
+  explicit FakeNetlinkManager(size_t num_bss) : NetlinkManager(nullptr) {
+    for (size_t i = 0; i < num_bss; i++) {
+      scan_dump_.push_back(CreateNewScanResultPacket(i, i == num_bss / 2));
+    }
+    NL80211Packet new_interface(kFamilyId, NL80211_CMD_NEW_INTERFACE, 0,
+                                getpid());
+    new_interface.AddAttribute(
+        NL80211Attr<uint32_t>(NL80211_ATTR_IFINDEX, kInterfaceIndex));
+    new_interface.AddAttribute(NL80211Attr<uint32_t>(NL80211_ATTR_WIPHY_FREQ,
+                                                     kAssociatedFrequency));
+    interface_.push_back(new_interface);
+  }
+
+  uint32_t GetSequenceNumber() override { return 0; }
+  uint16_t GetFamilyId() override { return kFamilyId; }
+  bool SendMessageAndGetResponses(
+      const NL80211Packet& packet,
+      vector<unique_ptr<const NL80211Packet>>* response) override {
+    const vector<NL80211Packet>& canned =
+        packet.GetCommand() == NL80211_CMD_GET_SCAN ? scan_dump_ : interface_;
+    for (const auto& canned_packet : canned) {
+      response->emplace_back(new NL80211Packet(canned_packet));
+    }
+    return true;
+  }
+
+ private:
+  vector<NL80211Packet> scan_dump_;
+  vector<NL80211Packet> interface_;
+};
+
+void BM_RoamFrequencyFromScanDump(benchmark::State& state) {
+  FakeNetlinkManager netlink_manager(state.range(0));
+  ScanUtils scan_utils(&netlink_manager);
+  const NL80211Packet roam_packet = CreateRoamPacket(false);
+  while (state.KeepRunning()) {
+    unique_ptr<MlmeRoamEvent> event =
+        MlmeRoamEvent::InitFromPacket(&roam_packet);
+    vector<NativeScanResult> scan_results;
+    scan_utils.GetScanResult(kInterfaceIndex, &scan_results);
+    uint32_t frequency = 0;
+    for (const auto& scan_result : scan_results) {
+      if (scan_result.associated) {
+        frequency = scan_result.frequency;
+      }
+    }
+    benchmark::DoNotOptimize(frequency);
+  }
+}
+BENCHMARK(BM_RoamFrequencyFromScanDump)->Arg(20)->Arg(100)->Arg(500);
+
+void BM_RoamFrequencyFromInterface(benchmark::State& state) {
+  FakeNetlinkManager netlink_manager(0);
+  NetlinkUtils netlink_utils(&netlink_manager);
+  const NL80211Packet roam_packet = CreateRoamPacket(false);
+  while (state.KeepRunning()) {
+    unique_ptr<MlmeRoamEvent> event =
+        MlmeRoamEvent::InitFromPacket(&roam_packet);
+    uint32_t frequency = 0;
+    netlink_utils.GetInterfaceFrequency(kInterfaceIndex, &frequency);
+    benchmark::DoNotOptimize(frequency);
+  }
+}
+BENCHMARK(BM_RoamFrequencyFromInterface);
+
+void BM_RoamFrequencyFromEvent(benchmark::State& state) {
+  const NL80211Packet roam_packet = CreateRoamPacket(true);
+  while (state.KeepRunning()) {
+    unique_ptr<MlmeRoamEvent> event =
+        MlmeRoamEvent::InitFromPacket(&roam_packet);
+    uint32_t frequency = event->GetFrequency();
+    benchmark::DoNotOptimize(frequency);
+  }
+}
+BENCHMARK(BM_RoamFrequencyFromEvent);
+
+}  // namespace
+}  // namespace wificond
+}  // namespace android
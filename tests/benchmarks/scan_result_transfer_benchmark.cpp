@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Compares the cost of handing scan results to a client through Parcel
+// marshalling against the flat shared memory layout of
+// ScanResultSharedMemory.
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <binder/Parcel.h>
+
+#include "wificond/scanning/scan_result.h"
+#include "wificond/scanning/scan_result_shared_memory.h"
+
+using ::com::android::server::wifi::wificond::NativeScanResult;
+using std::vector;
+
+namespace android {
+namespace wificond {
+namespace {
+
+// Typical sizes observed for a BSS in a GET_SCAN dump.
+constexpr size_t kSsidSize = 12;
+constexpr size_t kInfoElementSize = 320;
+
+vector<NativeScanResult> CreateScanResults(size_t num_results, uint8_t seed) {
+  vector<NativeScanResult> scan_results;
+  for (size_t i = 0; i < num_results; i++) {
+    vector<uint8_t> ssid(kSsidSize, 'a' + (i % 26));
+    vector<uint8_t> bssid = {0x02, 0x00, seed, 0x00,
+                             static_cast<uint8_t>(i >> 8),
+                             static_cast<uint8_t>(i)};
+    vector<uint8_t> ie(kInfoElementSize, static_cast<uint8_t>(i + seed));
+    scan_results.emplace_back(ssid, bssid, ie, 2412 + (i % 13) * 5,
+                              -4000 - static_cast<int32_t>(i % 50) * 100,
+                              1000000 + i, 0x0411, false);
+  }
+  return scan_results;
+}
+
+// Mirrors what the AIDL generated code does for a NativeScanResult[] reply:
+// marshal every element and unmarshal it again on the client side.
+void BM_ParcelTransfer(benchmark::State& state) {
+  const vector<NativeScanResult> scan_results =
+      CreateScanResults(state.range(0), 0);
+  while (state.KeepRunning()) {
+    Parcel parcel;
+    parcel.writeInt32(scan_results.size());
+    for (const auto& result : scan_results) {
+      parcel.writeInt32(1);
+      result.writeToParcel(&parcel);
+    }
+    parcel.setDataPosition(0);
+    vector<NativeScanResult> received(parcel.readInt32());
+    for (auto& result : received) {
+      parcel.readInt32();
+      result.readFromParcel(&parcel);
+    }
+    benchmark::DoNotOptimize(received.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParcelTransfer)->Arg(100)->Arg(500)->Arg(2000);
+
+// Publishes a new region every iteration and reads it back through a
+// read-only mapping, as a client would.
+void BM_SharedMemoryTransfer(benchmark::State& state) {
+  const vector<NativeScanResult> scan_results[] = {
+      CreateScanResults(state.range(0), 0),
+      CreateScanResults(state.range(0), 1)};
+  ScanResultSharedMemory shared_memory;
+  size_t iteration = 0;
+  while (state.KeepRunning()) {
+    int fd;
+    if (!shared_memory.Update(scan_results[iteration++ % 2], &fd)) {
+      state.SkipWithError("Failed to publish scan results");
+      break;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    void* region = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    vector<NativeScanResult> received;
+    ScanResultSharedMemory::Deserialize(
+        static_cast<const uint8_t*>(region), size, &received);
+    munmap(region, size);
+    benchmark::DoNotOptimize(received.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SharedMemoryTransfer)->Arg(100)->Arg(500)->Arg(2000);
+
+// Repeated reads of unchanged scan results reuse the existing region.
+void BM_SharedMemoryTransferUnchanged(benchmark::State& state) {
+  const vector<NativeScanResult> scan_results =
+      CreateScanResults(state.range(0), 0);
+  ScanResultSharedMemory shared_memory;
+  while (state.KeepRunning()) {
+    int fd;
+    if (!shared_memory.Update(scan_results, &fd)) {
+      state.SkipWithError("Failed to publish scan results");
+      break;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    void* region = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    vector<NativeScanResult> received;
+    ScanResultSharedMemory::Deserialize(
+        static_cast<const uint8_t*>(region), size, &received);
+    munmap(region, size);
+    benchmark::DoNotOptimize(received.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SharedMemoryTransferUnchanged)->Arg(100)->Arg(500)->Arg(2000);
+
+}  // namespace
+}  // namespace wificond
+}  // namespace android
+
+BENCHMARK_MAIN();
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/channel_planner.h"
+#include "wificond/scanning/scan_result.h"
+
+using ::com::android::server::wifi::wificond::NativeScanResult;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const vector<uint8_t> kSavedSsid = {'H', 'o', 'm', 'e'};
+const vector<uint8_t> kOtherSsid = {'C', 'a', 'f', 'e'};
+
+NativeScanResult CreateScanResult(uint32_t frequency,
+                                  const vector<uint8_t>& ssid) {
+  NativeScanResult result;
+  result.ssid = ssid;
+  result.frequency = frequency;
+  return result;
+}
+
+}  // namespace
+
+class ChannelPlannerTest : public ::testing::Test {
+ protected:
+  ChannelPlanner planner_;
+};
+
+TEST_F(ChannelPlannerTest, PlansFullSweepWithoutHistory) {
+  EXPECT_TRUE(planner_.PlanScan().empty());
+}
+
+TEST_F(ChannelPlannerTest, PlansPartialScanOverProductiveChannels) {
+  planner_.SetSavedSsids({kSavedSsid});
+  planner_.OnScanResults({}, {CreateScanResult(2412, kSavedSsid),
+                              CreateScanResult(2437, kOtherSsid),
+                              CreateScanResult(5180, kOtherSsid),
+                              CreateScanResult(5745, kOtherSsid)});
+  EXPECT_GT(planner_.GetChannelYield(2412), planner_.GetChannelYield(2437));
+
+  vector<uint32_t> freqs = planner_.PlanScan();
+  ASSERT_FALSE(freqs.empty());
+  EXPECT_EQ(2412u, freqs[0]);
+  EXPECT_LT(freqs.size(), 4u);
+}
+
+TEST_F(ChannelPlannerTest, PlansFullSweepAfterPartialScanMissed) {
+  planner_.SetSavedSsids({kSavedSsid});
+  planner_.OnScanResults({}, {CreateScanResult(2412, kSavedSsid)});
+  vector<uint32_t> freqs = planner_.PlanScan();
+  ASSERT_FALSE(freqs.empty());
+
+  // The saved network moved to a channel we did not scan.
+  planner_.OnScanResults(freqs, {CreateScanResult(5180, kSavedSsid)});
+  EXPECT_TRUE(planner_.PlanScan().empty());
+  // Stale cache entries from unscanned channels are not learned from.
+  EXPECT_EQ(0, planner_.GetChannelYield(5180));
+}
+
+TEST_F(ChannelPlannerTest, PlansPeriodicFullSweep) {
+  planner_.SetSavedSsids({kSavedSsid});
+  planner_.OnScanResults({}, {CreateScanResult(2412, kSavedSsid)});
+  for (uint32_t i = 0; i < ChannelPlanner::kPartialScansPerFullSweep; i++) {
+    vector<uint32_t> freqs = planner_.PlanScan();
+    ASSERT_FALSE(freqs.empty());
+    planner_.OnScanResults(freqs, {CreateScanResult(2412, kSavedSsid)});
+  }
+  EXPECT_TRUE(planner_.PlanScan().empty());
+  planner_.OnScanResults({}, {CreateScanResult(2412, kSavedSsid)});
+  EXPECT_FALSE(planner_.PlanScan().empty());
+}
+
+TEST_F(ChannelPlannerTest, LearnsFromOffloadScanResults) {
+  planner_.SetSavedSsids({kSavedSsid});
+  planner_.OnScanResults({}, {CreateScanResult(2412, kOtherSsid),
+                              CreateScanResult(2437, kOtherSsid)});
+  // The Offload HAL scanned channels 1 and 6 and found the saved network on
+  // channel 36 only.
+  vector<uint8_t> histogram_channels(37, 0);
+  histogram_channels[1] = 4;
+  histogram_channels[6] = 4;
+  histogram_channels[36] = 4;
+  planner_.OnOffloadScanResults(histogram_channels,
+                                {CreateScanResult(5180, kSavedSsid)});
+  EXPECT_GT(planner_.GetChannelYield(5180), 0);
+  EXPECT_LT(planner_.GetChannelYield(2412), 1);
+  EXPECT_LT(planner_.GetChannelYield(2437), 1);
+  EXPECT_EQ(5180u, planner_.PlanPnoScan()[0]);
+}
+
+TEST_F(ChannelPlannerTest, LearnsFromOffloadChannelsScannedSinceLastResults) {
+  planner_.SetSavedSsids({kSavedSsid});
+  vector<uint8_t> histogram_channels(37, 0);
+  histogram_channels[1] = 4;
+  histogram_channels[36] = 4;
+  planner_.OnOffloadScanResults(histogram_channels,
+                                {CreateScanResult(2412, kSavedSsid),
+                                 CreateScanResult(5180, kSavedSsid)});
+  double yield_2412 = planner_.GetChannelYield(2412);
+
+  // Only channel 36 was scanned for the next results, so the absence of
+  // the saved network on channel 1 says nothing.
+  histogram_channels[36] = 5;
+  planner_.OnOffloadScanResults(histogram_channels,
+                                {CreateScanResult(5180, kSavedSsid)});
+  EXPECT_EQ(yield_2412, planner_.GetChannelYield(2412));
+
+  // Channel 1 was scanned this time and had nothing.
+  histogram_channels[1] = 5;
+  planner_.OnOffloadScanResults(histogram_channels,
+                                {CreateScanResult(5180, kSavedSsid)});
+  EXPECT_LT(planner_.GetChannelYield(2412), yield_2412);
+}
+
+TEST_F(ChannelPlannerTest, PlansPeriodicFullSweepForPnoScans) {
+  EXPECT_TRUE(planner_.PlanPnoScan().empty());
+  planner_.SetSavedSsids({kSavedSsid});
+  planner_.OnPnoScanResults({}, {CreateScanResult(2412, kSavedSsid)});
+  for (uint32_t i = 0; i < ChannelPlanner::kPartialScansPerFullSweep; i++) {
+    EXPECT_FALSE(planner_.PlanPnoScan().empty());
+  }
+  EXPECT_TRUE(planner_.PlanPnoScan().empty());
+  EXPECT_FALSE(planner_.PlanPnoScan().empty());
+  // Pno scans do not delay the full sweeps of single scans.
+  EXPECT_FALSE(planner_.PlanScan().empty());
+}
+
+}  // namespace wificond
+}  // namespace android
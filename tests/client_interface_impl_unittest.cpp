@@ -24,6 +24,9 @@
 #include <wifi_system_test/mock_supplicant_manager.h>
 
 #include "wificond/client_interface_impl.h"
+#include "wificond/net/mlme_event.h"
+#include "wificond/net/nl80211_packet.h"
+#include "wificond/tests/mock_event_loop.h"
 #include "wificond/tests/mock_netlink_manager.h"
 #include "wificond/tests/mock_netlink_utils.h"
 #include "wificond/tests/mock_scan_utils.h"
@@ -33,8 +36,11 @@ using android::wifi_system::MockSupplicantManager;
 using android::wifi_system::SupplicantManager;
 using std::unique_ptr;
 using std::vector;
+using testing::DoAll;
 using testing::NiceMock;
 using testing::Return;
+using testing::SaveArg;
+using testing::SetArgPointee;
 using testing::_;
 
 namespace android {
@@ -44,13 +50,34 @@ namespace {
 const uint32_t kTestWiphyIndex = 2;
 const char kTestInterfaceName[] = "testwifi0";
 const uint32_t kTestInterfaceIndex = 42;
+const uint32_t kTestFrequency = 5180;
+const uint32_t kTestFrequency1 = 2437;
+const uint16_t kTestFamilyId = 14;
+const vector<uint8_t> kTestBssid = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};
+
+// Creates a successful NL80211_CMD_ROAM event, with NL80211_ATTR_WIPHY_FREQ
+// unless |frequency| is 0.
+unique_ptr<MlmeRoamEvent> CreateRoamEvent(uint32_t frequency) {
+  NL80211Packet packet(kTestFamilyId, NL80211_CMD_ROAM, 0, 0);
+  packet.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_ATTR_IFINDEX, kTestInterfaceIndex));
+  packet.AddAttribute(NL80211Attr<vector<uint8_t>>(NL80211_ATTR_MAC,
+                                                   kTestBssid));
+  packet.AddAttribute(NL80211Attr<uint16_t>(NL80211_ATTR_STATUS_CODE, 0));
+  if (frequency != 0) {
+    packet.AddAttribute(
+        NL80211Attr<uint32_t>(NL80211_ATTR_WIPHY_FREQ, frequency));
+  }
+  return MlmeRoamEvent::InitFromPacket(&packet);
+}
 
 class ClientInterfaceImplTest : public ::testing::Test {
  protected:
 
   void SetUp() override {
     EXPECT_CALL(*netlink_utils_,
-                SubscribeMlmeEvent(kTestInterfaceIndex, _));
+                SubscribeMlmeEvent(kTestInterfaceIndex, _))
+        .WillOnce(SaveArg<1>(&mlme_event_handler_));
     EXPECT_CALL(*netlink_utils_,
                 GetWiphyInfo(kTestWiphyIndex, _, _, _));
     client_interface_.reset(new ClientInterfaceImpl{
@@ -61,7 +88,8 @@ class ClientInterfaceImplTest : public ::testing::Test {
         if_tool_.get(),
         supplicant_manager_.get(),
         netlink_utils_.get(),
-        scan_utils_.get()});
+        scan_utils_.get(),
+        &event_loop_});
   }
 
   void TearDown() override {
@@ -81,7 +109,18 @@ class ClientInterfaceImplTest : public ::testing::Test {
       new NiceMock<MockNetlinkUtils>(netlink_manager_.get())};
   unique_ptr<NiceMock<MockScanUtils>> scan_utils_{
       new NiceMock<MockScanUtils>(netlink_manager_.get())};
+  NiceMock<MockEventLoop> event_loop_;
   unique_ptr<ClientInterfaceImpl> client_interface_;
+  MlmeEventHandler* mlme_event_handler_ = nullptr;
+
+  // Returns the association frequency reported by SignalPoll().
+  int32_t GetSignalPollFrequency() {
+    ON_CALL(*netlink_utils_, GetStationInfo(kTestInterfaceIndex, _, _))
+        .WillByDefault(Return(true));
+    vector<int32_t> signal_poll_results;
+    EXPECT_TRUE(client_interface_->SignalPoll(&signal_poll_results));
+    return signal_poll_results.empty() ? 0 : signal_poll_results.back();
+  }
 };  // class ClientInterfaceImplTest
 
 }  // namespace
@@ -110,5 +149,20 @@ TEST_F(ClientInterfaceImplTest, ShouldReportDisableSuccess) {
   EXPECT_TRUE(client_interface_->DisableSupplicant());
 }
 
+TEST_F(ClientInterfaceImplTest, TakesAssociateFrequencyFromMlmeEvent) {
+  EXPECT_CALL(*netlink_utils_, GetInterfaceFrequency(_, _)).Times(0);
+  EXPECT_CALL(*scan_utils_, GetScanResult(_, _)).Times(0);
+  mlme_event_handler_->OnRoam(CreateRoamEvent(kTestFrequency));
+  EXPECT_EQ(static_cast<int32_t>(kTestFrequency), GetSignalPollFrequency());
+}
+
+TEST_F(ClientInterfaceImplTest, QueriesInterfaceForAssociateFrequency) {
+  EXPECT_CALL(*netlink_utils_, GetInterfaceFrequency(kTestInterfaceIndex, _))
+      .WillOnce(DoAll(SetArgPointee<1>(kTestFrequency1), Return(true)));
+  EXPECT_CALL(*scan_utils_, GetScanResult(_, _)).Times(0);
+  mlme_event_handler_->OnRoam(CreateRoamEvent(0));
+  EXPECT_EQ(static_cast<int32_t>(kTestFrequency1), GetSignalPollFrequency());
+}
+
 }  // namespace wificond
 }  // namespace android
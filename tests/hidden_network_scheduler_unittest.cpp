@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/hidden_network_scheduler.h"
+
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const vector<uint8_t> kSsidA = {'A'};
+const vector<uint8_t> kSsidB = {'B'};
+const vector<uint8_t> kSsidC = {'C'};
+const vector<uint8_t> kSsidD = {'D'};
+const vector<uint8_t> kSsidE = {'E'};
+
+}  // namespace
+
+class HiddenNetworkSchedulerTest : public ::testing::Test {
+ protected:
+  HiddenNetworkScheduler scheduler_;
+};
+
+TEST_F(HiddenNetworkSchedulerTest, KeepsAllSsidsThatFit) {
+  vector<vector<vector<uint8_t>>> batches =
+      scheduler_.Schedule({kSsidA, kSsidB}, 3, false);
+  ASSERT_EQ(1u, batches.size());
+  EXPECT_EQ(vector<vector<uint8_t>>({kSsidA, kSsidB}), batches[0]);
+}
+
+TEST_F(HiddenNetworkSchedulerTest, RotatesOverflowAcrossRequests) {
+  const vector<vector<uint8_t>> ssids = {kSsidA, kSsidB, kSsidC, kSsidD,
+                                         kSsidE};
+  vector<vector<vector<uint8_t>>> batches = scheduler_.Schedule(ssids, 2, false);
+  ASSERT_EQ(1u, batches.size());
+  EXPECT_EQ(vector<vector<uint8_t>>({kSsidA, kSsidB}), batches[0]);
+
+  batches = scheduler_.Schedule(ssids, 2, false);
+  ASSERT_EQ(1u, batches.size());
+  EXPECT_EQ(vector<vector<uint8_t>>({kSsidC, kSsidD}), batches[0]);
+
+  batches = scheduler_.Schedule(ssids, 2, false);
+  ASSERT_EQ(1u, batches.size());
+  EXPECT_EQ(vector<vector<uint8_t>>({kSsidE, kSsidA}), batches[0]);
+
+  HiddenNetworkCoverage coverage = scheduler_.GetCoverageStats()[kSsidB];
+  EXPECT_EQ(3u, coverage.num_requested);
+  EXPECT_EQ(1u, coverage.num_probed);
+  EXPECT_EQ(2u, coverage.num_deferred);
+}
+
+TEST_F(HiddenNetworkSchedulerTest, SplitsRequestForFullCoverage) {
+  vector<vector<vector<uint8_t>>> batches =
+      scheduler_.Schedule({kSsidA, kSsidB, kSsidC, kSsidD, kSsidE}, 2, true);
+  ASSERT_EQ(3u, batches.size());
+  EXPECT_EQ(vector<vector<uint8_t>>({kSsidA, kSsidB}), batches[0]);
+  EXPECT_EQ(vector<vector<uint8_t>>({kSsidC, kSsidD}), batches[1]);
+  EXPECT_EQ(vector<vector<uint8_t>>({kSsidE}), batches[2]);
+  for (const auto& it : scheduler_.GetCoverageStats()) {
+    EXPECT_EQ(1u, it.second.num_probed);
+    EXPECT_EQ(0u, it.second.num_deferred);
+  }
+}
+
+TEST_F(HiddenNetworkSchedulerTest, DeferredSsidsKeepTheirPlaceInRotation) {
+  scheduler_.Schedule({kSsidA}, 1, false);
+  vector<vector<vector<uint8_t>>> batches =
+      scheduler_.Schedule({kSsidB}, 1, false);
+  ASSERT_EQ(1u, batches.size());
+  EXPECT_EQ(vector<vector<uint8_t>>({kSsidB}), batches[0]);
+  // The scan that was to probe for B had no room left for it.
+  scheduler_.Defer({kSsidB});
+
+  HiddenNetworkCoverage coverage = scheduler_.GetCoverageStats()[kSsidB];
+  EXPECT_EQ(0u, coverage.num_probed);
+  EXPECT_EQ(1u, coverage.num_deferred);
+  // B was never probed, so it goes before A.
+  batches = scheduler_.Schedule({kSsidA, kSsidB}, 1, false);
+  ASSERT_EQ(1u, batches.size());
+  EXPECT_EQ(vector<vector<uint8_t>>({kSsidB}), batches[0]);
+}
+
+TEST_F(HiddenNetworkSchedulerTest, DefersEverythingWithoutSsidSlots) {
+  vector<vector<vector<uint8_t>>> batches =
+      scheduler_.Schedule({kSsidA, kSsidB}, 0, true);
+  ASSERT_EQ(1u, batches.size());
+  EXPECT_TRUE(batches[0].empty());
+  EXPECT_EQ(1u, scheduler_.GetCoverageStats()[kSsidA].num_deferred);
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+
+#include <android/hardware/wifi/offload/1.0/IOffload.h>
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/offload/hidl_call_stats.h"
+#include "wificond/scanning/offload/hidl_call_util.h"
+#include "wificond/tests/offload_hal_test_constants.h"
+#include "wificond/tests/offload_test_utils.h"
+
+using android::hardware::Return;
+using android::hardware::Status;
+using android::hardware::Void;
+using android::hardware::wifi::offload::V1_0::IOffload;
+using android::hardware::wifi::offload::V1_0::IOffloadCallback;
+using android::hardware::wifi::offload::V1_0::OffloadStatus;
+using android::hardware::wifi::offload::V1_0::OffloadStatusCode;
+using android::hardware::wifi::offload::V1_0::ScanFilter;
+using android::hardware::wifi::offload::V1_0::ScanParam;
+using android::hardware::wifi::offload::V1_0::ScanStats;
+using android::sp;
+using com::android::server::wifi::wificond::NativeScanStats;
+using namespace android::wificond::offload_hal_test_constants;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+constexpr int64_t kDeadlineMs = 20;
+
+// Offload HAL which answers every call after |latency_us|, or fails the
+// transport if |transport_ok| is false.
+class FakeOffload : public IOffload {
+ public:
+  Return<void> configureScans(const ScanParam& param,
+                              const ScanFilter& filter,
+                              configureScans_cb cb) override {
+    return Answer([&cb]() { cb(CreateOkStatus()); });
+  }
+  Return<void> getScanStats(getScanStats_cb cb) override {
+    return Answer([&cb]() {
+      NativeScanStats unused;
+      cb(CreateOkStatus(), OffloadTestUtils::createScanStats(&unused));
+    });
+  }
+  Return<void> subscribeScanResults(uint32_t delay_ms,
+                                    subscribeScanResults_cb cb) override {
+    return Answer([&cb]() { cb(CreateOkStatus()); });
+  }
+  Return<void> unsubscribeScanResults() override { return Void(); }
+  Return<void> setEventCallback(const sp<IOffloadCallback>& cb) override {
+    return Void();
+  }
+
+  int64_t latency_us = 0;
+  bool transport_ok = true;
+
+ private:
+  static OffloadStatus CreateOkStatus() {
+    return OffloadTestUtils::createOffloadStatus(OffloadStatusCode::OK);
+  }
+
+  Return<void> Answer(const std::function<void()>& reply) {
+    usleep(latency_us);
+    if (!transport_ok) {
+      return Status::fromExceptionCode(Status::EX_TRANSACTION_FAILED);
+    }
+    reply();
+    return Void();
+  }
+};
+
+}  // namespace
+
+class HidlCallUtilTest : public ::testing::Test {
+ protected:
+  sp<FakeOffload> offload_{new FakeOffload()};
+  HidlCallStats stats_{kDeadlineMs};
+};
+
+TEST_F(HidlCallUtilTest, ReturnsCallbackArguments) {
+  const auto& result = HIDL_INVOKE(offload_, getScanStats);
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ(OffloadStatusCode::OK, result.first.first.code);
+  EXPECT_EQ(kDefaultNumScansRequestedByWifi,
+            result.first.second.numScansRequestedByWifi);
+}
+
+TEST_F(HidlCallUtilTest, RecordsLatencyPerMethod) {
+  HIDL_INVOKE_WITH_STATS(&stats_, offload_, getScanStats);
+  HIDL_INVOKE_WITH_STATS(&stats_, offload_, getScanStats);
+  HIDL_INVOKE_WITH_STATS(&stats_, offload_, subscribeScanResults, 1000);
+
+  const auto& method_stats = stats_.GetMethodStats();
+  ASSERT_EQ(2u, method_stats.size());
+  const HidlMethodStats& get_scan_stats = method_stats.at("getScanStats");
+  EXPECT_EQ(2u, get_scan_stats.latency.GetCount());
+  EXPECT_EQ(0u, get_scan_stats.num_transport_failures);
+  EXPECT_EQ(0u, get_scan_stats.num_slow_calls);
+  EXPECT_EQ(1u, method_stats.at("subscribeScanResults").latency.GetCount());
+}
+
+TEST_F(HidlCallUtilTest, CountsTransportFailures) {
+  offload_->transport_ok = false;
+  const auto& result = HIDL_INVOKE_WITH_STATS(
+      &stats_, offload_, configureScans, ScanParam(), ScanFilter());
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ(1u,
+            stats_.GetMethodStats().at("configureScans").num_transport_failures);
+}
+
+TEST_F(HidlCallUtilTest, CountsCallsPastDeadline) {
+  offload_->latency_us = kDeadlineMs * 1000;
+  const auto& result = HIDL_INVOKE_WITH_STATS(&stats_, offload_, getScanStats);
+  // A slow call still delivers its result.
+  EXPECT_TRUE(result.second);
+  const HidlMethodStats& stats = stats_.GetMethodStats().at("getScanStats");
+  EXPECT_EQ(1u, stats.num_slow_calls);
+  EXPECT_GE(stats.latency.GetMaxUs(), kDeadlineMs * 1000);
+}
+
+TEST_F(HidlCallUtilTest, NoDeadline) {
+  HidlCallStats stats(0);
+  offload_->latency_us = kDeadlineMs * 1000;
+  HIDL_INVOKE_WITH_STATS(&stats, offload_, getScanStats);
+  EXPECT_EQ(0u, stats.GetMethodStats().at("getScanStats").num_slow_calls);
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "wificond/latency_histogram.h"
+
+namespace android {
+namespace wificond {
+
+TEST(LatencyHistogramTest, Empty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0u, histogram.GetCount());
+  EXPECT_EQ(0, histogram.GetAverageUs());
+  EXPECT_EQ(0, histogram.GetMaxUs());
+  EXPECT_EQ("", histogram.ToString());
+}
+
+TEST(LatencyHistogramTest, BucketsByUpperBound) {
+  LatencyHistogram histogram;
+  histogram.Add(0);
+  histogram.Add(99);
+  histogram.Add(100);
+  histogram.Add(999);
+  histogram.Add(2000000);
+
+  const auto& counts = histogram.GetBucketCounts();
+  EXPECT_EQ(2u, counts[0]);
+  EXPECT_EQ(1u, counts[1]);
+  EXPECT_EQ(1u, counts[3]);
+  EXPECT_EQ(1u, counts[LatencyHistogram::kNumBuckets - 1]);
+  EXPECT_EQ(100, LatencyHistogram::GetBucketUpperBoundUs(0));
+  EXPECT_EQ(-1, LatencyHistogram::GetBucketUpperBoundUs(
+                    LatencyHistogram::kNumBuckets - 1));
+
+  EXPECT_EQ(5u, histogram.GetCount());
+  EXPECT_EQ(2000000, histogram.GetMaxUs());
+  EXPECT_EQ((99 + 100 + 999 + 2000000) / 5, histogram.GetAverageUs());
+  EXPECT_EQ("<100us:2 <250us:1 <1ms:1 >=1s:1", histogram.ToString());
+}
+
+}  // namespace wificond
+}  // namespace android
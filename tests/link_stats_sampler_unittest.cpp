@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "wificond/link_stats_sampler.h"
+#include "wificond/tests/mock_netlink_manager.h"
+#include "wificond/tests/mock_netlink_utils.h"
+
+using std::unique_ptr;
+using std::vector;
+using testing::DoAll;
+using testing::NiceMock;
+using testing::Return;
+using testing::SetArgPointee;
+using testing::_;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const uint32_t kFakeInterfaceIndex = 12;
+const int64_t kFakeSamplingPeriodMs = 1000;
+const vector<uint8_t> kFakeBssid1 = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};
+const vector<uint8_t> kFakeBssid2 = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbd};
+
+}  // namespace
+
+class LinkStatsSamplerTest : public ::testing::Test {
+ protected:
+  unique_ptr<NiceMock<MockNetlinkManager>> netlink_manager_{
+      new NiceMock<MockNetlinkManager>()};
+  unique_ptr<NiceMock<MockNetlinkUtils>> netlink_utils_{
+      new NiceMock<MockNetlinkUtils>(netlink_manager_.get())};
+  LinkStatsSampler sampler_{netlink_utils_.get(), kFakeInterfaceIndex,
+                            kFakeSamplingPeriodMs};
+};
+
+TEST_F(LinkStatsSamplerTest, CollapsesQueriesWithinSamplingPeriod) {
+  StationInfo station_info(10, 1, 540, -60);
+  EXPECT_CALL(*netlink_utils_,
+              GetStationInfo(kFakeInterfaceIndex, kFakeBssid1, _))
+      .Times(2)
+      .WillRepeatedly(DoAll(SetArgPointee<2>(station_info), Return(true)));
+
+  StationInfo result;
+  EXPECT_TRUE(sampler_.GetStationInfo(kFakeBssid1, 5000, &result));
+  EXPECT_TRUE(sampler_.GetStationInfo(kFakeBssid1, 5999, &result));
+  EXPECT_EQ(-60, result.current_rssi);
+  EXPECT_EQ(10, result.station_tx_packets);
+  EXPECT_TRUE(sampler_.GetStationInfo(
+      kFakeBssid1, 5000 + kFakeSamplingPeriodMs, &result));
+
+  EXPECT_EQ(3u, sampler_.GetNumRequests());
+  EXPECT_EQ(2u, sampler_.GetNumKernelQueries());
+  EXPECT_EQ(2u, sampler_.GetSamples().size());
+}
+
+TEST_F(LinkStatsSamplerTest, QueriesKernelForAnotherAp) {
+  EXPECT_CALL(*netlink_utils_, GetStationInfo(_, kFakeBssid1, _))
+      .WillOnce(Return(true));
+  EXPECT_CALL(*netlink_utils_, GetStationInfo(_, kFakeBssid2, _))
+      .WillOnce(Return(true));
+
+  StationInfo result;
+  EXPECT_TRUE(sampler_.GetStationInfo(kFakeBssid1, 5000, &result));
+  EXPECT_TRUE(sampler_.GetStationInfo(kFakeBssid2, 5001, &result));
+  ASSERT_EQ(2u, sampler_.GetSamples().size());
+  EXPECT_EQ(kFakeBssid2, sampler_.GetSamples().back().bssid);
+}
+
+TEST_F(LinkStatsSamplerTest, KeepsLatestSamplesOnly) {
+  EXPECT_CALL(*netlink_utils_, GetStationInfo(_, _, _))
+      .WillOnce(Return(false))
+      .WillRepeatedly(Return(true));
+
+  StationInfo result;
+  // Failed queries are not kept, and the next getter queries again.
+  EXPECT_FALSE(sampler_.GetStationInfo(kFakeBssid1, 0, &result));
+  EXPECT_TRUE(sampler_.GetSamples().empty());
+  for (size_t i = 0; i < LinkStatsSampler::kMaxSamples + 1; i++) {
+    EXPECT_TRUE(sampler_.Sample(kFakeBssid1, i));
+  }
+  ASSERT_EQ(LinkStatsSampler::kMaxSamples, sampler_.GetSamples().size());
+  EXPECT_EQ(1, sampler_.GetSamples().front().time_ms);
+}
+
+}  // namespace wificond
+}  // namespace android
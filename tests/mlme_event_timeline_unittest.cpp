@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wificond/mlme_event_timeline.h"
+
+using com::android::server::wifi::wificond::MlmeEventStats;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const vector<uint8_t> kBssid1 = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};
+const vector<uint8_t> kBssid2 = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbd};
+const uint16_t kStatusUnspecifiedFailure = 1;
+
+MlmeEventRecord CreateEvent(int64_t time_ms, MlmeEventType type,
+                            uint16_t status_code,
+                            const vector<uint8_t>& bssid) {
+  return {time_ms, type, status_code, false, bssid};
+}
+
+}  // namespace
+
+TEST(MlmeEventTimelineTest, MeasuresReconnectOutageFromFailedAttempt) {
+  MlmeEventTimeline timeline;
+  timeline.Add(CreateEvent(1000, MlmeEventType::kConnect,
+                           kStatusUnspecifiedFailure, kBssid1));
+  timeline.Add(CreateEvent(1400, MlmeEventType::kConnect, 0, kBssid1));
+
+  EXPECT_EQ(1u, timeline.GetReconnectOutage().GetCount());
+  EXPECT_EQ(400, timeline.GetReconnectOutage().GetMaxMs());
+  EXPECT_EQ(0u, timeline.GetRoamInterruption().GetCount());
+  MlmeEventStats stats = timeline.GetStats();
+  EXPECT_EQ(2u, stats.num_connect_attempts_);
+  EXPECT_EQ(1u, stats.num_connect_failures_);
+  ASSERT_EQ(OutageHistogram::kNumBuckets,
+            stats.reconnect_outage_counts_.size());
+  ASSERT_EQ(OutageHistogram::kNumBuckets,
+            stats.outage_bucket_upper_bounds_ms_.size());
+  // 400 ms falls in [250 ms, 500 ms).
+  EXPECT_EQ(500, stats.outage_bucket_upper_bounds_ms_[3]);
+  EXPECT_EQ(1, stats.reconnect_outage_counts_[3]);
+}
+
+TEST(MlmeEventTimelineTest, KeepsOutagesUpToLimitInMsBuckets) {
+  MlmeEventTimeline timeline;
+  timeline.Add(CreateEvent(0, MlmeEventType::kConnect, 0, kBssid1));
+  timeline.Add(CreateEvent(1000, MlmeEventType::kDisconnect, 0, kBssid1));
+  timeline.Add(CreateEvent(1000 + MlmeEventTimeline::kMaxOutageMs,
+                           MlmeEventType::kConnect, 0, kBssid1));
+
+  const OutageHistogram& outage = timeline.GetReconnectOutage();
+  EXPECT_EQ(1u, outage.GetCount());
+  EXPECT_EQ(MlmeEventTimeline::kMaxOutageMs, outage.GetMaxMs());
+  EXPECT_EQ(1u, outage.GetBucketCounts()[OutageHistogram::kNumBuckets - 1]);
+  EXPECT_EQ(-1, OutageHistogram::GetBucketUpperBoundMs(
+                    OutageHistogram::kNumBuckets - 1));
+  EXPECT_EQ(">=20s:1", outage.ToString());
+}
+
+TEST(MlmeEventTimelineTest, CountsAssociateAndConnectAsOneAttempt) {
+  MlmeEventTimeline timeline;
+  // Drivers with SME in the host report both events for one attempt.
+  timeline.Add(CreateEvent(1000, MlmeEventType::kAssociate,
+                           kStatusUnspecifiedFailure, kBssid1));
+  timeline.Add(CreateEvent(1001, MlmeEventType::kConnect,
+                           kStatusUnspecifiedFailure, kBssid1));
+  timeline.Add(CreateEvent(1300, MlmeEventType::kAssociate, 0, kBssid1));
+  timeline.Add(CreateEvent(1301, MlmeEventType::kConnect, 0, kBssid1));
+
+  MlmeEventStats stats = timeline.GetStats();
+  EXPECT_EQ(2u, stats.num_connect_attempts_);
+  EXPECT_EQ(1u, stats.num_connect_failures_);
+  EXPECT_EQ(0u, stats.num_disconnects_);
+  EXPECT_EQ(1u, timeline.GetReconnectOutage().GetCount());
+  EXPECT_EQ(300, timeline.GetReconnectOutage().GetMaxMs());
+}
+
+TEST(MlmeEventTimelineTest, MeasuresRoamInterruptionOnAnotherAp) {
+  MlmeEventTimeline timeline;
+  timeline.Add(CreateEvent(1000, MlmeEventType::kConnect, 0, kBssid1));
+  timeline.Add(CreateEvent(5000, MlmeEventType::kDisassociate, 0, kBssid1));
+  timeline.Add(CreateEvent(5001, MlmeEventType::kDisconnect, 0, kBssid1));
+  timeline.Add(CreateEvent(5080, MlmeEventType::kConnect, 0, kBssid2));
+  // A seamless roam has no outage to measure.
+  timeline.Add(CreateEvent(9000, MlmeEventType::kRoam, 0, kBssid1));
+
+  EXPECT_EQ(0u, timeline.GetReconnectOutage().GetCount());
+  EXPECT_EQ(1u, timeline.GetRoamInterruption().GetCount());
+  EXPECT_EQ(80, timeline.GetRoamInterruption().GetMaxMs());
+  MlmeEventStats stats = timeline.GetStats();
+  EXPECT_EQ(1u, stats.num_disconnects_);
+  EXPECT_EQ(1u, stats.num_roams_);
+}
+
+TEST(MlmeEventTimelineTest, SkipsLongOutagesAndKeepsLatestEvents) {
+  MlmeEventTimeline timeline;
+  timeline.Add(CreateEvent(0, MlmeEventType::kConnect, 0, kBssid1));
+  timeline.Add(CreateEvent(1000, MlmeEventType::kDisconnect, 0, kBssid1));
+  timeline.Add(CreateEvent(1000 + MlmeEventTimeline::kMaxOutageMs + 1,
+                           MlmeEventType::kConnect, 0, kBssid1));
+  EXPECT_EQ(0u, timeline.GetReconnectOutage().GetCount());
+
+  for (size_t i = 0; i < MlmeEventTimeline::kMaxEvents; i++) {
+    timeline.Add(CreateEvent(100000 + i, MlmeEventType::kRoam, 0, kBssid2));
+  }
+  ASSERT_EQ(MlmeEventTimeline::kMaxEvents, timeline.GetEvents().size());
+  EXPECT_EQ(100000, timeline.GetEvents().front().time_ms);
+  EXPECT_EQ(MlmeEventType::kRoam, timeline.GetEvents().back().type);
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -36,7 +36,8 @@ MockClientInterfaceImpl::MockClientInterfaceImpl(
       android::wifi_system::InterfaceTool* interface_tool,
       android::wifi_system::SupplicantManager* supplicant_manager,
       NetlinkUtils* netlink_utils,
-      ScanUtils* scan_utils)
+      ScanUtils* scan_utils,
+      EventLoop* event_loop)
     : ClientInterfaceImpl(
         kTestWiphyIndex,
         kTestInterfaceName,
@@ -47,7 +48,8 @@ MockClientInterfaceImpl::MockClientInterfaceImpl(
         interface_tool,
         supplicant_manager,
         netlink_utils,
-        scan_utils) {}
+        scan_utils,
+        event_loop) {}
 
 }  // namespace wificond
 }  // namespace android
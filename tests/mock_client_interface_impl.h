@@ -31,7 +31,8 @@ class MockClientInterfaceImpl : public ClientInterfaceImpl {
       android::wifi_system::InterfaceTool*,
       android::wifi_system::SupplicantManager*,
       NetlinkUtils*,
-      ScanUtils*);
+      ScanUtils*,
+      EventLoop*);
   ~MockClientInterfaceImpl() override = default;
 
   MOCK_CONST_METHOD0(IsAssociated, bool());
@@ -45,6 +45,12 @@ class MockNetlinkUtils : public NetlinkUtils {
                void(uint32_t interface_index,
                     OnStationEventHandler handler));
 
+  MOCK_METHOD2(GetInterfaceFrequency,
+               bool(uint32_t interface_index, uint32_t* out_frequency));
+  MOCK_METHOD3(GetStationInfo,
+               bool(uint32_t interface_index,
+                    const std::vector<uint8_t>& mac_address,
+                    StationInfo* out_station_info));
   MOCK_METHOD2(GetInterfaces,
                bool(uint32_t wiphy_index,
                     std::vector<InterfaceInfo>* interfaces));
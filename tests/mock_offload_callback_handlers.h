@@ -33,7 +33,7 @@ class MockOffloadCallbackHandlers : public OffloadCallbackHandlers {
 
   MOCK_METHOD1(
       OnScanResultHandler,
-      void(const std::vector<
+      void(const android::hardware::hidl_vec<
            android::hardware::wifi::offload::V1_0::ScanResult>& scanResult));
   MOCK_METHOD1(OnErrorHandler,
                void(const android::hardware::wifi::offload::V1_0::OffloadStatus&
@@ -32,18 +32,22 @@ class MockOffloadScanManager : public OffloadScanManager {
       std::shared_ptr<OffloadScanCallbackInterface> callback_interface);
   ~MockOffloadScanManager() override = default;
 
-  MOCK_METHOD7(startScan,
+  MOCK_METHOD8(startScan,
                bool(uint32_t interval_ms, int32_t rssi_threshold,
                     const std::vector<std::vector<uint8_t>>& scan_ssids,
                     const std::vector<std::vector<uint8_t>>& match_ssids,
                     const std::vector<uint8_t>& match_security,
                     const std::vector<uint32_t>& frequencies,
+                    uint32_t subscription_delay_ms,
                     OffloadScanManager::ReasonCode* reason_code));
   MOCK_METHOD1(stopScan, bool(OffloadScanManager::ReasonCode* reason_code));
   MOCK_METHOD1(getScanStats,
                bool(::com::android::server::wifi::wificond::NativeScanStats*
                         scan_stats));
   MOCK_CONST_METHOD0(getOffloadStatus, OffloadScanManager::StatusCode());
+  MOCK_CONST_METHOD0(
+      getScanStatsHistory,
+      std::vector<::com::android::server::wifi::wificond::NativeScanStats>());
   MOCK_METHOD1(
       getScanResults,
       bool(std::vector<
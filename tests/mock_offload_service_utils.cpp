@@ -19,7 +19,8 @@
 namespace android {
 namespace wificond {
 
-MockOffloadServiceUtils::MockOffloadServiceUtils() {}
+MockOffloadServiceUtils::MockOffloadServiceUtils()
+    : OffloadServiceUtils(nullptr) {}
 
 }  // namespace wificond
 }  // namespace android
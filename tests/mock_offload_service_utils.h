@@ -34,6 +34,8 @@ class MockOffloadServiceUtils : public OffloadServiceUtils {
   MockOffloadServiceUtils();
   ~MockOffloadServiceUtils() override = default;
   MOCK_CONST_METHOD0(IsOffloadScanSupported, bool());
+  MOCK_CONST_METHOD0(GetScanStatsSamplingPeriodMs, uint32_t());
+  MOCK_CONST_METHOD0(GetMaxPnoNetworks, uint32_t());
   MOCK_METHOD0(GetOffloadService,
                sp<android::hardware::wifi::offload::V1_0::IOffload>());
   MOCK_METHOD1(GetOffloadCallback,
@@ -49,6 +51,8 @@ class MockOffloadServiceUtils : public OffloadServiceUtils {
                    std::weak_ptr<OffloadServiceUtils> service_utils,
                    std::shared_ptr<OffloadScanCallbackInterfaceImpl>
                        callback_interface));
+  MOCK_METHOD2(PostDelayedTask,
+               bool(const std::function<void()>& task, int64_t delay_ms));
 };
 
 }  // namespace wificond
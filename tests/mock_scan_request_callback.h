@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_TESTS_MOCK_SCAN_REQUEST_CALLBACK_H_
+#define WIFICOND_TESTS_MOCK_SCAN_REQUEST_CALLBACK_H_
+
+#include <gmock/gmock.h>
+
+#include "android/net/wifi/BnScanRequestCallback.h"
+
+namespace android {
+namespace wificond {
+
+class MockScanRequestCallback
+    : public ::android::net::wifi::BnScanRequestCallback {
+ public:
+  MockScanRequestCallback();
+  ~MockScanRequestCallback() override = default;
+
+  MOCK_METHOD2(OnScanRequestAcked, ::android::binder::Status(
+      int32_t request_id, int64_t cookie));
+  MOCK_METHOD2(OnScanRequestFailed, ::android::binder::Status(
+      int32_t request_id, int32_t error_code));
+  MOCK_METHOD2(OnScanRequestCompleted, ::android::binder::Status(
+      int32_t request_id, bool aborted));
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_TESTS_MOCK_SCAN_REQUEST_CALLBACK_H_
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_TESTS_MOCK_SCAN_RESULT_DELTA_EVENT_H_
+#define WIFICOND_TESTS_MOCK_SCAN_RESULT_DELTA_EVENT_H_
+
+#include <gmock/gmock.h>
+
+#include "android/net/wifi/BnScanResultDeltaEvent.h"
+
+namespace android {
+namespace wificond {
+
+class MockScanResultDeltaEvent
+    : public ::android::net::wifi::BnScanResultDeltaEvent {
+ public:
+  MockScanResultDeltaEvent();
+  ~MockScanResultDeltaEvent() override = default;
+
+  MOCK_METHOD1(OnScanResultDelta, ::android::binder::Status(
+      const ::com::android::server::wifi::wificond::ScanResultDelta& delta));
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_TESTS_MOCK_SCAN_RESULT_DELTA_EVENT_H_
@@ -19,6 +19,8 @@
 
 #include <gmock/gmock.h>
 
+#include "wificond/scanning/scan_result_filter.h"
+#include "wificond/scanning/scan_result_projection.h"
 #include "wificond/scanning/scan_utils.h"
 
 namespace android {
@@ -40,19 +42,43 @@ class MockScanUtils : public ScanUtils {
   MOCK_METHOD2(GetScanResult, bool(
       uint32_t interface_index,
       std::vector<::com::android::server::wifi::wificond::NativeScanResult>* out_scan_results));
+  MOCK_METHOD4(GetFilteredScanResult, bool(
+      uint32_t interface_index,
+      const ::com::android::server::wifi::wificond::ScanResultFilter& filter,
+      const ::com::android::server::wifi::wificond::ScanResultProjection& projection,
+      std::vector<::com::android::server::wifi::wificond::NativeScanResult>* out_scan_results));
 
-  MOCK_METHOD5(Scan, bool(
+  MOCK_METHOD8(Scan, bool(
       uint32_t interface_index,
       bool random_mac,
+      int scan_type,
+      uint32_t dwell_time_ms,
+      bool flush_cache,
       const std::vector<std::vector<uint8_t>>& ssids,
       const std::vector<uint32_t>& freqs,
       int* error_code));
 
-  MOCK_METHOD8(StartScheduledScan, bool(
+  MOCK_METHOD7(ScanAsync, bool(
+      uint32_t interface_index,
+      bool random_mac,
+      int scan_type,
+      uint32_t dwell_time_ms,
+      bool flush_cache,
+      const std::vector<std::vector<uint8_t>>& ssids,
+      const std::vector<uint32_t>& freqs));
+
+  MOCK_METHOD2(SubscribeScanTriggerNotification, void(
+      uint32_t interface_index,
+      OnScanTriggeredHandler handler));
+  MOCK_METHOD1(UnsubscribeScanTriggerNotification,
+               void(uint32_t interface_index));
+
+  MOCK_METHOD9(StartScheduledScan, bool(
       uint32_t interface_index,
       const SchedScanIntervalSetting& interval_setting,
-      int32_t rssi_threshold,
-      bool request_random_mac,
+      int32_t rssi_threshold_2g,
+      int32_t rssi_threshold_5g,
+      const SchedScanReqFlags& req_flags,
       const std::vector<std::vector<uint8_t>>& scan_ssids,
       const std::vector<std::vector<uint8_t>>& match_ssids,
       const std::vector<uint32_t>& freqs,
@@ -153,7 +153,17 @@ void AppendBandInfoAttributes(NL80211Packet* packet) {
 void AppendWiphyFeaturesAttributes(NL80211Packet* packet) {
   packet->AddAttribute(NL80211Attr<uint32_t>(
       NL80211_ATTR_FEATURE_FLAGS,
-      NL80211_FEATURE_SCAN_RANDOM_MAC_ADDR));
+      NL80211_FEATURE_SCAN_RANDOM_MAC_ADDR | NL80211_FEATURE_SCAN_FLUSH));
+
+  std::vector<uint8_t> ext_feature_flags_bytes(NUM_NL80211_EXT_FEATURES / 8 + 1);
+  for (auto ext_feature_flag : {NL80211_EXT_FEATURE_LOW_SPAN_SCAN,
+                                NL80211_EXT_FEATURE_SET_SCAN_DWELL,
+                                NL80211_EXT_FEATURE_SCHED_SCAN_RELATIVE_RSSI}) {
+    ext_feature_flags_bytes[ext_feature_flag / 8] |=
+        1 << (ext_feature_flag % 8);
+  }
+  packet->AddAttribute(NL80211Attr<std::vector<uint8_t>>(
+      NL80211_ATTR_EXT_FEATURES, ext_feature_flags_bytes));
 }
 
 void VerifyScanCapabilities(const ScanCapabilities& scan_capabilities,
@@ -191,6 +201,13 @@ void VerifyBandInfo(const BandInfo& band_info) {
 void VerifyWiphyFeatures(const WiphyFeatures& wiphy_features) {
   EXPECT_TRUE(wiphy_features.supports_random_mac_oneshot_scan);
   EXPECT_FALSE(wiphy_features.supports_random_mac_sched_scan);
+  EXPECT_TRUE(wiphy_features.supports_scan_flush);
+  EXPECT_TRUE(wiphy_features.supports_low_span_oneshot_scan);
+  EXPECT_FALSE(wiphy_features.supports_low_power_oneshot_scan);
+  EXPECT_FALSE(wiphy_features.supports_high_accuracy_oneshot_scan);
+  EXPECT_TRUE(wiphy_features.supports_scan_dwell);
+  EXPECT_FALSE(wiphy_features.supports_sched_scan_band_specific_rssi);
+  EXPECT_TRUE(wiphy_features.supports_sched_scan_relative_rssi);
 }
 
 }  // namespace
@@ -307,6 +324,107 @@ TEST_F(NetlinkUtilsTest, CanGetInterfaces) {
   EXPECT_EQ(if_mac_addr, interfaces[0].mac_address);
 }
 
+TEST_F(NetlinkUtilsTest, CanGetInterfaceFrequency) {
+  NL80211Packet new_interface(
+      netlink_manager_->GetFamilyId(),
+      NL80211_CMD_NEW_INTERFACE,
+      netlink_manager_->GetSequenceNumber(),
+      getpid());
+  new_interface.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_ATTR_IFINDEX, kFakeInterfaceIndex));
+  new_interface.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_ATTR_WIPHY_FREQ, kFakeFrequency4));
+  vector<NL80211Packet> response = {new_interface};
+
+  EXPECT_CALL(*netlink_manager_, SendMessageAndGetResponses(_, _)).
+      WillOnce(DoAll(MakeupResponse(response), Return(true)));
+
+  uint32_t frequency = 0;
+  EXPECT_TRUE(netlink_utils_->GetInterfaceFrequency(kFakeInterfaceIndex,
+                                                    &frequency));
+  EXPECT_EQ(kFakeFrequency4, frequency);
+}
+
+TEST_F(NetlinkUtilsTest, CanHandleInterfaceWithoutChannel) {
+  NL80211Packet new_interface(
+      netlink_manager_->GetFamilyId(),
+      NL80211_CMD_NEW_INTERFACE,
+      netlink_manager_->GetSequenceNumber(),
+      getpid());
+  new_interface.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_ATTR_IFINDEX, kFakeInterfaceIndex));
+  vector<NL80211Packet> response = {new_interface};
+
+  EXPECT_CALL(*netlink_manager_, SendMessageAndGetResponses(_, _)).
+      WillOnce(DoAll(MakeupResponse(response), Return(true)));
+
+  uint32_t frequency = 0;
+  EXPECT_FALSE(netlink_utils_->GetInterfaceFrequency(kFakeInterfaceIndex,
+                                                     &frequency));
+}
+
+TEST_F(NetlinkUtilsTest, CanGetStationInfo) {
+  NL80211Packet new_station(
+      netlink_manager_->GetFamilyId(),
+      NL80211_CMD_NEW_STATION,
+      netlink_manager_->GetSequenceNumber(),
+      getpid());
+  NL80211NestedAttr tx_bitrate(NL80211_STA_INFO_TX_BITRATE);
+  tx_bitrate.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_RATE_INFO_BITRATE32, 8667));
+  tx_bitrate.AddAttribute(NL80211Attr<uint8_t>(NL80211_RATE_INFO_VHT_MCS, 9));
+  tx_bitrate.AddAttribute(NL80211Attr<uint8_t>(NL80211_RATE_INFO_VHT_NSS, 2));
+  tx_bitrate.AddFlagAttribute(NL80211_RATE_INFO_80_MHZ_WIDTH);
+  NL80211NestedAttr rx_bitrate(NL80211_STA_INFO_RX_BITRATE);
+  rx_bitrate.AddAttribute(NL80211Attr<uint16_t>(NL80211_RATE_INFO_BITRATE, 60));
+  NL80211NestedAttr sta_info(NL80211_ATTR_STA_INFO);
+  sta_info.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_STA_INFO_TX_PACKETS, 100));
+  sta_info.AddAttribute(NL80211Attr<uint32_t>(NL80211_STA_INFO_TX_FAILED, 3));
+  sta_info.AddAttribute(NL80211Attr<uint8_t>(NL80211_STA_INFO_SIGNAL,
+                                             static_cast<uint8_t>(-55)));
+  sta_info.AddAttribute(NL80211Attr<uint8_t>(NL80211_STA_INFO_SIGNAL_AVG,
+                                             static_cast<uint8_t>(-57)));
+  sta_info.AddAttribute(
+      NL80211Attr<uint64_t>(NL80211_STA_INFO_RX_BYTES64, 5000000000ULL));
+  sta_info.AddAttribute(NL80211Attr<uint32_t>(NL80211_STA_INFO_TX_BYTES, 2000));
+  sta_info.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_STA_INFO_RX_PACKETS, 200));
+  sta_info.AddAttribute(NL80211Attr<uint32_t>(NL80211_STA_INFO_TX_RETRIES, 7));
+  sta_info.AddAttribute(NL80211Attr<uint32_t>(NL80211_STA_INFO_BEACON_LOSS, 1));
+  sta_info.AddAttribute(tx_bitrate);
+  sta_info.AddAttribute(rx_bitrate);
+  new_station.AddAttribute(sta_info);
+  vector<NL80211Packet> response = {new_station};
+
+  EXPECT_CALL(*netlink_manager_, SendMessageAndGetResponses(_, _)).
+      WillOnce(DoAll(MakeupResponse(response), Return(true)));
+
+  StationInfo station_info;
+  EXPECT_TRUE(netlink_utils_->GetStationInfo(
+      kFakeInterfaceIndex,
+      vector<uint8_t>(std::begin(kFakeInterfaceMacAddress),
+                      std::end(kFakeInterfaceMacAddress)),
+      &station_info));
+  EXPECT_EQ(100, station_info.station_tx_packets);
+  EXPECT_EQ(3, station_info.station_tx_failed);
+  EXPECT_EQ(8667u, station_info.station_tx_bitrate);
+  EXPECT_EQ(-55, station_info.current_rssi);
+  EXPECT_EQ(-57, station_info.signal_avg);
+  EXPECT_EQ(5000000000ULL, station_info.rx_bytes);
+  EXPECT_EQ(2000u, station_info.tx_bytes);
+  EXPECT_EQ(200u, station_info.rx_packets);
+  EXPECT_EQ(7u, station_info.tx_retries);
+  EXPECT_EQ(1u, station_info.beacon_loss);
+  EXPECT_EQ(8667u, station_info.tx_rate.bitrate);
+  EXPECT_EQ(9, station_info.tx_rate.mcs);
+  EXPECT_EQ(2, station_info.tx_rate.nss);
+  EXPECT_EQ(80u, station_info.tx_rate.width_mhz);
+  EXPECT_EQ(60u, station_info.rx_rate.bitrate);
+  EXPECT_EQ(-1, station_info.rx_rate.mcs);
+  EXPECT_EQ(20u, station_info.rx_rate.width_mhz);
+}
+
 TEST_F(NetlinkUtilsTest, SkipsPseudoDevicesWhenGetInterfaces) {
   // This might be a psuedo p2p interface without any interface index/name
   // attributes.
@@ -478,6 +596,41 @@ TEST_F(NetlinkUtilsTest, CanGetWiphyInfoScanPlanNotSupported) {
   VerifyWiphyFeatures(wiphy_features);
 }
 
+TEST_F(NetlinkUtilsTest, CanGetWiphyInfoExtFeaturesNotSupported) {
+  NL80211Packet new_wiphy(
+      netlink_manager_->GetFamilyId(),
+      NL80211_CMD_NEW_WIPHY,
+      netlink_manager_->GetSequenceNumber(),
+      getpid());
+  new_wiphy.AddAttribute(NL80211Attr<uint32_t>(NL80211_ATTR_WIPHY,
+                                               kFakeWiphyIndex));
+
+  AppendBandInfoAttributes(&new_wiphy);
+  AppendScanCapabilitiesAttributes(&new_wiphy, true);
+  // Kernels predating NL80211_ATTR_EXT_FEATURES only report feature flags.
+  new_wiphy.AddAttribute(NL80211Attr<uint32_t>(
+      NL80211_ATTR_FEATURE_FLAGS,
+      NL80211_FEATURE_SCAN_RANDOM_MAC_ADDR));
+
+  vector<NL80211Packet> response = {new_wiphy};
+
+  EXPECT_CALL(*netlink_manager_, SendMessageAndGetResponses(_, _)).
+      WillOnce(DoAll(MakeupResponse(response), Return(true)));
+
+  BandInfo band_info;
+  ScanCapabilities scan_capabilities;
+  WiphyFeatures wiphy_features;
+  EXPECT_TRUE(netlink_utils_->GetWiphyInfo(kFakeWiphyIndex,
+                                           &band_info,
+                                           &scan_capabilities,
+                                           &wiphy_features));
+  EXPECT_TRUE(wiphy_features.supports_random_mac_oneshot_scan);
+  EXPECT_FALSE(wiphy_features.supports_low_span_oneshot_scan);
+  EXPECT_FALSE(wiphy_features.supports_low_power_oneshot_scan);
+  EXPECT_FALSE(wiphy_features.supports_high_accuracy_oneshot_scan);
+  EXPECT_FALSE(wiphy_features.supports_scan_dwell);
+}
+
 
 TEST_F(NetlinkUtilsTest, CanHandleGetWiphyInfoError) {
   // Mock an error response from kernel.
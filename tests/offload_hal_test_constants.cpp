@@ -33,6 +33,8 @@ const uint64_t kTsf = 0;
 const uint16_t kCapability = 0;
 const uint8_t kNetworkFlags = 0;
 const uint32_t kDisconnectedModeScanIntervalMs = 5000;
+// Lets OffloadScanManager adapt the subscription delay to the scan interval.
+const uint32_t kAdaptiveSubscriptionDelayMs = 0;
 const uint64_t kSubscriptionDurationMs = 10000;
 const uint64_t kScanDurationMs[2] = {2000, 500};
 const uint32_t kNumChannelsScanned[2] = {14, 6};
@@ -37,6 +37,7 @@ extern const uint64_t kTsf;
 extern const uint16_t kCapability;
 extern const uint8_t kNetworkFlags;
 extern const uint32_t kDisconnectedModeScanIntervalMs;
+extern const uint32_t kAdaptiveSubscriptionDelayMs;
 extern const uint64_t kSubscriptionDurationMs;
 extern const uint64_t kScanDurationMs[2];
 extern const uint32_t kNumChannelsScanned[2];
@@ -142,6 +142,141 @@ TEST_F(OffloadScanManagerTest, BinderDeathRegisteredCookieAndService) {
             offload_scan_manager_->getOffloadStatus());
 }
 
+/**
+ * Testing OffloadScanManager reconnects to the Offload HAL with exponential
+ * backoff after its binder death, and restores the scans requested before
+ */
+TEST_F(OffloadScanManagerTest, ReconnectAfterBinderDeathRestoresScans) {
+  vector<std::function<void()>> tasks;
+  vector<int64_t> delays;
+  ON_CALL(*mock_offload_service_utils_, PostDelayedTask(_, _))
+      .WillByDefault(Invoke([&tasks, &delays](
+          const std::function<void()>& task, int64_t delay_ms) {
+        tasks.push_back(task);
+        delays.push_back(delay_ms);
+        return true;
+      }));
+  ON_CALL(*mock_offload_service_utils_, GetOffloadService())
+      .WillByDefault(testing::Return(mock_offload_));
+  offload_scan_manager_.reset(new OffloadScanManager(
+      mock_offload_service_utils_, mock_offload_scan_callback_interface_));
+  OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
+  EXPECT_TRUE(offload_scan_manager_->startScan(
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code));
+
+  EXPECT_CALL(*mock_offload_scan_callback_interface_,
+              OnOffloadError(OffloadScanCallbackInterface::BINDER_DEATH));
+  death_recipient_->serviceDied(cookie_, mock_offload_);
+  ASSERT_EQ(1u, tasks.size());
+  EXPECT_EQ(1000, delays[0]);
+
+  // The service is not back yet: back off.
+  ON_CALL(*mock_offload_service_utils_, GetOffloadService())
+      .WillByDefault(testing::Return(nullptr));
+  tasks[0]();
+  ASSERT_EQ(2u, tasks.size());
+  EXPECT_EQ(2000, delays[1]);
+  tasks[1]();
+  ASSERT_EQ(3u, tasks.size());
+  EXPECT_EQ(4000, delays[2]);
+
+  ON_CALL(*mock_offload_service_utils_, GetOffloadService())
+      .WillByDefault(testing::Return(mock_offload_));
+  EXPECT_CALL(*mock_offload_, configureScans(_, _, _));
+  EXPECT_CALL(*mock_offload_, subscribeScanResults(_, _));
+  EXPECT_CALL(*mock_offload_scan_callback_interface_, OnOffloadScanRestored());
+  tasks[2]();
+  EXPECT_EQ(3u, tasks.size());
+  EXPECT_EQ(OffloadScanManager::kNoError,
+            offload_scan_manager_->getOffloadStatus());
+
+  OffloadReconnectStats stats = offload_scan_manager_->getReconnectStats();
+  EXPECT_EQ(1u, stats.num_service_deaths);
+  EXPECT_EQ(3u, stats.num_reconnect_attempts);
+  EXPECT_EQ(1u, stats.num_reconnects);
+  EXPECT_EQ(0u, stats.num_restore_failures);
+}
+
+/**
+ * Testing OffloadScanManager does not restore scans stopped while the
+ * Offload HAL was dead, and that pending reconnects outlive it safely
+ */
+TEST_F(OffloadScanManagerTest, ReconnectAfterBinderDeathSkipsStoppedScans) {
+  vector<std::function<void()>> tasks;
+  ON_CALL(*mock_offload_service_utils_, PostDelayedTask(_, _))
+      .WillByDefault(Invoke([&tasks](const std::function<void()>& task,
+                                     int64_t delay_ms) {
+        tasks.push_back(task);
+        return true;
+      }));
+  ON_CALL(*mock_offload_service_utils_, GetOffloadService())
+      .WillByDefault(testing::Return(mock_offload_));
+  offload_scan_manager_.reset(new OffloadScanManager(
+      mock_offload_service_utils_, mock_offload_scan_callback_interface_));
+  OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
+  EXPECT_TRUE(offload_scan_manager_->startScan(
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code));
+  death_recipient_->serviceDied(cookie_, mock_offload_);
+  ON_CALL(*mock_offload_service_utils_, GetOffloadService())
+      .WillByDefault(testing::Return(nullptr));
+  EXPECT_FALSE(offload_scan_manager_->stopScan(&reason_code));
+
+  ON_CALL(*mock_offload_service_utils_, GetOffloadService())
+      .WillByDefault(testing::Return(mock_offload_));
+  EXPECT_CALL(*mock_offload_, configureScans(_, _, _)).Times(0);
+  EXPECT_CALL(*mock_offload_scan_callback_interface_, OnOffloadScanRestored())
+      .Times(0);
+  ASSERT_EQ(1u, tasks.size());
+  tasks[0]();
+  EXPECT_EQ(1u, offload_scan_manager_->getReconnectStats().num_reconnects);
+
+  death_recipient_->serviceDied(cookie_, mock_offload_);
+  ASSERT_EQ(2u, tasks.size());
+  offload_scan_manager_.reset();
+  tasks[1]();
+}
+
+/**
+ * Testing OffloadScanManager samples the scan statistics periodically while
+ * scans are requested, and stops sampling once they are stopped
+ */
+TEST_F(OffloadScanManagerTest, SamplesScanStatsWhileScansAreRequested) {
+  vector<std::function<void()>> tasks;
+  ON_CALL(*mock_offload_service_utils_, GetScanStatsSamplingPeriodMs())
+      .WillByDefault(testing::Return(60000));
+  EXPECT_CALL(*mock_offload_service_utils_, PostDelayedTask(_, 60000))
+      .Times(2)
+      .WillRepeatedly(Invoke([&tasks](const std::function<void()>& task,
+                                      int64_t delay_ms) {
+        tasks.push_back(task);
+        return true;
+      }));
+  ON_CALL(*mock_offload_service_utils_, GetOffloadService())
+      .WillByDefault(testing::Return(mock_offload_));
+  offload_scan_manager_.reset(new OffloadScanManager(
+      mock_offload_service_utils_, mock_offload_scan_callback_interface_));
+  OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
+  EXPECT_TRUE(offload_scan_manager_->startScan(
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code));
+  EXPECT_TRUE(offload_scan_manager_->getScanStatsHistory().empty());
+
+  EXPECT_CALL(*mock_offload_, getScanStats(_));
+  ASSERT_EQ(1u, tasks.size());
+  tasks[0]();
+  EXPECT_EQ(1u, offload_scan_manager_->getScanStatsHistory().size());
+
+  EXPECT_TRUE(offload_scan_manager_->stopScan(&reason_code));
+  ASSERT_EQ(2u, tasks.size());
+  tasks[1]();
+  EXPECT_EQ(1u, offload_scan_manager_->getScanStatsHistory().size());
+}
+
 /**
  * Testing OffloadScanManager for binder death with invalid cookie
  */
@@ -206,6 +341,29 @@ TEST_F(OffloadScanManagerTest, CallbackInvokedTest) {
   offload_callback_->onScanResult(dummy_scan_results_);
 }
 
+/**
+ * Testing OffloadScanManager publishes the scan results from Offload HAL as a
+ * new snapshot, without changing the snapshots already handed out
+ */
+TEST_F(OffloadScanManagerTest, ScanResultSnapshotTest) {
+  ON_CALL(*mock_offload_service_utils_, GetOffloadService())
+      .WillByDefault(testing::Return(mock_offload_));
+  offload_scan_manager_.reset(new OffloadScanManager(
+      mock_offload_service_utils_, mock_offload_scan_callback_interface_));
+  ScanResultSnapshot empty_snapshot =
+      offload_scan_manager_->getScanResultSnapshot();
+  vector<ScanResult> dummy_scan_results_ =
+      OffloadTestUtils::createOffloadScanResults();
+  offload_callback_->onScanResult(dummy_scan_results_);
+
+  EXPECT_TRUE(empty_snapshot->empty());
+  ScanResultSnapshot snapshot = offload_scan_manager_->getScanResultSnapshot();
+  EXPECT_EQ(dummy_scan_results_.size(), snapshot->size());
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(offload_scan_manager_->getScanResults(&scan_results));
+  EXPECT_EQ(snapshot->size(), scan_results.size());
+}
+
 /**
  * Testing OffloadScanManager when service is available and valid handler
  * is registered, ensure that error callback is invoked
@@ -243,7 +401,8 @@ TEST_F(OffloadScanManagerTest, StartScanTestWhenServiceIsOk) {
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
       kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code);
   EXPECT_EQ(result, true);
 }
 
@@ -260,7 +419,8 @@ TEST_F(OffloadScanManagerTest, StartScanTestWhenServiceIsNotAvailable) {
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
       kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code);
   EXPECT_EQ(result, false);
   EXPECT_EQ(reason_code, OffloadScanManager::kNotAvailable);
 }
@@ -283,7 +443,8 @@ TEST_F(OffloadScanManagerTest, StartScanTestWhenServiceIsNotConnected) {
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
       kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code);
   EXPECT_EQ(result, false);
   EXPECT_EQ(reason_code, OffloadScanManager::kNotAvailable);
 }
@@ -300,16 +461,20 @@ TEST_F(OffloadScanManagerTest, StartScanTwiceTestWhenServiceIsOk) {
       .WillByDefault(testing::Return(mock_offload_));
   offload_scan_manager_.reset(new OffloadScanManager(
       mock_offload_service_utils_, mock_offload_scan_callback_interface_));
-  EXPECT_CALL(*mock_offload_, subscribeScanResults(_, _)).Times(2);
+  // The second scans replace the first ones in place, under the same
+  // subscription.
+  EXPECT_CALL(*mock_offload_, subscribeScanResults(_, _)).Times(1);
   EXPECT_CALL(*mock_offload_, configureScans(_, _, _)).Times(2);
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
       kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code);
   EXPECT_EQ(result, true);
   result = offload_scan_manager_->startScan(
       kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code);
   EXPECT_EQ(result, true);
 }
 
@@ -331,7 +496,8 @@ TEST_F(OffloadScanManagerTest, StopScanTestWhenServiceIsOk) {
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
       kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code);
   EXPECT_EQ(result, true);
   result = offload_scan_manager_->stopScan(&reason_code);
   EXPECT_EQ(result, true);
@@ -353,7 +519,8 @@ TEST_F(OffloadScanManagerTest, StopScanTestWhenServiceIsNotConnectedAnymore) {
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
       kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code);
   EXPECT_EQ(result, true);
   OffloadStatus status =
       OffloadTestUtils::createOffloadStatus(OffloadStatusCode::NO_CONNECTION);
@@ -419,7 +586,8 @@ TEST_F(OffloadScanManagerTest, StartScanFailedTest) {
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
       kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code);
   EXPECT_EQ(result, false);
   EXPECT_EQ(reason_code, OffloadScanManager::kOperationFailed);
 }
@@ -443,5 +611,89 @@ TEST_F(OffloadScanManagerTest, getScanStatsFailedTest) {
   EXPECT_EQ(result, false);
 }
 
+/**
+ * Testing OffloadScanManager subscribes to scan results with a short delay,
+ * and backs the delay off once scan results are reported
+ */
+TEST_F(OffloadScanManagerTest, SubscriptionDelayBacksOffAfterScanResults) {
+  ON_CALL(*mock_offload_service_utils_, GetOffloadService())
+      .WillByDefault(testing::Return(mock_offload_));
+  offload_scan_manager_.reset(new OffloadScanManager(
+      mock_offload_service_utils_, mock_offload_scan_callback_interface_));
+  EXPECT_CALL(*mock_offload_, subscribeScanResults(
+                                  SubscriptionDelayPolicy::kInitialDelayMs, _));
+  OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
+  EXPECT_TRUE(offload_scan_manager_->startScan(
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code));
+
+  uint32_t backed_off_delay_ms = SubscriptionDelayPolicy::kInitialDelayMs *
+                                 SubscriptionDelayPolicy::kBackoffFactor;
+  EXPECT_CALL(*mock_offload_, subscribeScanResults(backed_off_delay_ms, _));
+  offload_callback_->onScanResult(OffloadTestUtils::createOffloadScanResults());
+
+  OffloadSubscriptionStats stats =
+      offload_scan_manager_->getSubscriptionStats();
+  EXPECT_EQ(2u, stats.num_subscriptions);
+  EXPECT_EQ(1u, stats.num_result_reports);
+  EXPECT_EQ(1u, stats.num_first_reports);
+  EXPECT_EQ(backed_off_delay_ms, stats.current_delay_ms);
+}
+
+/**
+ * Testing OffloadScanManager keeps the subscription delay of the request
+ */
+TEST_F(OffloadScanManagerTest, RequestedSubscriptionDelayIsKept) {
+  const uint32_t kRequestedDelayMs = 3000;
+  ON_CALL(*mock_offload_service_utils_, GetOffloadService())
+      .WillByDefault(testing::Return(mock_offload_));
+  offload_scan_manager_.reset(new OffloadScanManager(
+      mock_offload_service_utils_, mock_offload_scan_callback_interface_));
+  EXPECT_CALL(*mock_offload_, subscribeScanResults(kRequestedDelayMs, _));
+  OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
+  EXPECT_TRUE(offload_scan_manager_->startScan(
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
+      security_flags, frequencies, kRequestedDelayMs, &reason_code));
+  offload_callback_->onScanResult(OffloadTestUtils::createOffloadScanResults());
+  EXPECT_EQ(1u, offload_scan_manager_->getSubscriptionStats().num_subscriptions);
+}
+
+/**
+ * Testing OffloadScanManager updates running scans at the same interval
+ * without subscribing again
+ */
+TEST_F(OffloadScanManagerTest, ScanUpdateKeepsSubscription) {
+  ON_CALL(*mock_offload_service_utils_, GetOffloadService())
+      .WillByDefault(testing::Return(mock_offload_));
+  offload_scan_manager_.reset(new OffloadScanManager(
+      mock_offload_service_utils_, mock_offload_scan_callback_interface_));
+  EXPECT_CALL(*mock_offload_, configureScans(_, _, _)).Times(3);
+  EXPECT_CALL(*mock_offload_, subscribeScanResults(_, _)).Times(2);
+  OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
+  EXPECT_TRUE(offload_scan_manager_->startScan(
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
+      security_flags, frequencies, kAdaptiveSubscriptionDelayMs,
+      &reason_code));
+  vector<vector<uint8_t>> updated_match_ssids{match_ssids[0]};
+  vector<uint8_t> updated_security_flags{kNetworkFlags};
+  EXPECT_TRUE(offload_scan_manager_->startScan(
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids,
+      updated_match_ssids, updated_security_flags, frequencies,
+      kAdaptiveSubscriptionDelayMs, &reason_code));
+  EXPECT_EQ(1u,
+            offload_scan_manager_->getSubscriptionStats().num_in_place_updates);
+
+  // A new interval changes the delay to subscribe with.
+  EXPECT_TRUE(offload_scan_manager_->startScan(
+      kDisconnectedModeScanIntervalMs * 2, kRssiThreshold, scan_ssids,
+      updated_match_ssids, updated_security_flags, frequencies,
+      kAdaptiveSubscriptionDelayMs, &reason_code));
+  OffloadSubscriptionStats stats =
+      offload_scan_manager_->getSubscriptionStats();
+  EXPECT_EQ(2u, stats.num_subscriptions);
+  EXPECT_EQ(1u, stats.num_in_place_updates);
+}
+
 }  // namespace wificond
 }  // namespace android
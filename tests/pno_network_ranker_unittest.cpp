@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/pno_network.h"
+#include "wificond/scanning/pno_network_ranker.h"
+#include "wificond/scanning/scan_result.h"
+
+using ::com::android::server::wifi::wificond::NativeScanResult;
+using ::com::android::server::wifi::wificond::PnoNetwork;
+using std::set;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+constexpr int64_t kFakeNowMs = 100 * 60 * 60 * 1000;
+constexpr int64_t kOneHourMs = 60 * 60 * 1000;
+
+PnoNetwork CreatePnoNetwork(char name, bool is_hidden) {
+  PnoNetwork network;
+  network.ssid_ = {'N', 'e', 't', static_cast<uint8_t>(name)};
+  network.is_hidden_ = is_hidden;
+  return network;
+}
+
+NativeScanResult CreateScanResult(const vector<uint8_t>& ssid) {
+  NativeScanResult result;
+  result.ssid = ssid;
+  return result;
+}
+
+}  // namespace
+
+class PnoNetworkRankerTest : public ::testing::Test {
+ protected:
+  PnoNetworkRanker ranker_;
+};
+
+TEST_F(PnoNetworkRankerTest, SelectsAllNetworksInRankOrderIfTheyFit) {
+  vector<PnoNetwork> networks = {CreatePnoNetwork('A', false),
+                                 CreatePnoNetwork('B', false),
+                                 CreatePnoNetwork('C', true)};
+  networks[1].last_connected_age_ms_ = kOneHourMs;
+
+  EXPECT_EQ(vector<size_t>({1, 2, 0}),
+            ranker_.SelectNetworks(networks, 3, 1, kFakeNowMs, true));
+}
+
+TEST_F(PnoNetworkRankerTest, RecentConnectionsAndSightingsScoreHigher) {
+  PnoNetwork recently_connected = CreatePnoNetwork('A', false);
+  recently_connected.last_connected_age_ms_ = 0;
+  PnoNetwork long_ago_connected = CreatePnoNetwork('B', false);
+  long_ago_connected.last_connected_age_ms_ = 48 * kOneHourMs;
+  PnoNetwork never_connected = CreatePnoNetwork('C', false);
+  EXPECT_GT(ranker_.GetScore(recently_connected, kFakeNowMs),
+            ranker_.GetScore(long_ago_connected, kFakeNowMs));
+  EXPECT_GT(ranker_.GetScore(long_ago_connected, kFakeNowMs),
+            ranker_.GetScore(never_connected, kFakeNowMs));
+
+  double score_before_sighting = ranker_.GetScore(never_connected, kFakeNowMs);
+  ranker_.OnScanResults({CreateScanResult(never_connected.ssid_)},
+                        kFakeNowMs - kOneHourMs);
+  double score_after_sighting = ranker_.GetScore(never_connected, kFakeNowMs);
+  EXPECT_GT(score_after_sighting, score_before_sighting);
+  // The sighting fades over time.
+  EXPECT_GT(score_after_sighting,
+            ranker_.GetScore(never_connected, kFakeNowMs + 24 * kOneHourMs));
+}
+
+TEST_F(PnoNetworkRankerTest, RotatesOverflowIntoReservedSlots) {
+  vector<PnoNetwork> networks;
+  for (char name = 'A'; name < 'K'; name++) {
+    networks.push_back(CreatePnoNetwork(name, false));
+  }
+  networks[9].last_connected_age_ms_ = 0;
+
+  // 8 slots for 10 networks: 6 fixed slots and 2 rotating ones.
+  set<size_t> covered;
+  for (int window = 0; window < 2; window++) {
+    vector<size_t> selected =
+        ranker_.SelectNetworks(networks, 8, 0, kFakeNowMs, true);
+    ASSERT_EQ(8u, selected.size());
+    EXPECT_EQ(9u, selected[0]);
+    covered.insert(selected.begin(), selected.end());
+  }
+  EXPECT_EQ(10u, covered.size());
+}
+
+TEST_F(PnoNetworkRankerTest, KeepsRotationWindowUnlessAdvanced) {
+  vector<PnoNetwork> networks;
+  for (char name = 'A'; name < 'K'; name++) {
+    networks.push_back(CreatePnoNetwork(name, false));
+  }
+
+  vector<size_t> selected =
+      ranker_.SelectNetworks(networks, 8, 0, kFakeNowMs, false);
+  EXPECT_EQ(selected,
+            ranker_.SelectNetworks(networks, 8, 0, kFakeNowMs, true));
+  EXPECT_NE(selected,
+            ranker_.SelectNetworks(networks, 8, 0, kFakeNowMs, true));
+}
+
+TEST_F(PnoNetworkRankerTest, RotatesHiddenNetworksBeyondHiddenLimit) {
+  vector<PnoNetwork> networks = {CreatePnoNetwork('A', true),
+                                 CreatePnoNetwork('B', true),
+                                 CreatePnoNetwork('C', true),
+                                 CreatePnoNetwork('D', false)};
+
+  set<size_t> covered;
+  for (int window = 0; window < 3; window++) {
+    vector<size_t> selected =
+        ranker_.SelectNetworks(networks, 4, 1, kFakeNowMs, true);
+    uint32_t num_hidden = 0;
+    for (size_t index : selected) {
+      if (networks[index].is_hidden_) {
+        num_hidden++;
+      }
+    }
+    EXPECT_EQ(1u, num_hidden);
+    covered.insert(selected.begin(), selected.end());
+  }
+  EXPECT_EQ(4u, covered.size());
+}
+
+TEST_F(PnoNetworkRankerTest, SelectsNothingWithoutMatchSets) {
+  vector<PnoNetwork> networks = {CreatePnoNetwork('A', false)};
+  EXPECT_TRUE(ranker_.SelectNetworks(networks, 0, 0, kFakeNowMs, true).empty());
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/scan_plan_generator.h"
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+constexpr uint32_t kFakeFastIntervalMs = 10000;
+constexpr uint32_t kFakeSlowIntervalMs = 160000;
+constexpr uint32_t kFakeIterationsPerPlan = 3;
+
+ScanPlanGenerator::Config CreateConfig() {
+  ScanPlanGenerator::Config config;
+  config.fast_interval_ms = kFakeFastIntervalMs;
+  config.slow_interval_ms = kFakeSlowIntervalMs;
+  config.backoff_factor = 2;
+  config.iterations_per_plan = kFakeIterationsPerPlan;
+  return config;
+}
+
+ScanCapabilities CreateScanCapabilities(uint32_t max_num_scan_plans,
+                                        uint32_t max_scan_plan_interval,
+                                        uint32_t max_scan_plan_iterations) {
+  return ScanCapabilities(0 /* max_num_scan_ssids */,
+                          0 /* max_num_sched_scan_ssids */,
+                          0 /* max_match_sets */,
+                          max_num_scan_plans,
+                          max_scan_plan_interval,
+                          max_scan_plan_iterations);
+}
+
+}  // namespace
+
+TEST(ScanPlanGeneratorTest, GeneratesExponentialBackoff) {
+  ScanPlanGenerator generator(CreateScanCapabilities(8, 3600, 100));
+  SchedScanIntervalSetting interval_setting =
+      generator.Generate(CreateConfig());
+
+  ASSERT_EQ(4u, interval_setting.plans.size());
+  EXPECT_EQ(10000u, interval_setting.plans[0].interval_ms);
+  EXPECT_EQ(20000u, interval_setting.plans[1].interval_ms);
+  EXPECT_EQ(40000u, interval_setting.plans[2].interval_ms);
+  EXPECT_EQ(80000u, interval_setting.plans[3].interval_ms);
+  for (const auto& plan : interval_setting.plans) {
+    EXPECT_EQ(kFakeIterationsPerPlan, plan.n_iterations);
+  }
+  EXPECT_EQ(kFakeSlowIntervalMs, interval_setting.final_interval_ms);
+  EXPECT_TRUE(generator.IsValid(interval_setting));
+}
+
+TEST(ScanPlanGeneratorTest, FitsScanPlansToCapabilities) {
+  // 3 plans in total, intervals up to 60 seconds and 2 iterations per plan.
+  ScanPlanGenerator generator(CreateScanCapabilities(3, 60, 2));
+  SchedScanIntervalSetting interval_setting =
+      generator.Generate(CreateConfig());
+
+  ASSERT_EQ(2u, interval_setting.plans.size());
+  EXPECT_EQ(10000u, interval_setting.plans[0].interval_ms);
+  EXPECT_EQ(20000u, interval_setting.plans[1].interval_ms);
+  EXPECT_EQ(2u, interval_setting.plans[0].n_iterations);
+  EXPECT_EQ(60000u, interval_setting.final_interval_ms);
+  EXPECT_TRUE(generator.IsValid(interval_setting));
+}
+
+TEST(ScanPlanGeneratorTest, GeneratesSingleIntervalWithoutScanPlanSupport) {
+  ScanPlanGenerator generator(CreateScanCapabilities(0, 0, 0));
+  SchedScanIntervalSetting interval_setting =
+      generator.Generate(CreateConfig());
+
+  EXPECT_TRUE(interval_setting.plans.empty());
+  EXPECT_EQ(kFakeFastIntervalMs, interval_setting.final_interval_ms);
+  EXPECT_TRUE(generator.IsValid(interval_setting));
+}
+
+TEST(ScanPlanGeneratorTest, RejectsScanPlansExceedingCapabilities) {
+  ScanPlanGenerator generator(CreateScanCapabilities(2, 60, 2));
+  EXPECT_FALSE(generator.IsValid(
+      SchedScanIntervalSetting{{{10000, 2}, {20000, 2}}, 40000}));
+  EXPECT_FALSE(generator.IsValid(
+      SchedScanIntervalSetting{{{10000, 3}}, 40000}));
+  EXPECT_FALSE(generator.IsValid(
+      SchedScanIntervalSetting{{{500, 2}}, 40000}));
+  EXPECT_FALSE(generator.IsValid(
+      SchedScanIntervalSetting{{{10000, 2}}, 120000}));
+  EXPECT_TRUE(generator.IsValid(
+      SchedScanIntervalSetting{{{10000, 2}}, 60000}));
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/scan_result_delta_tracker.h"
+
+using ::com::android::server::wifi::wificond::NativeScanResult;
+using ::com::android::server::wifi::wificond::ScanResultDelta;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const vector<uint8_t> kFakeBssid = {0x45, 0x54, 0xad, 0x67, 0x98, 0xf6};
+const vector<uint8_t> kFakeBssid1 = {0x45, 0x54, 0xad, 0x67, 0x98, 0xf7};
+const vector<uint8_t> kFakeIE = {0x05, 0x11, 0x32, 0x11};
+constexpr uint32_t kFakeFrequency = 5240;
+constexpr int32_t kFakeSignalMbm = -5000;
+
+NativeScanResult CreateScanResult(const vector<uint8_t>& bssid,
+                                  int32_t signal_mbm) {
+  NativeScanResult result;
+  result.bssid = bssid;
+  result.info_element = kFakeIE;
+  result.frequency = kFakeFrequency;
+  result.signal_mbm = signal_mbm;
+  result.tsf = 0;
+  result.capability = 0;
+  result.associated = false;
+  return result;
+}
+
+}  // namespace
+
+class ScanResultDeltaTrackerTest : public ::testing::Test {
+ protected:
+  ScanResultDeltaTracker tracker_;
+};
+
+TEST_F(ScanResultDeltaTrackerTest, ReportsNewBssAsAdded) {
+  ScanResultDelta delta =
+      tracker_.Update({CreateScanResult(kFakeBssid, kFakeSignalMbm)});
+  ASSERT_EQ(1u, delta.added_.size());
+  EXPECT_EQ(kFakeBssid, delta.added_[0].bssid);
+  EXPECT_TRUE(delta.updated_.empty());
+  EXPECT_TRUE(delta.lost_bssids_.empty());
+
+  // Nothing changed.
+  EXPECT_TRUE(
+      tracker_.Update({CreateScanResult(kFakeBssid, kFakeSignalMbm)}).empty());
+}
+
+TEST_F(ScanResultDeltaTrackerTest, ReportsInfoElementChangeOnHashCollision) {
+  // Both vendor specific elements have the same FNV-1a hash.
+  NativeScanResult result = CreateScanResult(kFakeBssid, kFakeSignalMbm);
+  result.info_element = {0xdd, 0x06, 0xbe, 0x6d, 0x47, 0x00, 0x39, 0x62};
+  tracker_.Update({result});
+  result.info_element = {0xdd, 0x06, 0xc7, 0x4c, 0x77, 0xef, 0xef, 0xad};
+  ScanResultDelta delta = tracker_.Update({result});
+  ASSERT_EQ(1u, delta.updated_.size());
+  EXPECT_EQ(result.info_element, delta.updated_[0].info_element);
+}
+
+TEST_F(ScanResultDeltaTrackerTest, ReportsSignalChangesBeyondThreshold) {
+  tracker_.Update({CreateScanResult(kFakeBssid, kFakeSignalMbm)});
+  const int32_t kSmallStep =
+      ScanResultDeltaTracker::kSignalChangeThresholdMbm / 2;
+  EXPECT_TRUE(tracker_.Update(
+      {CreateScanResult(kFakeBssid, kFakeSignalMbm + kSmallStep)}).empty());
+
+  // Small steps add up against the last reported signal.
+  ScanResultDelta delta = tracker_.Update(
+      {CreateScanResult(kFakeBssid, kFakeSignalMbm + 2 * kSmallStep)});
+  ASSERT_EQ(1u, delta.updated_.size());
+  EXPECT_EQ(kFakeSignalMbm + 2 * kSmallStep, delta.updated_[0].signal_mbm);
+}
+
+TEST_F(ScanResultDeltaTrackerTest, ReportsInfoElementChanges) {
+  tracker_.Update({CreateScanResult(kFakeBssid, kFakeSignalMbm)});
+  NativeScanResult changed = CreateScanResult(kFakeBssid, kFakeSignalMbm);
+  changed.info_element.push_back(0x00);
+  EXPECT_EQ(1u, tracker_.Update({changed}).updated_.size());
+}
+
+TEST_F(ScanResultDeltaTrackerTest, ReportsAgedOutBssAsLost) {
+  tracker_.Update({CreateScanResult(kFakeBssid, kFakeSignalMbm),
+                   CreateScanResult(kFakeBssid1, kFakeSignalMbm)});
+  ScanResultDelta delta =
+      tracker_.Update({CreateScanResult(kFakeBssid1, kFakeSignalMbm)});
+  EXPECT_TRUE(delta.added_.empty());
+  EXPECT_TRUE(delta.updated_.empty());
+  EXPECT_EQ(vector<vector<uint8_t>>({kFakeBssid}), delta.lost_bssids_);
+  EXPECT_EQ(1u, tracker_.GetNumTrackedBss());
+}
+
+TEST_F(ScanResultDeltaTrackerTest, ReportsEverythingAsAddedAfterReset) {
+  tracker_.Update({CreateScanResult(kFakeBssid, kFakeSignalMbm)});
+  tracker_.Reset();
+  EXPECT_EQ(1u, tracker_.Update(
+      {CreateScanResult(kFakeBssid, kFakeSignalMbm)}).added_.size());
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/scan_result.h"
+#include "wificond/scanning/scan_result_shared_memory.h"
+
+using ::com::android::server::wifi::wificond::NativeScanResult;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const uint8_t kFakeSsid[] =
+    {'G', 'o', 'o', 'g', 'l', 'e', 'G', 'u', 'e', 's', 't'};
+const uint8_t kFakeBssid[] = {0x45, 0x54, 0xad, 0x67, 0x98, 0xf6};
+const uint8_t kFakeIE[] = {0x05, 0x11, 0x32, 0x11, 0x07};
+constexpr uint32_t kFakeFrequency = 5240;
+constexpr int32_t kFakeSignalMbm = -3200;
+constexpr uint64_t kFakeTsf = 1200;
+constexpr uint16_t kFakeCapability = 0x0411;
+constexpr bool kFakeAssociated = true;
+
+NativeScanResult CreateFakeScanResult(uint32_t frequency) {
+  vector<uint8_t> ssid(kFakeSsid, kFakeSsid + sizeof(kFakeSsid));
+  vector<uint8_t> bssid(kFakeBssid, kFakeBssid + sizeof(kFakeBssid));
+  vector<uint8_t> ie(kFakeIE, kFakeIE + sizeof(kFakeIE));
+  return NativeScanResult(ssid, bssid, ie, frequency, kFakeSignalMbm,
+                          kFakeTsf, kFakeCapability, kFakeAssociated);
+}
+
+void ExpectSameScanResult(const NativeScanResult& expected,
+                          const NativeScanResult& actual) {
+  EXPECT_EQ(expected.ssid, actual.ssid);
+  EXPECT_EQ(expected.bssid, actual.bssid);
+  EXPECT_EQ(expected.info_element, actual.info_element);
+  EXPECT_EQ(expected.frequency, actual.frequency);
+  EXPECT_EQ(expected.signal_mbm, actual.signal_mbm);
+  EXPECT_EQ(expected.tsf, actual.tsf);
+  EXPECT_EQ(expected.capability, actual.capability);
+  EXPECT_EQ(expected.associated, actual.associated);
+}
+
+}  // namespace
+
+class ScanResultSharedMemoryTest : public ::testing::Test {
+ protected:
+  ScanResultSharedMemory shared_memory_;
+};
+
+TEST_F(ScanResultSharedMemoryTest, SerializeAndDeserialize) {
+  vector<NativeScanResult> scan_results = {CreateFakeScanResult(2412),
+                                           CreateFakeScanResult(5180)};
+  vector<uint8_t> data;
+  ScanResultSharedMemory::Serialize(scan_results, &data);
+  EXPECT_EQ(0u, data.size() % 8);
+
+  vector<NativeScanResult> scan_results_copy;
+  EXPECT_TRUE(ScanResultSharedMemory::Deserialize(
+      data.data(), data.size(), &scan_results_copy));
+  ASSERT_EQ(scan_results.size(), scan_results_copy.size());
+  for (size_t i = 0; i < scan_results.size(); i++) {
+    ExpectSameScanResult(scan_results[i], scan_results_copy[i]);
+  }
+}
+
+TEST_F(ScanResultSharedMemoryTest, RejectsTruncatedBuffer) {
+  vector<uint8_t> data;
+  ScanResultSharedMemory::Serialize({CreateFakeScanResult(2412)}, &data);
+  vector<NativeScanResult> scan_results;
+  EXPECT_FALSE(ScanResultSharedMemory::Deserialize(
+      data.data(), data.size() - 8, &scan_results));
+}
+
+TEST_F(ScanResultSharedMemoryTest, PublishesSealedRegion) {
+  vector<NativeScanResult> scan_results = {CreateFakeScanResult(2412)};
+  int fd = -1;
+  ASSERT_TRUE(shared_memory_.Update(scan_results, &fd));
+  ASSERT_GE(fd, 0);
+
+  off_t size = lseek(fd, 0, SEEK_END);
+  ASSERT_GT(size, 0);
+  // The region must not be writable by anyone.
+  EXPECT_EQ(MAP_FAILED,
+            mmap(nullptr, size, PROT_WRITE, MAP_SHARED, fd, 0));
+  void* region = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ASSERT_NE(MAP_FAILED, region);
+  vector<NativeScanResult> scan_results_copy;
+  EXPECT_TRUE(ScanResultSharedMemory::Deserialize(
+      static_cast<const uint8_t*>(region), size, &scan_results_copy));
+  munmap(region, size);
+  ASSERT_EQ(1u, scan_results_copy.size());
+  ExpectSameScanResult(scan_results[0], scan_results_copy[0]);
+}
+
+TEST_F(ScanResultSharedMemoryTest, ReusesRegionWhenResultsAreUnchanged) {
+  vector<NativeScanResult> scan_results = {CreateFakeScanResult(2412)};
+  int fd = -1;
+  ASSERT_TRUE(shared_memory_.Update(scan_results, &fd));
+  int reused_fd = -1;
+  ASSERT_TRUE(shared_memory_.Update(scan_results, &reused_fd));
+  EXPECT_EQ(fd, reused_fd);
+  EXPECT_EQ(1u, shared_memory_.GetReuseCount());
+
+  scan_results.push_back(CreateFakeScanResult(5180));
+  int new_fd = -1;
+  ASSERT_TRUE(shared_memory_.Update(scan_results, &new_fd));
+  EXPECT_EQ(1u, shared_memory_.GetReuseCount());
+  vector<NativeScanResult> scan_results_copy;
+  off_t size = lseek(new_fd, 0, SEEK_END);
+  void* region = mmap(nullptr, size, PROT_READ, MAP_SHARED, new_fd, 0);
+  ASSERT_NE(MAP_FAILED, region);
+  EXPECT_TRUE(ScanResultSharedMemory::Deserialize(
+      static_cast<const uint8_t*>(region), size, &scan_results_copy));
+  munmap(region, size);
+  EXPECT_EQ(2u, scan_results_copy.size());
+}
+
+}  // namespace wificond
+}  // namespace android
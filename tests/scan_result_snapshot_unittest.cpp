@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/scan_result.h"
+#include "wificond/scanning/scan_result_snapshot.h"
+
+using ::com::android::server::wifi::wificond::NativeScanResult;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const uint8_t kFakeSsid[] =
+    {'G', 'o', 'o', 'g', 'l', 'e', 'G', 'u', 'e', 's', 't'};
+const uint8_t kFakeBssid[] = {0x45, 0x54, 0xad, 0x67, 0x98, 0xf6};
+constexpr int32_t kFakeSignalMbm = -3200;
+constexpr uint64_t kFakeTsf = 1200;
+constexpr uint16_t kFakeCapability = 0x0411;
+constexpr int kNumPublishes = 1000;
+
+NativeScanResult CreateFakeScanResult(uint32_t frequency) {
+  vector<uint8_t> ssid(kFakeSsid, kFakeSsid + sizeof(kFakeSsid));
+  vector<uint8_t> bssid(kFakeBssid, kFakeBssid + sizeof(kFakeBssid));
+  vector<uint8_t> ie;
+  return NativeScanResult(ssid, bssid, ie, frequency, kFakeSignalMbm, kFakeTsf,
+                          kFakeCapability, false);
+}
+
+}  // namespace
+
+class ScanResultSnapshotTest : public ::testing::Test {
+ protected:
+  ScanResultSnapshotCache cache_;
+};
+
+TEST_F(ScanResultSnapshotTest, StartsEmpty) {
+  ScanResultSnapshot snapshot = cache_.Get();
+  ASSERT_NE(nullptr, snapshot);
+  EXPECT_TRUE(snapshot->empty());
+}
+
+TEST_F(ScanResultSnapshotTest, PublishAndGet) {
+  cache_.Publish({CreateFakeScanResult(2412), CreateFakeScanResult(5180)});
+  ScanResultSnapshot snapshot = cache_.Get();
+  ASSERT_EQ(2u, snapshot->size());
+  EXPECT_EQ(2412u, (*snapshot)[0].frequency);
+  EXPECT_EQ(5180u, (*snapshot)[1].frequency);
+  // Getting the same snapshot again does not copy it.
+  EXPECT_EQ(snapshot, cache_.Get());
+}
+
+TEST_F(ScanResultSnapshotTest, HeldSnapshotSurvivesPublish) {
+  cache_.Publish({CreateFakeScanResult(2412)});
+  ScanResultSnapshot old_snapshot = cache_.Get();
+  cache_.Publish({CreateFakeScanResult(5180), CreateFakeScanResult(5200)});
+
+  ASSERT_EQ(1u, old_snapshot->size());
+  EXPECT_EQ(2412u, (*old_snapshot)[0].frequency);
+  EXPECT_EQ(2u, cache_.Get()->size());
+}
+
+TEST_F(ScanResultSnapshotTest, Clear) {
+  cache_.Publish({CreateFakeScanResult(2412)});
+  ScanResultSnapshot old_snapshot = cache_.Get();
+  cache_.Clear();
+  EXPECT_TRUE(cache_.Get()->empty());
+  EXPECT_EQ(1u, old_snapshot->size());
+}
+
+TEST_F(ScanResultSnapshotTest, ReadersNeverSeePartialSnapshot) {
+  std::thread writer([this]() {
+    for (int i = 1; i <= kNumPublishes; i++) {
+      // Every published snapshot has |i| results on frequency |i|.
+      cache_.Publish(vector<NativeScanResult>(i, CreateFakeScanResult(i)));
+    }
+  });
+  for (int i = 0; i < kNumPublishes; i++) {
+    ScanResultSnapshot snapshot = cache_.Get();
+    for (const NativeScanResult& scan_result : *snapshot) {
+      ASSERT_EQ(snapshot->size(), scan_result.frequency);
+    }
+  }
+  writer.join();
+  EXPECT_EQ(static_cast<size_t>(kNumPublishes), cache_.Get()->size());
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -19,8 +19,10 @@
 #include <gtest/gtest.h>
 
 #include "wificond/scanning/scan_result.h"
+#include "wificond/scanning/scan_result_delta.h"
 
 using ::com::android::server::wifi::wificond::NativeScanResult;
+using ::com::android::server::wifi::wificond::ScanResultDelta;
 using std::vector;
 
 namespace android {
@@ -68,5 +70,30 @@ TEST_F(ScanResultTest, ParcelableTest) {
   EXPECT_EQ(kFakeAssociated, scan_result_copy.associated);
 }
 
+TEST_F(ScanResultTest, DeltaParcelableTest) {
+  std::vector<uint8_t> ssid(kFakeSsid, kFakeSsid + sizeof(kFakeSsid));
+  std::vector<uint8_t> bssid(kFakeBssid, kFakeBssid + sizeof(kFakeBssid));
+  std::vector<uint8_t> ie(kFakeIE, kFakeIE + sizeof(kFakeIE));
+  NativeScanResult scan_result(ssid, bssid, ie, kFakeFrequency,
+      kFakeSignalMbm, kFakeTsf, kFakeCapability, kFakeAssociated);
+
+  ScanResultDelta delta;
+  delta.updated_.push_back(scan_result);
+  delta.lost_bssids_.push_back(bssid);
+  EXPECT_FALSE(delta.empty());
+  Parcel parcel;
+  EXPECT_EQ(::android::OK, delta.writeToParcel(&parcel));
+
+  ScanResultDelta delta_copy;
+  parcel.setDataPosition(0);
+  EXPECT_EQ(::android::OK, delta_copy.readFromParcel(&parcel));
+
+  EXPECT_TRUE(delta_copy.added_.empty());
+  ASSERT_EQ(1u, delta_copy.updated_.size());
+  EXPECT_EQ(bssid, delta_copy.updated_[0].bssid);
+  EXPECT_EQ(kFakeSignalMbm, delta_copy.updated_[0].signal_mbm);
+  EXPECT_EQ(vector<vector<uint8_t>>({bssid}), delta_copy.lost_bssids_);
+}
+
 }  // namespace wificond
 }  // namespace android
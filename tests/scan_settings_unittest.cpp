@@ -18,16 +18,22 @@
 
 #include <gtest/gtest.h>
 
+#include "android/net/wifi/IWifiScannerImpl.h"
 #include "wificond/scanning/channel_settings.h"
 #include "wificond/scanning/hidden_network.h"
 #include "wificond/scanning/pno_network.h"
 #include "wificond/scanning/pno_settings.h"
+#include "wificond/scanning/scan_result_filter.h"
+#include "wificond/scanning/scan_result_projection.h"
 #include "wificond/scanning/single_scan_settings.h"
 
+using ::android::net::wifi::IWifiScannerImpl;
 using ::com::android::server::wifi::wificond::ChannelSettings;
 using ::com::android::server::wifi::wificond::HiddenNetwork;
 using ::com::android::server::wifi::wificond::PnoNetwork;
 using ::com::android::server::wifi::wificond::PnoSettings;
+using ::com::android::server::wifi::wificond::ScanResultFilter;
+using ::com::android::server::wifi::wificond::ScanResultProjection;
 using ::com::android::server::wifi::wificond::SingleScanSettings;
 using std::vector;
 
@@ -44,11 +50,21 @@ const uint8_t kFakeSsid1[] =
 constexpr int32_t kFakePnoIntervalMs = 20000;
 constexpr int32_t kFakePnoMin2gRssi = -80;
 constexpr int32_t kFakePnoMin5gRssi = -85;
+constexpr int32_t kFakeSubscriptionDelayMs = 3000;
 
 constexpr uint32_t kFakeFrequency = 5260;
 constexpr uint32_t kFakeFrequency1 = 2460;
 constexpr uint32_t kFakeFrequency2 = 2500;
 
+constexpr int32_t kFakeDwellTimeMs = 40;
+constexpr int32_t kFakeScanDeadlineMs = 500;
+
+constexpr int32_t kFakeMinSignalMbm = -7000;
+constexpr int64_t kFakeMaxAgeMs = 30000;
+constexpr int64_t kFakeMinTimestampUs = 123456789;
+constexpr int32_t kFakeMaxResults = 10;
+constexpr int32_t kFakeElementIdRsn = 48;
+
 }  // namespace
 
 class ScanSettingsTest : public ::testing::Test {
@@ -95,6 +111,12 @@ TEST_F(ScanSettingsTest, SingleScanSettingsParcelableTest) {
   network.ssid_ =
       vector<uint8_t>(kFakeSsid, kFakeSsid + sizeof(kFakeSsid));
 
+  scan_settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY;
+  scan_settings.dwell_time_ms_ = kFakeDwellTimeMs;
+  scan_settings.flush_cache_ = true;
+  scan_settings.full_hidden_network_coverage_ = true;
+  scan_settings.priority_ = IWifiScannerImpl::SCAN_PRIORITY_HIGH;
+  scan_settings.deadline_ms_ = kFakeScanDeadlineMs;
   scan_settings.channel_settings_ = {channel, channel1, channel2};
   scan_settings.hidden_networks_ = {network};
 
@@ -108,11 +130,33 @@ TEST_F(ScanSettingsTest, SingleScanSettingsParcelableTest) {
   EXPECT_EQ(scan_settings, scan_settings_copy);
 }
 
+TEST_F(ScanSettingsTest, SingleScanSettingsRejectsInvalidScanType) {
+  SingleScanSettings scan_settings;
+  scan_settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY + 1;
+
+  Parcel parcel;
+  EXPECT_NE(::android::OK, scan_settings.writeToParcel(&parcel));
+
+  parcel.writeInt32(IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY + 1);
+  parcel.setDataPosition(0);
+  SingleScanSettings scan_settings_copy;
+  EXPECT_NE(::android::OK, scan_settings_copy.readFromParcel(&parcel));
+}
+
+TEST_F(ScanSettingsTest, SingleScanSettingsRejectsInvalidPriority) {
+  SingleScanSettings scan_settings;
+  scan_settings.priority_ = IWifiScannerImpl::SCAN_PRIORITY_HIGH + 1;
+
+  Parcel parcel;
+  EXPECT_NE(::android::OK, scan_settings.writeToParcel(&parcel));
+}
+
 TEST_F(ScanSettingsTest, PnoNetworkParcelableTest) {
   PnoNetwork pno_network;
   pno_network.ssid_ =
       vector<uint8_t>(kFakeSsid, kFakeSsid + sizeof(kFakeSsid));
   pno_network.is_hidden_ = true;
+  pno_network.last_connected_age_ms_ = 3600000;
 
   Parcel parcel;
   EXPECT_EQ(::android::OK, pno_network.writeToParcel(&parcel));
@@ -138,6 +182,7 @@ TEST_F(ScanSettingsTest, PnoSettingsParcelableTest) {
   pno_settings.interval_ms_ = kFakePnoIntervalMs;
   pno_settings.min_2g_rssi_ = kFakePnoMin2gRssi;
   pno_settings.min_5g_rssi_ = kFakePnoMin5gRssi;
+  pno_settings.offload_subscription_delay_ms_ = kFakeSubscriptionDelayMs;
 
   pno_settings.pno_networks_ = {network, network1};
 
@@ -151,6 +196,41 @@ TEST_F(ScanSettingsTest, PnoSettingsParcelableTest) {
   EXPECT_EQ(pno_settings, pno_settings_copy);
 }
 
+TEST_F(ScanSettingsTest, ScanResultFilterParcelableTest) {
+  ScanResultFilter filter;
+  filter.min_signal_mbm_ = kFakeMinSignalMbm;
+  filter.frequencies_ = {kFakeFrequency, kFakeFrequency1};
+  filter.max_age_ms_ = kFakeMaxAgeMs;
+  filter.min_timestamp_us_ = kFakeMinTimestampUs;
+  filter.ssids_ = {vector<uint8_t>(kFakeSsid, kFakeSsid + sizeof(kFakeSsid)),
+                   vector<uint8_t>(kFakeSsid1, kFakeSsid1 + sizeof(kFakeSsid1))};
+  filter.max_results_ = kFakeMaxResults;
+
+  Parcel parcel;
+  EXPECT_EQ(::android::OK, filter.writeToParcel(&parcel));
+
+  ScanResultFilter filter_copy;
+  parcel.setDataPosition(0);
+  EXPECT_EQ(::android::OK, filter_copy.readFromParcel(&parcel));
+
+  EXPECT_EQ(filter, filter_copy);
+}
+
+TEST_F(ScanSettingsTest, ScanResultProjectionParcelableTest) {
+  ScanResultProjection projection;
+  projection.omit_info_elements_ = false;
+  projection.info_element_ids_ = {0, kFakeElementIdRsn};
+
+  Parcel parcel;
+  EXPECT_EQ(::android::OK, projection.writeToParcel(&parcel));
+
+  ScanResultProjection projection_copy;
+  parcel.setDataPosition(0);
+  EXPECT_EQ(::android::OK, projection_copy.readFromParcel(&parcel));
+
+  EXPECT_EQ(projection, projection_copy);
+}
+
 
 
 }  // namespace wificond
@@ -38,6 +38,7 @@ TEST_F(ScanStatsTest, ParcelableTest) {
                                 kDefaultNumScansServicedByWifi,
                                 kScanDurationTotalMs, kSubscriptionDurationMs,
                                 kNumChannelsTotalScanned, histogram_channels);
+  scan_stats_in.time_stamp_ = 3600;
   Parcel parcel;
   EXPECT_EQ(::android::OK, scan_stats_in.writeToParcel(&parcel));
   NativeScanStats scan_stats_out;
@@ -46,5 +47,20 @@ TEST_F(ScanStatsTest, ParcelableTest) {
   EXPECT_TRUE(scan_stats_in == scan_stats_out);
 }
 
+TEST_F(ScanStatsTest, DerivedRates) {
+  // 8 of 10 scans serviced over 2 hours, scanning 40 channels in 36 s.
+  NativeScanStats scan_stats(10, 8, 2 * 3600 * 1000, 36000, 40, {});
+  EXPECT_DOUBLE_EQ(4.0, scan_stats.GetScansPerHour());
+  EXPECT_DOUBLE_EQ(5.0, scan_stats.GetChannelsPerScan());
+  EXPECT_DOUBLE_EQ(0.005, scan_stats.GetDutyCycle());
+  EXPECT_DOUBLE_EQ(0.8, scan_stats.GetServicedRatio());
+
+  NativeScanStats empty_scan_stats;
+  EXPECT_EQ(0, empty_scan_stats.GetScansPerHour());
+  EXPECT_EQ(0, empty_scan_stats.GetChannelsPerScan());
+  EXPECT_EQ(0, empty_scan_stats.GetDutyCycle());
+  EXPECT_EQ(0, empty_scan_stats.GetServicedRatio());
+}
+
 }  // namespace wificond
 }  // namespace android
@@ -22,8 +22,12 @@
 #include <linux/nl80211.h>
 
 #include <gtest/gtest.h>
+#include <utils/Timers.h>
 
+#include "android/net/wifi/IWifiScannerImpl.h"
 #include "wificond/scanning/scan_result.h"
+#include "wificond/scanning/scan_result_filter.h"
+#include "wificond/scanning/scan_result_projection.h"
 #include "wificond/scanning/scan_utils.h"
 #include "wificond/tests/mock_netlink_manager.h"
 
@@ -33,13 +37,18 @@ using std::placeholders::_2;
 using std::unique_ptr;
 using std::vector;
 using testing::AllOf;
+using testing::DoAll;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Not;
 using testing::Return;
+using testing::SaveArg;
 using testing::_;
 
+using android::net::wifi::IWifiScannerImpl;
 using com::android::server::wifi::wificond::NativeScanResult;
+using com::android::server::wifi::wificond::ScanResultFilter;
+using com::android::server::wifi::wificond::ScanResultProjection;
 
 namespace android {
 namespace wificond {
@@ -51,7 +60,13 @@ constexpr uint32_t kFakeScheduledScanIntervalMs = 20000;
 constexpr uint32_t kFakeSequenceNumber = 1984;
 constexpr int kFakeErrorCode = EIO;
 constexpr int32_t kFakeRssiThreshold = -80;
+constexpr int32_t kFakeRssiThreshold2g = -75;
 constexpr bool kFakeUseRandomMAC = true;
+constexpr uint16_t kFakeFamilyId = 14;
+constexpr uint32_t kFakeMaxScanResultAgeMs = 60000;
+constexpr uint8_t kElemIdSsid = 0;
+constexpr uint8_t kElemIdSupportedRates = 1;
+constexpr uint8_t kElemIdRsn = 48;
 
 // Currently, control messages are only created by the kernel and sent to us.
 // Therefore NL80211Packet doesn't have corresponding constructor.
@@ -90,6 +105,55 @@ bool AppendMessageAndReturn(
   return mock_return_value;
 }
 
+SchedScanReqFlags CreateSchedScanReqFlags(bool request_random_mac) {
+  SchedScanReqFlags req_flags;
+  req_flags.request_random_mac = request_random_mac;
+  return req_flags;
+}
+
+// Creates a NL80211_CMD_NEW_SCAN_RESULTS packet for one BSS, as found in the
+// response to NL80211_CMD_GET_SCAN.
+// The information elements of the BSS contain an SSID element with |ssid|,
+// followed by a supported rates element and a RSN element.
+NL80211Packet CreateNewScanResultPacket(uint8_t bssid_last_byte,
+                                        uint32_t frequency,
+                                        int32_t signal_mbm,
+                                        uint64_t last_seen_ns,
+                                        const vector<uint8_t>& ssid,
+                                        bool has_boottime = true) {
+  NL80211Packet packet(
+      kFakeFamilyId,
+      NL80211_CMD_NEW_SCAN_RESULTS,
+      kFakeSequenceNumber,
+      getpid());
+  packet.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_ATTR_IFINDEX, kFakeInterfaceIndex));
+
+  vector<uint8_t> ie = {kElemIdSsid, static_cast<uint8_t>(ssid.size())};
+  ie.insert(ie.end(), ssid.begin(), ssid.end());
+  ie.insert(ie.end(), {kElemIdSupportedRates, 1, 0x82});
+  ie.insert(ie.end(), {kElemIdRsn, 2, 0x01, 0x00});
+
+  NL80211NestedAttr bss(NL80211_ATTR_BSS);
+  bss.AddAttribute(NL80211Attr<vector<uint8_t>>(
+      NL80211_BSS_BSSID, {0x12, 0x34, 0x56, 0x78, 0x9a, bssid_last_byte}));
+  bss.AddAttribute(NL80211Attr<uint32_t>(NL80211_BSS_FREQUENCY, frequency));
+  bss.AddAttribute(
+      NL80211Attr<vector<uint8_t>>(NL80211_BSS_INFORMATION_ELEMENTS, ie));
+  if (has_boottime) {
+    bss.AddAttribute(
+        NL80211Attr<uint64_t>(NL80211_BSS_LAST_SEEN_BOOTTIME, last_seen_ns));
+  } else {
+    // Drivers without boot time stamps only report the TSF of the AP.
+    bss.AddAttribute(NL80211Attr<uint64_t>(NL80211_BSS_TSF, last_seen_ns));
+  }
+  bss.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_BSS_SIGNAL_MBM, signal_mbm));
+  bss.AddAttribute(NL80211Attr<uint16_t>(NL80211_BSS_CAPABILITY, 0x0411));
+  packet.AddAttribute(bss);
+  return packet;
+}
+
 }  // namespace
 
 class ScanUtilsTest : public ::testing::Test {
@@ -113,6 +177,26 @@ MATCHER_P(DoesNL80211PacketHaveAttribute, attr,
   return arg.HasAttribute(attr);
 }
 
+MATCHER_P2(DoesNL80211PacketHaveAttributeWithUint32Value, attr, expected_value,
+           "Check if the netlink packet has atttribute |attr| with "
+           "|expected_value|") {
+  uint32_t actual_value;
+  if (!arg.GetAttributeValue(attr, &actual_value)) {
+    return false;
+  }
+  return actual_value == expected_value;
+}
+
+MATCHER_P2(DoesNL80211PacketHaveAttributeWithUint16Value, attr, expected_value,
+           "Check if the netlink packet has atttribute |attr| with "
+           "|expected_value|") {
+  uint16_t actual_value;
+  if (!arg.GetAttributeValue(attr, &actual_value)) {
+    return false;
+  }
+  return actual_value == expected_value;
+}
+
 TEST_F(ScanUtilsTest, CanGetScanResult) {
   vector<NativeScanResult> scan_results;
   EXPECT_CALL(
@@ -128,6 +212,206 @@ TEST_F(ScanUtilsTest, CanGetScanResult) {
   scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results);
 }
 
+TEST_F(ScanUtilsTest, CanFilterScanResults) {
+  const vector<uint8_t> kSsid = {'G', 'u', 'e', 's', 't'};
+  const vector<uint8_t> kOtherSsid = {'H', 'o', 'm', 'e'};
+  vector<NL80211Packet> dump = {
+      // Accepted.
+      CreateNewScanResultPacket(1, 2412, -5000, 2000000, kSsid),
+      // Too weak.
+      CreateNewScanResultPacket(2, 2412, -9000, 2000000, kSsid),
+      // Unwanted frequency.
+      CreateNewScanResultPacket(3, 5180, -5000, 2000000, kSsid),
+      // Too old.
+      CreateNewScanResultPacket(4, 2412, -5000, 500000, kSsid),
+      // Unwanted SSID.
+      CreateNewScanResultPacket(5, 2412, -5000, 2000000, kOtherSsid),
+      // Unknown age, since only the TSF is reported.
+      CreateNewScanResultPacket(6, 2412, -5000, 500000, kSsid, false)};
+  ON_CALL(netlink_manager_, GetFamilyId()).WillByDefault(Return(kFakeFamilyId));
+  EXPECT_CALL(
+      netlink_manager_,
+      SendMessageAndGetResponses(
+          DoesNL80211PacketMatchCommand(NL80211_CMD_GET_SCAN), _))
+      .WillOnce(Invoke([&dump](
+          const NL80211Packet& request,
+          vector<unique_ptr<const NL80211Packet>>* response) {
+        for (const auto& packet : dump) {
+          response->push_back(std::make_unique<NL80211Packet>(packet));
+        }
+        return true;
+      }));
+
+  ScanResultFilter filter;
+  filter.min_signal_mbm_ = -8000;
+  filter.frequencies_ = {2412, 2437};
+  filter.min_timestamp_us_ = 1000;
+  filter.ssids_ = {kSsid};
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetFilteredScanResult(
+      kFakeInterfaceIndex, filter, ScanResultProjection(), &scan_results));
+  ASSERT_EQ(2u, scan_results.size());
+  EXPECT_EQ(1, scan_results[0].bssid.back());
+  EXPECT_EQ(kSsid, scan_results[0].ssid);
+  EXPECT_EQ(6, scan_results[1].bssid.back());
+}
+
+TEST_F(ScanUtilsTest, CanDropStaleScanResultsAndRecordDumpStats) {
+  const vector<uint8_t> kSsid = {'G', 'u', 'e', 's', 't'};
+  const uint64_t now_ns = systemTime(SYSTEM_TIME_BOOTTIME);
+  vector<NL80211Packet> dump = {
+      CreateNewScanResultPacket(1, 2412, -5000, now_ns - 1000000000, kSsid),
+      // Last seen 10 minutes ago.
+      CreateNewScanResultPacket(2, 2412, -5000, now_ns - 600000000000,
+                                kSsid)};
+  ON_CALL(netlink_manager_, GetFamilyId()).WillByDefault(Return(kFakeFamilyId));
+  EXPECT_CALL(netlink_manager_, SendMessageAndGetResponses(_, _))
+      .WillOnce(Invoke([&dump](
+          const NL80211Packet& request,
+          vector<unique_ptr<const NL80211Packet>>* response) {
+        for (const auto& packet : dump) {
+          response->push_back(std::make_unique<NL80211Packet>(packet));
+        }
+        return true;
+      }));
+
+  scan_utils_.SetMaxScanResultAge(kFakeMaxScanResultAgeMs);
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+  ASSERT_EQ(1u, scan_results.size());
+  EXPECT_EQ(1, scan_results[0].bssid.back());
+
+  ScanResultDumpStats stats =
+      scan_utils_.GetScanResultDumpStats(kFakeInterfaceIndex);
+  EXPECT_EQ(1u, stats.num_dumps);
+  EXPECT_EQ(2u, stats.last_num_bss);
+  EXPECT_EQ(2u, stats.max_num_bss);
+  EXPECT_EQ(2u, stats.total_num_bss);
+  EXPECT_EQ(1u, stats.total_num_stale_bss);
+  EXPECT_EQ(dump[0].GetConstData().size() + dump[1].GetConstData().size(),
+            stats.last_num_bytes);
+}
+
+TEST_F(ScanUtilsTest, CanKeepScanResultsWithoutBootTimeUnderMaxAge) {
+  const vector<uint8_t> kSsid = {'G', 'u', 'e', 's', 't'};
+  // A small TSF, which would be stale if it were a boot time stamp.
+  vector<NL80211Packet> dump = {
+      CreateNewScanResultPacket(1, 2412, -5000, 1000, kSsid, false)};
+  ON_CALL(netlink_manager_, GetFamilyId()).WillByDefault(Return(kFakeFamilyId));
+  EXPECT_CALL(netlink_manager_, SendMessageAndGetResponses(_, _))
+      .WillOnce(Invoke([&dump](
+          const NL80211Packet& request,
+          vector<unique_ptr<const NL80211Packet>>* response) {
+        for (const auto& packet : dump) {
+          response->push_back(std::make_unique<NL80211Packet>(packet));
+        }
+        return true;
+      }));
+
+  scan_utils_.SetMaxScanResultAge(kFakeMaxScanResultAgeMs);
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+  ASSERT_EQ(1u, scan_results.size());
+  EXPECT_EQ(1, scan_results[0].bssid.back());
+
+  ScanResultDumpStats stats =
+      scan_utils_.GetScanResultDumpStats(kFakeInterfaceIndex);
+  EXPECT_EQ(1u, stats.total_num_bss);
+  EXPECT_EQ(0u, stats.total_num_stale_bss);
+  EXPECT_EQ(1u, stats.total_num_unknown_age_bss);
+}
+
+TEST_F(ScanUtilsTest, CanLimitScanResultsToStrongest) {
+  const vector<uint8_t> kSsid = {'G', 'u', 'e', 's', 't'};
+  vector<NL80211Packet> dump = {
+      CreateNewScanResultPacket(1, 2412, -7000, 2000000, kSsid),
+      CreateNewScanResultPacket(2, 2412, -4000, 2000000, kSsid),
+      CreateNewScanResultPacket(3, 5180, -8000, 2000000, kSsid),
+      CreateNewScanResultPacket(4, 5180, -5000, 2000000, kSsid)};
+  ON_CALL(netlink_manager_, GetFamilyId()).WillByDefault(Return(kFakeFamilyId));
+  EXPECT_CALL(netlink_manager_, SendMessageAndGetResponses(_, _))
+      .WillOnce(Invoke([&dump](
+          const NL80211Packet& request,
+          vector<unique_ptr<const NL80211Packet>>* response) {
+        for (const auto& packet : dump) {
+          response->push_back(std::make_unique<NL80211Packet>(packet));
+        }
+        return true;
+      }));
+
+  ScanResultFilter filter;
+  filter.max_results_ = 2;
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetFilteredScanResult(
+      kFakeInterfaceIndex, filter, ScanResultProjection(), &scan_results));
+  ASSERT_EQ(2u, scan_results.size());
+  EXPECT_EQ(-4000, scan_results[0].signal_mbm);
+  EXPECT_EQ(-5000, scan_results[1].signal_mbm);
+}
+
+TEST_F(ScanUtilsTest, CutsWeakScanResultsBeforeParsingThem) {
+  const vector<uint8_t> kSsid = {'G', 'u', 'e', 's', 't'};
+  vector<NL80211Packet> dump = {
+      CreateNewScanResultPacket(1, 2412, -4000, 2000000, kSsid),
+      CreateNewScanResultPacket(2, 2412, -5000, 2000000, kSsid),
+      // Its age would be checked after its signal.
+      CreateNewScanResultPacket(3, 5180, -8000, 1000, kSsid, false)};
+  ON_CALL(netlink_manager_, GetFamilyId()).WillByDefault(Return(kFakeFamilyId));
+  EXPECT_CALL(netlink_manager_, SendMessageAndGetResponses(_, _))
+      .WillOnce(Invoke([&dump](
+          const NL80211Packet& request,
+          vector<unique_ptr<const NL80211Packet>>* response) {
+        for (const auto& packet : dump) {
+          response->push_back(std::make_unique<NL80211Packet>(packet));
+        }
+        return true;
+      }));
+
+  ScanResultFilter filter;
+  filter.max_results_ = 2;
+  filter.min_timestamp_us_ = 1;
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetFilteredScanResult(
+      kFakeInterfaceIndex, filter, ScanResultProjection(), &scan_results));
+  ASSERT_EQ(2u, scan_results.size());
+  EXPECT_EQ(-4000, scan_results[0].signal_mbm);
+  EXPECT_EQ(-5000, scan_results[1].signal_mbm);
+
+  ScanResultDumpStats stats =
+      scan_utils_.GetScanResultDumpStats(kFakeInterfaceIndex);
+  EXPECT_EQ(3u, stats.last_num_bss);
+  EXPECT_EQ(0u, stats.total_num_unknown_age_bss);
+}
+
+TEST_F(ScanUtilsTest, CanProjectInformationElements) {
+  const vector<uint8_t> kSsid = {'G', 'u', 'e', 's', 't'};
+  NL80211Packet packet =
+      CreateNewScanResultPacket(1, 2412, -5000, 2000000, kSsid);
+  ON_CALL(netlink_manager_, GetFamilyId()).WillByDefault(Return(kFakeFamilyId));
+  EXPECT_CALL(netlink_manager_, SendMessageAndGetResponses(_, _))
+      .Times(2)
+      .WillRepeatedly(Invoke(bind(
+          AppendMessageAndReturn, packet, true, _1, _2)));
+
+  ScanResultProjection projection;
+  projection.info_element_ids_ = {kElemIdSsid, kElemIdRsn};
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetFilteredScanResult(
+      kFakeInterfaceIndex, ScanResultFilter(), projection, &scan_results));
+  ASSERT_EQ(1u, scan_results.size());
+  vector<uint8_t> expected_ie = {kElemIdSsid, 5, 'G', 'u', 'e', 's', 't',
+                                 kElemIdRsn, 2, 0x01, 0x00};
+  EXPECT_EQ(expected_ie, scan_results[0].info_element);
+
+  projection.omit_info_elements_ = true;
+  scan_results.clear();
+  EXPECT_TRUE(scan_utils_.GetFilteredScanResult(
+      kFakeInterfaceIndex, ScanResultFilter(), projection, &scan_results));
+  ASSERT_EQ(1u, scan_results.size());
+  EXPECT_TRUE(scan_results[0].info_element.empty());
+  EXPECT_EQ(kSsid, scan_results[0].ssid);
+}
+
 TEST_F(ScanUtilsTest, CanSendScanRequest) {
   NL80211Packet response = CreateControlMessageAck();
   EXPECT_CALL(
@@ -138,8 +422,9 @@ TEST_F(ScanUtilsTest, CanSendScanRequest) {
                   AppendMessageAndReturn, response, true, _1, _2)));
 
   int errno_ignored;
-  EXPECT_TRUE(scan_utils_.Scan(kFakeInterfaceIndex, kFakeUseRandomMAC, {}, {},
-                               &errno_ignored));
+  EXPECT_TRUE(scan_utils_.Scan(kFakeInterfaceIndex, kFakeUseRandomMAC,
+                               IWifiScannerImpl::SCAN_TYPE_DEFAULT, 0, false,
+                               {}, {}, &errno_ignored));
   // TODO(b/34231420): Add validation of requested scan ssids, threshold,
   // and frequencies.
 }
@@ -153,11 +438,102 @@ TEST_F(ScanUtilsTest, CanHandleScanRequestFailure) {
               WillOnce(Invoke(bind(
                   AppendMessageAndReturn, response, true, _1, _2)));
   int error_code;
-  EXPECT_FALSE(scan_utils_.Scan(kFakeInterfaceIndex, kFakeUseRandomMAC, {}, {},
-                                &error_code));
+  EXPECT_FALSE(scan_utils_.Scan(kFakeInterfaceIndex, kFakeUseRandomMAC,
+                                IWifiScannerImpl::SCAN_TYPE_DEFAULT, 0, false,
+                                {}, {}, &error_code));
   EXPECT_EQ(kFakeErrorCode, error_code);
 }
 
+TEST_F(ScanUtilsTest, CanSendAsyncScanRequest) {
+  std::function<void(unique_ptr<const NL80211Packet>)> response_handler;
+  EXPECT_CALL(
+      netlink_manager_,
+      RegisterHandlerAndSendMessage(
+          DoesNL80211PacketMatchCommand(NL80211_CMD_TRIGGER_SCAN), _)).
+              WillOnce(DoAll(SaveArg<1>(&response_handler), Return(true)));
+  EXPECT_CALL(netlink_manager_, SendMessageAndGetResponses(_, _)).Times(0);
+  int handled_error_code = -1;
+  scan_utils_.SubscribeScanTriggerNotification(
+      kFakeInterfaceIndex,
+      [&handled_error_code](uint32_t interface_index, int error_code,
+                            uint64_t cookie) {
+        handled_error_code = error_code;
+      });
+
+  EXPECT_TRUE(scan_utils_.ScanAsync(kFakeInterfaceIndex, kFakeUseRandomMAC,
+                                    IWifiScannerImpl::SCAN_TYPE_DEFAULT, 0,
+                                    false, {}, {}));
+  // The kernel answer is passed on to the subscribed handler.
+  response_handler(unique_ptr<const NL80211Packet>(
+      new NL80211Packet(CreateControlMessageError(kFakeErrorCode))));
+  EXPECT_EQ(kFakeErrorCode, handled_error_code);
+}
+
+TEST_F(ScanUtilsTest, CanSendScanRequestWithScanTypeAndDwellTime) {
+  NL80211Packet response = CreateControlMessageAck();
+  EXPECT_CALL(
+      netlink_manager_,
+      SendMessageAndGetResponses(
+          AllOf(
+              DoesNL80211PacketMatchCommand(NL80211_CMD_TRIGGER_SCAN),
+              DoesNL80211PacketHaveAttributeWithUint32Value(
+                  NL80211_ATTR_SCAN_FLAGS,
+                  static_cast<uint32_t>(NL80211_SCAN_FLAG_RANDOM_ADDR |
+                                        NL80211_SCAN_FLAG_LOW_SPAN)),
+              // 30 ms is 29 TUs.
+              DoesNL80211PacketHaveAttributeWithUint16Value(
+                  NL80211_ATTR_MEASUREMENT_DURATION,
+                  static_cast<uint16_t>(29))),
+          _)).
+              WillOnce(Invoke(bind(
+                  AppendMessageAndReturn, response, true, _1, _2)));
+
+  int errno_ignored;
+  EXPECT_TRUE(scan_utils_.Scan(kFakeInterfaceIndex, kFakeUseRandomMAC,
+                               IWifiScannerImpl::SCAN_TYPE_LOW_SPAN, 30, false,
+                               {}, {}, &errno_ignored));
+}
+
+TEST_F(ScanUtilsTest, DoesNotSetScanFlagsOrDwellTimeByDefault) {
+  NL80211Packet response = CreateControlMessageAck();
+  EXPECT_CALL(
+      netlink_manager_,
+      SendMessageAndGetResponses(
+          AllOf(
+              DoesNL80211PacketMatchCommand(NL80211_CMD_TRIGGER_SCAN),
+              Not(DoesNL80211PacketHaveAttribute(NL80211_ATTR_SCAN_FLAGS)),
+              Not(DoesNL80211PacketHaveAttribute(
+                  NL80211_ATTR_MEASUREMENT_DURATION))),
+          _)).
+              WillOnce(Invoke(bind(
+                  AppendMessageAndReturn, response, true, _1, _2)));
+
+  int errno_ignored;
+  EXPECT_TRUE(scan_utils_.Scan(kFakeInterfaceIndex, false,
+                               IWifiScannerImpl::SCAN_TYPE_DEFAULT, 0, false,
+                               {}, {}, &errno_ignored));
+}
+
+TEST_F(ScanUtilsTest, CanSendScanRequestWithFlushFlag) {
+  NL80211Packet response = CreateControlMessageAck();
+  EXPECT_CALL(
+      netlink_manager_,
+      SendMessageAndGetResponses(
+          AllOf(
+              DoesNL80211PacketMatchCommand(NL80211_CMD_TRIGGER_SCAN),
+              DoesNL80211PacketHaveAttributeWithUint32Value(
+                  NL80211_ATTR_SCAN_FLAGS,
+                  static_cast<uint32_t>(NL80211_SCAN_FLAG_FLUSH))),
+          _)).
+              WillOnce(Invoke(bind(
+                  AppendMessageAndReturn, response, true, _1, _2)));
+
+  int errno_ignored;
+  EXPECT_TRUE(scan_utils_.Scan(kFakeInterfaceIndex, false,
+                               IWifiScannerImpl::SCAN_TYPE_DEFAULT, 0, true,
+                               {}, {}, &errno_ignored));
+}
+
 TEST_F(ScanUtilsTest, CanSendSchedScanRequest) {
   NL80211Packet response = CreateControlMessageAck();
   EXPECT_CALL(
@@ -170,7 +546,8 @@ TEST_F(ScanUtilsTest, CanSendSchedScanRequest) {
   EXPECT_TRUE(scan_utils_.StartScheduledScan(
       kFakeInterfaceIndex,
       SchedScanIntervalSetting(),
-      kFakeRssiThreshold, kFakeUseRandomMAC, {}, {}, {}, &errno_ignored));
+      kFakeRssiThreshold, kFakeRssiThreshold,
+      CreateSchedScanReqFlags(kFakeUseRandomMAC), {}, {}, {}, &errno_ignored));
   // TODO(b/34231420): Add validation of requested scan ssids, threshold,
   // and frequencies.
 }
@@ -187,7 +564,8 @@ TEST_F(ScanUtilsTest, CanHandleSchedScanRequestFailure) {
   EXPECT_FALSE(scan_utils_.StartScheduledScan(
       kFakeInterfaceIndex,
       SchedScanIntervalSetting(),
-      kFakeRssiThreshold, kFakeUseRandomMAC, {}, {}, {}, &error_code));
+      kFakeRssiThreshold, kFakeRssiThreshold,
+      CreateSchedScanReqFlags(kFakeUseRandomMAC), {}, {}, {}, &error_code));
   EXPECT_EQ(kFakeErrorCode, error_code);
 }
 
@@ -209,7 +587,8 @@ TEST_F(ScanUtilsTest, CanSpecifyScanPlansForSchedScanRequest) {
   scan_utils_.StartScheduledScan(
       kFakeInterfaceIndex,
       interval_setting,
-      kFakeRssiThreshold, kFakeUseRandomMAC, {}, {}, {}, &errno_ignored);
+      kFakeRssiThreshold, kFakeRssiThreshold,
+      CreateSchedScanReqFlags(kFakeUseRandomMAC), {}, {}, {}, &errno_ignored);
 }
 
 TEST_F(ScanUtilsTest, CanSpecifySingleIntervalForSchedScanRequest) {
@@ -228,7 +607,54 @@ TEST_F(ScanUtilsTest, CanSpecifySingleIntervalForSchedScanRequest) {
   scan_utils_.StartScheduledScan(
       kFakeInterfaceIndex,
       interval_setting,
-      kFakeRssiThreshold, kFakeUseRandomMAC, {}, {}, {}, &errno_ignored);
+      kFakeRssiThreshold, kFakeRssiThreshold,
+      CreateSchedScanReqFlags(kFakeUseRandomMAC), {}, {}, {}, &errno_ignored);
+}
+
+TEST_F(ScanUtilsTest, CanSpecifyBandSpecificAndRelativeRssiForSchedScan) {
+  const vector<uint8_t> kSsid = {'G', 'u', 'e', 's', 't'};
+  vector<uint8_t> request_data;
+  EXPECT_CALL(
+      netlink_manager_,
+      SendMessageAndGetResponses(
+          AllOf(
+              DoesNL80211PacketMatchCommand(NL80211_CMD_START_SCHED_SCAN),
+              DoesNL80211PacketHaveAttribute(
+                  NL80211_ATTR_SCHED_SCAN_RELATIVE_RSSI),
+              DoesNL80211PacketHaveAttribute(
+                  NL80211_ATTR_SCHED_SCAN_RSSI_ADJUST)),
+          _))
+      .WillOnce(Invoke([&request_data](
+          const NL80211Packet& request_message,
+          vector<unique_ptr<const NL80211Packet>>* response) {
+        request_data = request_message.GetConstData();
+        return false;
+      }));
+  SchedScanReqFlags req_flags;
+  req_flags.request_band_specific_rssi = true;
+  req_flags.request_relative_rssi = true;
+  int errno_ignored;
+  scan_utils_.StartScheduledScan(
+      kFakeInterfaceIndex,
+      SchedScanIntervalSetting{{}, kFakeScheduledScanIntervalMs},
+      kFakeRssiThreshold2g, kFakeRssiThreshold, req_flags,
+      {}, {kSsid}, {}, &errno_ignored);
+
+  NL80211Packet request(request_data);
+  NL80211NestedAttr match_attr(0);
+  ASSERT_TRUE(request.GetAttribute(NL80211_ATTR_SCHED_SCAN_MATCH,
+                                   &match_attr));
+  NL80211NestedAttr match_group(0);
+  ASSERT_TRUE(match_attr.GetAttribute(0, &match_group));
+  NL80211NestedAttr per_band_rssi(0);
+  ASSERT_TRUE(match_group.GetAttribute(NL80211_SCHED_SCAN_MATCH_PER_BAND_RSSI,
+                                       &per_band_rssi));
+  int32_t rssi_2g = 0;
+  int32_t rssi_5g = 0;
+  EXPECT_TRUE(per_band_rssi.GetAttributeValue(NL80211_BAND_2GHZ, &rssi_2g));
+  EXPECT_TRUE(per_band_rssi.GetAttributeValue(NL80211_BAND_5GHZ, &rssi_5g));
+  EXPECT_EQ(kFakeRssiThreshold2g, rssi_2g);
+  EXPECT_EQ(kFakeRssiThreshold, rssi_5g);
 }
 
 TEST_F(ScanUtilsTest, CanPrioritizeLastSeenSinceBootNetlinkAttribute) {
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <unistd.h>
+
+#include <set>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -24,24 +27,40 @@
 #include "wificond/scanning/offload/offload_scan_utils.h"
 #include "wificond/scanning/scanner_impl.h"
 #include "wificond/tests/mock_client_interface_impl.h"
+#include "wificond/tests/mock_event_loop.h"
 #include "wificond/tests/mock_netlink_manager.h"
 #include "wificond/tests/mock_netlink_utils.h"
 #include "wificond/tests/mock_offload_scan_callback_interface_impl.h"
 #include "wificond/tests/mock_offload_scan_manager.h"
 #include "wificond/tests/mock_offload_service_utils.h"
+#include "wificond/tests/mock_scan_event.h"
+#include "wificond/tests/mock_scan_request_callback.h"
+#include "wificond/tests/mock_scan_result_delta_event.h"
 #include "wificond/tests/mock_scan_utils.h"
 #include "wificond/tests/offload_test_utils.h"
 
 using ::android::binder::Status;
+using ::android::net::wifi::IWifiScannerImpl;
 using ::android::wifi_system::MockInterfaceTool;
 using ::android::wifi_system::MockSupplicantManager;
+using ::com::android::server::wifi::wificond::ChannelSettings;
+using ::com::android::server::wifi::wificond::HiddenNetwork;
 using ::com::android::server::wifi::wificond::SingleScanSettings;
+using ::com::android::server::wifi::wificond::PnoNetwork;
 using ::com::android::server::wifi::wificond::PnoSettings;
+using ::com::android::server::wifi::wificond::ScanResultDelta;
 using ::com::android::server::wifi::wificond::NativeScanResult;
 using android::hardware::wifi::offload::V1_0::ScanResult;
+using ::testing::AllOf;
+using ::testing::Field;
 using ::testing::Invoke;
 using ::testing::NiceMock;
+using ::testing::DoAll;
+using ::testing::ElementsAre;
 using ::testing::Return;
+using ::testing::SaveArg;
+using ::testing::SizeIs;
+using ::testing::UnorderedElementsAre;
 using ::testing::_;
 using std::shared_ptr;
 using std::unique_ptr;
@@ -57,16 +76,43 @@ namespace {
 constexpr uint32_t kFakeInterfaceIndex = 12;
 constexpr uint32_t kFakeWiphyIndex = 5;
 constexpr uint32_t kFakeScanIntervalMs = 10000;
+constexpr uint8_t kFakeMaxNumScanSsids = 4;
+constexpr uint32_t kFakeDwellTimeMs = 40;
+constexpr int32_t kFakeMin2gRssi = -75;
+constexpr int32_t kFakeMin5gRssi = -80;
+constexpr uint64_t kFakeScanCookie = 0x1234;
+const vector<uint8_t> kFakeHiddenSsid = {'H', 'i', 'd', 'd', 'e', 'n'};
+
+SingleScanSettings CreateSingleScanSettings(
+    const vector<uint32_t>& freqs,
+    const vector<vector<uint8_t>>& hidden_ssids) {
+  SingleScanSettings settings;
+  for (uint32_t freq : freqs) {
+    ChannelSettings channel;
+    channel.frequency_ = freq;
+    settings.channel_settings_.push_back(channel);
+  }
+  for (const auto& ssid : hidden_ssids) {
+    HiddenNetwork network;
+    network.ssid_ = ssid;
+    settings.hidden_networks_.push_back(network);
+  }
+  return settings;
+}
 
 // This is a helper function to mock the behavior of ScanUtils::Scan()
 // when we expect a error code.
-// |interface_index_ignored|, |request_random_mac_ignored|, |ssids_ignored|,
-// |freqs_ignored|, |error_code| are mapped to existing parameters of ScanUtils::Scan().
+// |interface_index_ignored|, |request_random_mac_ignored|,
+// |scan_type_ignored|, |dwell_time_ms_ignored|, |flush_cache_ignored|,
+// |ssids_ignored|, |freqs_ignored|, |error_code| are mapped to existing parameters of ScanUtils::Scan().
 // |mock_error_code| is a additional parameter used for specifying expected error code.
 bool ReturnErrorCodeForScanRequest(
     int mock_error_code,
     uint32_t interface_index_ignored,
     bool request_random_mac_ignored,
+    int scan_type_ignored,
+    uint32_t dwell_time_ms_ignored,
+    bool flush_cache_ignored,
     const std::vector<std::vector<uint8_t>>& ssids_ignored,
     const std::vector<uint32_t>& freqs_ignored,
     int* error_code) {
@@ -78,8 +124,9 @@ bool ReturnErrorCodeForScanRequest(
 bool CaptureSchedScanIntervalSetting(
     uint32_t /* interface_index */,
     const SchedScanIntervalSetting&  interval_setting,
-    int32_t /* rssi_threshold */,
-    bool /* request_random_mac */,
+    int32_t /* rssi_threshold_2g */,
+    int32_t /* rssi_threshold_5g */,
+    const SchedScanReqFlags& /* req_flags */,
     const  std::vector<std::vector<uint8_t>>& /* scan_ssids */,
     const std::vector<std::vector<uint8_t>>& /* match_ssids */,
     const  std::vector<uint32_t>& /* freqs */,
@@ -124,8 +171,10 @@ class ScannerTest : public ::testing::Test {
   NiceMock<MockScanUtils> scan_utils_{&netlink_manager_};
   NiceMock<MockInterfaceTool> if_tool_;
   NiceMock<MockSupplicantManager> supplicant_manager_;
+  NiceMock<MockEventLoop> event_loop_;
   NiceMock<MockClientInterfaceImpl> client_interface_impl_{
-      &if_tool_, &supplicant_manager_, &netlink_utils_, &scan_utils_};
+      &if_tool_, &supplicant_manager_, &netlink_utils_, &scan_utils_,
+      &event_loop_};
   shared_ptr<NiceMock<MockOffloadServiceUtils>> offload_service_utils_{
       new NiceMock<MockOffloadServiceUtils>()};
   shared_ptr<NiceMock<MockOffloadScanCallbackInterfaceImpl>>
@@ -141,12 +190,13 @@ class ScannerTest : public ::testing::Test {
 };
 
 TEST_F(ScannerTest, TestSingleScan) {
-  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _)).WillOnce(Return(true));
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _)).WillOnce(Return(true));
   bool success = false;
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   EXPECT_TRUE(scanner_impl_->scan(SingleScanSettings(), &success).isOk());
   EXPECT_TRUE(success);
 }
@@ -155,12 +205,13 @@ TEST_F(ScannerTest, TestSingleScanFailure) {
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   EXPECT_CALL(
       scan_utils_,
-      Scan(_, _, _, _, _)).
+      Scan(_, _, _, _, _, _, _, _)).
           WillOnce(Invoke(bind(
-              ReturnErrorCodeForScanRequest, EBUSY, _1, _2, _3, _4, _5)));
+              ReturnErrorCodeForScanRequest, EBUSY, _1, _2, _3, _4, _5, _6, _7, _8)));
 
   bool success = false;
   EXPECT_TRUE(scanner_impl_->scan(SingleScanSettings(), &success).isOk());
@@ -171,25 +222,80 @@ TEST_F(ScannerTest, TestProcessAbortsOnScanReturningNoDeviceError) {
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   ON_CALL(
       scan_utils_,
-      Scan(_, _, _, _, _)).
+      Scan(_, _, _, _, _, _, _, _)).
           WillByDefault(Invoke(bind(
-              ReturnErrorCodeForScanRequest, ENODEV, _1, _2, _3, _4, _5)));
+              ReturnErrorCodeForScanRequest, ENODEV, _1, _2, _3, _4, _5, _6, _7, _8)));
 
   bool success_ignored;
   EXPECT_DEATH(scanner_impl_->scan(SingleScanSettings(), &success_ignored),
                "Driver is in a bad state*");
 }
 
+TEST_F(ScannerTest, TestSingleScanWithSupportedScanTypeAndDwellTime) {
+  wiphy_features_.supports_low_span_oneshot_scan = true;
+  wiphy_features_.supports_scan_dwell = true;
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  SingleScanSettings settings;
+  settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_LOW_SPAN;
+  settings.dwell_time_ms_ = kFakeDwellTimeMs;
+  EXPECT_CALL(scan_utils_, Scan(_, _, IWifiScannerImpl::SCAN_TYPE_LOW_SPAN,
+                                kFakeDwellTimeMs, _, _, _, _))
+      .WillOnce(Return(true));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(settings, &success).isOk());
+  EXPECT_TRUE(success);
+}
+
+TEST_F(ScannerTest, TestSingleScanFallsBackIfScanTypeNotSupported) {
+  wiphy_features_.supports_low_span_oneshot_scan = true;
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  SingleScanSettings settings;
+  settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY;
+  settings.dwell_time_ms_ = kFakeDwellTimeMs;
+  EXPECT_CALL(scan_utils_, Scan(_, _, IWifiScannerImpl::SCAN_TYPE_DEFAULT,
+                                0u, _, _, _, _))
+      .WillOnce(Return(true));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(settings, &success).isOk());
+  EXPECT_TRUE(success);
+}
+
+TEST_F(ScannerTest, TestSingleScanFlushesCacheIfSupported) {
+  wiphy_features_.supports_scan_flush = true;
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  SingleScanSettings settings;
+  settings.flush_cache_ = true;
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, true, _, _, _))
+      .WillOnce(Return(true));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(settings, &success).isOk());
+  EXPECT_TRUE(success);
+}
+
 TEST_F(ScannerTest, TestAbortScan) {
   bool single_scan_success = false;
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
-  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _)).WillOnce(Return(true));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _)).WillOnce(Return(true));
   EXPECT_TRUE(
       scanner_impl_->scan(SingleScanSettings(), &single_scan_success).isOk());
   EXPECT_TRUE(single_scan_success);
@@ -202,17 +308,534 @@ TEST_F(ScannerTest, TestAbortScanNotIssuedIfNoOngoingScan) {
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   EXPECT_CALL(scan_utils_, AbortScan(_)).Times(0);
   EXPECT_TRUE(scanner_impl_->abortScan().isOk());
 }
 
+TEST_F(ScannerTest, TestScanRequestCoveredByOngoingScanIsNotReissued) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  scanner_impl_->subscribeScanEvents(scan_event);
+
+  // A full scan covers a later scan on a subset of channels.
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _)).WillOnce(Return(true));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(SingleScanSettings(), &success).isOk());
+  EXPECT_TRUE(success);
+  success = false;
+  EXPECT_TRUE(scanner_impl_->scan(
+      CreateSingleScanSettings({2412, 5180}, {}), &success).isOk());
+  EXPECT_TRUE(success);
+
+  // One notification per scan() call.
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(2);
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> freqs;
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+}
+
+TEST_F(ScannerTest, TestScanRequestsAreCoalescedIntoFollowUpScan) {
+  ScanCapabilities scan_capabilities(kFakeMaxNumScanSsids, 0, 0, 0, 0, 0);
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  scanner_impl_->subscribeScanEvents(scan_event);
+
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _)).WillOnce(Return(true));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(
+      CreateSingleScanSettings({2412}, {}), &success).isOk());
+  EXPECT_TRUE(success);
+
+  // Neither of these is covered by the ongoing scan, and neither is sent to
+  // the kernel while it runs.
+  EXPECT_TRUE(scanner_impl_->scan(
+      CreateSingleScanSettings({5180}, {}), &success).isOk());
+  EXPECT_TRUE(success);
+  EXPECT_TRUE(scanner_impl_->scan(
+      CreateSingleScanSettings({5200}, {kFakeHiddenSsid}), &success).isOk());
+  EXPECT_TRUE(success);
+
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(1);
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _,
+                                UnorderedElementsAre(vector<uint8_t>(),
+                                                     kFakeHiddenSsid),
+                                UnorderedElementsAre(5180u, 5200u), _))
+      .WillOnce(Return(true));
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> freqs;
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(2);
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+}
+
+TEST_F(ScannerTest, TestHiddenSsidsLeftOutOfFollowUpScanAreDeferred) {
+  // Room for the wild card ssid and one hidden network per scan.
+  ScanCapabilities scan_capabilities(2, 0, 0, 0, 0, 0);
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _)).WillOnce(Return(true));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(
+      CreateSingleScanSettings({2412}, {}), &success).isOk());
+  EXPECT_TRUE(success);
+
+  const vector<uint8_t> kOtherHiddenSsid = {'O', 't', 'h', 'e', 'r'};
+  EXPECT_TRUE(scanner_impl_->scan(
+      CreateSingleScanSettings({5180}, {kFakeHiddenSsid}), &success).isOk());
+  EXPECT_TRUE(success);
+  // The follow-up scan has no ssid slot left for this one.
+  EXPECT_TRUE(scanner_impl_->scan(
+      CreateSingleScanSettings({5200}, {kOtherHiddenSsid}), &success).isOk());
+  EXPECT_TRUE(success);
+
+  auto coverage_stats = scanner_impl_->GetHiddenNetworkCoverageStats();
+  EXPECT_EQ(1u, coverage_stats[kFakeHiddenSsid].num_probed);
+  EXPECT_EQ(0u, coverage_stats[kOtherHiddenSsid].num_probed);
+  EXPECT_EQ(1u, coverage_stats[kOtherHiddenSsid].num_deferred);
+}
+
+TEST_F(ScannerTest, TestScanSplitsRequestForFullHiddenNetworkCoverage) {
+  // Room for the wild card ssid and one hidden network per scan.
+  ScanCapabilities scan_capabilities(2, 0, 0, 0, 0, 0);
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  scanner_impl_->subscribeScanEvents(scan_event);
+
+  const vector<uint8_t> kOtherHiddenSsid = {'O', 't', 'h', 'e', 'r'};
+  SingleScanSettings settings =
+      CreateSingleScanSettings({}, {kFakeHiddenSsid, kOtherHiddenSsid});
+  settings.full_hidden_network_coverage_ = true;
+
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _,
+                                ElementsAre(vector<uint8_t>(),
+                                            kFakeHiddenSsid), _, _))
+      .WillOnce(Return(true));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(settings, &success).isOk());
+  EXPECT_TRUE(success);
+
+  // The caller only hears back once the second scan is done.
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(0);
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _,
+                                ElementsAre(vector<uint8_t>(),
+                                            kOtherHiddenSsid), _, _))
+      .WillOnce(Return(true));
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> freqs;
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(1);
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+
+  auto coverage_stats = scanner_impl_->GetHiddenNetworkCoverageStats();
+  EXPECT_EQ(1u, coverage_stats[kFakeHiddenSsid].num_probed);
+  EXPECT_EQ(1u, coverage_stats[kOtherHiddenSsid].num_probed);
+}
+
+TEST_F(ScannerTest, TestScanRotatesHiddenNetworksBeyondSsidLimit) {
+  ScanCapabilities scan_capabilities(2, 0, 0, 0, 0, 0);
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  const vector<uint8_t> kOtherHiddenSsid = {'O', 't', 'h', 'e', 'r'};
+  SingleScanSettings settings =
+      CreateSingleScanSettings({}, {kFakeHiddenSsid, kOtherHiddenSsid});
+
+  vector<vector<uint8_t>> scanned_ssids;
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _))
+      .Times(2)
+      .WillRepeatedly(DoAll(SaveArg<5>(&scanned_ssids), Return(true)));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(settings, &success).isOk());
+  EXPECT_EQ(vector<vector<uint8_t>>({{}, kFakeHiddenSsid}), scanned_ssids);
+
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> freqs;
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+
+  // The network left out last time goes first.
+  EXPECT_TRUE(scanner_impl_->scan(settings, &success).isOk());
+  EXPECT_EQ(vector<vector<uint8_t>>({{}, kOtherHiddenSsid}), scanned_ssids);
+}
+
+TEST_F(ScannerTest, TestScanResultsSharedMemoryIsOnlyRefreshedOnNewResults) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  EXPECT_CALL(scan_utils_, GetScanResult(_, _))
+      .Times(2)
+      .WillRepeatedly(
+          Invoke(bind(ReturnNetlinkScanResults, _1, _2, dummy_scan_results_)));
+
+  ::android::base::unique_fd first_fd;
+  ::android::base::unique_fd second_fd;
+  EXPECT_TRUE(scanner_impl_->getScanResultsSharedMemory(&first_fd).isOk());
+  EXPECT_TRUE(scanner_impl_->getScanResultsSharedMemory(&second_fd).isOk());
+  EXPECT_GE(first_fd.get(), 0);
+  EXPECT_GE(second_fd.get(), 0);
+
+  // Only new scan results from the kernel lead to another dump.
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> freqs;
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+  ::android::base::unique_fd third_fd;
+  EXPECT_TRUE(scanner_impl_->getScanResultsSharedMemory(&third_fd).isOk());
+  EXPECT_GE(third_fd.get(), 0);
+}
+
+TEST_F(ScannerTest, TestScanResultDeltasArePushedBeforeScanEvent) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  scanner_impl_->subscribeScanEvents(scan_event);
+  sp<NiceMock<MockScanResultDeltaEvent>> delta_event(
+      new NiceMock<MockScanResultDeltaEvent>());
+  scanner_impl_->subscribeScanResultDeltas(delta_event);
+  ON_CALL(scan_utils_, GetScanResult(_, _))
+      .WillByDefault(
+          Invoke(bind(ReturnNetlinkScanResults, _1, _2, dummy_scan_results_)));
+
+  bool success = false;
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _))
+      .WillRepeatedly(Return(true));
+  EXPECT_TRUE(scanner_impl_->scan(SingleScanSettings(), &success).isOk());
+  {
+    ::testing::InSequence sequence;
+    EXPECT_CALL(*delta_event, OnScanResultDelta(
+        Field(&ScanResultDelta::added_, SizeIs(dummy_scan_results_.size()))));
+    EXPECT_CALL(*scan_event, OnScanResultReady());
+  }
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> freqs;
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+
+  // Same scan results again: nothing to push.
+  EXPECT_TRUE(scanner_impl_->scan(SingleScanSettings(), &success).isOk());
+  EXPECT_CALL(*delta_event, OnScanResultDelta(_)).Times(0);
+  EXPECT_CALL(*scan_event, OnScanResultReady());
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+}
+
+TEST_F(ScannerTest, TestAsyncScanReportsEachStepWithRequestId) {
+  OnScanResultsReadyHandler scan_results_handler;
+  OnScanTriggeredHandler scan_triggered_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_results_handler));
+  EXPECT_CALL(scan_utils_, SubscribeScanTriggerNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_triggered_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  scanner_impl_->subscribeScanEvents(scan_event);
+  sp<NiceMock<MockScanRequestCallback>> callback(
+      new NiceMock<MockScanRequestCallback>());
+
+  // The binder call returns before the kernel answers.
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _)).Times(0);
+  EXPECT_CALL(scan_utils_, ScanAsync(_, _, _, _, _, _, _))
+      .WillOnce(Return(true));
+  int32_t request_id = IWifiScannerImpl::SCAN_REQUEST_ID_INVALID;
+  EXPECT_TRUE(scanner_impl_->scanAsync(
+      SingleScanSettings(), callback, &request_id).isOk());
+  EXPECT_NE(IWifiScannerImpl::SCAN_REQUEST_ID_INVALID, request_id);
+
+  EXPECT_CALL(*callback, OnScanRequestAcked(request_id, kFakeScanCookie));
+  scan_triggered_handler(kFakeInterfaceIndex, 0, kFakeScanCookie);
+
+  // Only the callback hears about its request.
+  EXPECT_CALL(*callback, OnScanRequestCompleted(request_id, false));
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(0);
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> freqs;
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+}
+
+TEST_F(ScannerTest, TestAsyncScanRejectedByKernel) {
+  OnScanTriggeredHandler scan_triggered_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanTriggerNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_triggered_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  scanner_impl_->subscribeScanEvents(scan_event);
+  sp<NiceMock<MockScanRequestCallback>> callback(
+      new NiceMock<MockScanRequestCallback>());
+
+  EXPECT_CALL(scan_utils_, ScanAsync(_, _, _, _, _, _, _))
+      .WillOnce(Return(true));
+  int32_t request_id = IWifiScannerImpl::SCAN_REQUEST_ID_INVALID;
+  EXPECT_TRUE(scanner_impl_->scanAsync(
+      SingleScanSettings(), callback, &request_id).isOk());
+  // A scan() call covered by the pending scan rides along with it.
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(SingleScanSettings(), &success).isOk());
+  EXPECT_TRUE(success);
+
+  EXPECT_CALL(*callback, OnScanRequestAcked(_, _)).Times(0);
+  EXPECT_CALL(*callback, OnScanRequestFailed(request_id, EBUSY));
+  EXPECT_CALL(*scan_event, OnScanFailed());
+  scan_triggered_handler(kFakeInterfaceIndex, EBUSY, 0);
+
+  // The scanner is idle again.
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _)).WillOnce(Return(true));
+  EXPECT_TRUE(scanner_impl_->scan(SingleScanSettings(), &success).isOk());
+  EXPECT_TRUE(success);
+}
+
+TEST_F(ScannerTest, TestAsyncScanFailsWhenTriggerIsNotAnswered) {
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanRequestCallback>> callback(
+      new NiceMock<MockScanRequestCallback>());
+  std::function<void()> timeout_task;
+  EXPECT_CALL(event_loop_, PostDelayedTask(_, _))
+      .WillOnce(SaveArg<0>(&timeout_task));
+  EXPECT_CALL(scan_utils_, ScanAsync(_, _, _, _, _, _, _))
+      .WillOnce(Return(true));
+  int32_t request_id = IWifiScannerImpl::SCAN_REQUEST_ID_INVALID;
+  EXPECT_TRUE(scanner_impl_->scanAsync(
+      SingleScanSettings(), callback, &request_id).isOk());
+
+  // The answer of the kernel was lost.
+  EXPECT_CALL(scan_utils_, AbortScan(kFakeInterfaceIndex));
+  EXPECT_CALL(*callback, OnScanRequestFailed(request_id, ETIMEDOUT));
+  ASSERT_TRUE(timeout_task != nullptr);
+  timeout_task();
+
+  // The scanner is idle again.
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _)).WillOnce(Return(true));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(SingleScanSettings(), &success).isOk());
+  EXPECT_TRUE(success);
+}
+
+TEST_F(ScannerTest, TestAsyncScanSendFailure) {
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanRequestCallback>> callback(
+      new NiceMock<MockScanRequestCallback>());
+  EXPECT_CALL(scan_utils_, ScanAsync(_, _, _, _, _, _, _))
+      .WillOnce(Return(false));
+  int32_t request_id = 0;
+  EXPECT_TRUE(scanner_impl_->scanAsync(
+      SingleScanSettings(), callback, &request_id).isOk());
+  EXPECT_EQ(IWifiScannerImpl::SCAN_REQUEST_ID_INVALID, request_id);
+}
+
+TEST_F(ScannerTest, TestAbortScanFailsCoalescedScanRequests) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  scanner_impl_->subscribeScanEvents(scan_event);
+
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _)).WillOnce(Return(true));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(
+      CreateSingleScanSettings({2412}, {}), &success).isOk());
+  EXPECT_TRUE(scanner_impl_->scan(
+      CreateSingleScanSettings({5180}, {}), &success).isOk());
+
+  EXPECT_CALL(scan_utils_, AbortScan(_)).WillOnce(Return(true));
+  EXPECT_TRUE(scanner_impl_->abortScan().isOk());
+
+  // No follow-up scan once aborted.
+  EXPECT_CALL(*scan_event, OnScanFailed()).Times(2);
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> freqs;
+  scan_results_handler(kFakeInterfaceIndex, true, ssids, freqs);
+}
+
+TEST_F(ScannerTest, TestHigherPriorityScanPreemptsOngoingScan) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  scanner_impl_->subscribeScanEvents(scan_event);
+  SingleScanSettings low_priority_settings =
+      CreateSingleScanSettings({2412}, {});
+  low_priority_settings.priority_ = IWifiScannerImpl::SCAN_PRIORITY_LOW;
+  SingleScanSettings high_priority_settings =
+      CreateSingleScanSettings({5180}, {});
+  high_priority_settings.priority_ = IWifiScannerImpl::SCAN_PRIORITY_HIGH;
+
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, ElementsAre(2412), _))
+      .WillOnce(Return(true));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(low_priority_settings, &success).isOk());
+  EXPECT_CALL(scan_utils_, AbortScan(_)).WillOnce(Return(true));
+  EXPECT_TRUE(scanner_impl_->scan(high_priority_settings, &success).isOk());
+  EXPECT_TRUE(success);
+
+  // The pre-empted scan doesn't fail, it runs again after the other one.
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> freqs;
+  EXPECT_CALL(*scan_event, OnScanFailed()).Times(0);
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(0);
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, ElementsAre(5180), _))
+      .WillOnce(Return(true));
+  scan_results_handler(kFakeInterfaceIndex, true, ssids, freqs);
+
+  EXPECT_CALL(*scan_event, OnScanResultReady());
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, ElementsAre(2412), _))
+      .WillOnce(Return(true));
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+
+  EXPECT_CALL(*scan_event, OnScanResultReady());
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+
+  const auto& stats = scanner_impl_->GetScanArbitrationStats();
+  EXPECT_EQ(1u, stats.at(IWifiScannerImpl::SCAN_PRIORITY_LOW).num_preempted);
+  EXPECT_EQ(1u, stats.at(IWifiScannerImpl::SCAN_PRIORITY_LOW).num_started);
+  EXPECT_EQ(1u, stats.at(IWifiScannerImpl::SCAN_PRIORITY_HIGH).num_started);
+}
+
+TEST_F(ScannerTest, TestScanRequestFailsPastDeadline) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  scanner_impl_->subscribeScanEvents(scan_event);
+  sp<NiceMock<MockScanRequestCallback>> callback(
+      new NiceMock<MockScanRequestCallback>());
+
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _)).WillOnce(Return(true));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(
+      CreateSingleScanSettings({2412}, {}), &success).isOk());
+  SingleScanSettings settings = CreateSingleScanSettings({5180}, {});
+  settings.deadline_ms_ = 1;
+  int32_t request_id = IWifiScannerImpl::SCAN_REQUEST_ID_INVALID;
+  EXPECT_TRUE(scanner_impl_->scanAsync(settings, callback, &request_id).isOk());
+  EXPECT_NE(IWifiScannerImpl::SCAN_REQUEST_ID_INVALID, request_id);
+  usleep(5000);
+
+  // The follow-up scan is dropped together with its only caller.
+  EXPECT_CALL(*scan_event, OnScanResultReady());
+  EXPECT_CALL(*callback, OnScanRequestFailed(request_id, ETIMEDOUT));
+  EXPECT_CALL(scan_utils_, ScanAsync(_, _, _, _, _, _, _)).Times(0);
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> freqs;
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+  EXPECT_EQ(1u, scanner_impl_->GetScanArbitrationStats()
+                    .at(IWifiScannerImpl::SCAN_PRIORITY_NORMAL)
+                    .num_expired);
+}
+
+TEST_F(ScannerTest, TestScanRequestFailsAtDeadlineWhileScanRuns) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _))
+      .WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanRequestCallback>> callback(
+      new NiceMock<MockScanRequestCallback>());
+
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _, _, _)).WillOnce(Return(true));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(
+      CreateSingleScanSettings({2412}, {}), &success).isOk());
+  SingleScanSettings settings = CreateSingleScanSettings({5180}, {});
+  settings.deadline_ms_ = 1;
+  std::function<void()> deadline_task;
+  EXPECT_CALL(event_loop_, PostDelayedTask(_, _))
+      .WillOnce(SaveArg<0>(&deadline_task));
+  int32_t request_id = IWifiScannerImpl::SCAN_REQUEST_ID_INVALID;
+  EXPECT_TRUE(scanner_impl_->scanAsync(settings, callback, &request_id).isOk());
+  usleep(5000);
+
+  // The caller hears back before the running scan is done.
+  EXPECT_CALL(*callback, OnScanRequestFailed(request_id, ETIMEDOUT));
+  ASSERT_TRUE(deadline_task != nullptr);
+  deadline_task();
+
+  EXPECT_CALL(scan_utils_, ScanAsync(_, _, _, _, _, _, _)).Times(0);
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> freqs;
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, freqs);
+}
+
 TEST_F(ScannerTest, TestGetScanResults) {
   vector<NativeScanResult> scan_results;
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   EXPECT_CALL(scan_utils_, GetScanResult(_, _)).WillOnce(Return(true));
   EXPECT_TRUE(scanner_impl_->getScanResults(&scan_results).isOk());
 }
@@ -225,8 +848,9 @@ TEST_F(ScannerTest, TestStartPnoScanViaNetlink) {
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
-  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _)).
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _)).
               WillOnce(Return(true));
   EXPECT_TRUE(scanner_impl_->startPnoScan(PnoSettings(), &success).isOk());
   EXPECT_TRUE(success);
@@ -240,7 +864,8 @@ TEST_F(ScannerTest, TestStopPnoScanViaNetlink) {
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   // StopScheduledScan() will be called no matter if there is an ongoing
   // scheduled scan or not. This is for making the system more robust.
   EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
@@ -253,7 +878,7 @@ TEST_F(ScannerTest, TestStartScanOverOffload) {
   EXPECT_CALL(*offload_service_utils_, IsOffloadScanSupported())
       .Times(1)
       .WillRepeatedly(Return(true));
-  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _))
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
       .Times(1)
       .WillRepeatedly(Return(true));
   EXPECT_CALL(*offload_scan_manager_, stopScan(_))
@@ -262,7 +887,8 @@ TEST_F(ScannerTest, TestStartScanOverOffload) {
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   scanner_impl_->startPnoScan(PnoSettings(), &success);
   EXPECT_TRUE(success);
   scanner_impl_->stopPnoScan(&success);
@@ -276,11 +902,12 @@ TEST_F(ScannerTest, TestStartScanOverNetlinkFallback) {
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
-  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _))
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
       .WillOnce(Return(false));
   EXPECT_CALL(*offload_scan_manager_, stopScan(_)).Times(0);
-  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _))
+  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
       .WillOnce(Return(true));
   EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
   EXPECT_TRUE(scanner_impl_->startPnoScan(PnoSettings(), &success).isOk());
@@ -294,7 +921,7 @@ TEST_F(ScannerTest, TestAsyncErrorOverOffload) {
   EXPECT_CALL(*offload_service_utils_, IsOffloadScanSupported())
       .Times(1)
       .WillRepeatedly(Return(true));
-  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _))
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
       .Times(1)
       .WillRepeatedly(Return(true));
   EXPECT_CALL(*offload_scan_manager_, stopScan(_))
@@ -303,8 +930,9 @@ TEST_F(ScannerTest, TestAsyncErrorOverOffload) {
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
-  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _))
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
       .WillOnce(Return(true));
   EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
   scanner_impl_->startPnoScan(PnoSettings(), &success);
@@ -315,12 +943,100 @@ TEST_F(ScannerTest, TestAsyncErrorOverOffload) {
   EXPECT_TRUE(success);
 }
 
+TEST_F(ScannerTest, TestPnoScanReturnsToOffloadAfterBinderDeath) {
+  bool success = false;
+  ON_CALL(*offload_service_utils_, IsOffloadScanSupported())
+      .WillByDefault(Return(true));
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
+      .WillOnce(Return(true));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  scanner_impl_->startPnoScan(PnoSettings(), &success);
+  EXPECT_TRUE(success);
+
+  // The dead Offload HAL is not asked to stop, its scans are restored later.
+  EXPECT_CALL(*offload_scan_manager_, stopScan(_)).Times(0);
+  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
+      .WillOnce(Return(true));
+  scanner_impl_->OnOffloadError(
+      OffloadScanCallbackInterface::AsyncErrorReason::BINDER_DEATH);
+  testing::Mock::VerifyAndClearExpectations(offload_scan_manager_.get());
+
+  EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
+  scanner_impl_->OnOffloadScanRestored();
+  EXPECT_EQ(1u, scanner_impl_->GetPnoOffloadStats().num_fallbacks);
+  EXPECT_EQ(1u, scanner_impl_->GetPnoOffloadStats().num_restores);
+
+  EXPECT_CALL(*offload_scan_manager_, stopScan(_)).WillOnce(Return(true));
+  scanner_impl_->stopPnoScan(&success);
+  EXPECT_TRUE(success);
+}
+
+TEST_F(ScannerTest, TestPnoScanRestartOverOffloadStopsFallbackScan) {
+  bool success = false;
+  ON_CALL(*offload_service_utils_, IsOffloadScanSupported())
+      .WillByDefault(Return(true));
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  PnoSettings pno_settings;
+  pno_settings.interval_ms_ = kFakeScanIntervalMs;
+  scanner_impl_->startPnoScan(pno_settings, &success);
+  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
+      .WillOnce(Return(true));
+  scanner_impl_->OnOffloadError(
+      OffloadScanCallbackInterface::AsyncErrorReason::BINDER_DEATH);
+
+  // The Offload HAL takes the new settings, so the fallback scheduled scan
+  // must not keep running alongside it.
+  EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
+  pno_settings.interval_ms_ = kFakeScanIntervalMs * 2;
+  scanner_impl_->startPnoScan(pno_settings, &success);
+  EXPECT_TRUE(success);
+}
+
+TEST_F(ScannerTest, TestPnoScanStoppedWhileOffloadIsDead) {
+  bool success = false;
+  ON_CALL(*offload_service_utils_, IsOffloadScanSupported())
+      .WillByDefault(Return(true));
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
+      .WillOnce(Return(true));
+  scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_, &netlink_utils_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  scanner_impl_->startPnoScan(PnoSettings(), &success);
+  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
+      .WillOnce(Return(true));
+  scanner_impl_->OnOffloadError(
+      OffloadScanCallbackInterface::AsyncErrorReason::BINDER_DEATH);
+
+  // Stopping must also drop the scans kept for the restarted Offload HAL.
+  EXPECT_CALL(*offload_scan_manager_, stopScan(_)).WillOnce(Return(false));
+  EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
+  scanner_impl_->stopPnoScan(&success);
+  EXPECT_TRUE(success);
+
+  EXPECT_CALL(scan_utils_, StopScheduledScan(_)).Times(0);
+  scanner_impl_->OnOffloadScanRestored();
+  EXPECT_EQ(0u, scanner_impl_->GetPnoOffloadStats().num_restores);
+}
+
 TEST_F(ScannerTest, TestGetScanResultsFromOffload) {
   bool success = false;
   EXPECT_CALL(*offload_service_utils_, IsOffloadScanSupported())
       .Times(1)
       .WillRepeatedly(Return(true));
-  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _))
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
       .Times(1)
       .WillRepeatedly(Return(true));
   EXPECT_CALL(*offload_scan_manager_, getScanResults(_))
@@ -333,7 +1049,8 @@ TEST_F(ScannerTest, TestGetScanResultsFromOffload) {
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   scanner_impl_->startPnoScan(PnoSettings(), &success);
   EXPECT_TRUE(success);
   scanner_impl_->OnOffloadScanResult();
@@ -349,7 +1066,7 @@ TEST_F(ScannerTest, TestGetScanResultsWhenOffloadFails) {
   EXPECT_CALL(*offload_service_utils_, IsOffloadScanSupported())
       .Times(1)
       .WillRepeatedly(Return(true));
-  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _))
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
       .Times(1)
       .WillRepeatedly(Return(true));
   EXPECT_CALL(*offload_scan_manager_, stopScan(_))
@@ -363,8 +1080,9 @@ TEST_F(ScannerTest, TestGetScanResultsWhenOffloadFails) {
   scanner_impl_.reset(new ScannerImpl(kFakeWiphyIndex, kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_, &netlink_utils_,
-                                      &scan_utils_, offload_service_utils_));
-  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _))
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
       .WillOnce(Return(true));
   EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
   EXPECT_TRUE(scanner_impl_->startPnoScan(PnoSettings(), &success).isOk());
@@ -378,6 +1096,66 @@ TEST_F(ScannerTest, TestGetScanResultsWhenOffloadFails) {
   EXPECT_TRUE(success);
 }
 
+TEST_F(ScannerTest, TestPnoScanSplitsNetworksBeyondOffloadCapacity) {
+  ScanCapabilities scan_capabilities_with_match_sets(
+      0 /* max_num_scan_ssids */,
+      4 /* max_num_sched_scan_ssids */,
+      4 /* max_match_sets */,
+      0 /* max_num_scan_plans */,
+      0 /* max_scan_plan_interval */,
+      0 /* max_scan_plan_iterations */);
+  ON_CALL(*offload_service_utils_, IsOffloadScanSupported())
+      .WillByDefault(Return(true));
+  ON_CALL(*offload_service_utils_, GetMaxPnoNetworks())
+      .WillByDefault(Return(2));
+  ScannerImpl scanner(
+      kFakeWiphyIndex, kFakeInterfaceIndex,
+      scan_capabilities_with_match_sets, wiphy_features_,
+      &client_interface_impl_,
+      &netlink_utils_, &scan_utils_, offload_service_utils_, &event_loop_);
+  PnoSettings pno_settings;
+  pno_settings.interval_ms_ = kFakeScanIntervalMs;
+  for (uint8_t i = 0; i < 5; i++) {
+    PnoNetwork network;
+    network.is_hidden_ = false;
+    network.ssid_ = {'N', 'e', 't', static_cast<uint8_t>('0' + i)};
+    pno_settings.pno_networks_.push_back(network);
+  }
+
+  vector<vector<uint8_t>> offload_match_ssids;
+  vector<vector<uint8_t>> netlink_match_ssids;
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
+      .WillOnce(DoAll(SaveArg<3>(&offload_match_ssids), Return(true)));
+  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
+      .WillOnce(DoAll(SaveArg<6>(&netlink_match_ssids), Return(true)));
+  bool success = false;
+  EXPECT_TRUE(scanner.startPnoScan(pno_settings, &success).isOk());
+  EXPECT_TRUE(success);
+  EXPECT_EQ(2u, offload_match_ssids.size());
+  EXPECT_EQ(3u, netlink_match_ssids.size());
+  std::set<vector<uint8_t>> covered_ssids(offload_match_ssids.begin(),
+                                          offload_match_ssids.end());
+  covered_ssids.insert(netlink_match_ssids.begin(), netlink_match_ssids.end());
+  EXPECT_EQ(5u, covered_ssids.size());
+  EXPECT_EQ(1u, scanner.GetPnoOffloadStats().num_hybrid_starts);
+
+  // Both halves found the same BSSs, which are only reported once.
+  EXPECT_CALL(*offload_scan_manager_, getScanResults(_))
+      .WillOnce(
+          Invoke(bind(ReturnOffloadScanResults, _1, dummy_scan_results_)));
+  EXPECT_CALL(scan_utils_, GetScanResult(_, _))
+      .WillOnce(
+          Invoke(bind(ReturnNetlinkScanResults, _1, _2, dummy_scan_results_)));
+  std::vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scanner.getPnoScanResults(&scan_results).isOk());
+  EXPECT_EQ(dummy_scan_results_.size(), scan_results.size());
+
+  EXPECT_CALL(*offload_scan_manager_, stopScan(_)).WillOnce(Return(true));
+  EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
+  EXPECT_TRUE(scanner.stopPnoScan(&success).isOk());
+  EXPECT_TRUE(success);
+}
+
 TEST_F(ScannerTest, TestGenerateScanPlansIfDeviceSupports) {
   ScanCapabilities scan_capabilities_scan_plan_supported(
       0 /* max_num_scan_ssids */,
@@ -391,7 +1169,7 @@ TEST_F(ScannerTest, TestGenerateScanPlansIfDeviceSupports) {
       kFakeWiphyIndex, kFakeInterfaceIndex,
       scan_capabilities_scan_plan_supported, wiphy_features_,
       &client_interface_impl_,
-      &netlink_utils_, &scan_utils_, offload_service_utils_);
+      &netlink_utils_, &scan_utils_, offload_service_utils_, &event_loop_);
 
   PnoSettings pno_settings;
   pno_settings.interval_ms_ = kFakeScanIntervalMs;
@@ -399,10 +1177,10 @@ TEST_F(ScannerTest, TestGenerateScanPlansIfDeviceSupports) {
   SchedScanIntervalSetting interval_setting;
   EXPECT_CALL(
       scan_utils_,
-      StartScheduledScan(_, _, _, _, _, _, _, _)).
+      StartScheduledScan(_, _, _, _, _, _, _, _, _)).
               WillOnce(Invoke(bind(
                   CaptureSchedScanIntervalSetting,
-                  _1, _2, _3, _4, _5, _6, _7, _8, &interval_setting)));
+                  _1, _2, _3, _4, _5, _6, _7, _8, _9, &interval_setting)));
 
   bool success_ignored = 0;
   EXPECT_TRUE(scanner.startPnoScan(pno_settings, &success_ignored).isOk());
@@ -425,17 +1203,17 @@ TEST_F(ScannerTest, TestGenerateSingleIntervalIfDeviceDoesNotSupportScanPlan) {
       kFakeWiphyIndex, kFakeInterfaceIndex,
       scan_capabilities_no_scan_plan_support, wiphy_features_,
       &client_interface_impl_,
-      &netlink_utils_, &scan_utils_, offload_service_utils_);
+      &netlink_utils_, &scan_utils_, offload_service_utils_, &event_loop_);
   PnoSettings pno_settings;
   pno_settings.interval_ms_ = kFakeScanIntervalMs;
 
   SchedScanIntervalSetting interval_setting;
   EXPECT_CALL(
       scan_utils_,
-      StartScheduledScan(_, _, _, _, _, _, _, _)).
+      StartScheduledScan(_, _, _, _, _, _, _, _, _)).
               WillOnce(Invoke(bind(
                   CaptureSchedScanIntervalSetting,
-                  _1, _2, _3, _4, _5, _6, _7, _8, &interval_setting)));
+                  _1, _2, _3, _4, _5, _6, _7, _8, _9, &interval_setting)));
 
   bool success_ignored = 0;
   EXPECT_TRUE(scanner.startPnoScan(pno_settings, &success_ignored).isOk());
@@ -444,5 +1222,144 @@ TEST_F(ScannerTest, TestGenerateSingleIntervalIfDeviceDoesNotSupportScanPlan) {
   EXPECT_EQ(kFakeScanIntervalMs, interval_setting.final_interval_ms);
 }
 
+TEST_F(ScannerTest, TestPnoScanUsesBothRssiThresholdsAndRelativeRssi) {
+  wiphy_features_.supports_random_mac_sched_scan = true;
+  wiphy_features_.supports_sched_scan_band_specific_rssi = true;
+  wiphy_features_.supports_sched_scan_relative_rssi = true;
+  ScannerImpl scanner(
+      kFakeWiphyIndex, kFakeInterfaceIndex,
+      scan_capabilities_, wiphy_features_,
+      &client_interface_impl_,
+      &netlink_utils_, &scan_utils_, offload_service_utils_, &event_loop_);
+  PnoSettings pno_settings;
+  pno_settings.interval_ms_ = kFakeScanIntervalMs;
+  pno_settings.min_2g_rssi_ = kFakeMin2gRssi;
+  pno_settings.min_5g_rssi_ = kFakeMin5gRssi;
+
+  ON_CALL(client_interface_impl_, IsAssociated()).WillByDefault(Return(true));
+  EXPECT_CALL(
+      scan_utils_,
+      StartScheduledScan(
+          _, _, kFakeMin2gRssi, kFakeMin5gRssi,
+          AllOf(Field(&SchedScanReqFlags::request_random_mac, false),
+                Field(&SchedScanReqFlags::request_band_specific_rssi, true),
+                Field(&SchedScanReqFlags::request_relative_rssi, true)),
+          _, _, _, _))
+      .WillOnce(Return(true));
+
+  bool success = false;
+  EXPECT_TRUE(scanner.startPnoScan(pno_settings, &success).isOk());
+  EXPECT_TRUE(success);
+}
+
+TEST_F(ScannerTest, TestPnoScanRotatesNetworksBeyondMatchSetLimit) {
+  ScanCapabilities scan_capabilities_with_few_match_sets(
+      0 /* max_num_scan_ssids */,
+      4 /* max_num_sched_scan_ssids */,
+      4 /* max_match_sets */,
+      0 /* max_num_scan_plans */,
+      0 /* max_scan_plan_interval */,
+      0 /* max_scan_plan_iterations */);
+  ScannerImpl scanner(
+      kFakeWiphyIndex, kFakeInterfaceIndex,
+      scan_capabilities_with_few_match_sets, wiphy_features_,
+      &client_interface_impl_,
+      &netlink_utils_, &scan_utils_, offload_service_utils_, &event_loop_);
+  PnoSettings pno_settings;
+  pno_settings.interval_ms_ = kFakeScanIntervalMs;
+  for (uint8_t i = 0; i < 6; i++) {
+    PnoNetwork network;
+    network.is_hidden_ = false;
+    network.ssid_ = {'N', 'e', 't', static_cast<uint8_t>('0' + i)};
+    pno_settings.pno_networks_.push_back(network);
+  }
+  // The network connected to most recently always gets a slot.
+  pno_settings.pno_networks_[5].last_connected_age_ms_ = 1000;
+
+  vector<vector<uint8_t>> match_ssids;
+  std::function<void()> rotation_task;
+  const int64_t kRotationWindowMs =
+      kFakeScanIntervalMs * PnoSettings::kSlowScanIntervalMultiplier * 4;
+  EXPECT_CALL(event_loop_, PostDelayedTask(_, kRotationWindowMs))
+      .Times(3)
+      .WillRepeatedly(SaveArg<0>(&rotation_task));
+  {
+    ::testing::InSequence sequence;
+    EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
+        .WillOnce(DoAll(SaveArg<6>(&match_ssids), Return(true)));
+    for (int i = 0; i < 2; i++) {
+      // The running scheduled scan is stopped to take the next window.
+      EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
+      EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
+          .WillOnce(DoAll(SaveArg<6>(&match_ssids), Return(true)));
+    }
+  }
+
+  std::set<vector<uint8_t>> covered_ssids;
+  bool success = false;
+  EXPECT_TRUE(scanner.startPnoScan(pno_settings, &success).isOk());
+  EXPECT_TRUE(success);
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(4u, match_ssids.size());
+    EXPECT_EQ(pno_settings.pno_networks_[5].ssid_, match_ssids[0]);
+    covered_ssids.insert(match_ssids.begin(), match_ssids.end());
+    if (i < 2) {
+      ASSERT_TRUE(rotation_task != nullptr);
+      rotation_task();
+    }
+  }
+  EXPECT_EQ(6u, covered_ssids.size());
+  EXPECT_EQ(2u, scanner.GetPnoUpdateStats().num_rotations);
+}
+
+TEST_F(ScannerTest, TestUnchangedPnoSettingsKeepScheduledScan) {
+  ScanCapabilities scan_capabilities_with_match_sets(
+      0 /* max_num_scan_ssids */,
+      4 /* max_num_sched_scan_ssids */,
+      4 /* max_match_sets */,
+      0 /* max_num_scan_plans */,
+      0 /* max_scan_plan_interval */,
+      0 /* max_scan_plan_iterations */);
+  ScannerImpl scanner(
+      kFakeWiphyIndex, kFakeInterfaceIndex,
+      scan_capabilities_with_match_sets, wiphy_features_,
+      &client_interface_impl_,
+      &netlink_utils_, &scan_utils_, offload_service_utils_, &event_loop_);
+  PnoSettings pno_settings;
+  pno_settings.interval_ms_ = kFakeScanIntervalMs;
+  for (uint8_t i = 0; i < 2; i++) {
+    PnoNetwork network;
+    network.is_hidden_ = false;
+    network.ssid_ = {'N', 'e', 't', static_cast<uint8_t>('0' + i)};
+    pno_settings.pno_networks_.push_back(network);
+  }
+
+  {
+    ::testing::InSequence sequence;
+    EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
+        .WillOnce(Return(true));
+    // The kernel cannot change a running scheduled scan, so it is stopped
+    // before the restart.
+    EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
+    EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
+        .WillOnce(Return(true));
+  }
+  bool success = false;
+  EXPECT_TRUE(scanner.startPnoScan(pno_settings, &success).isOk());
+  EXPECT_TRUE(success);
+  // The age of a network alone does not change which networks are scanned.
+  pno_settings.pno_networks_[0].last_connected_age_ms_ = 1000;
+  success = false;
+  EXPECT_TRUE(scanner.startPnoScan(pno_settings, &success).isOk());
+  EXPECT_TRUE(success);
+  EXPECT_EQ(1u, scanner.GetPnoUpdateStats().num_unchanged_updates);
+
+  pno_settings.interval_ms_ = kFakeScanIntervalMs * 2;
+  EXPECT_TRUE(scanner.startPnoScan(pno_settings, &success).isOk());
+  EXPECT_TRUE(success);
+  EXPECT_EQ(2u, scanner.GetPnoUpdateStats().num_updates);
+  EXPECT_EQ(1u, scanner.GetPnoUpdateStats().num_unchanged_updates);
+}
+
 }  // namespace wificond
 }  // namespace android
@@ -23,6 +23,7 @@
 #include <wifi_system_test/mock_supplicant_manager.h>
 
 #include "android/net/wifi/IApInterface.h"
+#include "wificond/tests/mock_event_loop.h"
 #include "wificond/tests/mock_netlink_manager.h"
 #include "wificond/tests/mock_netlink_utils.h"
 #include "wificond/tests/mock_scan_utils.h"
@@ -112,11 +113,13 @@ class ServerTest : public ::testing::Test {
                kFakeInterfaceMacAddress1 + sizeof(kFakeInterfaceMacAddress1)))
   };
 
+  NiceMock<MockEventLoop> event_loop_;
   Server server_{unique_ptr<InterfaceTool>(if_tool_),
                  unique_ptr<SupplicantManager>(supplicant_manager_),
                  unique_ptr<HostapdManager>(hostapd_manager_),
                  netlink_utils_.get(),
-                 scan_utils_.get()};
+                 scan_utils_.get(),
+                 &event_loop_};
 };  // class ServerTest
 
 }  // namespace
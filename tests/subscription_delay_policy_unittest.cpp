@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/offload/subscription_delay_policy.h"
+
+namespace android {
+namespace wificond {
+
+TEST(SubscriptionDelayPolicyTest, BacksOffToTwoScanIntervals) {
+  SubscriptionDelayPolicy policy;
+  policy.Reset(5000 /* scan_interval_ms */, 0 /* requested_delay_ms */);
+  EXPECT_EQ(SubscriptionDelayPolicy::kInitialDelayMs, policy.GetDelayMs());
+  uint32_t num_backoffs = 0;
+  while (policy.OnScanResultsReported()) {
+    num_backoffs++;
+  }
+  EXPECT_EQ(10000u, policy.GetDelayMs());
+  EXPECT_EQ(4u, num_backoffs);
+}
+
+TEST(SubscriptionDelayPolicyTest, BoundsDelayOfIdleScans) {
+  SubscriptionDelayPolicy policy;
+  policy.Reset(600000 /* scan_interval_ms */, 0 /* requested_delay_ms */);
+  while (policy.OnScanResultsReported()) {}
+  EXPECT_EQ(SubscriptionDelayPolicy::kMaxDelayMs, policy.GetDelayMs());
+
+  // A new request gets a quick first report again.
+  policy.Reset(600000 /* scan_interval_ms */, 0 /* requested_delay_ms */);
+  EXPECT_EQ(SubscriptionDelayPolicy::kInitialDelayMs, policy.GetDelayMs());
+}
+
+TEST(SubscriptionDelayPolicyTest, KeepsRequestedDelay) {
+  SubscriptionDelayPolicy policy;
+  policy.Reset(5000 /* scan_interval_ms */, 3000 /* requested_delay_ms */);
+  EXPECT_EQ(3000u, policy.GetDelayMs());
+  EXPECT_FALSE(policy.OnScanResultsReported());
+  EXPECT_EQ(3000u, policy.GetDelayMs());
+}
+
+}  // namespace wificond
+}  // namespace android